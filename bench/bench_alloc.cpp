@@ -0,0 +1,139 @@
+// Allocation benchmark: runs a few queries over an in-memory table and
+// counts heap allocations per query, with the BufferPool cache disabled
+// (every batch buffer and its owner come from the heap, as before the pool)
+// and enabled (buffers are recycled between batches).
+//
+// Usage: bench_alloc [rows] [repeats]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include "catalog/catalog.h"
+#include "exec/buffer_pool.h"
+#include "exec/physical_planner.h"
+#include "logical/planner.h"
+#include "parser/parser.h"
+
+namespace {
+
+std::atomic<uint64_t> heap_allocations{0};
+
+void* counted_alloc(std::size_t size, std::size_t alignment = 0) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void* ptr = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                                                      : std::malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return counted_alloc(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return counted_alloc(size, static_cast<std::size_t>(align)); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+using namespace bosql;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+Catalog build_catalog(int64_t rows) {
+    Catalog catalog;
+    Table sales;
+    sales.dict = std::make_shared<Dictionary>();
+    auto id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto store_col = std::make_unique<ColumnVector<int64_t>>();
+    auto price_col = std::make_unique<ColumnVector<double>>();
+    auto region_col = std::make_unique<ColumnVector<uint32_t>>();
+    const char* regions[] = {"north", "south", "east", "west"};
+    for (int64_t i = 0; i < rows; ++i) {
+        id_col->append(i);
+        store_col->append((i * 7919) % 1000);
+        price_col->append(static_cast<double>(i % 500) / 4.0);
+        region_col->append(sales.dict->get_or_add(regions[i % 4]));
+    }
+    sales.columns.push_back({"sales.id", std::move(id_col)});
+    sales.columns.push_back({"sales.store", std::move(store_col)});
+    sales.columns.push_back({"sales.price", std::move(price_col)});
+    sales.columns.push_back({"sales.region", std::move(region_col)});
+    std::vector<ColumnMeta> cols;
+    cols.emplace_back("sales.id", TypeId::INT64);
+    cols.emplace_back("sales.store", TypeId::INT64);
+    cols.emplace_back("sales.price", TypeId::DOUBLE);
+    cols.emplace_back("sales.region", TypeId::STRING);
+    catalog.register_table(std::move(sales), TableMeta("sales", std::move(cols), static_cast<size_t>(rows)));
+    return catalog;
+}
+
+struct Measurement {
+    double allocations = 0.0;  // per query
+    double ms = 0.0;           // per query
+};
+
+Measurement measure(const Catalog& catalog, const std::string& sql, size_t repeats) {
+    SelectStmt stmt = parse_sql(sql);
+    LogicalPlanner planner;
+    auto logical = planner.build_logical_plan(stmt);
+    uint64_t before = heap_allocations.load();
+    auto start = Clock::now();
+    for (size_t i = 0; i < repeats; ++i) {
+        auto root = build_physical_plan(logical.get(), catalog);
+        root->open();
+        ExecBatch batch;
+        while (root->next(batch)) {
+        }
+        root->close();
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    uint64_t allocations = heap_allocations.load() - before;
+    return {static_cast<double>(allocations) / static_cast<double>(repeats), elapsed / static_cast<double>(repeats)};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int64_t rows = argc > 1 ? std::stoll(argv[1]) : 1'000'000;
+    size_t repeats = argc > 2 ? std::stoull(argv[2]) : 5;
+    Catalog catalog = build_catalog(rows);
+
+    const std::vector<std::pair<std::string, std::string>> queries = {
+        {"filter + project", "SELECT sales.id, sales.price * 2 AS doubled FROM sales WHERE sales.store < 500"},
+        {"limit", "SELECT sales.id, sales.region FROM sales LIMIT 900000"},
+        {"group by", "SELECT sales.store, SUM(sales.price) AS total FROM sales GROUP BY sales.store"},
+        {"order by", "SELECT sales.price, sales.id FROM sales WHERE sales.store < 50 ORDER BY sales.price, sales.id"},
+    };
+
+    fmt::print("rows: {}, repeats: {}\n\n", rows, repeats);
+    fmt::print("| query            | allocs/query (no pool) | allocs/query (pool) |  ms (no pool) |  ms (pool) |\n");
+    fmt::print("| ---------------- | ---------------------- | ------------------- | ------------- | ---------- |\n");
+    BufferPool& pool = BufferPool::global();
+    for (const auto& [name, sql] : queries) {
+        pool.set_max_cached_bytes(0);
+        Measurement uncached = measure(catalog, sql, repeats);
+        pool.set_max_cached_bytes(BufferPool::kDefaultCachedBytes);
+        measure(catalog, sql, 1);  // warm the free lists
+        Measurement pooled = measure(catalog, sql, repeats);
+        fmt::print("| {:<16} | {:>22.0f} | {:>19.0f} | {:>13.2f} | {:>10.2f} |\n", name, uncached.allocations,
+                   pooled.allocations, uncached.ms, pooled.ms);
+    }
+    BufferPool::Stats stats = pool.stats();
+    fmt::print("\npool: {} heap allocations, {} reuses, {} bytes cached\n", stats.allocations, stats.reuses,
+               stats.cached_bytes);
+    return 0;
+}
@@ -0,0 +1,149 @@
+// Column compression benchmark: builds the same generated table plain and
+// compressed, prints each column's layout and footprint, and times filtered
+// aggregates over both.
+//
+// Usage: bench_compression [rows] [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include "catalog/catalog.h"
+#include "exec/formatter.hpp"
+#include "exec/operator.hpp"
+#include "exec/physical_planner.h"
+#include "logical/planner.h"
+#include "parser/parser.h"
+#include "storage/compression.h"
+
+using namespace bosql;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+Catalog build_catalog(int64_t rows, bool compress) {
+    Catalog catalog;
+    Table sales;
+    sales.dict = std::make_shared<Dictionary>();
+    auto id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto quantity_col = std::make_unique<ColumnVector<int64_t>>();
+    auto price_col = std::make_unique<ColumnVector<double>>();
+    auto region_col = std::make_unique<ColumnVector<uint32_t>>();
+    auto day_col = std::make_unique<ColumnVector<int32_t>>();
+    const char* regions[] = {"north", "south", "east", "west"};
+    uint64_t seed = 42;
+    for (int64_t i = 0; i < rows; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        id_col->append(1'000'000 + i);
+        quantity_col->append(static_cast<int64_t>(1 + (seed >> 33) % 50));
+        price_col->append(static_cast<double>((seed >> 20) % 100000) / 100.0);
+        region_col->append(sales.dict->get_or_add(regions[(seed >> 40) % 4]));
+        day_col->append(static_cast<int32_t>(20240101 + i * 28 / rows));  // sorted by day
+    }
+    sales.columns.push_back({"sales.id", std::move(id_col)});
+    sales.columns.push_back({"sales.quantity", std::move(quantity_col)});
+    sales.columns.push_back({"sales.price", std::move(price_col)});
+    sales.columns.push_back({"sales.region", std::move(region_col)});
+    sales.columns.push_back({"sales.day", std::move(day_col)});
+    std::vector<ColumnMeta> cols;
+    for (auto& column : sales.columns) {
+        cols.emplace_back(column.name, column.data->type());
+        if (compress) column.data = compress_column(std::move(column.data));
+    }
+    catalog.register_table(std::move(sales), TableMeta("sales", std::move(cols), static_cast<size_t>(rows)));
+    return catalog;
+}
+
+std::ostream discard(nullptr);
+
+// Drops the result; the bench times the scan, filter and aggregate
+struct NullFormatter : Formatter {
+    NullFormatter() : Formatter(discard) {}
+    void begin(const std::vector<std::string>&, const std::vector<TypeId>&) override {}
+    void write_batch(const ExecBatch&, const Dictionary*) override {}
+    void end(std::size_t) override {}
+};
+
+double time_query(const Catalog& catalog, const std::string& sql, size_t repeats) {
+    SelectStmt stmt = parse_sql(sql);
+    LogicalPlanner planner;
+    auto logical = planner.build_logical_plan(stmt);
+    auto [names, types, dict] = get_output_schema(logical.get(), catalog);
+    double best_ms = 0.0;
+    for (size_t i = 0; i < repeats; ++i) {
+        NullFormatter formatter;
+        auto start = Clock::now();
+        run_query(build_physical_plan(logical.get(), catalog), names, types, formatter, dict);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        best_ms = i == 0 ? ms : std::min(best_ms, ms);
+    }
+    return best_ms;
+}
+
+// Best time to read a whole column in scan-sized batches
+double time_decode(const Column& column, size_t repeats) {
+    constexpr size_t kBatch = 4096;
+    std::vector<char> out(kBatch * type_width(column.type()));
+    double best_ms = 0.0;
+    for (size_t i = 0; i < repeats; ++i) {
+        auto start = Clock::now();
+        for (size_t row = 0; row < column.size(); row += kBatch) {
+            column.decode(row, std::min(kBatch, column.size() - row), out.data());
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        best_ms = i == 0 ? ms : std::min(best_ms, ms);
+    }
+    return best_ms;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int64_t rows = argc > 1 ? std::stoll(argv[1]) : 5'000'000;
+    size_t repeats = argc > 2 ? std::stoull(argv[2]) : 3;
+    Catalog plain = build_catalog(rows, false);
+    Catalog compressed = build_catalog(rows, true);
+
+    size_t plain_total = 0, compressed_total = 0;
+    const Table& plain_table = *plain.get_table_data("sales");
+    const Table& compressed_table = *compressed.get_table_data("sales");
+    for (size_t i = 0; i < plain_table.columns.size(); ++i) {
+        const Column& before = *plain_table.columns[i].data;
+        const Column& after = *compressed_table.columns[i].data;
+        plain_total += before.memory_bytes();
+        compressed_total += after.memory_bytes();
+        fmt::print("{:<16} {:<10} {:>12} -> {:>12} bytes ({:.1f}x), read {:.2f} -> {:.2f} ms\n", plain_table.columns[i].name,
+                   after.encoding(), before.memory_bytes(), after.memory_bytes(),
+                   static_cast<double>(before.memory_bytes()) / static_cast<double>(after.memory_bytes()),
+                   time_decode(before, repeats), time_decode(after, repeats));
+    }
+    fmt::print("total            {:>23} -> {:>12} bytes ({:.1f}x)\n", plain_total, compressed_total,
+               static_cast<double>(plain_total) / static_cast<double>(compressed_total));
+
+    // The second query only reads RLE columns, so it runs once per run; the
+    // third compares 8-bit quantities where they are stored; the fourth
+    // matches each region string once; the last two look quantities up in a
+    // bitmap and ids in a hash set
+    std::string ids;
+    for (int64_t i = 0; i < 500; ++i) ids += (i ? ", " : "") + std::to_string(1'000'000 + i * 7919 % rows);
+    const std::string queries[] = {
+        "SELECT sales.day, SUM(sales.quantity) FROM sales WHERE sales.id > 1000000 GROUP BY sales.day",
+        "SELECT sales.day, COUNT(*) FROM sales WHERE sales.day > 20240110 GROUP BY sales.day",
+        "SELECT COUNT(*) FROM sales WHERE sales.quantity < 5 AND sales.id > 1500000",
+        "SELECT COUNT(*) FROM sales WHERE sales.region LIKE '%th'",
+        "SELECT COUNT(*) FROM sales WHERE sales.quantity IN (1, 7, 19, 42)",
+        "SELECT COUNT(*) FROM sales WHERE sales.id IN (" + ids + ")",
+    };
+    for (const auto& sql : queries) {
+        double plain_ms = time_query(plain, sql, repeats);
+        double compressed_ms = time_query(compressed, sql, repeats);
+        const std::string shown = sql.size() > 120 ? sql.substr(0, 117) + "..." : sql;
+        fmt::print("{}\nrows: {}, best of {}: plain {:.1f} ms, compressed {:.1f} ms\n", shown, rows, repeats, plain_ms,
+                   compressed_ms);
+    }
+    return 0;
+}
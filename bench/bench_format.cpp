@@ -0,0 +1,97 @@
+// Result export benchmark: scans a generated table and writes it as CSV to a
+// stream that discards its input, so the time is the query plus formatting.
+//
+// Usage: bench_format [rows] [repeats]
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include "catalog/catalog.h"
+#include "exec/formatter.hpp"
+#include "exec/operator.hpp"
+#include "exec/physical_planner.h"
+#include "logical/planner.h"
+#include "parser/parser.h"
+
+using namespace bosql;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Counts the bytes written to it and drops them
+struct CountingBuffer : std::streambuf {
+    size_t bytes = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        bytes += static_cast<size_t>(count);
+        return count;
+    }
+    int_type overflow(int_type ch) override {
+        ++bytes;
+        return ch;
+    }
+};
+
+Catalog build_catalog(int64_t rows) {
+    Catalog catalog;
+    Table sales;
+    sales.dict = std::make_shared<Dictionary>();
+    auto id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto price_col = std::make_unique<ColumnVector<double>>();
+    auto region_col = std::make_unique<ColumnVector<uint32_t>>();
+    auto day_col = std::make_unique<ColumnVector<int32_t>>();
+    const char* regions[] = {"north", "south", "east", "west"};
+    for (int64_t i = 0; i < rows; ++i) {
+        id_col->append(i);
+        price_col->append(static_cast<double>(i % 100000) / 7.0);
+        region_col->append(sales.dict->get_or_add(regions[i % 4]));
+        day_col->append(static_cast<int32_t>(20240101 + i % 28));
+    }
+    sales.columns.push_back({"sales.id", std::move(id_col)});
+    sales.columns.push_back({"sales.price", std::move(price_col)});
+    sales.columns.push_back({"sales.region", std::move(region_col)});
+    sales.columns.push_back({"sales.day", std::move(day_col)});
+    std::vector<ColumnMeta> cols;
+    cols.emplace_back("sales.id", TypeId::INT64);
+    cols.emplace_back("sales.price", TypeId::DOUBLE);
+    cols.emplace_back("sales.region", TypeId::STRING);
+    cols.emplace_back("sales.day", TypeId::DATE32);
+    catalog.register_table(std::move(sales), TableMeta("sales", std::move(cols), static_cast<size_t>(rows)));
+    return catalog;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int64_t rows = argc > 1 ? std::stoll(argv[1]) : 5'000'000;
+    size_t repeats = argc > 2 ? std::stoull(argv[2]) : 3;
+    Catalog catalog = build_catalog(rows);
+
+    SelectStmt stmt = parse_sql("SELECT sales.id, sales.price, sales.region, sales.day FROM sales");
+    LogicalPlanner planner;
+    auto logical = planner.build_logical_plan(stmt);
+    auto [names, types, dict] = get_output_schema(logical.get(), catalog);
+
+    double best_ms = 0.0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < repeats; ++i) {
+        CountingBuffer sink;
+        std::ostream stream(&sink);
+        CsvFormatter formatter(stream);
+        auto start = Clock::now();
+        run_query(build_physical_plan(logical.get(), catalog), names, types, formatter, dict);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        best_ms = i == 0 ? ms : std::min(best_ms, ms);
+        bytes = sink.bytes;
+    }
+    fmt::print("rows: {}, csv bytes: {}\n", rows, bytes);
+    fmt::print("best of {}: {:.1f} ms, {:.1f} M rows/s, {:.1f} MB/s\n", repeats, best_ms,
+               static_cast<double>(rows) / best_ms / 1e3, static_cast<double>(bytes) / best_ms / 1e3);
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Skewed-work benchmark: the expensive rows are clustered in one region of
+// the table (think of a selective filter whose matches sit together, or a hot
+// join key). Compares fixed range partitioning against recursive splitting on
+// the work-stealing Scheduler and reports how evenly the threads were busy.
+//
+// Usage: bench_skew [rows] [threads]
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+#include "exec/scheduler.h"
+
+using namespace bosql;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kMaxThreads = 256;
+constexpr size_t kLeafRows = 16384;
+constexpr int kHotCost = 256;
+
+// Per-thread busy time, indexed by a slot each thread claims on first use
+std::array<std::atomic<int64_t>, kMaxThreads> busy_ns;
+std::atomic<size_t> next_slot{0};
+thread_local size_t slot = kMaxThreads;
+
+std::atomic<uint64_t> checksum{0};
+
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// The first eighth of the table is hot: each of its rows costs kHotCost mixes
+void process(size_t begin, size_t end, size_t hot_rows) {
+    auto start = Clock::now();
+    uint64_t acc = 0;
+    for (size_t row = begin; row < end; ++row) {
+        uint64_t v = row;
+        int cost = row < hot_rows ? kHotCost : 1;
+        for (int i = 0; i < cost; ++i) v = mix(v);
+        acc += v;
+    }
+    checksum.fetch_add(acc, std::memory_order_relaxed);
+    if (slot == kMaxThreads) slot = next_slot.fetch_add(1) % kMaxThreads;
+    busy_ns[slot].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+void reset() {
+    for (auto& b : busy_ns) b.store(0);
+    next_slot.store(0);
+}
+
+void report(const std::string& name, Clock::duration wall, size_t threads) {
+    std::vector<double> busy;
+    for (size_t i = 0; i < threads; ++i) {
+        busy.push_back(static_cast<double>(busy_ns[i].load()) / 1e6);
+    }
+    double max = *std::max_element(busy.begin(), busy.end());
+    double min = *std::min_element(busy.begin(), busy.end());
+    double sum = 0.0;
+    for (double b : busy) sum += b;
+    double avg = sum / static_cast<double>(threads);
+    double wall_ms = std::chrono::duration<double, std::milli>(wall).count();
+    fmt::print("| {:<14} | {:>9.1f} | {:>9.1f} | {:>9.1f} | {:>9.1f} | {:>9.2f} | {:>10.0f}% |\n",
+               name, wall_ms, min, avg, max, max / std::max(avg, 1e-9),
+               100.0 * sum / (wall_ms * static_cast<double>(threads)));
+}
+
+// Forks the upper half of the range as a stealable task and keeps the lower half
+void split(Scheduler& scheduler, TaskGroup& group, size_t begin, size_t end, size_t hot_rows) {
+    while (end - begin > kLeafRows) {
+        size_t mid = begin + (end - begin) / 2;
+        scheduler.submit(group, [&scheduler, &group, mid, end, hot_rows] {
+            split(scheduler, group, mid, end, hot_rows);
+        });
+        end = mid;
+    }
+    process(begin, end, hot_rows);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::stoull(argv[1]) : 4'000'000;
+    size_t threads = argc > 2 ? std::stoull(argv[2]) : std::thread::hardware_concurrency();
+    threads = std::clamp<size_t>(threads, 2, kMaxThreads);
+    size_t hot_rows = rows / 8;
+
+    fmt::print("rows: {}, threads: {}, hot rows: {} (first eighth, {}x cost)\n\n", rows, threads, hot_rows, kHotCost);
+    fmt::print("| strategy       |   wall ms |  busy min |  busy avg |  busy max | max / avg | utilization |\n");
+    fmt::print("| -------------- | --------- | --------- | --------- | --------- | --------- | ----------- |\n");
+
+    // Fixed partitioning: one contiguous range per thread
+    reset();
+    auto start = Clock::now();
+    {
+        std::vector<std::thread> pool;
+        size_t per_thread = (rows + threads - 1) / threads;
+        for (size_t t = 0; t < threads; ++t) {
+            size_t begin = std::min(rows, t * per_thread);
+            size_t end = std::min(rows, begin + per_thread);
+            pool.emplace_back([=] { process(begin, end, hot_rows); });
+        }
+        for (auto& thread : pool) thread.join();
+    }
+    report("static ranges", Clock::now() - start, threads);
+
+    // Work stealing: the caller plus threads - 1 workers split the range recursively
+    Scheduler scheduler(threads - 1);
+    reset();
+    start = Clock::now();
+    {
+        TaskGroup group;
+        scheduler.submit(group, [&] { split(scheduler, group, 0, rows, hot_rows); });
+        scheduler.wait(group);
+    }
+    report("work stealing", Clock::now() - start, threads);
+
+    uint64_t tasks = 0;
+    uint64_t steals = 0;
+    for (const auto& stats : scheduler.stats()) {
+        tasks += stats.tasks;
+        steals += stats.steals;
+    }
+    fmt::print("\nworker tasks: {}, steals: {} (checksum {:x})\n", tasks, steals, checksum.load());
+    return 0;
+}
@@ -7,17 +7,44 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <memory>
 #include "types.h"
 #include "storage/table.h"
 
 namespace bosql {
 
+// Value that occurs often enough to be tracked on its own.
+// Numeric types store the value as a double; STRING stores the dictionary code.
+struct MostCommonValue {
+    f64 value;
+    f64 frequency;  // fraction of all rows
+};
+
+// Equi-depth histogram over the values not covered by the MCV list.
+// bounds[0] is the smallest value and bounds[i + 1] closes bucket i; every
+// bucket holds roughly the same number of rows.
+struct EquiDepthHistogram {
+    std::vector<f64> bounds;
+
+    size_t bucket_count() const { return bounds.size() < 2 ? 0 : bounds.size() - 1; }
+    bool empty() const { return bucket_count() == 0; }
+};
+
 // Column statistics
 struct ColumnStats {
     i64 min_i64 = 0, max_i64 = 0;
     f64 min_f64 = 0.0, max_f64 = 0.0;
     Date32 min_date = 0, max_date = 0;
-    size_t ndv = 0;
+    size_t ndv = 0;  // HyperLogLog estimate
+    // min/max and ndv come from the leading rows only (lazy and external CSV
+    // tables) until ANALYZE reads the whole column
+    bool approximate = false;
+
+    // Populated by ANALYZE
+    bool analyzed = false;
+    size_t sample_rows = 0;
+    std::vector<MostCommonValue> mcvs;
+    EquiDepthHistogram histogram;
 };
 
 // Column metadata with statistics
@@ -46,8 +73,13 @@ struct TableMeta {
 class Catalog {
 private:
     std::unordered_map<std::string, std::pair<Table, TableMeta>> tables_;
+    std::shared_ptr<Dictionary> shared_dictionary_ = std::make_shared<Dictionary>();
 
 public:
+    // Dictionary for the tables loaded into this catalog to share, so their
+    // string codes compare across tables without translation
+    const std::shared_ptr<Dictionary>& shared_dictionary() const { return shared_dictionary_; }
+
     // Register a table in the catalog
     void register_table(Table table, TableMeta&& table_meta);
 
@@ -57,8 +89,41 @@ public:
     // Get table metadata by name
     OptionalRef<const TableMeta> get_table_meta(const std::string& name) const;
 
+    // Replace the metadata of a registered table (keyed by meta.name)
+    bool update_table_meta(TableMeta&& table_meta);
+
     // List all table names
     std::vector<std::string> list_tables() const;
 };
 
+// Footprint of one column, as SHOW STORAGE reports it
+struct ColumnStorage {
+    std::string name;
+    TypeId type;
+    std::string encoding;
+    size_t rows = 0;
+    size_t bytes = 0;        // as stored
+    size_t stats_bytes = 0;  // MCV list and histogram kept for the planner
+    // Read by queries since load, in stored bytes
+    uint64_t scanned_rows = 0;
+    uint64_t scanned_bytes = 0;
+};
+
+struct TableStorage {
+    std::string name;
+    size_t rows = 0;
+    // Tables loaded in one session share a dictionary, so totals count each
+    // one once
+    const Dictionary* dictionary = nullptr;
+    size_t dictionary_entries = 0;
+    size_t dictionary_bytes = 0;
+    // Positional map of an external table
+    size_t map_bytes = 0;
+    std::vector<ColumnStorage> columns;
+};
+
+// Storage of `table`, or of every table (by name) when it is empty. Unknown
+// tables yield an empty list.
+std::vector<TableStorage> storage_report(const Catalog& catalog, const std::string& table = "");
+
 } // namespace bosql
\ No newline at end of file
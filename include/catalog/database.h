@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include "catalog/catalog.h"
+
+namespace bosql {
+
+// A saved catalog is a directory holding a MANIFEST (table and column
+// metadata with statistics), one file per dictionary and one file per
+// column. Column files are a 64-byte header followed by the raw values, so
+// they can be memory-mapped and used in place, or by the values of an
+// encoded layout from storage/compression.h.
+
+// Writes every table of the catalog to `directory`, creating it if needed.
+// Files are written under temporary names and renamed into place, so a
+// database that is currently open from the same directory stays readable.
+// Returns the number of tables saved.
+size_t save_database(const Catalog& catalog, const std::filesystem::path& directory);
+
+// Registers every table saved in `directory`, replacing tables with the same
+// name. Only the manifest and encoded columns are read now. Dictionaries
+// and plain columns are mapped; the OS pages them in when a query first
+// touches them, though dictionaries are indexed at once.
+// Returns the number of tables opened.
+size_t open_database(Catalog& catalog, const std::filesystem::path& directory);
+
+} // namespace bosql
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "types.h"
+#include "storage/table.h"
+#include "catalog/catalog.h"
+
+namespace bosql {
+
+// 64-bit finalizer (splitmix64) used to spread column values before sketching
+inline uint64_t hash_u64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t hash_f64(double v) {
+    if (v == 0.0) v = 0.0;  // fold -0.0 onto +0.0
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return hash_u64(bits);
+}
+
+// HyperLogLog sketch for approximate distinct counts in fixed memory
+class HyperLogLog {
+public:
+    explicit HyperLogLog(uint8_t precision = 14);
+
+    void add_hash(uint64_t hash);
+    void add(i64 v) { add_hash(hash_u64(static_cast<uint64_t>(v))); }
+    void add(f64 v) { add_hash(hash_f64(v)); }
+    void merge(const HyperLogLog& other);
+    size_t estimate() const;
+
+private:
+    uint8_t precision_;
+    std::vector<uint8_t> registers_;
+};
+
+// Knobs for ANALYZE
+struct AnalyzeOptions {
+    size_t sample_rows = 30000;     // rows drawn for histograms and MCVs
+    size_t histogram_buckets = 64;
+    size_t mcv_count = 16;
+    uint64_t seed = 42;             // keeps repeated ANALYZE runs deterministic
+};
+
+// Approximate distinct count of a column using HyperLogLog
+size_t estimate_ndv(const Column& column);
+
+// Rebuild MCV list, equi-depth histogram and NDV for every column of the table.
+// Each column is read once, a chunk at a time. The NDV sketch takes every
+// value, so this resolves lazy columns, including the cached columns of an
+// external table; MCVs and the histogram come from the row sample.
+void analyze_table(const Table& table, TableMeta& meta, const AnalyzeOptions& options = {});
+
+} // namespace bosql
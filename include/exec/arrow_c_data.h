@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "catalog/catalog.h"
+#include "exec/execution_types.hpp"
+
+// Arrow C Data Interface structs, as published in the Arrow specification.
+// The guard lets this header coexist with Arrow's own abi.h.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+}  // extern "C"
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace bosql {
+
+// Exports a batch as a struct array with one child per column. Column buffers
+// are shared, not copied: the exported array holds each ColumnSlice::owner
+// until the consumer calls release. DATE32 children are converted to days
+// since the epoch ("tdD"); STRING children are uint32 indices into a
+// dictionary array built from `dict`, shared by all of them. A dictionary
+// larger than the batch's string values is cut down to the strings the
+// batch references, and those children get remapped index buffers.
+void export_batch(const ExecBatch& batch,
+                  const std::vector<std::string>& names,
+                  const Dictionary* dict,
+                  ArrowSchema* schema,
+                  ArrowArray* array);
+
+// Exports a whole table the same way. Plain columns are shared, so the table
+// must outlive the array; encoded columns are decoded into buffers it owns.
+void export_table(const Table& table, ArrowSchema* schema, ArrowArray* array);
+
+// Imports a struct array as a table. INT64 and DOUBLE children ("l", "g")
+// are used in place: the table takes over `array`, and calls its release
+// once its last column is gone. Dates ("tdD"), int32 ("i") and strings
+// ("u", or dictionary-encoded "u") are converted. Arrays with nulls are
+// rejected. `schema` is only read; it stays with the caller.
+std::pair<Table, TableMeta> import_table(const std::string& name, const ArrowSchema* schema, ArrowArray* array);
+
+} // namespace bosql
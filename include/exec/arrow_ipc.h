@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "exec/formatter.hpp"
+
+namespace bosql {
+
+// Writes the result as an Arrow IPC stream (Arrow's columnar format, version
+// 5), readable by pyarrow.ipc.open_stream and every other Arrow reader.
+// Column buffers are copied into the stream as they are; only DATE32 values
+// are converted, from YYYYMMDD to days since the epoch. STRING columns become
+// dictionary-encoded Utf8 with uint32 indices: they all share one dictionary,
+// the query's Dictionary, sent once before the first record batch. The
+// schema goes out with the first batch, whose column types it follows.
+struct ArrowIpcFormatter final : Formatter {
+    explicit ArrowIpcFormatter(std::ostream& stream);
+    void begin(const std::vector<std::string>& names, const std::vector<TypeId>& types) override;
+    void write_batch(const ExecBatch& batch, const Dictionary* dict) override;
+    void end(std::size_t row_count) override;
+
+private:
+    void write_schema();
+    void write_dictionary(const Dictionary* dict);
+    // Encapsulated message: continuation marker, size, FlatBuffers metadata
+    void emit_metadata(const std::string& metadata);
+    // One body buffer, padded to 8 bytes
+    void emit_body(const void* data, size_t length);
+
+    std::vector<std::string> names;
+    std::vector<TypeId> types;
+    bool schema_written = false;
+    bool dictionary_written = false;
+    std::vector<int32_t> days;  // scratch for DATE32 columns
+};
+
+} // namespace bosql
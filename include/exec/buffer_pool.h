@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bosql {
+
+// Column buffers start on a cache line
+constexpr size_t kBufferAlignment = 64;
+
+// Storage borrowed from a BufferPool. The buffer goes back to the pool, and
+// its charge to the memory tracker is released, when the last copy of
+// `owner` is gone.
+struct PooledBuffer {
+    void* data = nullptr;
+    size_t capacity = 0;  // bytes
+    std::shared_ptr<void> owner;
+};
+
+// Recycles batch buffers by power-of-two size class, so that steady-state
+// execution does not touch the heap: both the buffer and the shared_ptr
+// control block that owns it come from free lists. Buffers are charged to the
+// memory tracker current at allocate().
+class BufferPool {
+public:
+    static constexpr size_t kDefaultCachedBytes = size_t{64} << 20;
+
+    explicit BufferPool(size_t max_cached_bytes = kDefaultCachedBytes);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Process-wide pool used by the operators
+    static BufferPool& global();
+
+    PooledBuffer allocate(size_t bytes);
+
+    // Free buffers kept for reuse; 0 returns every buffer to the heap
+    void set_max_cached_bytes(size_t bytes);
+    // Returns every cached buffer to the heap
+    void trim();
+
+    struct Stats {
+        uint64_t allocations = 0;  // buffers taken from the heap
+        uint64_t reuses = 0;       // buffers taken from a free list
+        size_t cached_bytes = 0;
+    };
+    Stats stats() const;
+
+private:
+    // 64 B up to 1 GB; larger buffers bypass the pool
+    static constexpr size_t kMinClassBits = 6;
+    static constexpr size_t kClasses = 25;
+    // Control blocks are small; their free lists are bucketed by 16 bytes
+    static constexpr size_t kBlockGranule = 16;
+    static constexpr size_t kBlockClasses = 16;
+
+    struct FreeList {
+        std::mutex mutex;
+        std::vector<void*> entries;
+    };
+
+    struct Release;
+    template <typename T>
+    struct BlockAllocator;
+
+    void release(void* data, size_t size_class);
+    void* allocate_block(size_t bytes);
+    void deallocate_block(void* block, size_t bytes);
+    bool reserve_cache(size_t bytes);
+
+    std::array<FreeList, kClasses> buffers;
+    std::array<FreeList, kBlockClasses> blocks;
+    std::atomic<size_t> max_cached;
+    std::atomic<size_t> cached{0};
+    std::atomic<uint64_t> fresh{0};
+    std::atomic<uint64_t> reused{0};
+};
+
+} // namespace bosql
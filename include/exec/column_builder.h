@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <variant>
+#include "types.h"
+#include "exec/buffer_pool.h"
+#include "exec/execution_types.hpp"
+#include "exec/instrumentation.h"
+
+namespace bosql {
+
+// Physical value of a datum stored in a column of T. Numeric datums convert,
+// so an INT64 column takes a SUM computed as a double.
+template <typename T>
+T datum_as(const Datum& value);
+
+template <>
+inline int64_t datum_as<int64_t>(const Datum& value) {
+    return value.type == TypeId::DOUBLE ? static_cast<int64_t>(value.value.f64_val) : value.value.i64_val;
+}
+
+template <>
+inline double datum_as<double>(const Datum& value) {
+    return value.type == TypeId::DOUBLE ? value.value.f64_val : static_cast<double>(value.value.i64_val);
+}
+
+template <>
+inline uint32_t datum_as<uint32_t>(const Datum& value) {
+    return value.value.str_id;
+}
+
+template <>
+inline int32_t datum_as<int32_t>(const Datum& value) {
+    return value.type == TypeId::DATE32 ? value.value.date32_val : static_cast<int32_t>(value.value.i64_val);
+}
+
+// Builds one column of T in pooled storage. Room for the expected row count
+// is taken on first use and doubled when full; finish() hands the buffer to a
+// ColumnSlice without copying and leaves the builder empty.
+template <typename T>
+class TypedColumnBuilder {
+public:
+    using value_type = T;
+
+    explicit TypedColumnBuilder(size_t expected_rows = 0) : expected(expected_rows) {}
+
+    size_t size() const { return count; }
+
+    void reserve(size_t rows) {
+        if (rows > capacity()) grow(rows);
+    }
+
+    void append(T value) {
+        if (count == capacity()) grow(count + 1);
+        values()[count++] = value;
+    }
+
+    void append(std::span<const T> source) {
+        std::copy(source.begin(), source.end(), extend(source.size()));
+    }
+
+    // Appends source[i] for every index
+    void gather(const T* source, std::span<const size_t> indices) {
+        T* out = extend(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            out[i] = source[indices[i]];
+        }
+    }
+
+    // Room for `rows` more values, which the caller writes
+    T* extend(size_t rows) {
+        reserve(count + rows);
+        T* out = values() + count;
+        count += rows;
+        return out;
+    }
+
+    ColumnSlice finish(TypeId type = type_id_for<T>()) {
+        count_allocation(buffer.capacity);
+        ColumnSlice slice{buffer.data, type, count, std::move(buffer.owner)};
+        buffer = {};
+        count = 0;
+        return slice;
+    }
+
+private:
+    size_t capacity() const { return buffer.capacity / sizeof(T); }
+    T* values() { return static_cast<T*>(buffer.data); }
+
+    void grow(size_t rows) {
+        size_t wanted = std::max({rows, expected, capacity() * 2});
+        PooledBuffer grown = BufferPool::global().allocate(wanted * sizeof(T));
+        if (count > 0) {
+            std::memcpy(grown.data, buffer.data, count * sizeof(T));
+        }
+        buffer = std::move(grown);
+    }
+
+    size_t expected;
+    size_t count = 0;
+    PooledBuffer buffer;
+};
+
+// Builder for a column whose type is only known at run time. visit() resolves
+// the type once and passes the typed builder on, so per-row loops stay typed.
+class ColumnBuilder {
+public:
+    ColumnBuilder(TypeId type, size_t expected_rows);
+
+    TypeId type() const { return column_type; }
+    size_t size() const;
+
+    template <typename F>
+    decltype(auto) visit(F&& f) {
+        return std::visit(std::forward<F>(f), builder);
+    }
+
+    // Appends slice rows at `indices`; the slice has this builder's type.
+    // Encoded slices are decoded, so the result is always flat.
+    void gather(const ColumnSlice& slice, std::span<const size_t> indices);
+    void append(const ColumnSlice& slice, size_t offset, size_t rows);
+    void append(std::span<const Datum> values);
+
+    ColumnSlice finish();
+
+private:
+    TypeId column_type;
+    std::variant<TypedColumnBuilder<int64_t>,
+                 TypedColumnBuilder<double>,
+                 TypedColumnBuilder<uint32_t>,
+                 TypedColumnBuilder<int32_t>>
+        builder;
+};
+
+// Decodes every encoded column of the batch into a flat one
+void flatten(ExecBatch& batch);
+
+// Whether every one of `columns` is Constant or RLE
+bool runs_only(const ExecBatch& batch, std::span<const size_t> columns);
+
+// Rows of `batch` that start a new value in any of `columns`, which are all
+// Constant or RLE, followed by batch.length. Every row between two of them
+// reads the same values from those columns.
+void segment_starts(const ExecBatch& batch, std::span<const size_t> columns, std::vector<size_t>& starts);
+
+// Keeps the rows in the ascending, disjoint [begin, end) `ranges`. Constant
+// and RLE columns stay encoded; the others are copied flat.
+void select_ranges(ExecBatch& batch, std::span<const std::pair<size_t, size_t>> ranges);
+
+} // namespace bosql
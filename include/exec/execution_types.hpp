@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <span>
 #include <stdexcept>
@@ -8,11 +10,54 @@
 
 namespace bosql {
 
+// How a slice lays out its `length` rows. Only scans and the operators that
+// understand encoded input (Selection, HashAggregate) see anything but Flat;
+// everything else receives flattened batches.
+enum class VectorKind : uint8_t {
+    Flat,        // data holds one value per row
+    Constant,    // data holds one value for every row
+    Rle,         // data holds value_count runs; run_ends[i] is the row after run i
+    Dictionary,  // data holds value_count values; codes[row] picks one
+    Narrow,      // data holds one unsigned delta of `width` bytes per row
+};
+
 struct ColumnSlice {
     const void* data;
     TypeId type;
     size_t length;
     std::shared_ptr<void> owner;
+    VectorKind kind = VectorKind::Flat;
+    size_t value_count = 0;
+    const uint32_t* run_ends = nullptr;
+    const uint8_t* codes = nullptr;
+    // Narrow: every value is base + a delta of `width` bytes. Dictionaries
+    // over consecutive values set width 1 too, as their codes are deltas.
+    uint8_t width = 0;
+    int64_t base = 0;
+
+    bool flat() const { return kind == VectorKind::Flat; }
+
+    // Value at `row` of a Narrow slice: base + delta, in the column's type
+    int64_t narrow_value(size_t row) const {
+        switch (width) {
+            case 1: return base + static_cast<const uint8_t*>(data)[row];
+            case 2: return base + static_cast<const uint16_t*>(data)[row];
+            default: return base + static_cast<const uint32_t*>(data)[row];
+        }
+    }
+
+    // Index into `data` of the value at `row`; Narrow slices hold no values
+    size_t position(size_t row) const {
+        switch (kind) {
+            case VectorKind::Flat: return row;
+            case VectorKind::Constant: return 0;
+            case VectorKind::Rle:
+                return static_cast<size_t>(std::upper_bound(run_ends, run_ends + value_count, row) - run_ends);
+            case VectorKind::Dictionary: return codes[row];
+            case VectorKind::Narrow: return row;
+        }
+        return row;
+    }
 };
 
 struct ExecBatch {
@@ -25,6 +70,11 @@ struct ExecBatch {
     }
 };
 
+// Whether any column of the batch is encoded
+inline bool has_encoded_columns(const ExecBatch& batch) {
+    return std::any_of(batch.columns.begin(), batch.columns.end(), [](const ColumnSlice& slice) { return !slice.flat(); });
+}
+
 template<typename T>
 std::span<const T> get_col(const ExecBatch& batch, size_t i) {
     if (batch.columns[i].type != type_id_for<T>()) {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "types.h"
 #include "exec/execution_types.hpp"
@@ -31,4 +33,62 @@ bool evaluate_predicate(const Expr* expr,
                         size_t row,
                         const ExprBindings& bindings);
 
+// SQL LIKE: % matches any run of characters, _ any single one
+bool like_match(std::string_view text, std::string_view pattern);
+
+// Adds the batch columns `expr` reads to `columns`, each once
+void referenced_columns(const Expr* expr, const ExprBindings& bindings, std::vector<size_t>& columns);
+
+// The integer literals of an IN list, compiled once at bind time: a bitmap
+// when they span a small range, a sorted array scanned without branches when
+// there are few of them, otherwise an open-addressing hash set
+class IntSet {
+public:
+    enum class Layout { Bitmap, Sorted, Hash };
+
+    explicit IntSet(std::vector<int64_t> values);
+
+    Layout layout() const { return layout_; }
+    bool contains(int64_t value) const;
+
+private:
+    Layout layout_;
+    // Bitmap: bit i stands for low_ + i
+    int64_t low_ = 0;
+    uint64_t span_ = 0;
+    std::vector<uint64_t> bits_;
+    // Sorted: the values. Hash: the slots, where `first_` marks an empty
+    // slot, and so is tested before probing
+    std::vector<int64_t> values_;
+    int64_t first_ = 0;
+    unsigned shift_ = 0;
+};
+
+// `column <op> integer literal` (either way round) over an INT64 column, or
+// `column [NOT] IN (integer literals)`, where `set` holds the list and `op`
+// is EQ or NE
+struct ColumnComparison {
+    size_t column;
+    BinaryOp op;
+    int64_t value;
+    std::shared_ptr<const IntSet> set = nullptr;
+};
+
+// The comparisons `predicate` ANDs together; empty when any conjunct is
+// something else
+std::vector<ColumnComparison> match_comparisons(const Expr* predicate, const ExprBindings& bindings);
+
+// Rows [0, length) whose value in `slice` satisfies the comparison. The
+// slice is an INT64 column that is Flat, Narrow, or a Dictionary whose codes
+// are deltas (width 1). Deltas are compared at their own width once the
+// literal has been moved into their range; set lookups look each possible
+// 8-bit delta up once per batch.
+void select_comparison(const ColumnSlice& slice, const ColumnComparison& comparison, size_t length, std::vector<size_t>& rows);
+// Keeps the `rows` that satisfy it
+void refine_comparison(const ColumnSlice& slice, const ColumnComparison& comparison, std::vector<size_t>& rows);
+
+// Evaluation only looks string literals up (so it can run on many threads at
+// once); operators that emit literals add them to the dictionary at plan time
+void intern_string_literals(const Expr* expr, Dictionary* dictionary);
+
 }
@@ -3,45 +3,80 @@
 #include <cstddef>
 #include <iosfwd>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "types.h"
+#include "exec/execution_types.hpp"
 
 namespace bosql {
 
+class Dictionary;
+
+// Text of every cell of one batch column, formatted a column at a time
+struct FormattedColumn {
+    std::string text;
+    std::vector<size_t> ends;  // end offset of each cell in `text`
+
+    std::string_view cell(size_t row) const {
+        size_t begin = row == 0 ? 0 : ends[row - 1];
+        return std::string_view(text).substr(begin, ends[row] - begin);
+    }
+};
+
+// Appends the cells of `slice` to `column`. Numbers use the shortest text
+// that reads back to the same value; string ids are decoded through `dict`,
+// or printed as codes without one.
+void format_column(const ColumnSlice& slice, const Dictionary* dict, FormattedColumn& column);
+
+// Writes query results batch by batch. Output is collected in one large
+// buffer and written to the stream in big chunks.
 struct Formatter {
-    explicit Formatter(std::ostream& stream) : out(stream) {}
-    virtual ~Formatter() = default;
+    explicit Formatter(std::ostream& stream);
+    virtual ~Formatter();
     virtual void begin(const std::vector<std::string>& names, const std::vector<TypeId>& types) = 0;
-    virtual void write_row(std::vector<std::string> row) = 0;
+    virtual void write_batch(const ExecBatch& batch, const Dictionary* dict) = 0;
     virtual void end(std::size_t row_count) = 0;
 
+    static constexpr size_t kFlushBytes = size_t{1} << 20;
+
 protected:
+    void emit(std::string_view text) {
+        buffer.append(text);
+        if (buffer.size() >= kFlushBytes) flush();
+    }
+    void emit(char ch) { buffer.push_back(ch); }
+    // Formats every column of the batch into `columns`
+    void format_batch(const ExecBatch& batch, const Dictionary* dict);
+    void flush();
+
     std::ostream& out;
+    std::string buffer;
+    std::vector<FormattedColumn> columns;
 };
 
+// Keeps the formatted text until end(), since column widths depend on every row
 struct MarkdownFormatter final : Formatter {
     explicit MarkdownFormatter(std::ostream& stream);
     void begin(const std::vector<std::string>& names, const std::vector<TypeId>& types) override;
-    void write_row(std::vector<std::string> row) override;
+    void write_batch(const ExecBatch& batch, const Dictionary* dict) override;
     void end(std::size_t row_count) override;
 
 private:
     std::vector<std::string> headers;
-    std::vector<std::vector<std::string>> data;
+    std::vector<FormattedColumn> data;  // every row so far, by column
     std::vector<std::size_t> widths;
 };
 
 struct CsvFormatter final : Formatter {
     explicit CsvFormatter(std::ostream& stream, char delimiter = ',');
     void begin(const std::vector<std::string>& names, const std::vector<TypeId>& types) override;
-    void write_row(std::vector<std::string> row) override;
+    void write_batch(const ExecBatch& batch, const Dictionary* dict) override;
     void end(std::size_t row_count) override;
 
 private:
     char sep;
-    bool header_written = false;
-    std::vector<std::string> headers;
-    std::string escape_cell(const std::string& cell) const;
+    bool quote_numbers;  // the delimiter can occur in a formatted number
+    void emit_escaped(std::string_view cell);
 };
 
 } // namespace bosql
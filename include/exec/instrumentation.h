@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "exec/memory.h"
+#include "exec/operator.hpp"
+
+namespace bosql {
+
+// Records batch and state buffer bytes allocated by an operator. They are
+// charged to the instrumented operator currently running on this thread.
+void count_allocation(size_t bytes);
+
+struct OperatorProfile {
+    std::chrono::nanoseconds open_time{0};
+    std::chrono::nanoseconds next_time{0};
+    std::chrono::nanoseconds close_time{0};
+    size_t batches = 0;
+    size_t rows = 0;
+    size_t bytes_allocated = 0;  // by this operator alone
+    std::thread::id thread;      // that opened the operator
+
+    std::chrono::nanoseconds total_time() const { return open_time + next_time + close_time; }
+};
+
+// Transparent probe that times and counts every call into the wrapped operator
+struct InstrumentedOperator : public Operator {
+    InstrumentedOperator(std::unique_ptr<Operator> inner, double estimated_rows = -1.0);
+
+    void open() override;
+    bool next(ExecBatch& out) override;
+    void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
+    const MemoryTracker* memory_tracker() const override { return inner->memory_tracker(); }
+
+    const OperatorProfile& profile() const { return stats; }
+    double estimated_rows() const { return estimated; }
+
+private:
+    std::unique_ptr<Operator> inner;
+    double estimated;
+    OperatorProfile stats;
+};
+
+// Makes the wrapped operator's tracker current for every call into it, so its
+// batches, its state and the tasks it submits are charged to that tracker
+struct TrackedOperator : public Operator {
+    TrackedOperator(std::unique_ptr<Operator> inner, std::shared_ptr<MemoryTracker> tracker);
+
+    void open() override;
+    bool next(ExecBatch& out) override;
+    void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
+    const MemoryTracker* memory_tracker() const override { return tracker.get(); }
+
+private:
+    std::unique_ptr<Operator> inner;
+    std::shared_ptr<MemoryTracker> tracker;
+};
+
+// Run an instrumented plan to completion, discarding its output, and render
+// the operator tree with estimated vs. actual rows, time and allocations.
+// With a query tracker the summary also reports the query's peak memory.
+std::string explain_analyze(Operator& root, const MemoryTracker* query = nullptr);
+
+} // namespace bosql
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bosql {
+
+// Live bytes charged to one level of the process -> query -> operator
+// hierarchy. Charges propagate to every ancestor; a charge that would take
+// any of them past its limit throws and leaves all counters unchanged.
+class MemoryTracker : public std::enable_shared_from_this<MemoryTracker> {
+public:
+    // Root of the hierarchy; it lists live queries only
+    static const std::shared_ptr<MemoryTracker>& process();
+
+    // limit 0 means unlimited
+    static std::shared_ptr<MemoryTracker> create(std::string label,
+                                                 size_t limit = 0,
+                                                 std::shared_ptr<MemoryTracker> parent = process());
+    ~MemoryTracker();
+
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    void consume(size_t bytes);
+    void release(size_t bytes);
+
+    const std::string& label() const { return name; }
+    size_t current() const { return used.load(std::memory_order_relaxed); }
+    size_t peak() const { return high_water.load(std::memory_order_relaxed); }
+    size_t limit() const { return max_bytes.load(std::memory_order_relaxed); }
+    void set_limit(size_t bytes) { max_bytes.store(bytes, std::memory_order_relaxed); }
+
+    // Snapshot of this tracker and its children. Children that were already
+    // destroyed keep their final numbers, except under the process tracker.
+    struct Usage {
+        std::string label;
+        size_t current = 0;
+        size_t peak = 0;
+        size_t limit = 0;
+        std::vector<Usage> children;
+    };
+    Usage usage() const;
+
+private:
+    MemoryTracker(std::string label, size_t limit, std::shared_ptr<MemoryTracker> parent);
+
+    std::string name;
+    std::shared_ptr<MemoryTracker> parent;
+    std::atomic<size_t> used{0};
+    std::atomic<size_t> high_water{0};
+    std::atomic<size_t> max_bytes;
+
+    mutable std::mutex children_mutex;
+    std::vector<std::weak_ptr<MemoryTracker>> children;
+    std::vector<Usage> retired;
+};
+
+// Tracker that allocations on this thread are charged to, or null
+MemoryTracker* current_memory_tracker();
+
+// Makes `tracker` current on this thread until the scope ends
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryTracker* tracker);
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryTracker* saved;
+};
+
+// Bytes held against a tracker until resized or destroyed. Safe to grow from
+// several threads at once.
+class MemoryReservation {
+public:
+    // Binds to the current tracker; without one the reservation only counts
+    MemoryReservation();
+    explicit MemoryReservation(std::shared_ptr<MemoryTracker> tracker);
+    ~MemoryReservation();
+
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    void grow(size_t bytes);
+    void shrink(size_t bytes);
+    // Not safe to call concurrently with grow() or shrink()
+    void resize(size_t bytes);
+    size_t size() const { return reserved.load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<MemoryTracker> tracker;
+    std::atomic<size_t> reserved{0};
+};
+
+} // namespace bosql
@@ -4,10 +4,22 @@
 #include <memory>
 #include <iostream>
 #include <unordered_map>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <optional>
 #include "types.h"
 #include "exec/execution_types.hpp"
 #include "exec/expression.h"
 #include "exec/formatter.hpp"
+#include "exec/memory.h"
+#include "exec/parallel.h"
+#include "exec/row_arena.h"
+#include "exec/scheduler.h"
+#include "exec/spill.h"
 #include "storage/table.h"
 #include "parser/ast.h"
 
@@ -20,6 +32,12 @@ struct Operator {
     virtual bool next(ExecBatch& out) = 0;
     virtual void close() = 0;
 
+    // Introspection for EXPLAIN ANALYZE
+    virtual std::string label() const = 0;
+    virtual std::vector<const Operator*> children() const { return {}; }
+    // Tracker the operator's allocations are charged to, if it has its own
+    virtual const MemoryTracker* memory_tracker() const { return nullptr; }
+
     const std::vector<std::string>& output_names() const { return names_; }
     const std::vector<TypeId>& output_types() const { return types_; }
     Dictionary* dictionary() const { return dict_; }
@@ -31,30 +49,125 @@ protected:
 };
 
 struct ColumnarScan : public Operator {
-    ColumnarScan(Table* t, std::vector<size_t> idx, size_t batch = 4096);
+    // With a shared MorselQueue the scan only reads the row ranges it claims,
+    // so several clones can split one table between worker threads
+    // With `encoded` the scan passes RLE columns on as RLE or constant slices,
+    // 8-bit frame-of-reference columns as dictionary slices and 16- and
+    // 32-bit ones as narrow slices instead of decoding them; only operators
+    // that read encoded input may consume it.
+    ColumnarScan(Table* t,
+                 std::vector<size_t> idx,
+                 size_t batch = 4096,
+                 std::shared_ptr<MorselQueue> morsels = nullptr,
+                 bool encoded = false);
+
+    void open() override;
+    bool next(ExecBatch& out) override;
+    void close() override;
+    std::string label() const override;
+
+private:
+    Table* table;
+    std::vector<size_t> indices;
+    // The scanned columns, resolved
+    std::vector<const Column*> columns;
+    size_t offset;
+    size_t batch_size;
+    std::shared_ptr<MorselQueue> morsels;
+    size_t morsel_end = 0;
+
+    // How a scanned column is read without decoding it
+    struct EncodedSource {
+        const void* values = nullptr;      // run values, or the value of each code
+        const size_t* run_ends = nullptr;  // RLE
+        size_t runs = 0;
+        const uint8_t* codes = nullptr;    // 8-bit frame of reference
+        std::shared_ptr<void> owner;       // holds the code values
+        const void* deltas = nullptr;      // 16- or 32-bit frame of reference
+        uint8_t width = 0;
+        int64_t base = 0;
+    };
+    // By scanned column; empty unless the scan emits encoded slices
+    std::vector<EncodedSource> encoded_sources;
+    // Read since open, in stored bytes; added to the columns' ScanCounters
+    // on close
+    uint64_t scanned_rows = 0;
+    std::vector<uint64_t> scanned_bytes;
+};
+
+// Scan of an external table (LOAD TABLE ... AS EXTERNAL). Numeric and date
+// columns are parsed from the mapped file a batch at a time, reading only
+// the fields the query needs through the table's positional map. Columns
+// already cached, string columns, whose codes must be assigned before any
+// operator reads the dictionary, and columns read by more than
+// ExternalCsv::kInSituScans earlier queries are parsed into the table's
+// cached column at plan time and read from there. The output is always flat.
+struct RawCsvScan : public Operator {
+    RawCsvScan(Table* t, std::vector<size_t> idx, size_t batch = 4096, std::shared_ptr<MorselQueue> morsels = nullptr);
 
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
 
 private:
     Table* table;
+    ExternalCsv* external;
     std::vector<size_t> indices;
+    // By scanned column: the cached column, or nullptr to read the file
+    std::vector<const Column*> columns;
+    // Scanned columns read from the file
+    std::vector<size_t> in_situ;
     size_t offset;
     size_t batch_size;
+    std::shared_ptr<MorselQueue> morsels;
+    size_t morsel_end = 0;
+    uint64_t scanned_rows = 0;
+    std::vector<uint64_t> scanned_bytes;
 };
 
 struct Selection : public Operator {
-    Selection(std::unique_ptr<Operator> c, std::unique_ptr<Expr> pred);
+    // With `encoded` the output keeps the encoded columns of the input;
+    // otherwise it is always flat.
+    Selection(std::unique_ptr<Operator> c, std::unique_ptr<Expr> pred, bool encoded = false);
 
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
 
 private:
     std::unique_ptr<Operator> child;
     std::unique_ptr<Expr> predicate;
     ExprBindings bindings;
+    bool encoded_output;
+    // Batch columns the predicate reads
+    std::vector<size_t> predicate_columns;
+    // The predicate as comparisons the width kernels can run, if it is one
+    std::vector<ColumnComparison> comparisons;
+    // The only column a string predicate reads, else npos. Its outcome is
+    // remembered per dictionary code: 0 untested, 1 rejected, 2 kept.
+    size_t string_column = std::string::npos;
+    std::vector<uint8_t> string_matches;
+    // Reused across batches
+    ExecBatch input;
+    std::vector<size_t> selected;
+    std::vector<size_t> segments;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    // Outcome per code of the dictionary column last filtered, as in
+    // string_matches, and the code values it holds on to
+    std::vector<uint8_t> code_matches;
+    const void* code_values = nullptr;
+    std::shared_ptr<void> code_owner;
+
+    bool select_rows(const ExecBatch& in, ExecBatch& out);
+    bool compares_in_place(const ExecBatch& in) const;
+    bool select_compared(const ExecBatch& in, ExecBatch& out);
+    bool select_encoded(ExecBatch& in, ExecBatch& out);
+    bool strings_by_code(const ExecBatch& in) const;
+    bool select_strings(ExecBatch& in, ExecBatch& out);
+    bool emit_selected(const ExecBatch& in, ExecBatch& out);
 };
 
 struct Project : public Operator {
@@ -65,6 +178,8 @@ struct Project : public Operator {
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
 
 private:
     std::unique_ptr<Operator> child;
@@ -74,6 +189,161 @@ private:
     std::vector<std::string> input_names;
     std::vector<TypeId> input_types;
     std::vector<int> direct_indices;
+    // Reused across batches
+    ExecBatch input;
+};
+
+// Build side of a hash join. Probe-side clones of a parallel plan share one
+// instance: the first to open submits a task per build input, and every probe
+// waits on that task group (helping to drain it) before it starts probing.
+// The drained rows are then inserted into one pre-sized chained hash table by
+// morsel-sized tasks, which link rows in with a CAS on the bucket head.
+// If the drained rows outgrow spill.memory_limit, the build side instead
+// writes them to hash-partitioned files and the probes run a Grace join.
+struct JoinBuildSide {
+    JoinBuildSide(std::vector<std::unique_ptr<Operator>> inputs,
+                  std::vector<std::string> key_names,
+                  size_t expected_rows = 0,
+                  SpillConfig spill = {});
+    ~JoinBuildSide();
+
+    void build();
+
+    // Re-encodes the build side's strings in `target`, the probe side's
+    // dictionary, when the two differ. Every build-side string is looked up
+    // once; rows and keys are then translated as they are drained, so string
+    // keys compare as integer codes. If the build side emits string columns
+    // besides its keys, strings the probe side lacks get codes in a
+    // query-local overlay of `target`, which is left unchanged. Returns the
+    // dictionary the join's output codes refer to.
+    Dictionary* map_strings(Dictionary* target);
+
+    // After build(): true when the rows went to partition files, not the table
+    bool spilled() const { return spilling.load(std::memory_order_relaxed); }
+    // Approximate memory a build row takes in a hash table
+    size_t row_bytes() const;
+
+    struct Key {
+        std::vector<Datum> values;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct KeyEqual {
+        bool operator()(const Key& lhs, const Key& rhs) const;
+    };
+
+    // A spilled partition of the build rows, shared by the probe clones of a
+    // Grace join. The first clone to reach it loads it into a table, or
+    // splits it by the next hash bits when its rows exceed a probe's budget;
+    // the others wait for that and probe the same table. Every clone
+    // releases every partition once, whether it probed it or had no rows
+    // for it. The last release frees the table and any files the partition
+    // owns, leaving it ready to load again.
+    struct GracePartition {
+        std::vector<std::filesystem::path> build_files;
+        bool owns_files = false;
+        unsigned level = 0;
+
+        std::atomic<bool> prepared{false};
+        std::unordered_map<Key, std::vector<size_t>, KeyHash, KeyEqual> table;
+        std::vector<std::vector<Datum>> rows;
+        // Set when split: the sub-partitions, null where no rows fell
+        std::vector<std::shared_ptr<GracePartition>> split;
+
+        std::mutex mutex;
+        size_t releases = 0;
+        // Releases by clones without rows for the partition; they count for
+        // its sub-partitions too
+        size_t skips = 0;
+
+        ~GracePartition();
+    };
+
+    // After a spilled build(): level-0 partitions, null where no rows fell
+    const std::vector<std::shared_ptr<GracePartition>>& grace_partitions() const { return spilled_partitions; }
+    // Loads or splits `partition` unless a clone already has. Returns false
+    // without waiting when `wait` is false and another clone is at it.
+    bool prepare_grace(GracePartition& partition, bool wait = true);
+    // One clone is done with `partition`; `probed` is false when it had no
+    // probe rows for it
+    void release_grace(GracePartition& partition, bool probed);
+
+    std::vector<std::unique_ptr<Operator>> inputs;
+    std::vector<std::string> key_names;
+    std::vector<size_t> key_indices;
+    std::vector<TypeId> key_types;
+    std::vector<std::string> names;
+    std::vector<TypeId> types;
+    Dictionary* dict = nullptr;
+    size_t expected_rows;
+
+    static constexpr size_t kNoMatch = std::numeric_limits<size_t>::max();
+
+    // First build row whose key equals `key`, or kNoMatch
+    size_t find(const Key& key) const;
+    // Next build row after `row` whose key equals `key`, or kNoMatch
+    size_t next_match(size_t row, const Key& key) const;
+
+    std::vector<Key> keys;
+    std::vector<std::vector<Datum>> rows;
+
+    // The join that lists the build inputs as its children (EXPLAIN)
+    const Operator* owner = nullptr;
+
+    SpillConfig spill;
+    // Probe clones sharing this build side; they split the memory budget
+    size_t probes = 0;
+    SpillStats spill_stats;
+
+private:
+    struct Partial {
+        std::vector<Key> keys;
+        std::vector<std::vector<Datum>> rows;
+        size_t offset = 0;  // position of the first row in `rows`
+        std::unique_ptr<PartitionedSpill> overflow;
+    };
+
+    void drain(size_t input);
+    void translate_strings(std::vector<Datum>& values) const;
+    void spill_partial(Partial& partial);
+    void finish_spill();
+    void prepare_table();
+    void insert_range(size_t partial, size_t begin, size_t end);
+    void finish();
+    size_t bucket_of(size_t hash) const;
+    size_t scan_chain(size_t link, size_t hash, const Key& key) const;
+
+    std::mutex mutex;
+    bool started = false;
+    bool inserting = false;
+    bool built = false;
+    TaskGroup drain_tasks;
+    TaskGroup insert_tasks;
+    std::vector<Partial> partials;
+    // Probe-side code of every build-side code; empty when the sides share
+    // a dictionary
+    std::vector<StrId> string_codes;
+    // The probe dictionary mapped to, and the overlay of it holding build
+    // strings it lacks
+    Dictionary* mapped_target = nullptr;
+    std::unique_ptr<Dictionary> overlay;
+
+    // Bucket heads and chain links hold row + 1, so zeroed memory is an
+    // empty table. Chains list rows in insertion order for serial builds.
+    std::vector<std::atomic<size_t>> buckets;
+    std::vector<size_t> links;
+    std::vector<size_t> hashes;
+    unsigned bucket_shift = 63;
+
+    std::atomic<size_t> reserved_bytes{0};
+    std::atomic<bool> spilling{false};
+    // Buffered rows, then the table, charged to the tracker of the first probe to open
+    std::unique_ptr<MemoryReservation> table_memory;
+    std::vector<std::vector<std::filesystem::path>> spilled_files;
+    std::vector<std::shared_ptr<GracePartition>> spilled_partitions;
 };
 
 struct HashJoin : public Operator {
@@ -81,53 +351,74 @@ struct HashJoin : public Operator {
              std::unique_ptr<Operator> right,
              std::vector<std::string> left_keys,
              std::vector<std::string> right_keys,
+             std::unique_ptr<Expr> residual,
+             size_t expected_build_rows = 0);
+    HashJoin(std::unique_ptr<Operator> left,
+             std::shared_ptr<JoinBuildSide> build,
+             std::vector<std::string> left_keys,
              std::unique_ptr<Expr> residual);
 
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
+
+    // Build and probe partitions written to disk by the last execution
+    SpillStats spill_stats() const;
 
 private:
+    using Key = JoinBuildSide::Key;
+
+    // Grace join: the probe input is partitioned like the spilled build side
+    // and every partition pair is joined in memory, or split again by the
+    // next hash bits when its build rows still exceed a probe's budget. The
+    // build partitions are shared with the other probe clones.
+    struct GraceWork {
+        std::shared_ptr<JoinBuildSide::GracePartition> build;
+        std::filesystem::path probe_file;
+    };
+
+    bool next_grace(ExecBatch& out);
+    void partition_probe();
+    // Queues each probe file with its build partition; partitions this
+    // clone has no rows for are released
+    void queue_grace_work(const std::vector<std::shared_ptr<JoinBuildSide::GracePartition>>& builds,
+                          std::vector<std::filesystem::path> probe_paths);
+    void load_grace_partition();
+    void discard_grace_partitions();
+
     std::unique_ptr<Operator> left_child;
-    std::unique_ptr<Operator> right_child;
+    std::shared_ptr<JoinBuildSide> build_side;
     std::vector<std::string> left_key_names;
-    std::vector<std::string> right_key_names;
     std::unique_ptr<Expr> residual_filter;
     std::vector<size_t> left_key_indices;
-    std::vector<size_t> right_key_indices;
     std::vector<TypeId> left_key_types;
-    std::vector<TypeId> right_key_types;
     std::vector<std::string> left_names;
     std::vector<TypeId> left_types;
-    std::vector<std::string> right_names;
-    std::vector<TypeId> right_types;
     ExprBindings left_bindings;
-    ExprBindings right_bindings;
 
-    struct Key {
-        std::vector<Datum> values;
-    };
-
-    struct KeyHash {
-        size_t operator()(const Key& key) const;
-    };
-
-    struct KeyEqual {
-        bool operator()(const Key& lhs, const Key& rhs) const;
-    };
-
-    std::unordered_map<Key, std::vector<size_t>, KeyHash, KeyEqual> hash_table;
-    std::vector<std::vector<Datum>> build_rows;
     ExecBatch probe_batch;
     bool probe_batch_valid = false;
     size_t probe_row_index = 0;
-    std::vector<size_t> current_matches;
-    size_t match_index = 0;
-
-    Key build_key(const ExecBatch& batch,
-                  size_t row,
-                  const std::vector<size_t>& indices,
-                  const std::vector<TypeId>& key_types) const;
+    Key probe_key;
+    size_t current_match = JoinBuildSide::kNoMatch;
+    // Matches of the batch being built
+    std::vector<size_t> probe_rows;
+    std::vector<size_t> build_matches;
+
+    bool probe_partitioned = false;
+    // Opened on a spilled build side and not yet released its partitions
+    bool grace_pending = false;
+    std::vector<GraceWork> grace_work;
+    // The build partition being probed
+    std::shared_ptr<JoinBuildSide::GracePartition> grace_build;
+    std::unique_ptr<RunReader> grace_probe;
+    std::vector<Datum> grace_probe_row;
+    const std::vector<size_t>* grace_matches = nullptr;
+    size_t grace_match_index = 0;
+    std::vector<std::vector<Datum>> grace_output;  // by column
+    SpillStats probe_spill_stats;
 };
 
 struct AggregateSpec {
@@ -139,11 +430,29 @@ struct AggregateSpec {
 struct HashAggregate : public Operator {
     HashAggregate(std::unique_ptr<Operator> child,
                   std::vector<std::unique_ptr<Expr>> group_exprs,
-                  std::vector<AggregateSpec> aggregates);
+                  std::vector<AggregateSpec> aggregates,
+                  size_t expected_groups = 0);
+    // One input per worker. Each input pre-aggregates into a bounded local
+    // table that flushes groups into hash partitions (passing rows straight
+    // through when the table is not reducing them); every partition is then
+    // merged by one task and emitted on its own.
+    // Once the groups outgrow spill.memory_limit they are written out as
+    // partial aggregates, partitioned by key hash, and every partition is
+    // finished on its own after the input is consumed (Grace aggregation).
+    HashAggregate(std::vector<std::unique_ptr<Operator>> inputs,
+                  std::vector<std::unique_ptr<Expr>> group_exprs,
+                  std::vector<AggregateSpec> aggregates,
+                  size_t expected_groups = 0,
+                  SpillConfig spill = {});
 
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
+
+    // Partitions written to disk by the last execution
+    const SpillStats& spill_stats() const { return spilled_stats; }
 
 private:
     struct AggState {
@@ -151,27 +460,113 @@ private:
         int64_t count = 0;
     };
 
-    std::unique_ptr<Operator> child;
+    std::vector<std::unique_ptr<Operator>> inputs;
     std::vector<std::unique_ptr<Expr>> group_exprs;
     std::vector<AggregateSpec> aggregates;
+    size_t expected_groups;
     ExprBindings child_bindings;
+    // Batch columns the group keys and aggregate arguments read
+    std::vector<size_t> input_columns;
+    // With every group key and SUM/AVG argument a plain column reference,
+    // the column each one reads (npos for COUNT)
+    bool decodes_columns = false;
+    std::vector<size_t> key_columns;
+    std::vector<size_t> arg_columns;
+
+    // Groups stored flat: key_width key values, one AggState per aggregate
+    // and the key hash of every group, so a group needs no allocation of
+    // its own
+    struct GroupRows {
+        size_t key_width = 0;
+        size_t aggregates = 0;
+        std::vector<Datum> keys;
+        std::vector<AggState> states;
+        std::vector<size_t> hashes;
+
+        size_t size() const { return hashes.size(); }
+        const Datum* key(size_t group) const { return keys.data() + group * key_width; }
+        AggState* aggs(size_t group) { return states.data() + group * aggregates; }
+        const AggState* aggs(size_t group) const { return states.data() + group * aggregates; }
+        // Appends a group with zeroed states
+        size_t add(const Datum* key, size_t hash);
+        void clear();
+    };
+
+    // Hash table over GroupRows: open addressing with linear probing, at
+    // most half full. Slots hold group + 1, so zero is an empty slot.
+    class GroupTable {
+    public:
+        static constexpr size_t kNoGroup = std::numeric_limits<size_t>::max();
+
+        GroupTable(size_t key_width, size_t aggregates);
+
+        size_t find(const Datum* key, size_t hash) const;
+        size_t add(const Datum* key, size_t hash);
+        void reserve(size_t groups);
+        void clear();
+        size_t size() const { return groups.size(); }
+        size_t memory_bytes() const;
+
+        GroupRows groups;
+
+    private:
+        void insert_slot(size_t group);
+
+        std::vector<uint32_t> slots;
+    };
+
+    // Per input: groups flushed from the local table, by hash partition
+    using PartitionBuffers = std::vector<GroupRows>;
 
-    struct GroupKeyHash {
-        size_t operator()(const std::vector<Datum>& key) const;
+    // Spilled partial aggregates of one hash partition, from every input
+    struct SpilledPartition {
+        std::vector<std::filesystem::path> files;
+        unsigned level = 0;
     };
 
-    struct GroupKeyEqual {
-        bool operator()(const std::vector<Datum>& lhs, const std::vector<Datum>& rhs) const;
+    // Group keys and aggregate arguments of one batch, decoded a column at
+    // a time at the width the columns are stored in
+    struct DecodedBatch {
+        bool decoded = false;
+        std::vector<Datum> keys;                // a key per row
+        std::vector<std::vector<double>> args;  // per aggregate, a value per row
     };
 
-    std::unordered_map<std::vector<Datum>, std::vector<AggState>, GroupKeyHash, GroupKeyEqual> groups;
+    // Key of the segment starting at `row`, from `decoded` or evaluated
+    // into `scratch`
+    const Datum* segment_key(const ExecBatch& batch, size_t row, const DecodedBatch& decoded,
+                             std::vector<Datum>& scratch) const;
+    // Adds `rows` rows that all read what `row` reads
+    void accumulate(AggState* states, const ExecBatch& batch, size_t row, size_t rows, const DecodedBatch& decoded) const;
+    void row_segments(ExecBatch& batch, std::vector<size_t>& starts, DecodedBatch& decoded) const;
+    bool decode_batch(const ExecBatch& batch, DecodedBatch& decoded) const;
+    void consume(Operator& input, GroupTable& target, std::unique_ptr<PartitionedSpill>& overflow) const;
+    void pre_aggregate(Operator& input, PartitionBuffers& buffers, std::unique_ptr<PartitionedSpill>& overflow) const;
+    void aggregate_serial();
+    void aggregate_parallel();
+
+    size_t group_bytes() const;
+    size_t partial_columns() const { return group_exprs.size() + 2 * aggregates.size(); }
+    GroupRows empty_groups() const { return {group_exprs.size(), aggregates.size(), {}, {}, {}}; }
+    // Writes every group out as a partial aggregate row
+    void spill_groups(const GroupRows& groups, PartitionedSpill& spill) const;
+    void queue_spilled(std::vector<std::unique_ptr<PartitionedSpill>>& spills);
+    void load_spilled_partition();
+
     std::vector<TypeId> group_types;
     std::vector<TypeId> agg_types;
     bool results_ready = false;
     bool child_consumed = false;
+    // Finished groups, by partition, in emission order
+    std::vector<GroupRows> results;
+    size_t emit_partition = 0;
     size_t emit_index = 0;
-    std::vector<std::vector<Datum>> result_keys;
-    std::vector<std::vector<AggState>> result_aggs;
+
+    SpillConfig spill;
+    std::vector<SpilledPartition> spilled_partitions;
+    SpillStats spilled_stats;
+    // Buffered partial groups, then the finished ones
+    std::unique_ptr<MemoryReservation> state_memory;
 };
 
 struct OrderBy : public Operator {
@@ -182,23 +577,72 @@ struct OrderBy : public Operator {
 
     OrderBy(std::unique_ptr<Operator> child,
             std::vector<SortKey> sort_keys);
+    // One input per worker: each sorts its own run, then the runs are merged
+    // pairwise with every merge split into independent merge-path ranges.
+    // With `top_n` set each worker keeps only its best top_n rows in a heap
+    // and the output stops after top_n rows. Otherwise an input that holds
+    // more than its share of spill.memory_limit writes its sorted run to disk,
+    // and the output is a streaming merge of all runs.
+    OrderBy(std::vector<std::unique_ptr<Operator>> inputs,
+            std::vector<SortKey> sort_keys,
+            std::optional<size_t> top_n = std::nullopt,
+            SpillConfig spill = {});
 
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
+
+    // Runs written to disk by the last execution
+    const SpillStats& spill_stats() const { return spilled_stats; }
 
 private:
-    std::unique_ptr<Operator> child;
-    std::vector<SortKey> sort_keys;
-    ExprBindings bindings;
+    // Output values, then sort values, in a row of the input's RowArena
     struct SortedRow {
-        std::vector<Datum> values;
-        std::vector<Datum> sort_values;
+        Datum* cells = nullptr;
+    };
+    using Run = std::vector<SortedRow>;
+
+    // Compares sort values
+    bool before(const Datum* a, const Datum* b) const;
+    bool before(const SortedRow& a, const SortedRow& b) const {
+        return before(a.cells + types_.size(), b.cells + types_.size());
+    }
+    std::vector<Run> merge_pairs(std::vector<Run>& runs) const;
+
+    // A sorted run being merged: spilled to disk or still in memory
+    struct MergeSource {
+        std::unique_ptr<RunReader> reader;
+        Run run;
+        size_t position = 0;
+        SortedRow head;
+        std::vector<Datum> read_row;  // holds the head read from disk
     };
-    std::vector<SortedRow> rows;
+
+    Run sort_run(Operator& input, RowArena& arena, std::vector<MergeSource>& spilled, SpillStats& stats) const;
+    void spill_run(Run& run, RowArena& arena, std::vector<MergeSource>& spilled, SpillStats& stats) const;
+    bool advance(MergeSource& source);
+
+    std::vector<std::unique_ptr<Operator>> inputs;
+    std::vector<SortKey> sort_keys;
+    std::optional<size_t> top_n;
+    SpillConfig spill;
+    ExprBindings bindings;
+    // Per input, the rows of its run
+    std::vector<RowArena> arenas;
+    Run rows;
     size_t emit_index = 0;
     bool materialized = false;
     bool child_consumed = false;
+
+    // Streaming k-way merge, used once anything was spilled
+    std::vector<MergeSource> sources;
+    std::vector<size_t> merge_heap;
+    std::vector<std::vector<Datum>> merge_output;  // by column
+    SpillStats spilled_stats;
+    // Sorted rows held in memory
+    std::unique_ptr<MemoryReservation> state_memory;
 };
 
 struct Limit : public Operator {
@@ -207,6 +651,8 @@ struct Limit : public Operator {
     void open() override;
     bool next(ExecBatch& out) override;
     void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
 
 private:
     std::unique_ptr<Operator> child;
@@ -217,6 +663,34 @@ private:
     bool cache_valid = false;
 };
 
+// Exchange operator: runs each input pipeline as a scheduler task and merges
+// their batches into a single stream, in no particular order
+struct Gather : public Operator {
+    explicit Gather(std::vector<std::unique_ptr<Operator>> inputs, size_t queue_capacity = 0);
+    ~Gather() override;
+
+    void open() override;
+    bool next(ExecBatch& out) override;
+    void close() override;
+    std::string label() const override;
+    std::vector<const Operator*> children() const override;
+
+private:
+    void produce(Operator& input);
+    void stop();
+
+    std::vector<std::unique_ptr<Operator>> inputs;
+    size_t capacity;
+    TaskGroup producers;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<ExecBatch> queue;
+    size_t active = 0;
+    bool cancelled = false;
+    std::exception_ptr error;
+};
+
 // Execution driver
 void run_query(std::unique_ptr<Operator> root,
                const std::vector<std::string>& col_names,
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace bosql {
+
+// Rows handed to a worker per claim. Large enough to amortize the atomic and
+// keep scans sequential, small enough to balance the tail of a query.
+constexpr size_t kDefaultMorselRows = 16384;
+
+// Shared cursor over a table's rows; every clone of a parallel scan claims
+// its next morsel (row range) from here
+class MorselQueue {
+public:
+    explicit MorselQueue(size_t total_rows, size_t morsel_rows = kDefaultMorselRows);
+
+    // Claims the next unprocessed range [begin, end); false once exhausted
+    bool next(size_t& begin, size_t& end);
+    void reset() { cursor.store(0, std::memory_order_relaxed); }
+    size_t total_rows() const { return total; }
+
+private:
+    std::atomic<size_t> cursor{0};
+    size_t total;
+    size_t morsel;
+};
+
+// Runs fn(0) .. fn(n - 1) as tasks on the global Scheduler and waits for all
+// of them, helping while it waits. The first exception thrown by any task is
+// rethrown on the calling thread.
+void run_parallel(size_t n, const std::function<void(size_t)>& fn);
+
+} // namespace bosql
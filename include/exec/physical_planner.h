@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
 #include "logical/logical.h"
 #include "catalog/catalog.h"
@@ -7,7 +8,23 @@
 
 namespace bosql {
 
+struct PhysicalPlanOptions {
+    // Wrap every operator in an InstrumentedOperator (EXPLAIN ANALYZE)
+    bool instrument = false;
+    // Worker threads per query; above 1, scans split their table into
+    // morsels and each worker runs its own clone of the pipeline
+    size_t threads = 1;
+    // Per-operator memory budget in bytes (0 = unlimited); sorts that exceed
+    // it write sorted runs to spill_directory (empty = system temp directory)
+    size_t memory_limit = 0;
+    std::filesystem::path spill_directory;
+    // Query memory tracker; when set, every operator gets a child tracker
+    std::shared_ptr<MemoryTracker> memory;
+};
+
 // Direct mapping from logical to physical operators
-std::unique_ptr<Operator> build_physical_plan(const LogicalOp* logical, const Catalog& catalog);
+std::unique_ptr<Operator> build_physical_plan(const LogicalOp* logical,
+                                              const Catalog& catalog,
+                                              const PhysicalPlanOptions& options = {});
 
 } // namespace bosql
\ No newline at end of file
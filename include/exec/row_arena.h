@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "types.h"
+
+namespace bosql {
+
+// Fixed-width rows of Datums carved out of large blocks, so an operator that
+// holds many rows allocates once per block instead of once per row. Rows
+// never move; clear() keeps the blocks for the next rows.
+class RowArena {
+public:
+    static constexpr size_t kBlockRows = 4096;
+
+    explicit RowArena(size_t width = 0) : width_(std::max<size_t>(width, 1)) {}
+
+    Datum* allocate() {
+        if (used_ == kBlockRows || blocks_.empty()) {
+            if (used_ == kBlockRows) ++block_;
+            if (block_ == blocks_.size()) {
+                blocks_.push_back(std::make_unique_for_overwrite<Datum[]>(kBlockRows * width_));
+            }
+            used_ = 0;
+        }
+        return blocks_[block_].get() + width_ * used_++;
+    }
+
+    void clear() {
+        block_ = 0;
+        used_ = 0;
+    }
+
+    size_t memory_bytes() const { return blocks_.size() * kBlockRows * width_ * sizeof(Datum); }
+
+private:
+    size_t width_;
+    std::vector<std::unique_ptr<Datum[]>> blocks_;
+    size_t block_ = 0;
+    size_t used_ = 0;
+};
+
+} // namespace bosql
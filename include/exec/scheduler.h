@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "exec/memory.h"
+
+namespace bosql {
+
+// A set of tasks that can be awaited together. Waiting on a group is how one
+// pipeline depends on another: e.g. join probes wait for the build group.
+class TaskGroup {
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class Scheduler;
+    std::atomic<size_t> pending{0};  // submitted, not yet finished
+    std::atomic<size_t> queued{0};   // submitted, not yet started
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+// Work-stealing task scheduler shared by all queries. Each worker owns a
+// deque: it pushes and pops its own tasks at the back and steals from the
+// front of the others' when it runs dry. Threads that wait on a group help
+// by running that group's queued tasks instead of blocking. Tasks charge
+// their allocations to the memory tracker that was current at submit().
+class Scheduler {
+public:
+    // 0 workers means one per hardware thread
+    explicit Scheduler(size_t workers = 0);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Process-wide instance used by the execution engine
+    static Scheduler& global();
+
+    size_t worker_count() const { return workers.size(); }
+
+    void submit(TaskGroup& group, std::function<void()> fn);
+
+    // Returns once every task of the group has finished, rethrowing the first
+    // exception one of them threw
+    void wait(TaskGroup& group);
+
+    struct WorkerStats {
+        uint64_t tasks = 0;
+        uint64_t steals = 0;
+        std::chrono::nanoseconds busy{0};
+    };
+    std::vector<WorkerStats> stats() const;
+    void reset_stats();
+
+private:
+    struct Task {
+        TaskGroup* group = nullptr;
+        std::function<void()> fn;
+        std::shared_ptr<MemoryTracker> memory;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<int64_t> busy_ns{0};
+    };
+
+    void worker_loop(size_t index);
+    // Takes a task of `only` (any group when null): own deque first, then the
+    // submission queue, then the other workers' deques
+    bool find_task(Task& task, TaskGroup* only);
+    void run(Task& task);
+    int worker_index() const;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    // Tasks submitted from threads that are not workers of this scheduler
+    std::mutex injection_mutex;
+    std::deque<Task> injection;
+
+    std::mutex sleep_mutex;
+    std::condition_variable work_available;
+    std::condition_variable group_changed;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+};
+
+} // namespace bosql
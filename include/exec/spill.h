@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "types.h"
+#include "exec/scheduler.h"
+
+namespace bosql {
+
+// Where and when operators write intermediate data to disk
+struct SpillConfig {
+    // Bytes an operator may hold before spilling; 0 means unlimited
+    size_t memory_limit = 0;
+    // Empty means the system temp directory
+    std::filesystem::path directory;
+};
+
+struct SpillStats {
+    size_t runs = 0;
+    size_t rows = 0;
+    size_t bytes = 0;
+};
+
+// Rows written to a spill file per block
+constexpr size_t kSpillBlockRows = 4096;
+
+// Writes rows of `columns` values to a new temp file. Blocks are stored
+// column by column: a row count, then per column a type tag followed by the
+// fixed-width values.
+class RunWriter {
+public:
+    RunWriter(const SpillConfig& config, size_t columns);
+    // Removes the file unless finish() was called
+    ~RunWriter();
+
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+
+    void append(const std::vector<Datum>& row);
+    // Flushes the last block; returns the file path
+    std::filesystem::path finish();
+
+    size_t rows_written() const { return rows; }
+    size_t bytes_written() const { return bytes; }
+
+private:
+    void flush_block();
+
+    std::filesystem::path path;
+    std::ofstream out;
+    size_t columns;
+    std::vector<std::vector<Datum>> block;
+    size_t rows = 0;
+    size_t bytes = 0;
+    bool finished = false;
+};
+
+// Streams a run back and, if it owns the file, deletes it when destroyed.
+// While the caller consumes one block the next is read on the scheduler.
+class RunReader {
+public:
+    RunReader(std::filesystem::path path, size_t columns, bool owns_file = true);
+    ~RunReader();
+
+    RunReader(const RunReader&) = delete;
+    RunReader& operator=(const RunReader&) = delete;
+
+    bool next(std::vector<Datum>& row);
+
+private:
+    using Block = std::vector<std::vector<Datum>>;  // column major
+
+    std::optional<Block> read_block();
+    void prefetch();
+
+    std::filesystem::path path;
+    std::ifstream in;
+    size_t columns;
+    Block current;
+    size_t position = 0;
+    size_t current_rows = 0;
+    std::optional<Block> pending;
+    TaskGroup read_ahead;
+    bool exhausted = false;
+    bool owns_file;
+};
+
+// Grace partitioning: rows go to one of kSpillPartitions files picked by
+// kSpillPartitionBits of their key hash; each recursive level uses the next
+// bits, until kMaxSpillLevel where partitions are processed in memory
+constexpr size_t kSpillPartitionBits = 4;
+constexpr size_t kSpillPartitions = size_t{1} << kSpillPartitionBits;
+constexpr unsigned kMaxSpillLevel = 8;
+
+size_t spill_partition(size_t hash, unsigned level);
+
+// One lazily created run file per partition
+class PartitionedSpill {
+public:
+    PartitionedSpill(SpillConfig config, size_t columns, unsigned level = 0);
+
+    void append(size_t hash, const std::vector<Datum>& row);
+    // Closes every file; entry p is empty when partition p received no rows
+    std::vector<std::filesystem::path> finish();
+
+    unsigned level() const { return spill_level; }
+    // Totals of the files written, valid after finish()
+    const SpillStats& stats() const { return totals; }
+
+private:
+    SpillConfig config;
+    size_t columns;
+    unsigned spill_level;
+    std::vector<std::unique_ptr<RunWriter>> writers;
+    SpillStats totals;
+};
+
+// Removes spill files, ignoring the ones that are already gone
+void remove_spill_files(const std::vector<std::filesystem::path>& paths);
+
+} // namespace bosql
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "parser/ast.h"
+#include "logical/logical.h"
+#include "catalog/catalog.h"
+#include "storage/dictionary.h"
+
+namespace bosql {
+
+// Fraction of rows in `meta` expected to satisfy `predicate`, in [0, 1].
+// Uses MCV lists and equi-depth histograms once the table has been ANALYZEd,
+// and falls back to min/max interpolation and 1/NDV otherwise.
+double estimate_selectivity(const Expr* predicate,
+                            const TableMeta& meta,
+                            const Dictionary* dict = nullptr);
+
+// Fill LogicalOp::estimated_rows for every node of the plan, bottom-up
+void annotate_cardinality(LogicalOp* plan, const Catalog& catalog);
+
+} // namespace bosql
@@ -22,10 +22,15 @@ enum class LogicalOpType {
 struct LogicalOp {
     LogicalOpType type;
     std::vector<std::unique_ptr<LogicalOp>> children;
+    double estimated_rows = -1.0; // set by annotate_cardinality, negative when unknown
 
     LogicalOp(LogicalOpType t) : type(t) {}
     virtual ~LogicalOp() = default;
     virtual std::string to_string(int indent = 0) const = 0;
+
+protected:
+    // " (est. rows: N)" once the plan has been annotated, empty otherwise
+    std::string estimate_suffix() const;
 };
 
 // Read a base table
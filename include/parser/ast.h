@@ -15,14 +15,16 @@ enum class ExprType {
     LITERAL_DOUBLE,
     LITERAL_STRING,
     BINARY_OP,
-    FUNC_CALL
+    FUNC_CALL,
+    IN_LIST     // left IN (args); op is NE for NOT IN
 };
 
 // Binary operators
 enum class BinaryOp {
     EQ, NE, LT, LE, GT, GE,
     ADD, SUB, MUL, DIV,
-    AND, OR
+    AND, OR,
+    LIKE, NOT_LIKE  // right is the pattern literal; % and _ are wildcards
 };
 
 // Base expression node
@@ -9,7 +9,7 @@ namespace bosql {
 enum class TokenType {
     SELECT = 0, FROM, WHERE, INNER, JOIN, ON, GROUP, BY, HAVING, ORDER, ASC, DESC, LIMIT,
     IDENTIFIER, NUMBER, STRING_LITERAL, COMMA, LPAREN, RPAREN, EQ, NE, LT, LE, GT, GE, PLUS, MINUS, MUL, DIV,
-    SUM, COUNT, AVG, AS, AND, OR,
+    SUM, COUNT, AVG, AS, AND, OR, NOT, LIKE, IN,
     END
 };
 
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "types.h"
+
+namespace bosql {
+
+// Encoded column layouts. They hold no contiguous values (values() is
+// nullptr); readers call decode(), which ColumnarScan does one batch at a
+// time into pooled buffers.
+
+// Frame of reference with fixed-width deltas: value = base + delta. Used for
+// integer and date columns whose range fits in 8, 16 or 32 bits, and for
+// dictionary codes narrowed to 8 or 16 bits.
+template <typename T, typename Narrow>
+struct NarrowColumn : Column {
+    T base;
+    std::vector<Narrow> deltas;
+
+    TypeId type() const override { return type_id_for<T>(); }
+    size_t size() const override { return deltas.size(); }
+    const void* values() const override { return nullptr; }
+    void decode(size_t offset, size_t count, void* out) const override;
+    const char* encoding() const override;
+    size_t memory_bytes() const override { return deltas.size() * sizeof(Narrow); }
+};
+
+// Frame of reference with deltas bit-packed at `bits` bits each. Values are
+// packed in blocks of 256 as four interleaved lanes: value i of a block goes
+// to lane i % 4, which packs its 64 values into every fourth word. Block k
+// starts at word k * 4 * bits and unpacks with a kernel specialized for the
+// width that shifts and masks all four lanes with one vector operation.
+template <typename T>
+struct BitPackedColumn : Column {
+    static constexpr size_t kLanes = 4;
+    static constexpr size_t kBlockValues = 64 * kLanes;
+
+    T base;
+    unsigned bits = 0;
+    size_t length = 0;
+    std::vector<uint64_t> words;
+
+    TypeId type() const override { return type_id_for<T>(); }
+    size_t size() const override { return length; }
+    const void* values() const override { return nullptr; }
+    void decode(size_t offset, size_t count, void* out) const override;
+    const char* encoding() const override { return "bitpacked"; }
+    size_t memory_bytes() const override { return words.size() * sizeof(uint64_t); }
+};
+
+// Run-length encoding: run i covers rows [run_ends[i - 1], run_ends[i]).
+template <typename T>
+struct RleColumn : Column {
+    std::vector<T> run_values;
+    std::vector<size_t> run_ends;
+
+    TypeId type() const override { return type_id_for<T>(); }
+    size_t size() const override { return run_ends.empty() ? 0 : run_ends.back(); }
+    const void* values() const override { return nullptr; }
+    void decode(size_t offset, size_t count, void* out) const override;
+    const char* encoding() const override { return "rle"; }
+    size_t memory_bytes() const override { return run_values.size() * (sizeof(T) + sizeof(size_t)); }
+
+    // Index of the run holding `row`
+    size_t find_run(size_t row) const;
+};
+
+// Re-encodes a plain column in the smallest layout that saves at least a
+// quarter of its bytes, or returns it unchanged. Integer, date and string
+// columns consider every layout; DOUBLE columns only RLE.
+std::unique_ptr<Column> compress_column(std::unique_ptr<Column> column);
+
+} // namespace bosql
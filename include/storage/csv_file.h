@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "types.h"
+#include "storage/dictionary.h"
+#include "storage/mapped_file.h"
+
+namespace bosql {
+
+// A CSV file mapped into memory. One pass over it at open finds the byte
+// offset where every chunk of kChunkRows data rows starts, so chunks can be
+// parsed independently, and in parallel, later. Rows follow load_csv: fields
+// are separated by commas and empty lines are skipped.
+class CsvFile {
+public:
+    static constexpr size_t kChunkRows = 16384;
+
+    explicit CsvFile(const std::string& filename);
+
+    const std::string& path() const { return path_; }
+    const std::vector<std::string>& headers() const { return headers_; }
+    size_t rows() const { return rows_; }
+    size_t chunks() const { return chunk_offsets_.size(); }
+    // The whole file
+    std::string_view text() const { return std::string_view(file_->data, file_->size); }
+    // The header and up to `rows` data lines, as they appear in the file
+    std::string_view head(size_t rows) const;
+
+    // Calls fn(row, line) for every data line of `chunk`, in order
+    template <typename Fn>
+    void for_each_line(size_t chunk, Fn&& fn) const {
+        const char* at = file_->data + chunk_offsets_[chunk];
+        const char* end = file_->data + (chunk + 1 < chunks() ? chunk_offsets_[chunk + 1] : file_->size);
+        size_t row = chunk * kChunkRows;
+        while (at < end) {
+            const char* newline = static_cast<const char*>(std::memchr(at, '\n', static_cast<size_t>(end - at)));
+            const char* line_end = newline ? newline : end;
+            if (line_end != at) fn(row++, std::string_view(at, static_cast<size_t>(line_end - at)));
+            at = line_end + 1;
+        }
+    }
+
+private:
+    std::string path_;
+    std::shared_ptr<MappedFile> file_;
+    std::vector<std::string> headers_;
+    // Byte offset of the first line of each chunk
+    std::vector<size_t> chunk_offsets_;
+    size_t rows_ = 0;
+};
+
+// Field `index` of a comma-separated line; throws when the line has fewer
+std::string_view csv_field(std::string_view line, size_t index);
+
+// Column of a CSV file that is parsed, a chunk per task, the first time it
+// is resolved, then compressed as load_csv would. Its type was inferred from
+// a sample; a value that does not parse as that type fails the load.
+class LazyCsvColumn : public Column {
+public:
+    LazyCsvColumn(std::shared_ptr<const CsvFile> file, size_t index, TypeId type, std::shared_ptr<Dictionary> dictionary);
+
+    TypeId type() const override { return type_; }
+    size_t size() const override { return file_->rows(); }
+    const void* values() const override { return resolve().values(); }
+    void decode(size_t offset, size_t count, void* out) const override { resolve().decode(offset, count, out); }
+    // "lazy" and no bytes until loaded
+    const char* encoding() const override;
+    size_t memory_bytes() const override;
+    const Column& resolve() const override;
+
+    bool loaded() const { return loaded_.load(std::memory_order_acquire) != nullptr; }
+
+private:
+    std::unique_ptr<Column> parse() const;
+
+    std::shared_ptr<const CsvFile> file_;
+    size_t index_;
+    TypeId type_;
+    std::shared_ptr<Dictionary> dictionary_;
+    mutable std::once_flag once_;
+    mutable std::unique_ptr<Column> column_;
+    mutable std::atomic<const Column*> loaded_{nullptr};
+};
+
+// Positional map of a CSV file queried in place (LOAD TABLE ... AS
+// EXTERNAL). It records where every data row starts and, for each column a
+// scan has read, where the column's field starts within the row. A chunk is
+// mapped by the first scan that reaches it, for the columns that scan reads,
+// so later scans jump straight to their fields; a column missing from the
+// map is found by counting commas from the nearest mapped column to its left.
+class ExternalCsv {
+public:
+    // Queries that read a column in place before it is parsed into the
+    // table's cached column (see RawCsvScan)
+    static constexpr uint32_t kInSituScans = 2;
+
+    explicit ExternalCsv(std::shared_ptr<const CsvFile> file);
+
+    const CsvFile& file() const { return *file_; }
+    // Counts a query reading `columns`
+    void note_scan(const std::vector<size_t>& columns);
+    // Queries counted for `column`
+    uint32_t scans(size_t column) const { return scans_[column].load(std::memory_order_relaxed); }
+
+    // Maps the chunks holding rows [offset, offset + count) for `columns`
+    void map(size_t offset, size_t count, const std::vector<size_t>& columns);
+    // Parses rows [offset, offset + count) of a mapped INT64, DOUBLE or
+    // DATE32 column into `out`; returns the bytes of text read
+    size_t read(size_t column, TypeId type, size_t offset, size_t count, void* out) const;
+    // Memory held by the map
+    size_t memory_bytes() const;
+
+private:
+    bool mapped(size_t chunk, size_t column) const {
+        return fields_mapped_[column * file_->chunks() + chunk].load(std::memory_order_acquire);
+    }
+    void map_chunk(size_t chunk, std::vector<size_t> columns);
+
+    std::shared_ptr<const CsvFile> file_;
+    // Byte offset of each row; sized by the first scan
+    std::vector<uint64_t> row_starts_;
+    // By column: offset of the field from the start of each row; sized by
+    // the first scan that reads the column
+    std::vector<std::vector<uint32_t>> field_starts_;
+    std::once_flag rows_sized_;
+    std::unique_ptr<std::once_flag[]> fields_sized_;
+    // By chunk, and by column then chunk: parts of the map that are built
+    std::unique_ptr<std::atomic<bool>[]> rows_mapped_;
+    std::unique_ptr<std::atomic<bool>[]> fields_mapped_;
+    std::unique_ptr<std::mutex[]> chunk_locks_;
+    std::unique_ptr<std::atomic<uint32_t>[]> scans_;
+};
+
+} // namespace bosql
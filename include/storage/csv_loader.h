@@ -7,15 +7,30 @@
 #include <stdexcept>
 #include <algorithm>
 #include <limits>
+#include <memory>
 #include <utility>
-#include <set>
 #include "types.h"
 #include "storage/table.h"
 #include "catalog/catalog.h"
 
 namespace bosql {
 
-std::pair<Table, TableMeta> load_csv(const std::string& filename);
-std::pair<Table, TableMeta> load_csv(std::istream& stream);
+// Strings are encoded with `dictionary` when one is given, so tables loaded
+// with the same dictionary share codes; otherwise each table gets its own.
+std::pair<Table, TableMeta> load_csv(const std::string& filename, std::shared_ptr<Dictionary> dictionary = nullptr);
+std::pair<Table, TableMeta> load_csv(std::istream& stream, std::shared_ptr<Dictionary> dictionary = nullptr);
+
+// Data rows load_csv_lazy infers types and statistics from
+constexpr size_t kLazySampleRows = 1000;
+
+// Maps the file and indexes its rows instead of parsing it. Column types and
+// statistics come from the first kLazySampleRows rows; each column is parsed
+// the first time a scan resolves it (see LazyCsvColumn).
+std::pair<Table, TableMeta> load_csv_lazy(const std::string& filename, std::shared_ptr<Dictionary> dictionary = nullptr);
+
+// Registers a CSV file to be queried in place: like load_csv_lazy, but scans
+// read the file through a positional map until a column has been read often
+// enough to be worth parsing (see ExternalCsv).
+std::pair<Table, TableMeta> load_csv_external(const std::string& filename, std::shared_ptr<Dictionary> dictionary = nullptr);
 
 } // namespace bosql
\ No newline at end of file
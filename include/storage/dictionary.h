@@ -1,19 +1,71 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <limits>
+#include <optional>
 #include "types.h"
 
 namespace bosql {
 
-// Dictionary for encoding strings to IDs and vice versa
+// Code that no dictionary entry ever receives
+inline constexpr StrId kInvalidStrId = std::numeric_limits<StrId>::max();
+
+// Dictionary for encoding strings to IDs and vice versa. Lookups go through
+// a hash index over the entries. An overlay extends a base dictionary for
+// one query: base codes read through, and strings added to the overlay get
+// codes after them, so the base is never modified.
 class Dictionary {
 public:
+    Dictionary() = default;
+    explicit Dictionary(const Dictionary* base);
+    // Serves the first `count` codes from external storage: entry i is
+    // chars[offsets[i], offsets[i + 1]). Nothing is copied, only the index is
+    // built; `owner` keeps the storage alive.
+    Dictionary(std::shared_ptr<const void> owner, const uint64_t* offsets, const char* chars, size_t count);
+
+    // Entries held here, for codes after the base's and the external ones;
+    // appending directly is allowed, lookups index such entries when they
+    // next add one
     std::vector<std::string> strings;
 
-    StrId get_or_add(const std::string& s);
-    const std::string& get(StrId id) const;
+    StrId get_or_add(std::string_view s);
+    // Valid until the entry's string moves, when strings grows
+    std::string_view get(StrId id) const;
+    // Lookup without inserting
+    std::optional<StrId> find(std::string_view s) const;
+    // Number of codes, including the base's
+    size_t size() const { return base_size_ + external_count_ + strings.size(); }
+    // Bytes held by the entries, including their string buffers and the
+    // index; an overlay does not count its base, nor any dictionary its
+    // external storage
+    size_t memory_bytes() const;
+
+private:
+    void index_entries();
+    void insert_slot(StrId own);
+    // Own entry `own`: external entries first, then strings
+    std::string_view entry(size_t own) const {
+        if (own < external_count_) {
+            return std::string_view(external_chars_ + external_offsets_[own], external_offsets_[own + 1] - external_offsets_[own]);
+        }
+        return strings[own - external_count_];
+    }
+    size_t own_count() const { return external_count_ + strings.size(); }
+
+    const Dictionary* base_ = nullptr;
+    size_t base_size_ = 0;
+    std::shared_ptr<const void> external_owner_;
+    const uint64_t* external_offsets_ = nullptr;
+    const char* external_chars_ = nullptr;
+    size_t external_count_ = 0;
+    // Open addressing over own entry positions; kInvalidStrId marks empty
+    std::vector<StrId> slots_;
+    // Own entries the index covers
+    size_t indexed_ = 0;
 };
 
-} // namespace bosql
\ No newline at end of file
+} // namespace bosql
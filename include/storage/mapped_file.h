@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+namespace bosql {
+
+// Read-only mapping of a whole file, unmapped with its last reference
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+};
+
+// Throws when the file cannot be opened or mapped; an empty file maps to
+// data == nullptr
+std::shared_ptr<MappedFile> map_file(const std::filesystem::path& path);
+
+} // namespace bosql
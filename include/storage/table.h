@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <variant>
@@ -10,10 +11,20 @@
 
 namespace bosql {
 
+class ExternalCsv;
+
+// What queries have read from a column since it was loaded. Scans add their
+// totals when they close, from any thread.
+struct ScanCounters {
+    std::atomic<uint64_t> rows{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
 // Represents a column in a table with name and data
 struct TableColumn {
     std::string name;
     std::unique_ptr<Column> data;
+    std::shared_ptr<ScanCounters> scans = std::make_shared<ScanCounters>();
 };
 
 // Represents a table with columns and a shared dictionary for strings
@@ -21,6 +32,9 @@ struct Table {
     std::string name;
     std::vector<TableColumn> columns;
     std::shared_ptr<Dictionary> dict;
+    // Set for tables queried in place from a CSV file; their columns are
+    // the cache the file's columns are parsed into (see RawCsvScan)
+    std::shared_ptr<ExternalCsv> external;
 
     // Helper to get column index by name
     size_t get_column_index(const std::string& col_name) const;
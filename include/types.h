@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -123,11 +125,64 @@ inline TypeId type_id_for<int32_t>() { return TypeId::DATE32; }
 template<>
 inline TypeId type_id_for<uint32_t>() { return TypeId::STRING; }
 
+// Physical width in bytes of one value of the given type
+inline size_t type_width(TypeId type) {
+    switch (type) {
+        case TypeId::INT64:
+        case TypeId::DOUBLE:
+            return 8;
+        case TypeId::STRING:
+        case TypeId::DATE32:
+            return 4;
+    }
+    return 0;
+}
+
+// Days since 1970-01-01 of a YYYYMMDD date, for formats that count days
+inline int32_t date32_to_days(Date32 date) {
+    int32_t year = date / 10000;
+    int32_t month = date / 100 % 100;
+    int32_t day = date % 100;
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    int32_t year_of_era = year - era * 400;
+    int32_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// Inverse of date32_to_days
+inline Date32 days_to_date32(int32_t days) {
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int32_t day_of_era = days - era * 146097;
+    int32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int32_t mp = (5 * day_of_year + 2) / 153;
+    int32_t day = day_of_year - (153 * mp + 2) / 5 + 1;
+    int32_t month = mp < 10 ? mp + 3 : mp - 9;
+    int32_t year = year_of_era + era * 400 + (month <= 2);
+    return year * 10000 + month * 100 + day;
+}
+
 // Base class
 struct Column {
     virtual ~Column() {}
     virtual TypeId type() const = 0;
     virtual size_t size() const = 0;
+    // Contiguous fixed-width values, size() of them; nullptr when encoded
+    virtual const void* values() const = 0;
+    // Writes values [offset, offset + count) to `out` in their logical type
+    virtual void decode(size_t offset, size_t count, void* out) const {
+        size_t width = type_width(type());
+        std::memcpy(out, static_cast<const char*>(values()) + offset * width, count * width);
+    }
+    // Storage layout, and the bytes it holds
+    virtual const char* encoding() const { return "plain"; }
+    virtual size_t memory_bytes() const { return size() * type_width(type()); }
+    // The column that holds the data: itself, or the loaded column of one
+    // that loads on first use
+    virtual const Column& resolve() const { return *this; }
 };
 
 // Typed column
@@ -142,8 +197,50 @@ struct ColumnVector : public Column {
     size_t size() const override { return data.size(); }
 
     void append(const T& v) { data.push_back(v); }
+    const void* values() const override { return data.data(); }
+};
+
+// Column over values that live elsewhere, e.g. in an imported Arrow array.
+// `owner` keeps that memory alive as long as the column.
+template<typename T>
+struct ColumnView : public Column {
+    const T* data;
+    size_t length;
+    std::shared_ptr<void> owner;
+
+    ColumnView(const T* values_in, size_t length_in, std::shared_ptr<void> owner_in)
+        : data(values_in), length(length_in), owner(std::move(owner_in)) {}
+
+    TypeId type() const override { return type_id_for<T>(); }
+    size_t size() const override { return length; }
+    const void* values() const override { return data; }
 };
 
+// Typed values of a column that stores them contiguously
+template<typename T>
+std::span<const T> column_values(const Column& column) {
+    if (column.type() != type_id_for<T>()) {
+        throw std::runtime_error("Type mismatch");
+    }
+    if (!column.values()) {
+        throw std::runtime_error("Column is encoded");
+    }
+    return {static_cast<const T*>(column.values()), column.size()};
+}
+
+// Typed values of any column: in place when stored contiguously, otherwise
+// decoded into `scratch`
+template<typename T>
+std::span<const T> column_values(const Column& column, std::vector<T>& scratch) {
+    if (column.values()) return column_values<T>(column);
+    if (column.type() != type_id_for<T>()) {
+        throw std::runtime_error("Type mismatch");
+    }
+    scratch.resize(column.size());
+    column.decode(0, column.size(), scratch.data());
+    return scratch;
+}
+
 // RecordBatch abstraction
 struct RecordBatch {
     std::vector<ColumnType> schema;
@@ -1,4 +1,6 @@
 #include "catalog/catalog.h"
+#include "storage/csv_file.h"
+#include <algorithm>
 
 namespace bosql {
 
@@ -17,6 +19,13 @@ OptionalRef<const TableMeta> Catalog::get_table_meta(const std::string& name) co
     return it != tables_.end() ? OptionalRef<const TableMeta>(it->second.second) : OptionalRef<const TableMeta>();
 }
 
+bool Catalog::update_table_meta(TableMeta&& table_meta) {
+    auto it = tables_.find(table_meta.name);
+    if (it == tables_.end()) return false;
+    it->second.second = std::move(table_meta);
+    return true;
+}
+
 std::vector<std::string> Catalog::list_tables() const {
     std::vector<std::string> names;
     names.reserve(tables_.size());
@@ -26,4 +35,42 @@ std::vector<std::string> Catalog::list_tables() const {
     return names;
 }
 
+std::vector<TableStorage> storage_report(const Catalog& catalog, const std::string& table) {
+    std::vector<std::string> names = table.empty() ? catalog.list_tables() : std::vector<std::string>{table};
+    std::sort(names.begin(), names.end());
+    std::vector<TableStorage> report;
+    for (const auto& name : names) {
+        auto data = catalog.get_table_data(name);
+        auto meta = catalog.get_table_meta(name);
+        if (!data.has_value() || !meta.has_value()) continue;
+        TableStorage storage;
+        storage.name = name;
+        storage.rows = meta->row_count;
+        storage.dictionary = data->dict.get();
+        if (storage.dictionary) {
+            storage.dictionary_entries = storage.dictionary->size();
+            storage.dictionary_bytes = storage.dictionary->memory_bytes();
+        }
+        if (data->external) storage.map_bytes = data->external->memory_bytes();
+        for (const auto& column : data->columns) {
+            ColumnStorage entry;
+            entry.name = column.name;
+            entry.type = column.data->type();
+            entry.encoding = column.data->encoding();
+            entry.rows = column.data->size();
+            entry.bytes = column.data->memory_bytes();
+            for (const auto& col_meta : meta->columns) {
+                if (col_meta.name != column.name) continue;
+                entry.stats_bytes = col_meta.stats.mcvs.size() * sizeof(MostCommonValue) +
+                                    col_meta.stats.histogram.bounds.size() * sizeof(f64);
+            }
+            entry.scanned_rows = column.scans->rows.load(std::memory_order_relaxed);
+            entry.scanned_bytes = column.scans->bytes.load(std::memory_order_relaxed);
+            storage.columns.push_back(std::move(entry));
+        }
+        report.push_back(std::move(storage));
+    }
+    return report;
+}
+
 } // namespace bosql
\ No newline at end of file
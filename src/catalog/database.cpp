@@ -0,0 +1,473 @@
+#include "catalog/database.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <fmt/core.h>
+#include "storage/compression.h"
+#include "storage/mapped_file.h"
+
+namespace bosql {
+
+namespace {
+
+constexpr char kManifestMagic[8] = {'B', 'O', 'S', 'Q', 'L', 'D', 'B', '1'};
+constexpr char kColumnMagic[8] = {'B', 'O', 'S', 'Q', 'L', 'C', 'O', 'L'};
+constexpr char kDictionaryMagic[8] = {'B', 'O', 'S', 'Q', 'L', 'D', 'I', 'C'};
+constexpr uint32_t kFormatVersion = 4;
+// Values start here, keeping them aligned for every column type
+constexpr size_t kColumnHeaderBytes = 64;
+// Smallest manifest entry: name length, row count, dictionary, column count
+constexpr size_t kMinTableBytes = 4 * sizeof(uint64_t);
+
+// How a column file stores its values. Plain values are mapped in place; the
+// encoded layouts of compression.h are kept as they are, so a compressed
+// table stays compressed across save and open.
+enum class ColumnLayout : uint8_t { Plain, Narrow, BitPacked, Rle };
+
+// Writes a file under a temporary name; commit() renames it into place
+class FileWriter {
+public:
+    explicit FileWriter(std::filesystem::path path_in)
+        : path(std::move(path_in)), temp_path(path.string() + ".tmp") {
+        out.open(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot create file: " + temp_path.string());
+        }
+    }
+
+    ~FileWriter() {
+        if (committed) return;
+        out.close();
+        std::error_code ignored;
+        std::filesystem::remove(temp_path, ignored);
+    }
+
+    void bytes(const void* data, size_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    template <typename T>
+    void put(const T& value) { bytes(&value, sizeof(T)); }
+
+    void put_string(const std::string& s) {
+        put<uint64_t>(s.size());
+        bytes(s.data(), s.size());
+    }
+
+    void pad_to(size_t offset) {
+        static const char zeros[kColumnHeaderBytes] = {};
+        auto at = static_cast<size_t>(out.tellp());
+        if (at < offset) bytes(zeros, offset - at);
+    }
+
+    void commit() {
+        out.close();
+        if (!out) {
+            throw std::runtime_error("Failed writing file: " + temp_path.string());
+        }
+        std::filesystem::rename(temp_path, path);
+        committed = true;
+    }
+
+private:
+    std::filesystem::path path;
+    std::filesystem::path temp_path;
+    std::ofstream out;
+    bool committed = false;
+};
+
+// Sequential reader over a mapped file that throws on truncated input
+class Reader {
+public:
+    Reader(const char* data_in, size_t size_in, std::string source_in)
+        : data(data_in), size(size_in), source(std::move(source_in)) {}
+
+    const char* bytes(size_t count) {
+        if (count > size - at) {
+            throw std::runtime_error("Corrupt database file: " + source);
+        }
+        const char* p = data + at;
+        at += count;
+        return p;
+    }
+
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string get_string() {
+        auto length = get<uint64_t>();
+        const char* p = bytes(length);
+        return std::string(p, length);
+    }
+
+    // A count of entries that take at least `entry_bytes` each, checked
+    // against what is left before anything is sized from it
+    uint64_t get_count(size_t entry_bytes) {
+        auto count = get<uint64_t>();
+        if (count > (size - at) / entry_bytes) {
+            throw std::runtime_error("Corrupt database file: " + source);
+        }
+        return count;
+    }
+
+    template <typename T>
+    std::vector<T> get_array(uint64_t count) {
+        if (count > (size - at) / sizeof(T)) {
+            throw std::runtime_error("Corrupt database file: " + source);
+        }
+        std::vector<T> values(count);
+        std::memcpy(values.data(), bytes(count * sizeof(T)), count * sizeof(T));
+        return values;
+    }
+
+    size_t position() const { return at; }
+
+    void expect_magic(const char (&magic)[8]) {
+        if (std::memcmp(bytes(sizeof(magic)), magic, sizeof(magic)) != 0) {
+            throw std::runtime_error("Not a bosql database file: " + source);
+        }
+    }
+
+private:
+    const char* data;
+    size_t size;
+    size_t at = 0;
+    std::string source;
+};
+
+Reader read_mapped(const MappedFile& mapped, const std::filesystem::path& path) {
+    return Reader(mapped.data, mapped.size, path.string());
+}
+
+void write_stats(FileWriter& out, const ColumnStats& stats) {
+    out.put(stats.min_i64);
+    out.put(stats.max_i64);
+    out.put(stats.min_f64);
+    out.put(stats.max_f64);
+    out.put(stats.min_date);
+    out.put(stats.max_date);
+    out.put<uint64_t>(stats.ndv);
+    out.put<uint8_t>(stats.approximate);
+    out.put<uint8_t>(stats.analyzed);
+    out.put<uint64_t>(stats.sample_rows);
+    out.put<uint64_t>(stats.mcvs.size());
+    for (const auto& mcv : stats.mcvs) {
+        out.put(mcv.value);
+        out.put(mcv.frequency);
+    }
+    out.put<uint64_t>(stats.histogram.bounds.size());
+    out.bytes(stats.histogram.bounds.data(), stats.histogram.bounds.size() * sizeof(f64));
+}
+
+ColumnStats read_stats(Reader& in) {
+    ColumnStats stats;
+    stats.min_i64 = in.get<i64>();
+    stats.max_i64 = in.get<i64>();
+    stats.min_f64 = in.get<f64>();
+    stats.max_f64 = in.get<f64>();
+    stats.min_date = in.get<Date32>();
+    stats.max_date = in.get<Date32>();
+    stats.ndv = in.get<uint64_t>();
+    stats.approximate = in.get<uint8_t>() != 0;
+    stats.analyzed = in.get<uint8_t>() != 0;
+    stats.sample_rows = in.get<uint64_t>();
+    stats.mcvs.resize(in.get_count(2 * sizeof(f64)));
+    for (auto& mcv : stats.mcvs) {
+        mcv.value = in.get<f64>();
+        mcv.frequency = in.get<f64>();
+    }
+    stats.histogram.bounds = in.get_array<f64>(in.get_count(sizeof(f64)));
+    return stats;
+}
+
+void write_dictionary(const std::filesystem::path& path, const Dictionary& dict) {
+    FileWriter out(path);
+    out.bytes(kDictionaryMagic, sizeof(kDictionaryMagic));
+    out.put<uint64_t>(dict.size());
+    uint64_t offset = 0;
+    out.put(offset);
+    for (size_t i = 0; i < dict.size(); ++i) {
+        offset += dict.get(static_cast<StrId>(i)).size();
+        out.put(offset);
+    }
+    for (size_t i = 0; i < dict.size(); ++i) {
+        auto s = dict.get(static_cast<StrId>(i));
+        out.bytes(s.data(), s.size());
+    }
+    out.commit();
+}
+
+// The strings stay in the mapped file; only the lookup index is built
+std::shared_ptr<Dictionary> read_dictionary(const std::filesystem::path& path) {
+    auto mapped = map_file(path);
+    Reader in = read_mapped(*mapped, path);
+    in.expect_magic(kDictionaryMagic);
+    auto count = in.get_count(sizeof(uint64_t));
+    // The header keeps the offsets 8-byte aligned in the page-aligned mapping
+    const auto* offsets = reinterpret_cast<const uint64_t*>(in.bytes((count + 1) * sizeof(uint64_t)));
+    const char* chars = in.bytes(offsets[count]);
+    for (size_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            throw std::runtime_error("Corrupt database file: " + path.string());
+        }
+    }
+    if (offsets[0] != 0 || count >= kInvalidStrId) {
+        throw std::runtime_error("Corrupt database file: " + path.string());
+    }
+    return std::make_shared<Dictionary>(std::move(mapped), offsets, chars, count);
+}
+
+// Writes the layout fields of the header and the encoded values, or returns
+// false when `column` is not in one of the encoded layouts
+template <typename T>
+bool write_encoded(FileWriter& out, const Column& column) {
+    auto header = [&](ColumnLayout layout, unsigned width, uint64_t base, uint64_t count) {
+        out.put(layout);
+        out.put<uint8_t>(static_cast<uint8_t>(width));
+        out.put(base);
+        out.put(count);
+        out.pad_to(kColumnHeaderBytes);
+    };
+    if (const auto* rle = dynamic_cast<const RleColumn<T>*>(&column)) {
+        header(ColumnLayout::Rle, 0, 0, rle->run_ends.size());
+        out.bytes(rle->run_values.data(), rle->run_values.size() * sizeof(T));
+        for (size_t end : rle->run_ends) out.put<uint64_t>(end);
+        return true;
+    }
+    if constexpr (std::is_integral_v<T>) {
+        auto narrow = [&](const auto* encoded) {
+            if (!encoded) return false;
+            using Delta = typename std::decay_t<decltype(encoded->deltas)>::value_type;
+            header(ColumnLayout::Narrow, sizeof(Delta), static_cast<uint64_t>(encoded->base), encoded->deltas.size());
+            out.bytes(encoded->deltas.data(), encoded->deltas.size() * sizeof(Delta));
+            return true;
+        };
+        if (narrow(dynamic_cast<const NarrowColumn<T, uint8_t>*>(&column)) ||
+            narrow(dynamic_cast<const NarrowColumn<T, uint16_t>*>(&column))) {
+            return true;
+        }
+        if constexpr (sizeof(T) == 8) {
+            if (narrow(dynamic_cast<const NarrowColumn<T, uint32_t>*>(&column))) return true;
+        }
+        if (const auto* packed = dynamic_cast<const BitPackedColumn<T>*>(&column)) {
+            header(ColumnLayout::BitPacked, packed->bits, static_cast<uint64_t>(packed->base), packed->words.size());
+            out.bytes(packed->words.data(), packed->words.size() * sizeof(uint64_t));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool write_encoded(FileWriter& out, const Column& column) {
+    switch (column.type()) {
+        case TypeId::INT64: return write_encoded<i64>(out, column);
+        case TypeId::DOUBLE: return write_encoded<f64>(out, column);
+        case TypeId::STRING: return write_encoded<StrId>(out, column);
+        case TypeId::DATE32: return write_encoded<Date32>(out, column);
+    }
+    return false;
+}
+
+void write_column(const std::filesystem::path& path, const Column& column) {
+    FileWriter out(path);
+    out.bytes(kColumnMagic, sizeof(kColumnMagic));
+    out.put<uint8_t>(static_cast<uint8_t>(column.type()));
+    out.put<uint64_t>(column.size());
+    if (write_encoded(out, column)) {
+        out.commit();
+        return;
+    }
+    out.put(ColumnLayout::Plain);
+    out.pad_to(kColumnHeaderBytes);
+    size_t width = type_width(column.type());
+    if (column.values()) {
+        out.bytes(column.values(), column.size() * width);
+    } else {
+        // Columns without a stored layout, such as lazy CSV ones, are saved
+        // decoded a chunk at a time
+        constexpr size_t kChunkRows = 1 << 16;
+        std::vector<char> chunk(kChunkRows * width);
+        for (size_t row = 0; row < column.size(); row += kChunkRows) {
+            size_t rows = std::min(kChunkRows, column.size() - row);
+            column.decode(row, rows, chunk.data());
+            out.bytes(chunk.data(), rows * width);
+        }
+    }
+    out.commit();
+}
+
+// Reads an encoded column back into its layout. Only the encoded bytes are
+// read; they are checked so that decoding stays within them.
+template <typename T>
+std::unique_ptr<Column> read_encoded(Reader& in, ColumnLayout layout, size_t rows, const std::filesystem::path& path) {
+    auto corrupt = [&] { return std::runtime_error("Corrupt database file: " + path.string()); };
+    const unsigned width = in.get<uint8_t>();
+    const auto base = static_cast<T>(in.get<uint64_t>());
+    const auto count = in.get<uint64_t>();
+    in.bytes(kColumnHeaderBytes - in.position());
+    if (layout == ColumnLayout::Rle) {
+        auto column = std::make_unique<RleColumn<T>>();
+        column->run_values = in.get_array<T>(count);
+        auto ends = in.get_array<uint64_t>(count);
+        column->run_ends.assign(ends.begin(), ends.end());
+        for (size_t run = 0; run < count; ++run) {
+            if (column->run_ends[run] <= (run ? column->run_ends[run - 1] : 0)) throw corrupt();
+        }
+        if (column->size() != rows) throw corrupt();
+        return column;
+    }
+    if constexpr (std::is_integral_v<T>) {
+        if (layout == ColumnLayout::Narrow && count == rows) {
+            auto narrow = [&]<typename Delta>(Delta) -> std::unique_ptr<Column> {
+                auto column = std::make_unique<NarrowColumn<T, Delta>>();
+                column->base = base;
+                column->deltas = in.get_array<Delta>(count);
+                return column;
+            };
+            if (width == 1) return narrow(uint8_t{});
+            if (width == 2) return narrow(uint16_t{});
+            if constexpr (sizeof(T) == 8) {
+                if (width == 4) return narrow(uint32_t{});
+            }
+        }
+        constexpr size_t kBlock = BitPackedColumn<T>::kBlockValues;
+        if (layout == ColumnLayout::BitPacked && width <= sizeof(T) * 8 &&
+            count == (rows + kBlock - 1) / kBlock * BitPackedColumn<T>::kLanes * width) {
+            auto column = std::make_unique<BitPackedColumn<T>>();
+            column->base = base;
+            column->bits = width;
+            column->length = rows;
+            column->words = in.get_array<uint64_t>(count);
+            return column;
+        }
+    }
+    throw corrupt();
+}
+
+template <typename T>
+std::unique_ptr<Column> open_column(Reader& in, std::shared_ptr<MappedFile> mapped, size_t rows, const std::filesystem::path& path) {
+    auto layout = in.get<ColumnLayout>();
+    if (layout != ColumnLayout::Plain) return read_encoded<T>(in, layout, rows, path);
+    if (rows > mapped->size / sizeof(T) || mapped->size != kColumnHeaderBytes + rows * sizeof(T)) {
+        throw std::runtime_error("Column file does not match the manifest: " + path.string());
+    }
+    const auto* values = reinterpret_cast<const T*>(mapped->data + kColumnHeaderBytes);
+    return std::make_unique<ColumnView<T>>(values, rows, std::move(mapped));
+}
+
+// Maps a column file; plain values are only read when a scan reaches them
+std::unique_ptr<Column> open_column(const std::filesystem::path& path, TypeId expected_type, size_t expected_rows) {
+    auto mapped = map_file(path);
+    Reader in = read_mapped(*mapped, path);
+    in.expect_magic(kColumnMagic);
+    auto type = static_cast<TypeId>(in.get<uint8_t>());
+    auto rows = in.get<uint64_t>();
+    if (type != expected_type || rows != expected_rows) {
+        throw std::runtime_error("Column file does not match the manifest: " + path.string());
+    }
+    switch (type) {
+        case TypeId::INT64: return open_column<i64>(in, std::move(mapped), rows, path);
+        case TypeId::DOUBLE: return open_column<f64>(in, std::move(mapped), rows, path);
+        case TypeId::STRING: return open_column<StrId>(in, std::move(mapped), rows, path);
+        case TypeId::DATE32: return open_column<Date32>(in, std::move(mapped), rows, path);
+    }
+    throw std::runtime_error("Unknown column type in " + path.string());
+}
+
+} // namespace
+
+size_t save_database(const Catalog& catalog, const std::filesystem::path& directory) {
+    std::filesystem::create_directories(directory);
+    auto names = catalog.list_tables();
+
+    // Tables may share a dictionary; each one is written once
+    std::unordered_map<const Dictionary*, uint32_t> dictionaries;
+    for (const auto& name : names) {
+        const Dictionary* dict = catalog.get_table_data(name)->dict.get();
+        if (dict && dictionaries.emplace(dict, static_cast<uint32_t>(dictionaries.size())).second) {
+            write_dictionary(directory / fmt::format("d{}.dict", dictionaries[dict]), *dict);
+        }
+    }
+
+    FileWriter manifest(directory / "MANIFEST");
+    manifest.bytes(kManifestMagic, sizeof(kManifestMagic));
+    manifest.put(kFormatVersion);
+    manifest.put<uint64_t>(names.size());
+    for (size_t t = 0; t < names.size(); ++t) {
+        const Table& table = *catalog.get_table_data(names[t]);
+        const TableMeta& meta = *catalog.get_table_meta(names[t]);
+        if (meta.columns.size() != table.columns.size()) {
+            throw std::runtime_error("Table '" + names[t] + "' has metadata for a different number of columns");
+        }
+        manifest.put_string(names[t]);
+        manifest.put<uint64_t>(meta.row_count);
+        manifest.put<int64_t>(table.dict ? static_cast<int64_t>(dictionaries[table.dict.get()]) : -1);
+        manifest.put<uint64_t>(table.columns.size());
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            const Column& column = *table.columns[c].data;
+            std::string file = fmt::format("t{}_c{}.col", t, c);
+            write_column(directory / file, column);
+            manifest.put_string(table.columns[c].name);
+            manifest.put<uint8_t>(static_cast<uint8_t>(column.type()));
+            manifest.put<uint64_t>(column.size());
+            manifest.put_string(file);
+            write_stats(manifest, meta.columns[c].stats);
+        }
+    }
+    // Last, so an interrupted save leaves the previous manifest in place
+    manifest.commit();
+    return names.size();
+}
+
+size_t open_database(Catalog& catalog, const std::filesystem::path& directory) {
+    auto mapped = map_file(directory / "MANIFEST");
+    Reader in = read_mapped(*mapped, directory / "MANIFEST");
+    in.expect_magic(kManifestMagic);
+    if (in.get<uint32_t>() != kFormatVersion) {
+        throw std::runtime_error("Unsupported database version in " + directory.string());
+    }
+
+    // Build everything before registering, so a bad file changes nothing
+    std::unordered_map<int64_t, std::shared_ptr<Dictionary>> dictionaries;
+    std::vector<std::pair<Table, TableMeta>> tables(in.get_count(kMinTableBytes));
+    for (auto& [table, meta] : tables) {
+        table.name = in.get_string();
+        meta.name = table.name;
+        meta.row_count = in.get<uint64_t>();
+        auto dict_index = in.get<int64_t>();
+        if (dict_index >= 0) {
+            auto& dict = dictionaries[dict_index];
+            if (!dict) dict = read_dictionary(directory / fmt::format("d{}.dict", dict_index));
+            table.dict = dict;
+        }
+        auto column_count = in.get<uint64_t>();
+        for (uint64_t c = 0; c < column_count; ++c) {
+            TableColumn column;
+            column.name = in.get_string();
+            auto type = static_cast<TypeId>(in.get<uint8_t>());
+            auto rows = in.get<uint64_t>();
+            column.data = open_column(directory / in.get_string(), type, rows);
+            ColumnMeta column_meta(column.name, type);
+            column_meta.stats = read_stats(in);
+            table.columns.push_back(std::move(column));
+            meta.columns.push_back(std::move(column_meta));
+        }
+    }
+
+    for (auto& [table, meta] : tables) {
+        catalog.register_table(std::move(table), std::move(meta));
+    }
+    return tables.size();
+}
+
+} // namespace bosql
@@ -0,0 +1,234 @@
+#include "catalog/statistics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace bosql {
+
+HyperLogLog::HyperLogLog(uint8_t precision) : precision_(precision) {
+    if (precision_ < 4 || precision_ > 18) {
+        throw std::runtime_error("HyperLogLog precision must be in [4, 18]");
+    }
+    registers_.assign(size_t{1} << precision_, 0);
+}
+
+void HyperLogLog::add_hash(uint64_t hash) {
+    size_t index = static_cast<size_t>(hash >> (64 - precision_));
+    uint64_t rest = hash << precision_;
+    uint8_t max_rank = static_cast<uint8_t>(64 - precision_ + 1);
+    uint8_t rank = rest == 0 ? max_rank : static_cast<uint8_t>(std::countl_zero(rest) + 1);
+    registers_[index] = std::max(registers_[index], std::min(rank, max_rank));
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) {
+        throw std::runtime_error("Cannot merge HyperLogLog sketches of different precision");
+    }
+    for (size_t i = 0; i < registers_.size(); ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+size_t HyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers_.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t r : registers_) {
+        sum += std::ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) ++zeros;
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        // Small-range correction: linear counting is far more accurate here
+        estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return static_cast<size_t>(std::llround(estimate));
+}
+
+namespace {
+
+// Calls fn(first_row, values) over the column a chunk at a time, so encoded
+// columns are never decoded whole; plain ones are passed in one piece
+template <typename T, typename Fn>
+void visit_chunks(const Column& column, Fn& fn) {
+    if (column.values()) {
+        fn(size_t{0}, column_values<T>(column));
+        return;
+    }
+    constexpr size_t kChunkRows = 1 << 16;
+    std::vector<T> chunk(std::min(kChunkRows, column.size()));
+    for (size_t row = 0; row < column.size(); row += kChunkRows) {
+        const size_t rows = std::min(kChunkRows, column.size() - row);
+        column.decode(row, rows, chunk.data());
+        fn(row, std::span<const T>(chunk.data(), rows));
+    }
+}
+
+template <typename Fn>
+void visit_chunks(const Column& column, Fn&& fn) {
+    switch (column.type()) {
+        case TypeId::INT64: return visit_chunks<int64_t>(column, fn);
+        case TypeId::DOUBLE: return visit_chunks<double>(column, fn);
+        case TypeId::STRING: return visit_chunks<uint32_t>(column, fn);
+        case TypeId::DATE32: return visit_chunks<int32_t>(column, fn);
+    }
+    throw std::runtime_error("Unknown column type");
+}
+
+template <typename T>
+void add_to_sketch(HyperLogLog& hll, T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        hll.add(static_cast<f64>(value));
+    } else {
+        hll.add(static_cast<i64>(value));
+    }
+}
+
+std::vector<size_t> sample_positions(size_t rows, const AnalyzeOptions& options) {
+    std::vector<size_t> positions;
+    if (rows <= options.sample_rows) {
+        positions.resize(rows);
+        for (size_t i = 0; i < rows; ++i) positions[i] = i;
+        return positions;
+    }
+    // Selection sampling (Knuth, Algorithm S): one pass, sorted output
+    positions.reserve(options.sample_rows);
+    std::mt19937_64 rng(options.seed);
+    size_t needed = options.sample_rows;
+    for (size_t i = 0; i < rows && needed > 0; ++i) {
+        std::uniform_int_distribution<size_t> pick(0, rows - i - 1);
+        if (pick(rng) < needed) {
+            positions.push_back(i);
+            --needed;
+        }
+    }
+    return positions;
+}
+
+void build_distribution(std::vector<f64> sample,
+                        bool ordered,
+                        const AnalyzeOptions& options,
+                        ColumnStats& stats) {
+    stats.mcvs.clear();
+    stats.histogram.bounds.clear();
+    stats.sample_rows = sample.size();
+    if (sample.empty()) return;
+
+    // NaNs have no order, so they are kept out of the sort and counted as
+    // one value after the others
+    auto nans = std::partition(sample.begin(), sample.end(), [](f64 v) { return !std::isnan(v); });
+    std::sort(sample.begin(), nans);
+    struct Run { f64 value; size_t count; };
+    std::vector<Run> runs;
+    for (auto it = sample.begin(); it != nans; ++it) {
+        if (runs.empty() || runs.back().value != *it) {
+            runs.push_back({*it, 1});
+        } else {
+            ++runs.back().count;
+        }
+    }
+    const size_t nan_count = static_cast<size_t>(sample.end() - nans);
+    if (nan_count > 0) runs.push_back({std::numeric_limits<f64>::quiet_NaN(), nan_count});
+
+    const double total = static_cast<double>(sample.size());
+    std::vector<Run> common;
+    if (runs.size() <= options.mcv_count) {
+        // Every distinct value fits in the MCV list: the distribution is exact
+        common = runs;
+    } else {
+        // Only values the histogram would misrepresent: clearly above average
+        // and at least as frequent as a whole bucket
+        const double average = total / static_cast<double>(runs.size());
+        const double bucket_share = total / static_cast<double>(std::max<size_t>(options.histogram_buckets, 1));
+        const double min_count = std::max({2.0, 1.25 * average, bucket_share});
+        for (const auto& run : runs) {
+            if (static_cast<double>(run.count) >= min_count) {
+                common.push_back(run);
+            }
+        }
+        // Runs are in value order, NaN last, which settles ties
+        std::stable_sort(common.begin(), common.end(), [](const Run& a, const Run& b) { return a.count > b.count; });
+        if (common.size() > options.mcv_count) common.resize(options.mcv_count);
+    }
+    for (const auto& run : common) {
+        stats.mcvs.push_back({run.value, static_cast<double>(run.count) / total});
+    }
+
+    if (!ordered || options.histogram_buckets == 0) return;
+    // An MCV for NaN keeps its rows out of every comparison's estimate; the
+    // histogram only covers ordered values
+    std::vector<f64> rest;
+    rest.reserve(sample.size());
+    for (const auto& run : runs) {
+        if (std::isnan(run.value)) continue;
+        bool is_common = std::any_of(common.begin(), common.end(), [&](const Run& c) { return c.value == run.value; });
+        if (!is_common) rest.insert(rest.end(), run.count, run.value);
+    }
+    if (rest.empty()) return;
+    size_t buckets = std::min(options.histogram_buckets, rest.size());
+    stats.histogram.bounds.reserve(buckets + 1);
+    for (size_t b = 0; b <= buckets; ++b) {
+        size_t pos = b * (rest.size() - 1) / buckets;
+        stats.histogram.bounds.push_back(rest[pos]);
+    }
+}
+
+} // namespace
+
+size_t estimate_ndv(const Column& column) {
+    HyperLogLog hll;
+    visit_chunks(column, [&](size_t, const auto& data) {
+        for (auto v : data) add_to_sketch(hll, v);
+    });
+    return hll.estimate();
+}
+
+void analyze_table(const Table& table, TableMeta& meta, const AnalyzeOptions& options) {
+    for (auto& col_meta : meta.columns) {
+        const Column& column = table.get_column_data(col_meta.name);
+        ColumnStats& stats = col_meta.stats;
+        std::vector<size_t> positions = sample_positions(column.size(), options);
+        std::vector<f64> sample;
+        sample.reserve(positions.size());
+        HyperLogLog hll;
+        size_t next = 0;
+        bool seen = false;
+        // One pass feeds the sketch and the sample and, when the load
+        // sampled the column, replaces its range with the whole column's
+        visit_chunks(column, [&](size_t first, const auto& data) {
+            for (auto v : data) add_to_sketch(hll, v);
+            for (; next < positions.size() && positions[next] < first + data.size(); ++next) {
+                sample.push_back(static_cast<f64>(data[positions[next] - first]));
+            }
+            if (!stats.approximate) return;
+            using T = typename std::decay_t<decltype(data)>::value_type;
+            auto widen = [&](T& lo, T& hi) {
+                for (T v : data) {
+                    if constexpr (std::is_floating_point_v<T>) {
+                        if (std::isnan(v)) continue;
+                    }
+                    lo = seen ? std::min(lo, v) : v;
+                    hi = seen ? std::max(hi, v) : v;
+                    seen = true;
+                }
+            };
+            if constexpr (std::is_same_v<T, int64_t>) widen(stats.min_i64, stats.max_i64);
+            if constexpr (std::is_same_v<T, double>) widen(stats.min_f64, stats.max_f64);
+            if constexpr (std::is_same_v<T, int32_t>) widen(stats.min_date, stats.max_date);
+        });
+        stats.approximate = false;
+        stats.ndv = hll.estimate();
+        build_distribution(std::move(sample), column.type() != TypeId::STRING, options, stats);
+        stats.analyzed = true;
+    }
+    meta.row_count = table.columns.empty() ? 0 : table.columns[0].data->size();
+}
+
+} // namespace bosql
@@ -1,18 +1,27 @@
 #include <algorithm>
 #include <cctype>
+#include <filesystem>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <sstream>
 #include <utility>
 #include <string_view>
+#include <thread>
 #include <fmt/core.h>
 #include <fmt/color.h>
 #include "catalog/catalog.h"
+#include "catalog/database.h"
+#include "catalog/statistics.h"
 #include "storage/csv_loader.h"
 #include "parser/parser.h"
 #include "logical/planner.h"
+#include "logical/cardinality.h"
 #include "exec/physical_planner.h"
+#include "exec/instrumentation.h"
+#include "exec/arrow_ipc.h"
 #include "exec/formatter.hpp"
+#include "exec/memory.h"
 #include "types.h"
 
 template<typename... Args>
@@ -37,16 +46,140 @@ std::string type_name(bosql::TypeId type) {
     }
 }
 
-void execute_select_sql(const std::string& sql, bosql::Catalog& catalog, std::string_view output_format) {
+std::string format_stat_value(double value, bosql::TypeId type, const bosql::Dictionary* dict) {
+    switch (type) {
+        case bosql::TypeId::STRING: {
+            auto code = static_cast<bosql::StrId>(value);
+            if (dict && code < dict->size()) return fmt::format("'{}'", dict->get(code));
+            return fmt::format("#{}", code);
+        }
+        case bosql::TypeId::DOUBLE:
+            return fmt::format("{}", value);
+        default:
+            return fmt::format("{}", static_cast<int64_t>(value));
+    }
+}
+
+// Parses "0", "none", "65536", "512KB", "64MB" or "2GB" into bytes (0 = unlimited)
+std::optional<size_t> parse_byte_size(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    if (value == "NONE") return 0;
+    size_t digits = 0;
+    while (digits < value.size() && std::isdigit(static_cast<unsigned char>(value[digits]))) ++digits;
+    if (digits == 0) return std::nullopt;
+    size_t number = 0;
+    try {
+        number = std::stoull(value.substr(0, digits));
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+    std::string unit = value.substr(digits);
+    if (unit.empty() || unit == "B") return number;
+    if (unit == "KB") return number << 10;
+    if (unit == "MB") return number << 20;
+    if (unit == "GB") return number << 30;
+    return std::nullopt;
+}
+
+std::string format_byte_size(size_t bytes) {
+    if (bytes >= (size_t{1} << 30)) return fmt::format("{:.1f} GB", static_cast<double>(bytes) / (1 << 30));
+    if (bytes >= (size_t{1} << 20)) return fmt::format("{:.1f} MB", static_cast<double>(bytes) / (1 << 20));
+    if (bytes >= (size_t{1} << 10)) return fmt::format("{:.1f} KB", static_cast<double>(bytes) / (1 << 10));
+    return fmt::format("{} B", bytes);
+}
+
+// Tracker of the most recent statement, kept for SHOW MEMORY
+std::shared_ptr<bosql::MemoryTracker> last_query_memory;
+
+// Gives a statement its own tracker under the process one; limit 0 = unlimited
+bosql::PhysicalPlanOptions track_query(const bosql::PhysicalPlanOptions& options, const std::string& sql, size_t limit) {
+    constexpr size_t kLabelChars = 48;
+    std::string label = sql.size() > kLabelChars ? sql.substr(0, kLabelChars - 3) + "..." : sql;
+    last_query_memory.reset();
+    last_query_memory = bosql::MemoryTracker::create("query: " + label, limit);
+    bosql::PhysicalPlanOptions tracked = options;
+    tracked.memory = last_query_memory;
+    return tracked;
+}
+
+void print_memory_usage(const bosql::MemoryTracker::Usage& usage, int indent) {
+    std::string line = fmt::format("{}{}: {} in use, peak {}", std::string(indent, ' '), usage.label,
+                                   format_byte_size(usage.current), format_byte_size(usage.peak));
+    if (usage.limit > 0) {
+        line += fmt::format(", limit {}", format_byte_size(usage.limit));
+    }
+    fmt::print("{}\n", line);
+    for (const auto& child : usage.children) {
+        print_memory_usage(child, indent + 2);
+    }
+}
+
+// SHOW STORAGE: one line per column, then the dictionary and a total
+void print_storage(const std::vector<bosql::TableStorage>& report) {
+    std::vector<const bosql::Dictionary*> dictionaries;
+    size_t total = 0;
+    for (const auto& table : report) {
+        fmt::print("Table: {} ({} rows)\n", table.name, table.rows);
+        fmt::print("  {:<24} {:<7} {:<10} {:>10} {:>10} {:>9} {:>9} {:>12} {:>11}\n", "column", "type", "encoding", "rows",
+                   "stored", "bytes/row", "stats", "scanned rows", "scanned b/r");
+        size_t table_bytes = 0;
+        for (const auto& column : table.columns) {
+            double per_row = column.rows ? static_cast<double>(column.bytes) / static_cast<double>(column.rows) : 0.0;
+            std::string scanned_per_row = column.scanned_rows
+                ? fmt::format("{:.2f}", static_cast<double>(column.scanned_bytes) / static_cast<double>(column.scanned_rows))
+                : "-";
+            fmt::print("  {:<24} {:<7} {:<10} {:>10} {:>10} {:>9.2f} {:>9} {:>12} {:>11}\n", column.name, type_name(column.type),
+                       column.encoding, column.rows, format_byte_size(column.bytes), per_row,
+                       format_byte_size(column.stats_bytes), column.scanned_rows, scanned_per_row);
+            table_bytes += column.bytes + column.stats_bytes;
+        }
+        if (table.map_bytes) {
+            fmt::print("  positional map: {}\n", format_byte_size(table.map_bytes));
+            table_bytes += table.map_bytes;
+        }
+        if (table.dictionary) {
+            bool counted = std::find(dictionaries.begin(), dictionaries.end(), table.dictionary) != dictionaries.end();
+            fmt::print("  dictionary: {} entries, {}{}\n", table.dictionary_entries, format_byte_size(table.dictionary_bytes),
+                       counted ? " (shared, counted once)" : "");
+            if (!counted) {
+                dictionaries.push_back(table.dictionary);
+                table_bytes += table.dictionary_bytes;
+            }
+        }
+        total += table_bytes;
+    }
+    fmt::print("Total: {} in {} table{}\n", format_byte_size(total), report.size(), report.size() == 1 ? "" : "s");
+}
+
+void analyze_tables(bosql::Catalog& catalog, const std::vector<std::string>& names, const bosql::AnalyzeOptions& options) {
+    for (const auto& name : names) {
+        auto table = catalog.get_table_data(name);
+        auto meta = catalog.get_table_meta(name);
+        if (!table.has_value() || !meta.has_value()) {
+            print_error("Table '{}' not found", name);
+            continue;
+        }
+        bosql::TableMeta updated = meta.value();
+        bosql::analyze_table(table.value(), updated, options);
+        catalog.update_table_meta(std::move(updated));
+        print_success("Analyzed table '{}'", name);
+    }
+}
+
+void execute_select_sql(const std::string& sql, bosql::Catalog& catalog, std::string_view output_format, const bosql::PhysicalPlanOptions& plan_options) {
     try {
         bosql::SelectStmt stmt = bosql::parse_sql(sql);
         bosql::LogicalPlanner planner;
         auto logical = planner.build_logical_plan(stmt);
-        auto physical = bosql::build_physical_plan(logical.get(), catalog);
+        bosql::annotate_cardinality(logical.get(), catalog);
+        auto physical = bosql::build_physical_plan(logical.get(), catalog, plan_options);
         auto [col_names, col_types, dict] = bosql::get_output_schema(logical.get(), catalog);
         if (output_format == "csv") {
             bosql::CsvFormatter formatter(std::cout);
             bosql::run_query(std::move(physical), col_names, col_types, formatter, dict);
+        } else if (output_format == "arrow") {
+            bosql::ArrowIpcFormatter formatter(std::cout);
+            bosql::run_query(std::move(physical), col_names, col_types, formatter, dict);
         } else {
             bosql::MarkdownFormatter formatter(std::cout);
             bosql::run_query(std::move(physical), col_names, col_types, formatter, dict);
@@ -62,6 +195,9 @@ int main(int argc, char* argv[]) {
     bool sql_argument = false;
     std::string sql_query;
     std::string output_format = "markdown";
+    bosql::PhysicalPlanOptions plan_options;
+    // Hard per-query cap enforced by the query's memory tracker (0 = none)
+    size_t query_memory_limit = 0;
     for (size_t i = 0; i < args.size(); ++i) {
         if (args[i] == "--sql") {
             if (i + 1 < args.size()) {
@@ -94,8 +230,8 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    if (output_format != "markdown" && output_format != "csv") {
-        print_error("Unsupported output format '{}'. Use 'markdown' or 'csv'.", output_format);
+    if (output_format != "markdown" && output_format != "csv" && output_format != "arrow") {
+        print_error("Unsupported output format '{}'. Use 'markdown', 'csv' or 'arrow'.", output_format);
         return 1;
     }
 
@@ -105,7 +241,7 @@ int main(int argc, char* argv[]) {
         std::string table_name = "table";
         if (!csv_file.empty()) {
             try {
-                auto [table, meta] = bosql::load_csv(csv_file);
+                auto [table, meta] = bosql::load_csv(csv_file, catalog.shared_dictionary());
                 table.name = table_name;
                 meta.name = table_name;
                 catalog.register_table(std::move(table), std::move(meta));
@@ -115,7 +251,7 @@ int main(int argc, char* argv[]) {
             }
         } else {
             try {
-                auto [table, meta] = bosql::load_csv(std::cin);
+                auto [table, meta] = bosql::load_csv(std::cin, catalog.shared_dictionary());
                 table.name = table_name;
                 meta.name = table_name;
                 catalog.register_table(std::move(table), std::move(meta));
@@ -124,14 +260,14 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
         }
-        execute_select_sql(sql_query, catalog, output_format);
+        execute_select_sql(sql_query, catalog, output_format, track_query(plan_options, sql_query, query_memory_limit));
         return 0;
     } else {
         // Load CSV if provided
         if (!csv_file.empty()) {
             std::string table_name = "table";
             try {
-                auto [table, meta] = bosql::load_csv(csv_file);
+                auto [table, meta] = bosql::load_csv(csv_file, catalog.shared_dictionary());
                 table.name = table_name;
                 meta.name = table_name;
                 catalog.register_table(std::move(table), std::move(meta));
@@ -150,30 +286,70 @@ int main(int argc, char* argv[]) {
         iss >> command;
 
         if (command == "LOAD") {
-            std::string table_keyword, table_name, from_keyword, filename;
-            iss >> table_keyword >> table_name >> from_keyword >> filename;
-            if (table_keyword != "TABLE" || from_keyword != "FROM") {
-                print_warning("Syntax: LOAD TABLE <name> FROM 'file.csv'");
+            std::string table_keyword, table_name, from_keyword, filename, mode, kind;
+            iss >> table_keyword >> table_name >> from_keyword >> filename >> mode >> kind;
+            const bool lazy = mode == "LAZY" && kind.empty();
+            const bool external = mode == "AS" && kind == "EXTERNAL";
+            if (table_keyword != "TABLE" || from_keyword != "FROM" || (!mode.empty() && !lazy && !external)) {
+                print_warning("Syntax: LOAD TABLE <name> FROM 'file.csv' [LAZY | AS EXTERNAL]");
             } else {
                 // Remove quotes from filename
                 if (!filename.empty() && filename.front() == '\'' && filename.back() == '\'') {
                     filename = filename.substr(1, filename.size() - 2);
                 }
                 try {
-                    std::pair<bosql::Table, bosql::TableMeta> result = bosql::load_csv(filename);
+                    std::pair<bosql::Table, bosql::TableMeta> result = external ? bosql::load_csv_external(filename, catalog.shared_dictionary())
+                                                                     : lazy     ? bosql::load_csv_lazy(filename, catalog.shared_dictionary())
+                                                                                : bosql::load_csv(filename, catalog.shared_dictionary());
                 result.first.name = table_name;
                 result.second.name = table_name;
                      catalog.register_table(std::move(result.first), std::move(result.second));
 
-                    print_success("Loaded table '{}' with {} rows", table_name, result.second.row_count);
+                    print_success("{} table '{}' with {} rows{}", lazy || external ? "Indexed" : "Loaded", table_name,
+                                  result.second.row_count,
+                                  external ? " (queried in place)" : lazy ? " (columns load on first use)" : "");
                 } catch (const std::exception& e) {
                     print_error("Error loading CSV: {}", e.what());
                 }
             }
+        } else if (command == "SAVE" || command == "OPEN") {
+            std::string database_keyword, directory;
+            iss >> database_keyword >> directory;
+            if (!directory.empty() && directory.front() == '\'' && directory.back() == '\'') {
+                directory = directory.substr(1, directory.size() - 2);
+            }
+            if (database_keyword != "DATABASE" || directory.empty()) {
+                print_warning("Syntax: {} DATABASE 'directory'", command);
+            } else {
+                try {
+                    if (command == "SAVE") {
+                        size_t tables = bosql::save_database(catalog, directory);
+                        print_success("Saved {} tables to {}", tables, directory);
+                    } else {
+                        size_t tables = bosql::open_database(catalog, directory);
+                        print_success("Opened {} tables from {}", tables, directory);
+                    }
+                } catch (const std::exception& e) {
+                    print_error("Error: {}", e.what());
+                }
+            }
         } else if (command == "SHOW") {
             std::string tables_keyword;
             iss >> tables_keyword;
-            if (tables_keyword == "TABLES") {
+            if (tables_keyword == "MEMORY") {
+                print_memory_usage(bosql::MemoryTracker::process()->usage(), 0);
+            } else if (tables_keyword == "STORAGE") {
+                std::string table_name;
+                iss >> table_name;
+                auto report = bosql::storage_report(catalog, table_name);
+                if (!table_name.empty() && report.empty()) {
+                    print_error("Table '{}' not found", table_name);
+                } else if (report.empty()) {
+                    print_info("No tables loaded");
+                } else {
+                    print_storage(report);
+                }
+            } else if (tables_keyword == "TABLES") {
                 auto tables = catalog.list_tables();
                 if (tables.empty()) {
                     print_info("No tables loaded");
@@ -192,6 +368,8 @@ int main(int argc, char* argv[]) {
               if (!meta.has_value()) {
                   print_error("Table '{}' not found", table_name);
               } else {
+                  auto table = catalog.get_table_data(table_name);
+                  const bosql::Dictionary* dict = table.has_value() ? table->dict.get() : nullptr;
                   fmt::print("Table: {} ({} rows)\n", meta->name, meta->row_count);
                   fmt::print("Columns:\n");
                   for (const auto& col : meta->columns) {
@@ -203,9 +381,54 @@ int main(int argc, char* argv[]) {
                       } else if (col.type == bosql::TypeId::DATE32) {
                           fmt::print(", min: {}, max: {}", col.stats.min_date, col.stats.max_date);
                       }
-                      fmt::print(")\n");
+                      fmt::print("{})\n", col.stats.approximate ? ", sampled" : "");
+                      if (!col.stats.analyzed) {
+                          continue;
+                      }
+                      fmt::print("    sampled rows: {}\n", col.stats.sample_rows);
+                      if (!col.stats.mcvs.empty()) {
+                          std::string mcvs;
+                          for (const auto& mcv : col.stats.mcvs) {
+                              if (!mcvs.empty()) mcvs += ", ";
+                              mcvs += fmt::format("{} ({:.1f}%)", format_stat_value(mcv.value, col.type, dict), mcv.frequency * 100.0);
+                          }
+                          fmt::print("    mcv: {}\n", mcvs);
+                      }
+                      if (!col.stats.histogram.empty()) {
+                          std::string bounds;
+                          for (double bound : col.stats.histogram.bounds) {
+                              if (!bounds.empty()) bounds += ", ";
+                              bounds += format_stat_value(bound, col.type, dict);
+                          }
+                          fmt::print("    histogram ({} buckets): [{}]\n", col.stats.histogram.bucket_count(), bounds);
+                      }
                   }
              }
+        } else if (command == "ANALYZE") {
+            std::vector<std::string> names;
+            bosql::AnalyzeOptions options;
+            std::string token;
+            bool syntax_ok = true;
+            while (iss >> token) {
+                if (token == "SAMPLE") {
+                    size_t rows = 0;
+                    if (!(iss >> rows) || rows == 0) {
+                        syntax_ok = false;
+                        break;
+                    }
+                    options.sample_rows = rows;
+                } else {
+                    names.push_back(token);
+                }
+            }
+            if (!syntax_ok || names.size() > 1) {
+                print_warning("Syntax: ANALYZE [table] [SAMPLE <rows>]");
+            } else {
+                if (names.empty()) {
+                    names = catalog.list_tables();
+                }
+                analyze_tables(catalog, names, options);
+            }
         } else if (command == "EXPLAIN") {
             std::string sql;
             std::getline(iss, sql);
@@ -215,13 +438,28 @@ int main(int argc, char* argv[]) {
                  sql = sql.substr(start);
              }
              if (sql.empty()) {
-                 print_warning("Syntax: EXPLAIN <sql>");
+                 print_warning("Syntax: EXPLAIN [ANALYZE] <sql>");
               } else {
                   try {
+                      // EXPLAIN ANALYZE runs the query and reports what actually happened
+                      bool analyze = false;
+                      if (sql.size() > 8 && std::equal(sql.begin(), sql.begin() + 8, "ANALYZE ",
+                                                       [](char a, char b) { return std::toupper(static_cast<unsigned char>(a)) == b; })) {
+                          analyze = true;
+                          sql = sql.substr(8);
+                      }
                       bosql::SelectStmt stmt = bosql::parse_sql(sql);
                       bosql::LogicalPlanner planner;
                       auto plan = planner.build_logical_plan(stmt);
-                      fmt::print("{}\n", plan->to_string());
+                      bosql::annotate_cardinality(plan.get(), catalog);
+                      if (analyze) {
+                          bosql::PhysicalPlanOptions options = track_query(plan_options, sql, query_memory_limit);
+                          options.instrument = true;
+                          auto physical = bosql::build_physical_plan(plan.get(), catalog, options);
+                          fmt::print("{}\n", bosql::explain_analyze(*physical, options.memory.get()));
+                      } else {
+                          fmt::print("{}\n", plan->to_string());
+                      }
                   } catch (const std::exception& e) {
                       print_error("Error: {}", e.what());
                   }
@@ -238,7 +476,7 @@ int main(int argc, char* argv[]) {
                if (sql.empty()) {
                    print_warning("Syntax: SELECT <sql>");
                 } else {
-              execute_select_sql(sql, catalog, output_format);
+              execute_select_sql(sql, catalog, output_format, track_query(plan_options, sql, query_memory_limit));
                 }
          } else if (command == "EXIT" || command == "QUIT") {
             break;
@@ -249,21 +487,64 @@ int main(int argc, char* argv[]) {
                 std::string value;
                 iss >> value;
                 if (value.empty()) {
-                    print_warning("Syntax: SET FORMAT <markdown|csv>");
+                    print_warning("Syntax: SET FORMAT <markdown|csv|arrow>");
                 } else {
                     std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-                    if (value == "markdown" || value == "csv") {
+                    if (value == "markdown" || value == "csv" || value == "arrow") {
                         output_format = value;
                         print_success("Output format set to {}", output_format);
                     } else {
-                        print_warning("Unsupported output format '{}'. Use 'markdown' or 'csv'.", value);
+                        print_warning("Unsupported output format '{}'. Use 'markdown', 'csv' or 'arrow'.", value);
                     }
                 }
+            } else if (setting == "THREADS") {
+                std::string value;
+                iss >> value;
+                size_t threads = 0;
+                try {
+                    threads = value.empty() ? 0 : std::stoul(value);
+                } catch (const std::exception&) {
+                    threads = 0;
+                }
+                if (threads == 0 || threads > 1024) {
+                    print_warning("Syntax: SET THREADS <n> (1 to 1024; this machine has {} hardware threads)",
+                                  std::thread::hardware_concurrency());
+                } else {
+                    plan_options.threads = threads;
+                    print_success("Query threads set to {}", threads);
+                }
+            } else if (setting == "MEMORY_LIMIT") {
+                std::string value;
+                iss >> value;
+                std::optional<size_t> limit = parse_byte_size(value);
+                if (!limit) {
+                    print_warning("Syntax: SET MEMORY_LIMIT <bytes|nKB|nMB|nGB|none>");
+                } else if (*limit == 0) {
+                    plan_options.memory_limit = 0;
+                    print_success("Memory limit removed");
+                } else {
+                    plan_options.memory_limit = *limit;
+                    print_success("Memory limit set to {}; larger sorts, joins and aggregations spill to {}", format_byte_size(*limit),
+                                  std::filesystem::temp_directory_path().string());
+                }
+            } else if (setting == "QUERY_MEMORY_LIMIT") {
+                std::string value;
+                iss >> value;
+                std::optional<size_t> limit = parse_byte_size(value);
+                if (!limit) {
+                    print_warning("Syntax: SET QUERY_MEMORY_LIMIT <bytes|nKB|nMB|nGB|none>");
+                } else if (*limit == 0) {
+                    query_memory_limit = 0;
+                    print_success("Query memory limit removed");
+                } else {
+                    query_memory_limit = *limit;
+                    print_success("Queries that hold more than {} now fail", format_byte_size(*limit));
+                }
             } else {
                 print_warning("Unknown setting");
             }
          } else {
-             print_warning("Unknown command. Available: LOAD TABLE, SHOW TABLES, DESCRIBE <table>, EXPLAIN <sql>, SELECT <sql>, SET FORMAT <markdown|csv>, EXIT");
+             print_warning("Unknown command. Available: LOAD TABLE [LAZY | AS EXTERNAL], SAVE DATABASE, OPEN DATABASE, SHOW TABLES, SHOW MEMORY, SHOW STORAGE [table], DESCRIBE <table>, ANALYZE [table], EXPLAIN [ANALYZE] <sql>, SELECT <sql>, SET FORMAT <markdown|csv|arrow>, SET THREADS <n>, SET MEMORY_LIMIT <size>, SET QUERY_MEMORY_LIMIT <size>, EXIT");
          }
 
         fmt::print("> ");
@@ -0,0 +1,413 @@
+#include "exec/arrow_c_data.h"
+#include "catalog/statistics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace bosql {
+
+namespace {
+
+// Everything an exported array points into. `keep` holds whatever owns the
+// value buffer (a ColumnSlice owner, or the shared dictionary strings).
+struct ExportedArray {
+    std::shared_ptr<void> keep;
+    std::vector<const void*> buffers;
+    std::vector<ArrowArray*> children;
+    ArrowArray* dictionary = nullptr;
+    std::vector<int32_t> days;
+    std::vector<StrId> codes;
+};
+
+struct ExportedSchema {
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema*> children;
+    ArrowSchema* dictionary = nullptr;
+};
+
+// Utf8 copy of the dictionary strings one export refers to, shared by the
+// dictionary arrays of all its STRING columns. When `positions` is empty the
+// copy is the whole dictionary and codes index it directly; otherwise it
+// holds only the referenced strings, at positions[code].
+struct DictionaryStrings {
+    std::vector<int32_t> offsets{0};
+    std::string chars;
+    std::unordered_map<StrId, StrId> positions;
+
+    void append(std::string_view s) {
+        if (chars.size() + s.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+            throw std::runtime_error("Dictionary too large for Arrow export");
+        }
+        chars += s;
+        offsets.push_back(static_cast<int32_t>(chars.size()));
+    }
+};
+
+void release_array(ArrowArray* array) {
+    auto* exported = static_cast<ExportedArray*>(array->private_data);
+    for (ArrowArray* child : exported->children) {
+        if (child->release) child->release(child);
+        delete child;
+    }
+    if (exported->dictionary) {
+        if (exported->dictionary->release) exported->dictionary->release(exported->dictionary);
+        delete exported->dictionary;
+    }
+    delete exported;
+    array->release = nullptr;
+}
+
+void release_schema(ArrowSchema* schema) {
+    auto* exported = static_cast<ExportedSchema*>(schema->private_data);
+    for (ArrowSchema* child : exported->children) {
+        if (child->release) child->release(child);
+        delete child;
+    }
+    if (exported->dictionary) {
+        if (exported->dictionary->release) exported->dictionary->release(exported->dictionary);
+        delete exported->dictionary;
+    }
+    delete exported;
+    schema->release = nullptr;
+}
+
+// Points `array` at `exported`, whose buffers and children are already set
+void fill_array(ArrowArray* array, ExportedArray* exported, size_t length) {
+    array->length = static_cast<int64_t>(length);
+    array->null_count = 0;
+    array->offset = 0;
+    array->n_buffers = static_cast<int64_t>(exported->buffers.size());
+    array->n_children = static_cast<int64_t>(exported->children.size());
+    array->buffers = exported->buffers.data();
+    array->children = exported->children.empty() ? nullptr : exported->children.data();
+    array->dictionary = exported->dictionary;
+    array->release = release_array;
+    array->private_data = exported;
+}
+
+ArrowSchema* make_schema(const std::string& format, const std::string& name) {
+    auto* exported = new ExportedSchema{format, name, {}, nullptr};
+    auto* schema = new ArrowSchema{};
+    schema->format = exported->format.c_str();
+    schema->name = exported->name.c_str();
+    schema->metadata = nullptr;
+    schema->flags = 0;
+    schema->n_children = 0;
+    schema->children = nullptr;
+    schema->dictionary = nullptr;
+    schema->release = release_schema;
+    schema->private_data = exported;
+    return schema;
+}
+
+// Copies the whole dictionary when it is no larger than the batch's string
+// values, so the code buffers can be shared as they are. A larger dictionary
+// is cut down to the strings the batch references, keeping each export
+// proportional to the batch rather than to the dictionary.
+std::shared_ptr<DictionaryStrings> dictionary_strings(const ExecBatch& batch, const Dictionary* dict) {
+    auto strings = std::make_shared<DictionaryStrings>();
+    if (!dict) return strings;
+    size_t values = 0;
+    for (const ColumnSlice& slice : batch.columns) {
+        if (slice.type == TypeId::STRING) values += slice.length;
+    }
+    if (dict->size() <= values) {
+        strings->offsets.reserve(dict->size() + 1);
+        for (size_t code = 0; code < dict->size(); ++code) {
+            strings->append(dict->get(static_cast<StrId>(code)));
+        }
+        return strings;
+    }
+    for (const ColumnSlice& slice : batch.columns) {
+        if (slice.type != TypeId::STRING) continue;
+        const auto* codes = static_cast<const StrId*>(slice.data);
+        for (size_t i = 0; i < slice.length; ++i) {
+            auto [it, added] = strings->positions.try_emplace(codes[i], static_cast<StrId>(strings->positions.size()));
+            if (added) strings->append(dict->get(codes[i]));
+        }
+    }
+    return strings;
+}
+
+ArrowArray* export_column(const ColumnSlice& slice, const std::shared_ptr<DictionaryStrings>& strings) {
+    auto* exported = new ExportedArray{};
+    exported->keep = slice.owner;
+    const void* values = slice.data;
+    if (slice.type == TypeId::DATE32) {
+        const auto* dates = static_cast<const Date32*>(slice.data);
+        exported->days.resize(slice.length);
+        std::transform(dates, dates + slice.length, exported->days.begin(), date32_to_days);
+        values = exported->days.data();
+    } else if (slice.type == TypeId::STRING) {
+        if (!strings->positions.empty()) {
+            const auto* codes = static_cast<const StrId*>(slice.data);
+            exported->codes.resize(slice.length);
+            for (size_t i = 0; i < slice.length; ++i) {
+                exported->codes[i] = strings->positions.at(codes[i]);
+            }
+            values = exported->codes.data();
+        }
+        auto* dict = new ExportedArray{};
+        dict->keep = strings;
+        dict->buffers = {nullptr, strings->offsets.data(), strings->chars.data()};
+        exported->dictionary = new ArrowArray{};
+        fill_array(exported->dictionary, dict, strings->offsets.size() - 1);
+    }
+    exported->buffers = {nullptr, values};
+    auto* array = new ArrowArray{};
+    fill_array(array, exported, slice.length);
+    return array;
+}
+
+ArrowSchema* export_field(TypeId type, const std::string& name) {
+    switch (type) {
+        case TypeId::INT64: return make_schema("l", name);
+        case TypeId::DOUBLE: return make_schema("g", name);
+        case TypeId::DATE32: return make_schema("tdD", name);
+        case TypeId::STRING: {
+            ArrowSchema* schema = make_schema("I", name);
+            ArrowSchema* values = make_schema("u", "");
+            static_cast<ExportedSchema*>(schema->private_data)->dictionary = values;
+            schema->dictionary = values;
+            return schema;
+        }
+    }
+    throw std::runtime_error("Unsupported type for Arrow export");
+}
+
+// Column of a struct array, with the parent's offset folded in
+struct ImportedChild {
+    const ArrowSchema* schema;
+    const ArrowArray* array;
+    size_t offset;
+    size_t length;
+
+    template <typename T>
+    const T* buffer(size_t index) const {
+        return static_cast<const T*>(array->buffers[index]);
+    }
+};
+
+// Maps Arrow utf8 value `i` into the table dictionary
+StrId add_utf8(const ArrowArray& values, size_t i, Dictionary& dict) {
+    const auto* offsets = static_cast<const int32_t*>(values.buffers[1]) + values.offset;
+    const auto* chars = static_cast<const char*>(values.buffers[2]);
+    return dict.get_or_add(std::string_view(chars + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i])));
+}
+
+template <typename Index>
+std::vector<StrId> import_dictionary_indices(const ImportedChild& child, const std::string& name, Dictionary& dict) {
+    const ArrowArray& values = *child.array->dictionary;
+    if (std::strcmp(child.schema->dictionary->format, "u") != 0) {
+        throw std::runtime_error("Arrow column " + name + " has a non-utf8 dictionary");
+    }
+    if (values.null_count != 0 && values.buffers[0]) {
+        throw std::runtime_error("Arrow column " + name + " has nulls");
+    }
+    std::vector<StrId> codes(static_cast<size_t>(values.length));
+    for (size_t i = 0; i < codes.size(); ++i) {
+        codes[i] = add_utf8(values, i, dict);
+    }
+    const Index* indices = child.buffer<Index>(1) + child.offset;
+    std::vector<StrId> data(child.length);
+    for (size_t i = 0; i < child.length; ++i) {
+        auto index = static_cast<size_t>(indices[i]);
+        if (index >= codes.size()) {
+            throw std::runtime_error("Arrow column " + name + " has an out-of-range dictionary index");
+        }
+        data[i] = codes[index];
+    }
+    return data;
+}
+
+// Converts one child into a table column and its metadata. INT64 and DOUBLE
+// values stay in the Arrow buffer, kept alive by `owner`.
+std::unique_ptr<Column> import_column(const ImportedChild& child,
+                                      const std::shared_ptr<ArrowArray>& owner,
+                                      Dictionary& dict,
+                                      ColumnMeta& meta) {
+    std::string format = child.schema->format;
+    std::string name = child.schema->name ? child.schema->name : "";
+    if (child.array->null_count != 0 && child.array->buffers[0]) {
+        throw std::runtime_error("Arrow column " + name + " has nulls");
+    }
+
+    std::unique_ptr<Column> column;
+    if (child.schema->dictionary) {
+        if (!child.array->dictionary) {
+            throw std::runtime_error("Arrow column " + name + " is missing its dictionary");
+        }
+        meta.type = TypeId::STRING;
+        if (format == "i") {
+            column = std::make_unique<ColumnVector<StrId>>(import_dictionary_indices<int32_t>(child, name, dict));
+        } else if (format == "I") {
+            column = std::make_unique<ColumnVector<StrId>>(import_dictionary_indices<uint32_t>(child, name, dict));
+        } else if (format == "l") {
+            column = std::make_unique<ColumnVector<StrId>>(import_dictionary_indices<int64_t>(child, name, dict));
+        } else {
+            throw std::runtime_error("Unsupported Arrow dictionary index format '" + format + "' for column " + name);
+        }
+    } else if (format == "l") {
+        meta.type = TypeId::INT64;
+        column = std::make_unique<ColumnView<i64>>(child.buffer<i64>(1) + child.offset, child.length, owner);
+    } else if (format == "g") {
+        meta.type = TypeId::DOUBLE;
+        column = std::make_unique<ColumnView<f64>>(child.buffer<f64>(1) + child.offset, child.length, owner);
+    } else if (format == "i") {
+        meta.type = TypeId::INT64;
+        const int32_t* values = child.buffer<int32_t>(1) + child.offset;
+        column = std::make_unique<ColumnVector<i64>>(std::vector<i64>(values, values + child.length));
+    } else if (format == "tdD") {
+        meta.type = TypeId::DATE32;
+        const int32_t* values = child.buffer<int32_t>(1) + child.offset;
+        std::vector<Date32> data(child.length);
+        std::transform(values, values + child.length, data.begin(), days_to_date32);
+        column = std::make_unique<ColumnVector<Date32>>(std::move(data));
+    } else if (format == "u") {
+        meta.type = TypeId::STRING;
+        ArrowArray values = *child.array;
+        values.offset = static_cast<int64_t>(child.offset);
+        std::vector<StrId> data(child.length);
+        for (size_t i = 0; i < child.length; ++i) {
+            data[i] = add_utf8(values, i, dict);
+        }
+        column = std::make_unique<ColumnVector<StrId>>(std::move(data));
+    } else {
+        throw std::runtime_error("Unsupported Arrow format '" + format + "' for column " + name);
+    }
+
+    ColumnStats& stats = meta.stats;
+    switch (meta.type) {
+        case TypeId::INT64: {
+            auto values = column_values<i64>(*column);
+            if (!values.empty()) {
+                auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+                stats.min_i64 = *lo;
+                stats.max_i64 = *hi;
+            }
+            break;
+        }
+        case TypeId::DOUBLE: {
+            auto values = column_values<f64>(*column);
+            if (!values.empty()) {
+                auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+                stats.min_f64 = *lo;
+                stats.max_f64 = *hi;
+            }
+            break;
+        }
+        case TypeId::DATE32: {
+            auto values = column_values<Date32>(*column);
+            if (!values.empty()) {
+                auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+                stats.min_date = *lo;
+                stats.max_date = *hi;
+            }
+            break;
+        }
+        case TypeId::STRING:
+            break;
+    }
+    stats.ndv = estimate_ndv(*column);
+    return column;
+}
+
+} // namespace
+
+void export_batch(const ExecBatch& batch,
+                  const std::vector<std::string>& names,
+                  const Dictionary* dict,
+                  ArrowSchema* schema,
+                  ArrowArray* array) {
+    if (names.size() != batch.columns.size()) {
+        throw std::runtime_error("Arrow export needs one name per column");
+    }
+    bool has_strings = std::any_of(batch.columns.begin(), batch.columns.end(),
+                                   [](const ColumnSlice& slice) { return slice.type == TypeId::STRING; });
+    std::shared_ptr<DictionaryStrings> strings = has_strings ? dictionary_strings(batch, dict) : nullptr;
+
+    auto* exported_schema = new ExportedSchema{"+s", "", {}, nullptr};
+    auto* exported_array = new ExportedArray{};
+    exported_array->buffers = {nullptr};
+    for (size_t i = 0; i < batch.columns.size(); ++i) {
+        exported_schema->children.push_back(export_field(batch.columns[i].type, names[i]));
+        exported_array->children.push_back(export_column(batch.columns[i], strings));
+    }
+
+    schema->format = exported_schema->format.c_str();
+    schema->name = exported_schema->name.c_str();
+    schema->metadata = nullptr;
+    schema->flags = 0;
+    schema->n_children = static_cast<int64_t>(exported_schema->children.size());
+    schema->children = exported_schema->children.empty() ? nullptr : exported_schema->children.data();
+    schema->dictionary = nullptr;
+    schema->release = release_schema;
+    schema->private_data = exported_schema;
+
+    fill_array(array, exported_array, batch.length);
+}
+
+void export_table(const Table& table, ArrowSchema* schema, ArrowArray* array) {
+    ExecBatch batch;
+    std::vector<std::string> names;
+    for (const auto& column : table.columns) {
+        const Column& data = *column.data;
+        if (data.values()) {
+            batch.columns.push_back({data.values(), data.type(), data.size(), nullptr});
+        } else {
+            // Encoded columns are exported decoded; the array owns the copy
+            auto decoded = std::make_shared<std::vector<char>>(data.size() * type_width(data.type()));
+            data.decode(0, data.size(), decoded->data());
+            batch.columns.push_back({decoded->data(), data.type(), data.size(), decoded});
+        }
+        names.push_back(column.name);
+    }
+    batch.length = table.columns.empty() ? 0 : table.columns[0].data->size();
+    export_batch(batch, names, table.dict.get(), schema, array);
+}
+
+std::pair<Table, TableMeta> import_table(const std::string& name, const ArrowSchema* schema, ArrowArray* array) {
+    if (!array->release) {
+        throw std::runtime_error("Arrow array was already released");
+    }
+    if (std::strcmp(schema->format, "+s") != 0) {
+        throw std::runtime_error("Arrow import expects a struct array, got '" + std::string(schema->format) + "'");
+    }
+    if (array->n_children != schema->n_children) {
+        throw std::runtime_error("Arrow array and schema disagree on the column count");
+    }
+
+    // Move the array: from here on the table decides when it is released
+    std::shared_ptr<ArrowArray> owner(new ArrowArray(*array), [](ArrowArray* moved) {
+        if (moved->release) moved->release(moved);
+        delete moved;
+    });
+    array->release = nullptr;
+
+    Table table;
+    table.name = name;
+    table.dict = std::make_shared<Dictionary>();
+    std::vector<ColumnMeta> column_metas;
+    for (int64_t i = 0; i < schema->n_children; ++i) {
+        const ArrowArray* child_array = owner->children[i];
+        ImportedChild child{schema->children[i], child_array,
+                            static_cast<size_t>(owner->offset + child_array->offset),
+                            static_cast<size_t>(owner->length)};
+        ColumnMeta meta(child.schema->name ? child.schema->name : "", TypeId::INT64);
+        TableColumn column;
+        column.name = meta.name;
+        column.data = import_column(child, owner, *table.dict, meta);
+        table.columns.push_back(std::move(column));
+        column_metas.push_back(std::move(meta));
+    }
+
+    TableMeta meta(name, std::move(column_metas), static_cast<size_t>(owner->length));
+    return {std::move(table), std::move(meta)};
+}
+
+} // namespace bosql
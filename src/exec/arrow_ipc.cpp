@@ -0,0 +1,373 @@
+#include "exec/arrow_ipc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include "storage/dictionary.h"
+
+namespace bosql {
+
+namespace {
+
+// Arrow format enums (format/Message.fbs and format/Schema.fbs)
+constexpr int16_t kMetadataV5 = 4;
+constexpr uint8_t kHeaderSchema = 1;
+constexpr uint8_t kHeaderDictionaryBatch = 2;
+constexpr uint8_t kHeaderRecordBatch = 3;
+constexpr uint8_t kTypeInt = 2;
+constexpr uint8_t kTypeFloatingPoint = 3;
+constexpr uint8_t kTypeUtf8 = 5;
+constexpr uint8_t kTypeDate = 8;
+constexpr int16_t kPrecisionDouble = 2;
+constexpr int16_t kDateUnitDay = 0;
+constexpr int64_t kStringDictionaryId = 0;
+constexpr uint32_t kContinuation = 0xFFFFFFFF;
+
+class FlatWriter;
+using ChildWriter = std::function<size_t(FlatWriter&)>;
+
+// One field of a FlatBuffers table: a scalar stored in the table, or an
+// offset to a child (string, vector, table) written after it
+struct FlatField {
+    uint16_t slot;
+    size_t size;
+    uint64_t bits = 0;
+    ChildWriter child;
+
+    template <typename T>
+    static FlatField scalar(uint16_t slot, T value) {
+        FlatField field{slot, sizeof(T), 0, {}};
+        std::memcpy(&field.bits, &value, sizeof(T));
+        return field;
+    }
+
+    static FlatField offset(uint16_t slot, ChildWriter child) {
+        return {slot, sizeof(uint32_t), 0, std::move(child)};
+    }
+};
+
+struct BufferSpec {
+    int64_t offset;
+    int64_t length;
+};
+
+// Minimal FlatBuffers writer for the IPC metadata. It writes front to back:
+// each table is preceded by its vtable and followed by its children, and a
+// field's offset is patched once its child has been placed. Positions are
+// relative to the start of the buffer, which the stream keeps 8-aligned.
+class FlatWriter {
+public:
+    FlatWriter() { put<uint32_t>(0); }  // root table offset
+
+    size_t position() const { return bytes.size(); }
+
+    void align(size_t alignment) {
+        bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, '\0');
+    }
+
+    template <typename T>
+    void put(T value) {
+        char raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        bytes.append(raw, sizeof(T));
+    }
+
+    template <typename T>
+    void patch(size_t at, T value) {
+        std::memcpy(bytes.data() + at, &value, sizeof(T));
+    }
+
+    size_t table(std::vector<FlatField> fields) {
+        // Widest fields first keeps every field naturally aligned
+        std::stable_sort(fields.begin(), fields.end(), [](const auto& a, const auto& b) { return a.size > b.size; });
+        size_t slots = 0;
+        size_t table_size = sizeof(int32_t);
+        size_t table_alignment = sizeof(int32_t);
+        std::vector<size_t> field_offsets;
+        for (const auto& field : fields) {
+            slots = std::max<size_t>(slots, field.slot + 1);
+            table_size = (table_size + field.size - 1) / field.size * field.size;
+            field_offsets.push_back(table_size);
+            table_size += field.size;
+            table_alignment = std::max(table_alignment, field.size);
+        }
+
+        align(sizeof(uint16_t));
+        size_t vtable = position();
+        put<uint16_t>(static_cast<uint16_t>(4 + 2 * slots));
+        put<uint16_t>(static_cast<uint16_t>(table_size));
+        std::vector<uint16_t> slot_offsets(slots, 0);
+        for (size_t i = 0; i < fields.size(); ++i) {
+            slot_offsets[fields[i].slot] = static_cast<uint16_t>(field_offsets[i]);
+        }
+        for (uint16_t offset : slot_offsets) {
+            put<uint16_t>(offset);
+        }
+
+        align(table_alignment);
+        size_t start = position();
+        bytes.resize(start + table_size, '\0');
+        patch<int32_t>(start, static_cast<int32_t>(start - vtable));
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (!fields[i].child) {
+                std::memcpy(bytes.data() + start + field_offsets[i], &fields[i].bits, fields[i].size);
+            }
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i].child) {
+                size_t at = start + field_offsets[i];
+                size_t child = fields[i].child(*this);
+                patch<uint32_t>(at, static_cast<uint32_t>(child - at));
+            }
+        }
+        return start;
+    }
+
+    size_t string(const std::string& value) {
+        align(sizeof(uint32_t));
+        size_t start = position();
+        put<uint32_t>(static_cast<uint32_t>(value.size()));
+        bytes.append(value);
+        bytes.push_back('\0');
+        return start;
+    }
+
+    size_t table_vector(size_t count, const std::function<size_t(FlatWriter&, size_t)>& element) {
+        align(sizeof(uint32_t));
+        size_t start = position();
+        put<uint32_t>(static_cast<uint32_t>(count));
+        bytes.resize(start + sizeof(uint32_t) * (count + 1), '\0');
+        for (size_t i = 0; i < count; ++i) {
+            size_t at = start + sizeof(uint32_t) * (i + 1);
+            size_t child = element(*this, i);
+            patch<uint32_t>(at, static_cast<uint32_t>(child - at));
+        }
+        return start;
+    }
+
+    // Vector of FieldNode or Buffer structs: two int64 each
+    size_t pair_vector(const std::vector<BufferSpec>& pairs) {
+        align(sizeof(uint32_t));
+        if (position() % 8 == 0) put<uint32_t>(0);  // elements must be 8-aligned
+        size_t start = position();
+        put<uint32_t>(static_cast<uint32_t>(pairs.size()));
+        for (const auto& pair : pairs) {
+            put<int64_t>(pair.offset);
+            put<int64_t>(pair.length);
+        }
+        return start;
+    }
+
+    std::string finish(size_t root) {
+        patch<uint32_t>(0, static_cast<uint32_t>(root));
+        return std::move(bytes);
+    }
+
+private:
+    std::string bytes;
+};
+
+FlatField int_type(uint16_t slot, int32_t bit_width, bool is_signed) {
+    return FlatField::offset(slot, [=](FlatWriter& w) {
+        return w.table({FlatField::scalar<int32_t>(0, bit_width), FlatField::scalar<uint8_t>(1, is_signed)});
+    });
+}
+
+size_t write_field(FlatWriter& w, const std::string& name, TypeId type) {
+    std::vector<FlatField> fields;
+    fields.push_back(FlatField::offset(0, [&](FlatWriter& fw) { return fw.string(name); }));
+    fields.push_back(FlatField::scalar<uint8_t>(1, 0));  // not nullable
+    switch (type) {
+        case TypeId::INT64:
+            fields.push_back(FlatField::scalar<uint8_t>(2, kTypeInt));
+            fields.push_back(int_type(3, 64, true));
+            break;
+        case TypeId::DOUBLE:
+            fields.push_back(FlatField::scalar<uint8_t>(2, kTypeFloatingPoint));
+            fields.push_back(FlatField::offset(3, [](FlatWriter& fw) {
+                return fw.table({FlatField::scalar<int16_t>(0, kPrecisionDouble)});
+            }));
+            break;
+        case TypeId::DATE32:
+            fields.push_back(FlatField::scalar<uint8_t>(2, kTypeDate));
+            fields.push_back(FlatField::offset(3, [](FlatWriter& fw) {
+                return fw.table({FlatField::scalar<int16_t>(0, kDateUnitDay)});
+            }));
+            break;
+        case TypeId::STRING:
+            fields.push_back(FlatField::scalar<uint8_t>(2, kTypeUtf8));
+            fields.push_back(FlatField::offset(3, [](FlatWriter& fw) { return fw.table({}); }));
+            // DictionaryEncoding{id, indexType: uint32}
+            fields.push_back(FlatField::offset(4, [](FlatWriter& fw) {
+                return fw.table({FlatField::scalar<int64_t>(0, kStringDictionaryId), int_type(1, 32, false)});
+            }));
+            break;
+    }
+    fields.push_back(FlatField::offset(5, [](FlatWriter& fw) {
+        return fw.table_vector(0, [](FlatWriter&, size_t) { return size_t{0}; });
+    }));
+    return w.table(std::move(fields));
+}
+
+// RecordBatch table: one node per column (no nulls) and the body buffers
+size_t write_record_batch(FlatWriter& w, int64_t length, size_t columns, const std::vector<BufferSpec>& buffers) {
+    std::vector<BufferSpec> nodes(columns, BufferSpec{length, 0});
+    return w.table({
+        FlatField::scalar<int64_t>(0, length),
+        FlatField::offset(1, [&](FlatWriter& fw) { return fw.pair_vector(nodes); }),
+        FlatField::offset(2, [&](FlatWriter& fw) { return fw.pair_vector(buffers); }),
+    });
+}
+
+// Lays out body buffers with the 8-byte alignment the format requires
+struct Body {
+    std::vector<BufferSpec> specs;
+    std::vector<std::pair<const void*, size_t>> data;
+    size_t bytes = 0;
+
+    void add(const void* source, size_t length) {
+        specs.push_back({static_cast<int64_t>(bytes), static_cast<int64_t>(length)});
+        data.emplace_back(source, length);
+        bytes += (length + 7) / 8 * 8;
+    }
+};
+
+std::string message_metadata(uint8_t header_type, ChildWriter header, size_t body_bytes) {
+    FlatWriter w;
+    size_t root = w.table({
+        FlatField::scalar<int16_t>(0, kMetadataV5),
+        FlatField::scalar<uint8_t>(1, header_type),
+        FlatField::offset(2, std::move(header)),
+        FlatField::scalar<int64_t>(3, static_cast<int64_t>(body_bytes)),
+    });
+    return w.finish(root);
+}
+
+} // namespace
+
+ArrowIpcFormatter::ArrowIpcFormatter(std::ostream& stream) : Formatter(stream) {}
+
+void ArrowIpcFormatter::begin(const std::vector<std::string>& column_names, const std::vector<TypeId>& column_types) {
+    names = column_names;
+    types = column_types;
+    schema_written = false;
+    dictionary_written = false;
+}
+
+void ArrowIpcFormatter::write_schema() {
+    // Field names may be missing when the planner could not name an output
+    names.resize(types.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i].empty()) names[i] = "col" + std::to_string(i + 1);
+    }
+    emit_metadata(message_metadata(kHeaderSchema, [&](FlatWriter& w) {
+        return w.table({FlatField::offset(1, [&](FlatWriter& fw) {
+            return fw.table_vector(names.size(), [&](FlatWriter& vw, size_t i) {
+                return write_field(vw, names[i], types[i]);
+            });
+        })});
+    }, 0));
+    schema_written = true;
+}
+
+void ArrowIpcFormatter::write_batch(const ExecBatch& batch, const Dictionary* dict) {
+    if (!schema_written) {
+        // The batches' physical types are authoritative: the declared output
+        // types can differ, e.g. for SUM over doubles
+        types.clear();
+        for (const auto& slice : batch.columns) {
+            types.push_back(slice.type);
+        }
+        write_schema();
+    }
+    if (!dictionary_written && std::find(types.begin(), types.end(), TypeId::STRING) != types.end()) {
+        write_dictionary(dict);
+    }
+    // DATE32 columns are converted into `days`, sized up front so the
+    // converted values stay put until the body is written
+    size_t date_columns = std::count_if(batch.columns.begin(), batch.columns.end(),
+                                        [](const auto& slice) { return slice.type == TypeId::DATE32; });
+    days.resize(date_columns * batch.length);
+    size_t next_days = 0;
+    Body body;
+    for (const auto& slice : batch.columns) {
+        body.add(nullptr, 0);
+        if (slice.type == TypeId::DATE32) {
+            auto dates = static_cast<const Date32*>(slice.data);
+            int32_t* out = days.data() + next_days;
+            for (size_t row = 0; row < batch.length; ++row) {
+                out[row] = date32_to_days(dates[row]);
+            }
+            next_days += batch.length;
+            body.add(out, batch.length * sizeof(int32_t));
+        } else {
+            body.add(slice.data, batch.length * type_width(slice.type));
+        }
+    }
+    emit_metadata(message_metadata(kHeaderRecordBatch, [&](FlatWriter& w) {
+        return write_record_batch(w, static_cast<int64_t>(batch.length), batch.columns.size(), body.specs);
+    }, body.bytes));
+    for (const auto& [data, length] : body.data) {
+        emit_body(data, length);
+    }
+}
+
+void ArrowIpcFormatter::end(std::size_t row_count) {
+    (void)row_count;
+    if (!schema_written) {
+        write_schema();
+    }
+    // End-of-stream marker
+    emit(std::string_view("\xFF\xFF\xFF\xFF\0\0\0\0", 8));
+    flush();
+}
+
+void ArrowIpcFormatter::write_dictionary(const Dictionary* dict) {
+    const size_t count = dict ? dict->size() : 0;
+    std::vector<int32_t> offsets;
+    offsets.reserve(count + 1);
+    offsets.push_back(0);
+    std::string data;
+    for (size_t code = 0; code < count; ++code) {
+        data.append(dict->get(static_cast<StrId>(code)));
+        if (data.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+            throw std::runtime_error("Dictionary too large for Arrow output");
+        }
+        offsets.push_back(static_cast<int32_t>(data.size()));
+    }
+    Body body;
+    body.add(nullptr, 0);
+    body.add(offsets.data(), offsets.size() * sizeof(int32_t));
+    body.add(data.data(), data.size());
+    emit_metadata(message_metadata(kHeaderDictionaryBatch, [&](FlatWriter& w) {
+        return w.table({
+            FlatField::scalar<int64_t>(0, kStringDictionaryId),
+            FlatField::offset(1, [&](FlatWriter& fw) {
+                return write_record_batch(fw, static_cast<int64_t>(count), 1, body.specs);
+            }),
+        });
+    }, body.bytes));
+    for (const auto& [bytes, length] : body.data) {
+        emit_body(bytes, length);
+    }
+    dictionary_written = true;
+}
+
+void ArrowIpcFormatter::emit_metadata(const std::string& metadata) {
+    // Continuation marker and the metadata size, padded so the body that
+    // follows starts 8-aligned
+    size_t padded = (metadata.size() + 7) / 8 * 8;
+    uint32_t prefix[2] = {kContinuation, static_cast<uint32_t>(padded)};
+    emit(std::string_view(reinterpret_cast<const char*>(prefix), sizeof(prefix)));
+    emit(metadata);
+    buffer.append(padded - metadata.size(), '\0');
+}
+
+void ArrowIpcFormatter::emit_body(const void* data, size_t length) {
+    emit(std::string_view(static_cast<const char*>(data), length));
+    buffer.append((length + 7) / 8 * 8 - length, '\0');
+}
+
+} // namespace bosql
@@ -0,0 +1,176 @@
+#include "exec/buffer_pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+#include "exec/memory.h"
+
+namespace bosql {
+
+namespace {
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+// Deleter of a pooled buffer's owner
+struct BufferPool::Release {
+    BufferPool* pool;
+    size_t size_class;  // kClasses for buffers that bypass the pool
+    size_t bytes;
+    std::shared_ptr<MemoryTracker> tracker;
+
+    void operator()(void* data) const {
+        if (tracker) tracker->release(bytes);
+        pool->release(data, size_class);
+    }
+};
+
+// Takes shared_ptr control blocks from the pool's small-block free lists
+template <typename T>
+struct BufferPool::BlockAllocator {
+    using value_type = T;
+
+    explicit BlockAllocator(BufferPool* pool_in) : pool(pool_in) {}
+    template <typename U>
+    BlockAllocator(const BlockAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool->allocate_block(n * sizeof(T))); }
+    void deallocate(T* block, size_t n) { pool->deallocate_block(block, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const BlockAllocator<U>& other) const { return pool == other.pool; }
+
+    BufferPool* pool;
+};
+
+BufferPool::BufferPool(size_t max_cached_bytes) : max_cached(max_cached_bytes) {}
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+BufferPool& BufferPool::global() {
+    // Never destroyed: buffers may be released during static destruction
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+PooledBuffer BufferPool::allocate(size_t bytes) {
+    size_t rounded = std::max(bytes, size_t{1} << kMinClassBits);
+    size_t size_class = std::bit_width(rounded - 1) - kMinClassBits;
+    size_t capacity = size_class < kClasses ? size_t{1} << (size_class + kMinClassBits)
+                                            : round_up(bytes, kBufferAlignment);
+    size_class = std::min(size_class, kClasses);
+
+    // Charge first, so a query over its limit fails before taking anything
+    MemoryTracker* tracker = current_memory_tracker();
+    if (tracker) tracker->consume(capacity);
+
+    void* data = nullptr;
+    if (size_class < kClasses) {
+        FreeList& list = buffers[size_class];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (!list.entries.empty()) {
+            data = list.entries.back();
+            list.entries.pop_back();
+        }
+    }
+    if (data) {
+        cached.fetch_sub(capacity, std::memory_order_relaxed);
+        reused.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        try {
+            data = ::operator new(capacity, std::align_val_t{kBufferAlignment});
+        } catch (...) {
+            if (tracker) tracker->release(capacity);
+            throw;
+        }
+        fresh.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Release release{this, size_class, capacity, tracker ? tracker->shared_from_this() : nullptr};
+    return {data, capacity, std::shared_ptr<void>(data, std::move(release), BlockAllocator<char>(this))};
+}
+
+void BufferPool::release(void* data, size_t size_class) {
+    if (size_class < kClasses && reserve_cache(size_t{1} << (size_class + kMinClassBits))) {
+        FreeList& list = buffers[size_class];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.entries.push_back(data);
+        return;
+    }
+    ::operator delete(data, std::align_val_t{kBufferAlignment});
+}
+
+bool BufferPool::reserve_cache(size_t bytes) {
+    size_t limit = max_cached.load(std::memory_order_relaxed);
+    size_t current = cached.load(std::memory_order_relaxed);
+    do {
+        if (current + bytes > limit) return false;
+    } while (!cached.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+void* BufferPool::allocate_block(size_t bytes) {
+    size_t block_class = (bytes - 1) / kBlockGranule;
+    if (block_class < kBlockClasses) {
+        FreeList& list = blocks[block_class];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (!list.entries.empty()) {
+            void* block = list.entries.back();
+            list.entries.pop_back();
+            return block;
+        }
+        return ::operator new((block_class + 1) * kBlockGranule);
+    }
+    return ::operator new(bytes);
+}
+
+void BufferPool::deallocate_block(void* block, size_t bytes) {
+    size_t block_class = (bytes - 1) / kBlockGranule;
+    // Control blocks are only kept while buffers are: they are tiny, and
+    // their number is bounded by the buffers alive at once
+    if (block_class < kBlockClasses && max_cached.load(std::memory_order_relaxed) > 0) {
+        FreeList& list = blocks[block_class];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.entries.push_back(block);
+        return;
+    }
+    ::operator delete(block);
+}
+
+void BufferPool::set_max_cached_bytes(size_t bytes) {
+    max_cached.store(bytes, std::memory_order_relaxed);
+    if (cached.load(std::memory_order_relaxed) > bytes) {
+        trim();
+    }
+}
+
+void BufferPool::trim() {
+    for (size_t size_class = 0; size_class < kClasses; ++size_class) {
+        FreeList& list = buffers[size_class];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        for (void* data : list.entries) {
+            ::operator delete(data, std::align_val_t{kBufferAlignment});
+        }
+        cached.fetch_sub(list.entries.size() << (size_class + kMinClassBits), std::memory_order_relaxed);
+        list.entries.clear();
+    }
+    for (FreeList& list : blocks) {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        for (void* block : list.entries) {
+            ::operator delete(block);
+        }
+        list.entries.clear();
+    }
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    return {fresh.load(std::memory_order_relaxed), reused.load(std::memory_order_relaxed),
+            cached.load(std::memory_order_relaxed)};
+}
+
+} // namespace bosql
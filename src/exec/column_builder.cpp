@@ -0,0 +1,216 @@
+#include "exec/column_builder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace bosql {
+
+ColumnBuilder::ColumnBuilder(TypeId type, size_t expected_rows)
+    : column_type(type), builder(std::in_place_type<TypedColumnBuilder<int64_t>>, expected_rows) {
+    switch (type) {
+        case TypeId::INT64:
+            break;
+        case TypeId::DOUBLE:
+            builder.emplace<TypedColumnBuilder<double>>(expected_rows);
+            break;
+        case TypeId::STRING:
+            builder.emplace<TypedColumnBuilder<uint32_t>>(expected_rows);
+            break;
+        case TypeId::DATE32:
+            builder.emplace<TypedColumnBuilder<int32_t>>(expected_rows);
+            break;
+    }
+}
+
+size_t ColumnBuilder::size() const {
+    return std::visit([](const auto& typed) { return typed.size(); }, builder);
+}
+
+namespace {
+
+// Values of an encoded slice at ascending `rows`; RLE walks its runs forward
+template <typename T, typename Rows>
+void decode_rows(const ColumnSlice& slice, const Rows& rows, T* out) {
+    const T* values = static_cast<const T*>(slice.data);
+    switch (slice.kind) {
+        case VectorKind::Flat:
+            for (size_t i = 0; i < rows.size(); ++i) out[i] = values[rows[i]];
+            return;
+        case VectorKind::Constant:
+            std::fill(out, out + rows.size(), values[0]);
+            return;
+        case VectorKind::Dictionary:
+            for (size_t i = 0; i < rows.size(); ++i) out[i] = values[slice.codes[rows[i]]];
+            return;
+        case VectorKind::Narrow:
+            for (size_t i = 0; i < rows.size(); ++i) out[i] = static_cast<T>(slice.narrow_value(rows[i]));
+            return;
+        case VectorKind::Rle: {
+            size_t run = rows.size() == 0 ? 0 : slice.position(rows[0]);
+            for (size_t i = 0; i < rows.size(); ++i) {
+                if (i > 0 && rows[i] < rows[i - 1]) run = slice.position(rows[i]);
+                while (slice.run_ends[run] <= rows[i]) ++run;
+                out[i] = values[run];
+            }
+            return;
+        }
+    }
+}
+
+// Row numbers offset, offset + 1, ... without materializing them
+struct RowRange {
+    size_t offset;
+    size_t count;
+    size_t size() const { return count; }
+    size_t operator[](size_t i) const { return offset + i; }
+};
+
+}
+
+void ColumnBuilder::gather(const ColumnSlice& slice, std::span<const size_t> indices) {
+    if (slice.type != column_type) {
+        throw std::runtime_error("Type mismatch");
+    }
+    visit([&](auto& typed) {
+        using T = typename std::decay_t<decltype(typed)>::value_type;
+        if (slice.flat()) {
+            typed.gather(static_cast<const T*>(slice.data), indices);
+        } else {
+            decode_rows(slice, indices, typed.extend(indices.size()));
+        }
+    });
+}
+
+void ColumnBuilder::append(const ColumnSlice& slice, size_t offset, size_t rows) {
+    if (slice.type != column_type) {
+        throw std::runtime_error("Type mismatch");
+    }
+    visit([&](auto& typed) {
+        using T = typename std::decay_t<decltype(typed)>::value_type;
+        if (slice.flat()) {
+            typed.append(std::span<const T>(static_cast<const T*>(slice.data) + offset, rows));
+        } else {
+            decode_rows(slice, RowRange{offset, rows}, typed.extend(rows));
+        }
+    });
+}
+
+void ColumnBuilder::append(std::span<const Datum> values) {
+    visit([&](auto& typed) {
+        using T = typename std::decay_t<decltype(typed)>::value_type;
+        T* out = typed.extend(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            out[i] = datum_as<T>(values[i]);
+        }
+    });
+}
+
+ColumnSlice ColumnBuilder::finish() {
+    return visit([&](auto& typed) { return typed.finish(column_type); });
+}
+
+void flatten(ExecBatch& batch) {
+    for (auto& slice : batch.columns) {
+        if (slice.flat()) continue;
+        ColumnBuilder builder(slice.type, slice.length);
+        builder.append(slice, 0, slice.length);
+        slice = builder.finish();
+    }
+}
+
+bool runs_only(const ExecBatch& batch, std::span<const size_t> columns) {
+    return std::all_of(columns.begin(), columns.end(), [&](size_t column) {
+        VectorKind kind = batch.columns[column].kind;
+        return kind == VectorKind::Constant || kind == VectorKind::Rle;
+    });
+}
+
+void segment_starts(const ExecBatch& batch, std::span<const size_t> columns, std::vector<size_t>& starts) {
+    starts.clear();
+    if (batch.length == 0) return;
+    starts.push_back(0);
+    for (size_t column : columns) {
+        const ColumnSlice& slice = batch.columns[column];
+        if (slice.kind == VectorKind::Rle) {
+            starts.insert(starts.end(), slice.run_ends, slice.run_ends + slice.value_count - 1);
+        } else if (slice.kind != VectorKind::Constant) {
+            throw std::runtime_error("Segments need constant or RLE columns");
+        }
+    }
+    if (columns.size() > 1) {
+        std::sort(starts.begin(), starts.end());
+        starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    }
+    starts.push_back(batch.length);
+}
+
+namespace {
+
+// Runs of `slice` restricted to `ranges`. Ranges that fall in the same input
+// run share an output run, since their rows hold the same value.
+template <typename T>
+ColumnSlice select_runs(const ColumnSlice& slice, std::span<const std::pair<size_t, size_t>> ranges) {
+    const size_t max_runs = slice.value_count + ranges.size();
+    const size_t values_bytes = (max_runs * sizeof(T) + 7) / 8 * 8;
+    PooledBuffer buffer = BufferPool::global().allocate(values_bytes + max_runs * sizeof(uint32_t));
+    count_allocation(buffer.capacity);
+    T* values = static_cast<T*>(buffer.data);
+    auto* ends = reinterpret_cast<uint32_t*>(static_cast<char*>(buffer.data) + values_bytes);
+    const T* source = static_cast<const T*>(slice.data);
+
+    size_t runs = 0;
+    size_t rows = 0;
+    size_t last_run = slice.value_count;
+    for (const auto& [begin, end] : ranges) {
+        for (size_t row = begin, run = slice.position(begin); row < end; ++run) {
+            size_t stop = std::min<size_t>(slice.run_ends[run], end);
+            rows += stop - row;
+            if (run != last_run) {
+                values[runs++] = source[run];
+                last_run = run;
+            }
+            ends[runs - 1] = static_cast<uint32_t>(rows);
+            row = stop;
+        }
+    }
+    ColumnSlice out{values, slice.type, rows, std::move(buffer.owner)};
+    out.kind = runs == 1 ? VectorKind::Constant : VectorKind::Rle;
+    out.value_count = runs;
+    out.run_ends = ends;
+    return out;
+}
+
+}
+
+void select_ranges(ExecBatch& batch, std::span<const std::pair<size_t, size_t>> ranges) {
+    size_t rows = 0;
+    for (const auto& [begin, end] : ranges) rows += end - begin;
+    for (auto& slice : batch.columns) {
+        switch (slice.kind) {
+            case VectorKind::Constant:
+                slice.length = rows;
+                break;
+            case VectorKind::Rle:
+                switch (slice.type) {
+                    case TypeId::INT64: slice = select_runs<int64_t>(slice, ranges); break;
+                    case TypeId::DOUBLE: slice = select_runs<double>(slice, ranges); break;
+                    case TypeId::STRING: slice = select_runs<uint32_t>(slice, ranges); break;
+                    case TypeId::DATE32: slice = select_runs<int32_t>(slice, ranges); break;
+                }
+                break;
+            case VectorKind::Flat:
+            case VectorKind::Dictionary:
+            case VectorKind::Narrow: {
+                ColumnBuilder builder(slice.type, rows);
+                for (const auto& [begin, end] : ranges) {
+                    builder.append(slice, begin, end - begin);
+                }
+                slice = builder.finish();
+                break;
+            }
+        }
+    }
+    batch.length = rows;
+}
+
+} // namespace bosql
@@ -1,7 +1,6 @@
 #include "exec/operator.hpp"
 #include <vector>
 #include <string>
-#include <iostream>
 
 namespace bosql {
 
@@ -10,51 +9,16 @@ void run_query(std::unique_ptr<Operator> root,
                const std::vector<TypeId>& col_types,
                Formatter& formatter,
                const Dictionary* dict) {
+    // A join may have given the output codes in a query-local overlay of
+    // the catalog dictionary
+    if (root->dictionary()) dict = root->dictionary();
     formatter.begin(col_names, col_types);
     root->open();
     ExecBatch batch;
     std::size_t row_count = 0;
     while (root->next(batch)) {
-        for (size_t i = 0; i < batch.length; ++i) {
-            std::vector<std::string> row;
-            for (size_t j = 0; j < batch.columns.size(); ++j) {
-                auto& slice = batch.columns[j];
-                std::string value;
-                switch (slice.type) {
-                    case TypeId::INT64: {
-                        auto col = get_col<int64_t>(batch, j);
-                        value = std::to_string(col[i]);
-                        break;
-                    }
-                    case TypeId::DOUBLE: {
-                        auto col = get_col<double>(batch, j);
-                        value = std::to_string(col[i]);
-                        break;
-                    }
-                    case TypeId::STRING: {
-                        auto col = get_col<uint32_t>(batch, j);
-                        if (dict) {
-                            value = dict->get(col[i]);
-                        } else {
-                            value = std::to_string(col[i]); // fallback to code
-                        }
-                        break;
-                    }
-                    case TypeId::DATE32: {
-                        auto col = get_col<int32_t>(batch, j);
-                        // For now, print as int
-                        value = std::to_string(col[i]);
-                        break;
-                    }
-                    default:
-                        value = "?";
-                        break;
-                }
-                row.push_back(value);
-            }
-            formatter.write_row(std::move(row));
-            ++row_count;
-        }
+        formatter.write_batch(batch, dict);
+        row_count += batch.length;
     }
     root->close();
     formatter.end(row_count);
@@ -1,4 +1,7 @@
 #include "exec/expression.h"
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <stdexcept>
 #include <cmath>
 #include <limits>
@@ -124,11 +127,48 @@ Datum evaluate_internal(const Expr* expr,
                         size_t row,
                         const ExprBindings& bindings);
 
+}
+
+bool like_match(std::string_view text, std::string_view pattern) {
+    // Greedy match that only ever backtracks to the most recent %
+    size_t t = 0, p = 0;
+    size_t star = std::string_view::npos, resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && pattern[p] == '%') {
+            star = p++;
+            resume = t;
+        } else if (p < pattern.size() && (pattern[p] == '_' || pattern[p] == text[t])) {
+            ++t;
+            ++p;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '%') ++p;
+    return p == pattern.size();
+}
+
+namespace {
+
 Datum read_column(size_t index,
                   const ExecBatch& batch,
                   size_t row,
                   const std::vector<TypeId>& types) {
     const auto& slice = batch.columns[index];
+    if (slice.kind == VectorKind::Narrow) {
+        int64_t value = slice.narrow_value(row);
+        switch (types[index]) {
+            case TypeId::INT64: return Datum::from_i64(value);
+            case TypeId::STRING: return Datum::from_str(static_cast<uint32_t>(value));
+            case TypeId::DATE32: return Datum::from_date32(static_cast<int32_t>(value));
+            case TypeId::DOUBLE: break;
+        }
+        throw std::runtime_error("Narrow column of non-integer type");
+    }
+    if (!slice.flat()) row = slice.position(row);
     switch (types[index]) {
         case TypeId::INT64: {
             auto ptr = reinterpret_cast<const int64_t*>(slice.data);
@@ -170,9 +210,20 @@ Datum evaluate_internal(const Expr* expr,
             if (!bindings.dictionary) {
                 throw std::runtime_error("String literal without dictionary binding");
             }
-            return Datum::from_str(bindings.dictionary->get_or_add(expr->str_val));
+            // A string the dictionary has never seen cannot match any row
+            auto id = bindings.dictionary->find(expr->str_val);
+            return Datum::from_str(id ? *id : kInvalidStrId);
         }
         case ExprType::BINARY_OP: {
+            if (expr->op == BinaryOp::LIKE || expr->op == BinaryOp::NOT_LIKE) {
+                Datum text = evaluate_internal(expr->left.get(), batch, row, bindings);
+                if (text.type != TypeId::STRING || expr->right->type != ExprType::LITERAL_STRING) {
+                    throw std::runtime_error("LIKE needs a string operand and a string pattern");
+                }
+                bool matched = text.value.str_id != kInvalidStrId &&
+                               like_match(bindings.dictionary->get(text.value.str_id), expr->right->str_val);
+                return Datum::from_i64(matched == (expr->op == BinaryOp::LIKE) ? 1 : 0);
+            }
             Datum left = evaluate_internal(expr->left.get(), batch, row, bindings);
             Datum right = evaluate_internal(expr->right.get(), batch, row, bindings);
             switch (expr->op) {
@@ -196,11 +247,25 @@ Datum evaluate_internal(const Expr* expr,
                     bool result = is_truthy(left) || is_truthy(right);
                     return Datum::from_i64(result ? 1 : 0);
                 }
+                default:
+                    break;
             }
             throw std::runtime_error("Unsupported binary operator");
         }
         case ExprType::FUNC_CALL:
             throw std::runtime_error("Function calls not supported in expression evaluation");
+        case ExprType::IN_LIST: {
+            Datum value = evaluate_internal(expr->left.get(), batch, row, bindings);
+            bool found = false;
+            for (const auto& arg : expr->args) {
+                Datum candidate = evaluate_internal(arg.get(), batch, row, bindings);
+                if (is_truthy(compare_values(value, candidate, BinaryOp::EQ))) {
+                    found = true;
+                    break;
+                }
+            }
+            return Datum::from_i64(found == (expr->op == BinaryOp::EQ) ? 1 : 0);
+        }
     }
     throw std::runtime_error("Unknown expression type");
 }
@@ -235,4 +300,322 @@ bool evaluate_predicate(const Expr* expr,
     return is_truthy(value);
 }
 
+void referenced_columns(const Expr* expr, const ExprBindings& bindings, std::vector<size_t>& columns) {
+    if (!expr) return;
+    if (expr->type == ExprType::COLUMN_REF) {
+        auto it = bindings.name_to_index.find(expr->str_val);
+        if (it != bindings.name_to_index.end() &&
+            std::find(columns.begin(), columns.end(), it->second) == columns.end()) {
+            columns.push_back(it->second);
+        }
+        return;
+    }
+    referenced_columns(expr->left.get(), bindings, columns);
+    referenced_columns(expr->right.get(), bindings, columns);
+    for (const auto& arg : expr->args) {
+        referenced_columns(arg.get(), bindings, columns);
+    }
+}
+
+namespace {
+
+void collect_comparisons(const Expr* expr, const ExprBindings& bindings, std::vector<ColumnComparison>& out, bool& matched) {
+    if (!matched) return;
+    if (expr->type == ExprType::BINARY_OP && expr->op == BinaryOp::AND) {
+        collect_comparisons(expr->left.get(), bindings, out, matched);
+        collect_comparisons(expr->right.get(), bindings, out, matched);
+        return;
+    }
+    matched = false;
+    if (expr->type == ExprType::IN_LIST) {
+        const Expr* column = expr->left.get();
+        if (column->type != ExprType::COLUMN_REF) return;
+        auto it = bindings.name_to_index.find(column->str_val);
+        if (it == bindings.name_to_index.end() || (*bindings.column_types)[it->second] != TypeId::INT64) return;
+        std::vector<int64_t> values;
+        values.reserve(expr->args.size());
+        for (const auto& arg : expr->args) {
+            if (arg->type != ExprType::LITERAL_INT) return;
+            values.push_back(arg->i64_val);
+        }
+        out.push_back({it->second, expr->op, 0, std::make_shared<IntSet>(std::move(values))});
+        matched = true;
+        return;
+    }
+    if (expr->type != ExprType::BINARY_OP || expr->op > BinaryOp::GE) return;
+    const Expr* column = expr->left.get();
+    const Expr* literal = expr->right.get();
+    BinaryOp op = expr->op;
+    if (column->type == ExprType::LITERAL_INT) {
+        std::swap(column, literal);
+        switch (op) {
+            case BinaryOp::LT: op = BinaryOp::GT; break;
+            case BinaryOp::LE: op = BinaryOp::GE; break;
+            case BinaryOp::GT: op = BinaryOp::LT; break;
+            case BinaryOp::GE: op = BinaryOp::LE; break;
+            default: break;
+        }
+    }
+    if (column->type != ExprType::COLUMN_REF || literal->type != ExprType::LITERAL_INT) return;
+    auto it = bindings.name_to_index.find(column->str_val);
+    if (it == bindings.name_to_index.end() || (*bindings.column_types)[it->second] != TypeId::INT64) return;
+    out.push_back({it->second, op, literal->i64_val});
+    matched = true;
+}
+
+// Values that satisfy a comparison, as the inclusive range [lo, lo + span]
+// of unsigned deltas from the slice's base; NE excludes the range instead
+struct DeltaRange {
+    bool empty = false;
+    bool negate = false;
+    uint64_t lo = 0;
+    uint64_t span = 0;
+};
+
+DeltaRange delta_range(const ColumnSlice& slice, const ColumnComparison& comparison) {
+    constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+    constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+    const int64_t value = comparison.value;
+    int64_t lo = kMin;
+    int64_t hi = kMax;
+    DeltaRange range;
+    switch (comparison.op) {
+        case BinaryOp::NE: range.negate = true; [[fallthrough]];
+        case BinaryOp::EQ: lo = hi = value; break;
+        case BinaryOp::LT: range.empty = value == kMin; hi = value - !range.empty; break;
+        case BinaryOp::LE: hi = value; break;
+        case BinaryOp::GT: range.empty = value == kMax; lo = value + !range.empty; break;
+        case BinaryOp::GE: lo = value; break;
+        default: throw std::runtime_error("Invalid comparison operator");
+    }
+    // Deltas reach at most 2^(8 * width) - 1 above the base
+    uint64_t base = 0;
+    if (slice.kind != VectorKind::Flat) {
+        const uint64_t max_delta = (uint64_t{1} << (8 * slice.width)) - 1;
+        const int64_t top = slice.base > kMax - static_cast<int64_t>(max_delta) ? kMax : slice.base + static_cast<int64_t>(max_delta);
+        lo = std::max(lo, slice.base);
+        hi = std::min(hi, top);
+        base = static_cast<uint64_t>(slice.base);
+    }
+    range.empty = range.empty || lo > hi;
+    range.lo = static_cast<uint64_t>(lo) - base;
+    range.span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+    return range;
+}
+
+// One unsigned compare per row, branch-free, at the width the values are
+// stored in
+template <typename U>
+void select_in_range(const U* values, size_t length, U lo, U span, bool negate, std::vector<size_t>& rows) {
+    rows.resize(length);
+    size_t* out = rows.data();
+    size_t count = 0;
+    for (size_t row = 0; row < length; ++row) {
+        out[count] = row;
+        count += (static_cast<U>(values[row] - lo) <= span) != negate;
+    }
+    rows.resize(count);
+}
+
+template <typename U>
+void refine_in_range(const U* values, U lo, U span, bool negate, std::vector<size_t>& rows) {
+    size_t count = 0;
+    for (size_t row : rows) {
+        rows[count] = row;
+        count += (static_cast<U>(values[row] - lo) <= span) != negate;
+    }
+    rows.resize(count);
+}
+
+// Calls `kernel` with the slice's values, or deltas, as stored
+template <typename Kernel>
+void dispatch_stored(const ColumnSlice& slice, Kernel&& kernel) {
+    const void* values = slice.kind == VectorKind::Dictionary ? slice.codes : slice.data;
+    switch (slice.kind == VectorKind::Flat ? 8 : slice.width) {
+        case 1: kernel(static_cast<const uint8_t*>(values)); break;
+        case 2: kernel(static_cast<const uint16_t*>(values)); break;
+        case 4: kernel(static_cast<const uint32_t*>(values)); break;
+        default: kernel(static_cast<const uint64_t*>(values)); break;
+    }
+}
+
+template <typename Kernel>
+void dispatch_width(const ColumnSlice& slice, const DeltaRange& range, Kernel&& kernel) {
+    dispatch_stored(slice, [&](const auto* values) {
+        using U = std::remove_cvref_t<decltype(*values)>;
+        kernel(values, static_cast<U>(range.lo), static_cast<U>(range.span));
+    });
+}
+
+// Set membership of `base + delta`. The 256 possible 8-bit deltas are looked
+// up once, up front; wider values are looked up per row.
+template <typename U>
+auto set_test(const IntSet& set, uint64_t base, bool negate) {
+    if constexpr (sizeof(U) == 1) {
+        std::array<uint8_t, 256> kept;
+        for (size_t delta = 0; delta < kept.size(); ++delta) {
+            kept[delta] = set.contains(static_cast<int64_t>(base + delta)) != negate;
+        }
+        return [kept](U delta) { return kept[delta]; };
+    } else {
+        return [&set, base, negate](U delta) { return set.contains(static_cast<int64_t>(base + delta)) != negate; };
+    }
+}
+
+template <typename U>
+void select_in_set(const U* values, size_t length, const IntSet& set, uint64_t base, bool negate, std::vector<size_t>& rows) {
+    auto test = set_test<U>(set, base, negate);
+    rows.resize(length);
+    size_t* out = rows.data();
+    size_t count = 0;
+    for (size_t row = 0; row < length; ++row) {
+        out[count] = row;
+        count += test(values[row]);
+    }
+    rows.resize(count);
+}
+
+template <typename U>
+void refine_in_set(const U* values, const IntSet& set, uint64_t base, bool negate, std::vector<size_t>& rows) {
+    auto test = set_test<U>(set, base, negate);
+    size_t count = 0;
+    for (size_t row : rows) {
+        rows[count] = row;
+        count += test(values[row]);
+    }
+    rows.resize(count);
+}
+
+uint64_t delta_base(const ColumnSlice& slice) {
+    return slice.kind == VectorKind::Flat ? 0 : static_cast<uint64_t>(slice.base);
+}
+
+}
+
+namespace {
+
+// Short lists are scanned in full; past that a hash probe is cheaper
+constexpr size_t kSortedSetValues = 16;
+// Widest range a bitmap covers regardless of the list length (8 KB)
+constexpr uint64_t kBitmapBits = uint64_t{1} << 16;
+
+}
+
+IntSet::IntSet(std::vector<int64_t> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    if (values.empty()) {
+        layout_ = Layout::Sorted;
+        return;
+    }
+    low_ = values.front();
+    span_ = static_cast<uint64_t>(values.back()) - static_cast<uint64_t>(low_);
+    if (span_ < kBitmapBits || span_ / 64 < values.size()) {
+        // Dense enough that one bit per value in range is smaller than a table
+        layout_ = Layout::Bitmap;
+        bits_.assign(span_ / 64 + 1, 0);
+        for (int64_t value : values) {
+            uint64_t bit = static_cast<uint64_t>(value) - static_cast<uint64_t>(low_);
+            bits_[bit / 64] |= uint64_t{1} << (bit % 64);
+        }
+    } else if (values.size() <= kSortedSetValues) {
+        layout_ = Layout::Sorted;
+        values_ = std::move(values);
+    } else {
+        layout_ = Layout::Hash;
+        const size_t slots = std::bit_ceil(values.size() * 2);
+        shift_ = 64 - static_cast<unsigned>(std::countr_zero(slots));
+        first_ = values.front();
+        values_.assign(slots, first_);
+        for (size_t i = 1; i < values.size(); ++i) {
+            size_t slot = static_cast<size_t>((static_cast<uint64_t>(values[i]) * 0x9e3779b97f4a7c15ULL) >> shift_);
+            while (values_[slot] != first_) slot = (slot + 1) & (slots - 1);
+            values_[slot] = values[i];
+        }
+    }
+}
+
+bool IntSet::contains(int64_t value) const {
+    switch (layout_) {
+        case Layout::Bitmap: {
+            uint64_t bit = static_cast<uint64_t>(value) - static_cast<uint64_t>(low_);
+            return bit <= span_ && (bits_[bit / 64] >> (bit % 64) & 1);
+        }
+        case Layout::Sorted: {
+            // No early exit: a fixed-length compare loop vectorizes
+            bool found = false;
+            for (int64_t candidate : values_) found |= candidate == value;
+            return found;
+        }
+        case Layout::Hash: {
+            if (value == first_) return true;
+            const size_t mask = values_.size() - 1;
+            size_t slot = static_cast<size_t>((static_cast<uint64_t>(value) * 0x9e3779b97f4a7c15ULL) >> shift_);
+            for (; values_[slot] != first_; slot = (slot + 1) & mask) {
+                if (values_[slot] == value) return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+std::vector<ColumnComparison> match_comparisons(const Expr* predicate, const ExprBindings& bindings) {
+    std::vector<ColumnComparison> comparisons;
+    bool matched = predicate != nullptr;
+    if (matched) collect_comparisons(predicate, bindings, comparisons, matched);
+    if (!matched) comparisons.clear();
+    return comparisons;
+}
+
+void select_comparison(const ColumnSlice& slice, const ColumnComparison& comparison, size_t length, std::vector<size_t>& rows) {
+    if (comparison.set) {
+        dispatch_stored(slice, [&](const auto* values) {
+            select_in_set(values, length, *comparison.set, delta_base(slice), comparison.op == BinaryOp::NE, rows);
+        });
+        return;
+    }
+    DeltaRange range = delta_range(slice, comparison);
+    if (range.empty) {
+        rows.resize(range.negate ? length : 0);
+        for (size_t row = 0; row < rows.size(); ++row) rows[row] = row;
+        return;
+    }
+    dispatch_width(slice, range, [&](const auto* values, auto lo, auto span) {
+        select_in_range(values, length, lo, span, range.negate, rows);
+    });
+}
+
+void refine_comparison(const ColumnSlice& slice, const ColumnComparison& comparison, std::vector<size_t>& rows) {
+    if (comparison.set) {
+        dispatch_stored(slice, [&](const auto* values) {
+            refine_in_set(values, *comparison.set, delta_base(slice), comparison.op == BinaryOp::NE, rows);
+        });
+        return;
+    }
+    DeltaRange range = delta_range(slice, comparison);
+    if (range.empty) {
+        if (!range.negate) rows.clear();
+        return;
+    }
+    dispatch_width(slice, range, [&](const auto* values, auto lo, auto span) {
+        refine_in_range(values, lo, span, range.negate, rows);
+    });
+}
+
+void intern_string_literals(const Expr* expr, Dictionary* dictionary) {
+    if (!expr || !dictionary) return;
+    if (expr->type == ExprType::LITERAL_STRING) {
+        dictionary->get_or_add(expr->str_val);
+        return;
+    }
+    intern_string_literals(expr->left.get(), dictionary);
+    // LIKE patterns are matched as text, never looked up
+    bool pattern = expr->type == ExprType::BINARY_OP && (expr->op == BinaryOp::LIKE || expr->op == BinaryOp::NOT_LIKE);
+    if (!pattern) intern_string_literals(expr->right.get(), dictionary);
+    for (const auto& arg : expr->args) {
+        intern_string_literals(arg.get(), dictionary);
+    }
+}
+
 }
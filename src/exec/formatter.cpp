@@ -1,11 +1,84 @@
 #include "exec/formatter.hpp"
 #include <algorithm>
-#include <iomanip>
+#include <charconv>
 #include <ostream>
 #include <fmt/core.h>
+#include "storage/dictionary.h"
 
 namespace bosql {
 
+namespace {
+
+// Appends the text of every value with one type dispatch for the column
+template <typename T>
+void format_numbers(const ColumnSlice& slice, FormattedColumn& column) {
+    auto values = static_cast<const T*>(slice.data);
+    char scratch[32];
+    for (size_t row = 0; row < slice.length; ++row) {
+        auto result = std::to_chars(scratch, scratch + sizeof(scratch), values[row]);
+        column.text.append(scratch, result.ptr);
+        column.ends.push_back(column.text.size());
+    }
+}
+
+bool needs_quotes(std::string_view cell, char sep) {
+    for (char ch : cell) {
+        if (ch == sep || ch == '"' || ch == '\n' || ch == '\r') {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void format_column(const ColumnSlice& slice, const Dictionary* dict, FormattedColumn& column) {
+    column.ends.reserve(column.ends.size() + slice.length);
+    switch (slice.type) {
+        case TypeId::INT64:
+            format_numbers<int64_t>(slice, column);
+            break;
+        case TypeId::DOUBLE:
+            format_numbers<double>(slice, column);
+            break;
+        case TypeId::DATE32:
+            format_numbers<int32_t>(slice, column);
+            break;
+        case TypeId::STRING: {
+            if (!dict) {
+                format_numbers<uint32_t>(slice, column);
+                break;
+            }
+            auto ids = static_cast<const StrId*>(slice.data);
+            for (size_t row = 0; row < slice.length; ++row) {
+                column.text.append(dict->get(ids[row]));
+                column.ends.push_back(column.text.size());
+            }
+            break;
+        }
+    }
+}
+
+Formatter::Formatter(std::ostream& stream) : out(stream) {
+    buffer.reserve(kFlushBytes + kFlushBytes / 4);
+}
+
+Formatter::~Formatter() = default;
+
+void Formatter::format_batch(const ExecBatch& batch, const Dictionary* dict) {
+    columns.resize(batch.columns.size());
+    for (size_t col = 0; col < batch.columns.size(); ++col) {
+        columns[col].text.clear();
+        columns[col].ends.clear();
+        format_column(batch.columns[col], dict, columns[col]);
+    }
+}
+
+void Formatter::flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
 MarkdownFormatter::MarkdownFormatter(std::ostream& stream) : Formatter(stream) {}
 
 void MarkdownFormatter::begin(const std::vector<std::string>& names, const std::vector<TypeId>& types) {
@@ -18,113 +91,122 @@ void MarkdownFormatter::begin(const std::vector<std::string>& names, const std::
     }
 }
 
-void MarkdownFormatter::write_row(std::vector<std::string> row) {
-    for (std::size_t i = 0; i < row.size(); ++i) {
-        if (i >= widths.size()) {
-            widths.resize(i + 1, 0);
+void MarkdownFormatter::write_batch(const ExecBatch& batch, const Dictionary* dict) {
+    if (data.size() < batch.columns.size()) {
+        data.resize(batch.columns.size());
+        widths.resize(batch.columns.size(), 0);
+    }
+    for (std::size_t col = 0; col < batch.columns.size(); ++col) {
+        FormattedColumn& column = data[col];
+        size_t first = column.ends.size();
+        format_column(batch.columns[col], dict, column);
+        for (size_t row = first; row < column.ends.size(); ++row) {
+            widths[col] = std::max<std::size_t>(widths[col], column.cell(row).size());
         }
-        widths[i] = std::max<std::size_t>(widths[i], row[i].size());
     }
-    data.push_back(std::move(row));
 }
 
 void MarkdownFormatter::end(std::size_t row_count) {
     if (row_count == 0) {
-        out << "(no results)\n";
+        emit("(no results)\n");
+        flush();
         return;
     }
     if (headers.empty()) {
         headers.resize(widths.size());
         for (std::size_t i = 0; i < headers.size(); ++i) {
             headers[i] = fmt::format("col{}", i + 1);
-            if (i >= widths.size()) {
-                widths.push_back(headers[i].size());
-            } else {
-                widths[i] = std::max<std::size_t>(widths[i], headers[i].size());
-            }
+            widths[i] = std::max<std::size_t>(widths[i], headers[i].size());
         }
     }
-    auto flags = out.flags();
-    auto print_row = [&](const std::vector<std::string>& cells) {
-        out << "|";
-        for (std::size_t i = 0; i < widths.size(); ++i) {
-            out << " " << std::left << std::setw(static_cast<int>(widths[i])) << (i < cells.size() ? cells[i] : std::string()) << " |";
-        }
-        out << '\n';
+    auto emit_cell = [&](std::string_view cell, std::size_t width) {
+        emit(' ');
+        emit(cell);
+        buffer.append(width - std::min(width, cell.size()), ' ');
+        emit(" |");
     };
 
-    print_row(headers);
-    out << "|";
+    emit('|');
     for (std::size_t i = 0; i < widths.size(); ++i) {
-        out << " " << std::string(widths[i], '-') << " |";
+        emit_cell(i < headers.size() ? std::string_view(headers[i]) : std::string_view(), widths[i]);
     }
-    out << '\n';
-    for (const auto& row : data) {
-        print_row(row);
+    emit('\n');
+    emit('|');
+    for (std::size_t i = 0; i < widths.size(); ++i) {
+        emit(' ');
+        buffer.append(widths[i], '-');
+        emit(" |");
     }
-    out.flags(flags);
+    emit('\n');
+    for (std::size_t row = 0; row < row_count; ++row) {
+        emit('|');
+        for (std::size_t i = 0; i < widths.size(); ++i) {
+            bool present = i < data.size() && row < data[i].ends.size();
+            emit_cell(present ? data[i].cell(row) : std::string_view(), widths[i]);
+        }
+        emit('\n');
+    }
+    flush();
+    data.clear();
 }
 
-CsvFormatter::CsvFormatter(std::ostream& stream, char delimiter) : Formatter(stream), sep(delimiter) {}
+CsvFormatter::CsvFormatter(std::ostream& stream, char delimiter)
+    : Formatter(stream),
+      sep(delimiter),
+      quote_numbers(std::string_view("0123456789+-.aefin").find(delimiter) != std::string_view::npos) {}
 
 void CsvFormatter::begin(const std::vector<std::string>& names, const std::vector<TypeId>& types) {
     (void)types;
-    headers = names;
-    header_written = false;
-    if (headers.empty()) {
+    if (names.empty()) {
         return;
     }
     bool first = true;
-    for (const auto& name : headers) {
+    for (const auto& name : names) {
         if (!first) {
-            out << sep;
+            emit(sep);
         }
-        out << escape_cell(name);
+        emit_escaped(name);
         first = false;
     }
-    out << '\n';
-    header_written = true;
+    emit('\n');
 }
 
-void CsvFormatter::write_row(std::vector<std::string> row) {
-    if (headers.empty() && !header_written) {
-        headers.resize(row.size());
-        header_written = true;
-    }
-    bool first = true;
-    for (const auto& cell : row) {
-        if (!first) {
-            out << sep;
+void CsvFormatter::write_batch(const ExecBatch& batch, const Dictionary* dict) {
+    format_batch(batch, dict);
+    for (size_t row = 0; row < batch.length; ++row) {
+        for (size_t col = 0; col < columns.size(); ++col) {
+            if (col > 0) {
+                emit(sep);
+            }
+            std::string_view cell = columns[col].cell(row);
+            if (batch.columns[col].type == TypeId::STRING || quote_numbers) {
+                emit_escaped(cell);
+            } else {
+                emit(cell);
+            }
         }
-        out << escape_cell(cell);
-        first = false;
+        emit('\n');
     }
-    out << '\n';
 }
 
 void CsvFormatter::end(std::size_t row_count) {
     (void)row_count;
+    flush();
 }
 
-std::string CsvFormatter::escape_cell(const std::string& cell) const {
-    bool needs_quotes = cell.find(sep) != std::string::npos ||
-                        cell.find('"') != std::string::npos ||
-                        cell.find('\n') != std::string::npos ||
-                        cell.find('\r') != std::string::npos;
-    if (!needs_quotes) {
-        return cell;
-    }
-    std::string escaped;
-    escaped.reserve(cell.size() + 2);
-    escaped.push_back('"');
+void CsvFormatter::emit_escaped(std::string_view cell) {
+    if (!needs_quotes(cell, sep)) {
+        emit(cell);
+        return;
+    }
+    emit('"');
     for (char ch : cell) {
         if (ch == '"') {
-            escaped.push_back('"');
+            emit('"');
         }
-        escaped.push_back(ch);
+        emit(ch);
     }
-    escaped.push_back('"');
-    return escaped;
+    emit('"');
 }
 
 } // namespace bosql
@@ -0,0 +1,181 @@
+#include "exec/instrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fmt/core.h>
+
+namespace bosql {
+
+namespace {
+
+// Profile of the instrumented operator executing on this thread, if any
+thread_local OperatorProfile* current_profile = nullptr;
+
+// Makes `profile` current for the duration of a forwarded call
+struct ProfileScope {
+    explicit ProfileScope(OperatorProfile& profile) : saved(current_profile) { current_profile = &profile; }
+    ~ProfileScope() { current_profile = saved; }
+    OperatorProfile* saved;
+};
+
+using Clock = std::chrono::steady_clock;
+
+std::string format_ms(std::chrono::nanoseconds time) {
+    return fmt::format("{:.3f} ms", std::chrono::duration<double, std::milli>(time).count());
+}
+
+std::string format_bytes(size_t bytes) {
+    if (bytes < 1024) return fmt::format("{} B", bytes);
+    double value = static_cast<double>(bytes) / 1024.0;
+    if (value < 1024.0) return fmt::format("{:.1f} KiB", value);
+    return fmt::format("{:.1f} MiB", value / 1024.0);
+}
+
+void render(const Operator& op, int indent, std::string& out) {
+    std::string prefix(indent, ' ');
+    const auto* probe = dynamic_cast<const InstrumentedOperator*>(&op);
+    if (!probe) {
+        out += fmt::format("{}{}\n", prefix, op.label());
+        for (const Operator* child : op.children()) render(*child, indent + 2, out);
+        return;
+    }
+
+    const OperatorProfile& profile = probe->profile();
+    size_t rows_in = 0;
+    auto child_time = std::chrono::nanoseconds{0};
+    for (const Operator* child : op.children()) {
+        if (const auto* child_probe = dynamic_cast<const InstrumentedOperator*>(child)) {
+            rows_in += child_probe->profile().rows;
+            // Children on worker threads ran concurrently, not inside this operator's time
+            if (child_probe->profile().thread == profile.thread) {
+                child_time += child_probe->profile().total_time();
+            }
+        }
+    }
+    auto self_time = std::max(profile.total_time() - child_time, std::chrono::nanoseconds{0});
+
+    std::string estimate = probe->estimated_rows() >= 0.0
+        ? fmt::format("{}", static_cast<int64_t>(std::llround(probe->estimated_rows())))
+        : "?";
+    out += fmt::format("{}{}\n", prefix, op.label());
+    out += fmt::format("{}  rows: {} (est. {}), in: {}, batches: {}\n",
+                       prefix, profile.rows, estimate, rows_in, profile.batches);
+    out += fmt::format("{}  time: {} (self {}; open {}, next {}, close {}), alloc: {}\n",
+                       prefix,
+                       format_ms(profile.total_time()),
+                       format_ms(self_time),
+                       format_ms(profile.open_time),
+                       format_ms(profile.next_time),
+                       format_ms(profile.close_time),
+                       format_bytes(profile.bytes_allocated));
+    if (const MemoryTracker* tracker = op.memory_tracker()) {
+        out += fmt::format("{}  memory: peak {}\n", prefix, format_bytes(tracker->peak()));
+    }
+    for (const Operator* child : op.children()) render(*child, indent + 2, out);
+}
+
+} // namespace
+
+void count_allocation(size_t bytes) {
+    if (current_profile) current_profile->bytes_allocated += bytes;
+}
+
+InstrumentedOperator::InstrumentedOperator(std::unique_ptr<Operator> op, double estimated_rows)
+    : inner(std::move(op)), estimated(estimated_rows) {
+    if (!inner) {
+        throw std::runtime_error("Instrumented operator is null");
+    }
+    names_ = inner->output_names();
+    types_ = inner->output_types();
+    dict_ = inner->dictionary();
+}
+
+void InstrumentedOperator::open() {
+    ProfileScope scope(stats);
+    stats.thread = std::this_thread::get_id();
+    auto start = Clock::now();
+    inner->open();
+    stats.open_time += Clock::now() - start;
+}
+
+bool InstrumentedOperator::next(ExecBatch& out) {
+    ProfileScope scope(stats);
+    auto start = Clock::now();
+    bool produced = inner->next(out);
+    stats.next_time += Clock::now() - start;
+    if (produced) {
+        ++stats.batches;
+        stats.rows += out.length;
+    }
+    return produced;
+}
+
+void InstrumentedOperator::close() {
+    ProfileScope scope(stats);
+    auto start = Clock::now();
+    inner->close();
+    stats.close_time += Clock::now() - start;
+}
+
+std::string InstrumentedOperator::label() const {
+    return inner->label();
+}
+
+std::vector<const Operator*> InstrumentedOperator::children() const {
+    return inner->children();
+}
+
+TrackedOperator::TrackedOperator(std::unique_ptr<Operator> op, std::shared_ptr<MemoryTracker> memory)
+    : inner(std::move(op)), tracker(std::move(memory)) {
+    if (!inner || !tracker) {
+        throw std::runtime_error("Tracked operator or tracker is null");
+    }
+    names_ = inner->output_names();
+    types_ = inner->output_types();
+    dict_ = inner->dictionary();
+}
+
+void TrackedOperator::open() {
+    MemoryScope scope(tracker.get());
+    inner->open();
+}
+
+bool TrackedOperator::next(ExecBatch& out) {
+    MemoryScope scope(tracker.get());
+    return inner->next(out);
+}
+
+void TrackedOperator::close() {
+    MemoryScope scope(tracker.get());
+    inner->close();
+}
+
+std::string TrackedOperator::label() const {
+    return inner->label();
+}
+
+std::vector<const Operator*> TrackedOperator::children() const {
+    return inner->children();
+}
+
+std::string explain_analyze(Operator& root, const MemoryTracker* query) {
+    auto start = Clock::now();
+    root.open();
+    ExecBatch batch;
+    size_t rows = 0;
+    while (root.next(batch)) {
+        rows += batch.length;
+    }
+    root.close();
+    auto elapsed = Clock::now() - start;
+
+    std::string out;
+    render(root, 0, out);
+    out += fmt::format("Total: {} rows in {}", rows, format_ms(elapsed));
+    if (query) {
+        out += fmt::format(", peak memory {}", format_bytes(query->peak()));
+    }
+    return out;
+}
+
+} // namespace bosql
@@ -0,0 +1,129 @@
+#include "exec/memory.h"
+
+#include <stdexcept>
+#include <fmt/core.h>
+
+namespace bosql {
+
+namespace {
+
+thread_local MemoryTracker* current_tracker = nullptr;
+
+std::string format_limit_error(const MemoryTracker& tracker, size_t wanted) {
+    return fmt::format("Memory limit exceeded: {} needs {} bytes, limit is {}", tracker.label(), wanted,
+                       tracker.limit());
+}
+
+} // namespace
+
+const std::shared_ptr<MemoryTracker>& MemoryTracker::process() {
+    static const std::shared_ptr<MemoryTracker> root(new MemoryTracker("process", 0, nullptr));
+    return root;
+}
+
+std::shared_ptr<MemoryTracker> MemoryTracker::create(std::string label,
+                                                     size_t limit,
+                                                     std::shared_ptr<MemoryTracker> parent) {
+    std::shared_ptr<MemoryTracker> tracker(new MemoryTracker(std::move(label), limit, parent));
+    if (parent) {
+        std::lock_guard<std::mutex> lock(parent->children_mutex);
+        parent->children.push_back(tracker);
+    }
+    return tracker;
+}
+
+MemoryTracker::MemoryTracker(std::string label, size_t limit, std::shared_ptr<MemoryTracker> parent_in)
+    : name(std::move(label)), parent(std::move(parent_in)), max_bytes(limit) {}
+
+MemoryTracker::~MemoryTracker() {
+    if (!parent) return;
+    Usage final_usage = usage();
+    std::lock_guard<std::mutex> lock(parent->children_mutex);
+    // Drop the expired entry so the list does not grow with every child
+    std::erase_if(parent->children, [](const auto& child) { return child.expired(); });
+    if (parent->parent) {
+        parent->retired.push_back(std::move(final_usage));
+    }
+}
+
+void MemoryTracker::consume(size_t bytes) {
+    if (bytes == 0) return;
+    for (MemoryTracker* tracker = this; tracker; tracker = tracker->parent.get()) {
+        size_t now = tracker->used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t limit = tracker->limit();
+        if (limit > 0 && now > limit) {
+            // Undo the charge on this level and every level below it
+            for (MemoryTracker* undo = this; undo != tracker->parent.get(); undo = undo->parent.get()) {
+                undo->used.fetch_sub(bytes, std::memory_order_relaxed);
+            }
+            throw std::runtime_error(format_limit_error(*tracker, now));
+        }
+    }
+    // Peaks only move once the whole chain accepted the charge
+    for (MemoryTracker* tracker = this; tracker; tracker = tracker->parent.get()) {
+        size_t now = tracker->current();
+        size_t peak = tracker->high_water.load(std::memory_order_relaxed);
+        while (now > peak && !tracker->high_water.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+void MemoryTracker::release(size_t bytes) {
+    for (MemoryTracker* tracker = this; tracker; tracker = tracker->parent.get()) {
+        tracker->used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+}
+
+MemoryTracker::Usage MemoryTracker::usage() const {
+    Usage result{name, current(), peak(), limit(), {}};
+    std::lock_guard<std::mutex> lock(children_mutex);
+    result.children = retired;
+    for (const auto& weak : children) {
+        if (auto child = weak.lock()) {
+            result.children.push_back(child->usage());
+        }
+    }
+    return result;
+}
+
+MemoryTracker* current_memory_tracker() {
+    return current_tracker;
+}
+
+MemoryScope::MemoryScope(MemoryTracker* tracker) : saved(current_tracker) {
+    current_tracker = tracker;
+}
+
+MemoryScope::~MemoryScope() {
+    current_tracker = saved;
+}
+
+MemoryReservation::MemoryReservation()
+    : tracker(current_tracker ? current_tracker->shared_from_this() : nullptr) {}
+
+MemoryReservation::MemoryReservation(std::shared_ptr<MemoryTracker> tracker_in) : tracker(std::move(tracker_in)) {}
+
+MemoryReservation::~MemoryReservation() {
+    if (tracker) tracker->release(size());
+}
+
+void MemoryReservation::grow(size_t bytes) {
+    if (tracker) tracker->consume(bytes);
+    reserved.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void MemoryReservation::shrink(size_t bytes) {
+    if (tracker) tracker->release(bytes);
+    reserved.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void MemoryReservation::resize(size_t bytes) {
+    size_t held = size();
+    if (bytes > held) {
+        grow(bytes - held);
+    } else if (bytes < held) {
+        shrink(held - bytes);
+    }
+}
+
+} // namespace bosql
@@ -1,8 +1,18 @@
 #include "exec/operator.hpp"
 #include "exec/expression.h"
+#include "exec/instrumentation.h"
+#include "exec/column_builder.h"
+#include "storage/compression.h"
+#include "storage/csv_file.h"
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cctype>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
 #include <stdexcept>
+#include <fmt/core.h>
 
 namespace bosql {
 
@@ -11,74 +21,18 @@ namespace {
 ColumnSlice copy_selected(const ColumnSlice& slice,
                           TypeId type,
                           const std::vector<size_t>& indices) {
-    switch (type) {
-        case TypeId::INT64: {
-            auto src = reinterpret_cast<const int64_t*>(slice.data);
-            auto buffer = std::make_shared<std::vector<int64_t>>(indices.size());
-            for (size_t i = 0; i < indices.size(); ++i) {
-                (*buffer)[i] = src[indices[i]];
-            }
-            return {buffer->data(), type, indices.size(), std::shared_ptr<void>(buffer, buffer->data())};
-        }
-        case TypeId::DOUBLE: {
-            auto src = reinterpret_cast<const double*>(slice.data);
-            auto buffer = std::make_shared<std::vector<double>>(indices.size());
-            for (size_t i = 0; i < indices.size(); ++i) {
-                (*buffer)[i] = src[indices[i]];
-            }
-            return {buffer->data(), type, indices.size(), std::shared_ptr<void>(buffer, buffer->data())};
-        }
-        case TypeId::STRING: {
-            auto src = reinterpret_cast<const uint32_t*>(slice.data);
-            auto buffer = std::make_shared<std::vector<uint32_t>>(indices.size());
-            for (size_t i = 0; i < indices.size(); ++i) {
-                (*buffer)[i] = src[indices[i]];
-            }
-            return {buffer->data(), type, indices.size(), std::shared_ptr<void>(buffer, buffer->data())};
-        }
-        case TypeId::DATE32: {
-            auto src = reinterpret_cast<const int32_t*>(slice.data);
-            auto buffer = std::make_shared<std::vector<int32_t>>(indices.size());
-            for (size_t i = 0; i < indices.size(); ++i) {
-                (*buffer)[i] = src[indices[i]];
-            }
-            return {buffer->data(), type, indices.size(), std::shared_ptr<void>(buffer, buffer->data())};
-        }
-    }
-    throw std::runtime_error("Unknown type");
+    ColumnBuilder builder(type, indices.size());
+    builder.gather(slice, indices);
+    return builder.finish();
 }
 
 ColumnSlice copy_range(const ColumnSlice& slice,
                        TypeId type,
                        size_t offset,
                        size_t count) {
-    switch (type) {
-        case TypeId::INT64: {
-            auto src = reinterpret_cast<const int64_t*>(slice.data);
-            auto buffer = std::make_shared<std::vector<int64_t>>(count);
-            std::copy_n(src + offset, count, buffer->begin());
-            return {buffer->data(), type, count, std::shared_ptr<void>(buffer, buffer->data())};
-        }
-        case TypeId::DOUBLE: {
-            auto src = reinterpret_cast<const double*>(slice.data);
-            auto buffer = std::make_shared<std::vector<double>>(count);
-            std::copy_n(src + offset, count, buffer->begin());
-            return {buffer->data(), type, count, std::shared_ptr<void>(buffer, buffer->data())};
-        }
-        case TypeId::STRING: {
-            auto src = reinterpret_cast<const uint32_t*>(slice.data);
-            auto buffer = std::make_shared<std::vector<uint32_t>>(count);
-            std::copy_n(src + offset, count, buffer->begin());
-            return {buffer->data(), type, count, std::shared_ptr<void>(buffer, buffer->data())};
-        }
-        case TypeId::DATE32: {
-            auto src = reinterpret_cast<const int32_t*>(slice.data);
-            auto buffer = std::make_shared<std::vector<int32_t>>(count);
-            std::copy_n(src + offset, count, buffer->begin());
-            return {buffer->data(), type, count, std::shared_ptr<void>(buffer, buffer->data())};
-        }
-    }
-    throw std::runtime_error("Unknown type");
+    ColumnBuilder builder(type, count);
+    builder.append(slice, offset, count);
+    return builder.finish();
 }
 
 TypeId infer_type(const Expr* expr, const ExprBindings& bindings) {
@@ -117,10 +71,14 @@ TypeId infer_type(const Expr* expr, const ExprBindings& bindings) {
                 case BinaryOp::GE:
                 case BinaryOp::AND:
                 case BinaryOp::OR:
+                case BinaryOp::LIKE:
+                case BinaryOp::NOT_LIKE:
                     return TypeId::INT64;
             }
             break;
         }
+        case ExprType::IN_LIST:
+            return TypeId::INT64;
         case ExprType::FUNC_CALL:
             if (expr->func_name.empty()) {
                 throw std::runtime_error("Function call unsupported in projection");
@@ -145,111 +103,16 @@ TypeId infer_type(const Expr* expr, const ExprBindings& bindings) {
     throw std::runtime_error("Cannot infer expression type");
 }
 
-struct ColumnBuilder {
-    TypeId type;
-    std::shared_ptr<void> storage;
-};
-
-ColumnBuilder make_builder(TypeId type) {
-    switch (type) {
-        case TypeId::INT64:
-            return {type, std::make_shared<std::vector<int64_t>>()};
-        case TypeId::DOUBLE:
-            return {type, std::make_shared<std::vector<double>>()};
-        case TypeId::STRING:
-            return {type, std::make_shared<std::vector<uint32_t>>()};
-        case TypeId::DATE32:
-            return {type, std::make_shared<std::vector<int32_t>>()};
-    }
-    throw std::runtime_error("Unknown column type");
-}
-
-void append_value(ColumnBuilder& builder, const ColumnSlice& slice, size_t row) {
-    switch (builder.type) {
-        case TypeId::INT64: {
-            auto vec = std::static_pointer_cast<std::vector<int64_t>>(builder.storage);
-            const auto* ptr = reinterpret_cast<const int64_t*>(slice.data);
-            vec->push_back(ptr[row]);
-            break;
-        }
-        case TypeId::DOUBLE: {
-            auto vec = std::static_pointer_cast<std::vector<double>>(builder.storage);
-            const auto* ptr = reinterpret_cast<const double*>(slice.data);
-            vec->push_back(ptr[row]);
-            break;
-        }
-        case TypeId::STRING: {
-            auto vec = std::static_pointer_cast<std::vector<uint32_t>>(builder.storage);
-            const auto* ptr = reinterpret_cast<const uint32_t*>(slice.data);
-            vec->push_back(ptr[row]);
-            break;
-        }
-        case TypeId::DATE32: {
-            auto vec = std::static_pointer_cast<std::vector<int32_t>>(builder.storage);
-            const auto* ptr = reinterpret_cast<const int32_t*>(slice.data);
-            vec->push_back(ptr[row]);
-            break;
-        }
-    }
-}
-
-void append_value(ColumnBuilder& builder, const Datum& value) {
-    switch (builder.type) {
-        case TypeId::INT64: {
-            auto vec = std::static_pointer_cast<std::vector<int64_t>>(builder.storage);
-            if (value.type == TypeId::DOUBLE) {
-                vec->push_back(static_cast<int64_t>(value.value.f64_val));
-            } else {
-                vec->push_back(value.value.i64_val);
-            }
-            break;
-        }
-        case TypeId::DOUBLE: {
-            auto vec = std::static_pointer_cast<std::vector<double>>(builder.storage);
-            if (value.type == TypeId::DOUBLE) {
-                vec->push_back(value.value.f64_val);
-            } else {
-                vec->push_back(static_cast<double>(value.value.i64_val));
-            }
-            break;
-        }
-        case TypeId::STRING: {
-            auto vec = std::static_pointer_cast<std::vector<uint32_t>>(builder.storage);
-            vec->push_back(value.value.str_id);
-            break;
-        }
-        case TypeId::DATE32: {
-            auto vec = std::static_pointer_cast<std::vector<int32_t>>(builder.storage);
-            if (value.type == TypeId::DATE32) {
-                vec->push_back(value.value.date32_val);
-            } else {
-                vec->push_back(static_cast<int32_t>(value.value.i64_val));
-            }
-            break;
-        }
-    }
-}
-
-ColumnSlice finalize_builder(const ColumnBuilder& builder) {
-    switch (builder.type) {
-        case TypeId::INT64: {
-            auto vec = std::static_pointer_cast<std::vector<int64_t>>(builder.storage);
-            return {vec->data(), builder.type, vec->size(), std::shared_ptr<void>(vec, vec->data())};
-        }
-        case TypeId::DOUBLE: {
-            auto vec = std::static_pointer_cast<std::vector<double>>(builder.storage);
-            return {vec->data(), builder.type, vec->size(), std::shared_ptr<void>(vec, vec->data())};
+// Appends value_of(i) for i in [0, rows) with the column type resolved once
+template <typename ValueOf>
+void append_column(ColumnBuilder& builder, size_t rows, ValueOf&& value_of) {
+    builder.visit([&](auto& typed) {
+        using T = typename std::decay_t<decltype(typed)>::value_type;
+        T* out = typed.extend(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            out[i] = datum_as<T>(value_of(i));
         }
-        case TypeId::STRING: {
-            auto vec = std::static_pointer_cast<std::vector<uint32_t>>(builder.storage);
-            return {vec->data(), builder.type, vec->size(), std::shared_ptr<void>(vec, vec->data())};
-        }
-        case TypeId::DATE32: {
-            auto vec = std::static_pointer_cast<std::vector<int32_t>>(builder.storage);
-            return {vec->data(), builder.type, vec->size(), std::shared_ptr<void>(vec, vec->data())};
-        }
-    }
-    throw std::runtime_error("Unknown column type");
+    });
 }
 
 Datum extract_value(const ColumnSlice& slice, TypeId type, size_t row) {
@@ -277,6 +140,12 @@ std::vector<Datum> materialize_row(const ExecBatch& batch,
     return values;
 }
 
+void materialize_row(const ExecBatch& batch, size_t row, const std::vector<TypeId>& types, Datum* out) {
+    for (size_t i = 0; i < types.size(); ++i) {
+        out[i] = extract_value(batch.columns[i], types[i], row);
+    }
+}
+
 double datum_as_double(const Datum& value) {
     switch (value.type) {
         case TypeId::DOUBLE:
@@ -316,10 +185,72 @@ int compare_datum(const Datum& lhs, const Datum& rhs) {
     return 0;
 }
 
+// Fills `source` when the column has a layout scans can pass on encoded
+template <typename T, typename Source>
+void describe_encoded(const Column& column, Source& source) {
+    if (const auto* rle = dynamic_cast<const RleColumn<T>*>(&column)) {
+        source.values = rle->run_values.data();
+        source.run_ends = rle->run_ends.data();
+        source.runs = rle->run_ends.size();
+        return;
+    }
+    if constexpr (std::is_integral_v<T>) {
+        if (const auto* narrow = dynamic_cast<const NarrowColumn<T, uint8_t>*>(&column)) {
+            // Every possible delta decoded once, so codes index values directly
+            auto values = std::make_shared<std::vector<T>>(256);
+            for (size_t code = 0; code < values->size(); ++code) {
+                (*values)[code] = static_cast<T>(static_cast<uint64_t>(narrow->base) + code);
+            }
+            source.values = values->data();
+            source.codes = narrow->deltas.data();
+            source.owner = std::move(values);
+            source.width = 1;
+            source.base = static_cast<int64_t>(narrow->base);
+        } else if (const auto* narrow16 = dynamic_cast<const NarrowColumn<T, uint16_t>*>(&column)) {
+            source.deltas = narrow16->deltas.data();
+            source.width = 2;
+            source.base = static_cast<int64_t>(narrow16->base);
+        } else if constexpr (sizeof(T) == 8) {
+            if (const auto* narrow32 = dynamic_cast<const NarrowColumn<T, uint32_t>*>(&column)) {
+                source.deltas = narrow32->deltas.data();
+                source.width = 4;
+                source.base = static_cast<int64_t>(narrow32->base);
+            }
+        }
+    }
+}
+
+// Rows [offset, offset + rows) of a run-length encoded column, with run ends
+// relative to the batch
+ColumnSlice run_slice(const void* run_values, const size_t* run_ends, size_t runs, TypeId type, size_t offset, size_t rows) {
+    const size_t first = static_cast<size_t>(std::upper_bound(run_ends, run_ends + runs, offset) - run_ends);
+    const size_t last = static_cast<size_t>(std::upper_bound(run_ends + first, run_ends + runs, offset + rows - 1) - run_ends);
+    ColumnSlice slice{static_cast<const char*>(run_values) + first * type_width(type), type, rows, {}};
+    slice.value_count = last - first + 1;
+    if (slice.value_count == 1) {
+        slice.kind = VectorKind::Constant;
+        return slice;
+    }
+    TypedColumnBuilder<uint32_t> ends(slice.value_count);
+    uint32_t* out = ends.extend(slice.value_count);
+    for (size_t run = first; run <= last; ++run) {
+        out[run - first] = static_cast<uint32_t>(std::min(run_ends[run], offset + rows) - offset);
+    }
+    ColumnSlice ends_slice = ends.finish();
+    slice.kind = VectorKind::Rle;
+    slice.run_ends = static_cast<const uint32_t*>(ends_slice.data);
+    slice.owner = std::move(ends_slice.owner);
+    return slice;
+}
+
 }
 
-ColumnarScan::ColumnarScan(Table* t, std::vector<size_t> idx, size_t batch)
-    : table(t), indices(std::move(idx)), offset(0), batch_size(batch) {
+ColumnarScan::ColumnarScan(Table* t,
+                           std::vector<size_t> idx,
+                           size_t batch,
+                           std::shared_ptr<MorselQueue> morsel_queue,
+                           bool encoded)
+    : table(t), indices(std::move(idx)), offset(0), batch_size(batch), morsels(std::move(morsel_queue)) {
     if (!table) {
         throw std::runtime_error("Scan table is null");
     }
@@ -331,62 +262,179 @@ ColumnarScan::ColumnarScan(Table* t, std::vector<size_t> idx, size_t batch)
     }
     names_.reserve(indices.size());
     types_.reserve(indices.size());
+    columns.reserve(indices.size());
     for (size_t i : indices) {
         names_.push_back(table->columns[i].name);
         types_.push_back(table->columns[i].data->type());
+        // Lazily loaded columns are parsed here, at plan time, before any
+        // operator reads the dictionary they add strings to
+        columns.push_back(&table->columns[i].data->resolve());
     }
     dict_ = table->dict.get();
+    if (encoded) {
+        encoded_sources.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            const Column& column = *columns[i];
+            switch (column.type()) {
+                case TypeId::INT64: describe_encoded<int64_t>(column, encoded_sources[i]); break;
+                case TypeId::DOUBLE: describe_encoded<double>(column, encoded_sources[i]); break;
+                case TypeId::STRING: describe_encoded<uint32_t>(column, encoded_sources[i]); break;
+                case TypeId::DATE32: describe_encoded<int32_t>(column, encoded_sources[i]); break;
+            }
+        }
+    }
 }
 
 void ColumnarScan::open() {
     offset = 0;
+    scanned_rows = 0;
+    scanned_bytes.assign(indices.size(), 0);
+    // Clones share the queue, so nobody resets it here; a serial scan owns the whole table
+    morsel_end = morsels || indices.empty() ? 0 : table->columns[indices[0]].data->size();
 }
 
 bool ColumnarScan::next(ExecBatch& out) {
     if (indices.empty()) return false;
-    size_t row_count = table->columns[indices[0]].data->size();
-    if (offset >= row_count) return false;
+    if (offset >= morsel_end) {
+        if (!morsels || !morsels->next(offset, morsel_end)) return false;
+    }
 
-    size_t take = std::min(batch_size, row_count - offset);
+    size_t take = std::min(batch_size, morsel_end - offset);
     out.clear();
     out.columns.reserve(indices.size());
-    for (size_t idx : indices) {
-        auto& col = table->columns[idx];
-        auto type = col.data->type();
-        const void* ptr = nullptr;
-        switch (type) {
-            case TypeId::INT64: {
-                auto* vec = dynamic_cast<ColumnVector<int64_t>*>(col.data.get());
-                ptr = vec->data.data() + offset;
-                break;
-            }
-            case TypeId::DOUBLE: {
-                auto* vec = dynamic_cast<ColumnVector<double>*>(col.data.get());
-                ptr = vec->data.data() + offset;
-                break;
-            }
-            case TypeId::STRING: {
-                auto* vec = dynamic_cast<ColumnVector<uint32_t>*>(col.data.get());
-                ptr = vec->data.data() + offset;
-                break;
-            }
-            case TypeId::DATE32: {
-                auto* vec = dynamic_cast<ColumnVector<int32_t>*>(col.data.get());
-                ptr = vec->data.data() + offset;
-                break;
-            }
+    for (size_t i = 0; i < indices.size(); ++i) {
+        const Column& col = *columns[i];
+        auto type = col.type();
+        const EncodedSource* source = encoded_sources.empty() ? nullptr : &encoded_sources[i];
+        if (source && source->run_ends) {
+            out.columns.push_back(run_slice(source->values, source->run_ends, source->runs, type, offset, take));
+            scanned_bytes[i] += std::max<size_t>(out.columns.back().value_count, 1) * (type_width(type) + sizeof(size_t));
+        } else if (source && source->codes) {
+            ColumnSlice slice{source->values, type, take, source->owner};
+            slice.kind = VectorKind::Dictionary;
+            slice.value_count = 256;
+            slice.codes = source->codes + offset;
+            slice.width = 1;
+            slice.base = source->base;
+            out.columns.push_back(std::move(slice));
+            scanned_bytes[i] += take;
+        } else if (source && source->deltas) {
+            ColumnSlice slice{static_cast<const char*>(source->deltas) + offset * source->width, type, take, {}};
+            slice.kind = VectorKind::Narrow;
+            slice.width = source->width;
+            slice.base = source->base;
+            out.columns.push_back(std::move(slice));
+            scanned_bytes[i] += take * source->width;
+        } else if (const void* values = col.values()) {
+            const void* ptr = static_cast<const char*>(values) + offset * type_width(type);
+            out.columns.push_back({ptr, type, take, {}});
+            scanned_bytes[i] += take * type_width(type);
+        } else {
+            // Encoded storage is decoded one batch at a time
+            ColumnBuilder builder(type, take);
+            builder.visit([&](auto& typed) { col.decode(offset, take, typed.extend(take)); });
+            out.columns.push_back(builder.finish());
+            scanned_bytes[i] += col.memory_bytes() * take / col.size();
+        }
+    }
+    out.length = take;
+    offset += take;
+    scanned_rows += take;
+    return true;
+}
+
+void ColumnarScan::close() {
+    for (size_t i = 0; i < scanned_bytes.size(); ++i) {
+        ScanCounters& counters = *table->columns[indices[i]].scans;
+        counters.rows.fetch_add(scanned_rows, std::memory_order_relaxed);
+        counters.bytes.fetch_add(scanned_bytes[i], std::memory_order_relaxed);
+    }
+    scanned_rows = 0;
+    scanned_bytes.assign(scanned_bytes.size(), 0);
+}
+
+RawCsvScan::RawCsvScan(Table* t, std::vector<size_t> idx, size_t batch, std::shared_ptr<MorselQueue> morsel_queue)
+    : table(t), indices(std::move(idx)), offset(0), batch_size(batch), morsels(std::move(morsel_queue)) {
+    if (!table || !table->external) {
+        throw std::runtime_error("Raw scan needs an external table");
+    }
+    external = table->external.get();
+    if (indices.empty()) {
+        indices.resize(table->columns.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+    names_.reserve(indices.size());
+    types_.reserve(indices.size());
+    columns.reserve(indices.size());
+    for (size_t i : indices) {
+        const Column& data = *table->columns[i].data;
+        names_.push_back(table->columns[i].name);
+        types_.push_back(data.type());
+        const auto* lazy = dynamic_cast<const LazyCsvColumn*>(&data);
+        if (lazy && !lazy->loaded() && data.type() != TypeId::STRING && external->scans(i) <= ExternalCsv::kInSituScans) {
+            columns.push_back(nullptr);
+            in_situ.push_back(i);
+        } else {
+            columns.push_back(&data.resolve());
+        }
+    }
+    dict_ = table->dict.get();
+}
+
+void RawCsvScan::open() {
+    offset = 0;
+    scanned_rows = 0;
+    scanned_bytes.assign(indices.size(), 0);
+    morsel_end = morsels || indices.empty() ? 0 : table->columns[indices[0]].data->size();
+}
+
+bool RawCsvScan::next(ExecBatch& out) {
+    if (indices.empty()) return false;
+    if (offset >= morsel_end) {
+        if (!morsels || !morsels->next(offset, morsel_end)) return false;
+    }
+
+    size_t take = std::min(batch_size, morsel_end - offset);
+    external->map(offset, take, in_situ);
+    out.clear();
+    out.columns.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        const Column* col = columns[i];
+        const TypeId type = types_[i];
+        if (!col) {
+            ColumnBuilder builder(type, take);
+            builder.visit([&](auto& typed) {
+                scanned_bytes[i] += external->read(indices[i], type, offset, take, typed.extend(take));
+            });
+            out.columns.push_back(builder.finish());
+        } else if (const void* values = col->values()) {
+            out.columns.push_back({static_cast<const char*>(values) + offset * type_width(type), type, take, {}});
+            scanned_bytes[i] += take * type_width(type);
+        } else {
+            ColumnBuilder builder(type, take);
+            builder.visit([&](auto& typed) { col->decode(offset, take, typed.extend(take)); });
+            out.columns.push_back(builder.finish());
+            scanned_bytes[i] += col->memory_bytes() * take / col->size();
         }
-        out.columns.push_back({ptr, type, take, {}});
     }
     out.length = take;
     offset += take;
+    scanned_rows += take;
     return true;
 }
 
-void ColumnarScan::close() {}
+void RawCsvScan::close() {
+    for (size_t i = 0; i < scanned_bytes.size(); ++i) {
+        ScanCounters& counters = *table->columns[indices[i]].scans;
+        counters.rows.fetch_add(scanned_rows, std::memory_order_relaxed);
+        counters.bytes.fetch_add(scanned_bytes[i], std::memory_order_relaxed);
+    }
+    scanned_rows = 0;
+    scanned_bytes.assign(scanned_bytes.size(), 0);
+}
 
-Selection::Selection(std::unique_ptr<Operator> c, std::unique_ptr<Expr> pred)
-    : child(std::move(c)), predicate(std::move(pred)) {
+Selection::Selection(std::unique_ptr<Operator> c, std::unique_ptr<Expr> pred, bool encoded)
+    : child(std::move(c)), predicate(std::move(pred)), encoded_output(encoded) {
     if (!child) {
         throw std::runtime_error("Selection child is null");
     }
@@ -394,6 +442,12 @@ Selection::Selection(std::unique_ptr<Operator> c, std::unique_ptr<Expr> pred)
     types_ = child->output_types();
     dict_ = child->dictionary();
     bindings = make_bindings(names_, types_, dict_);
+    referenced_columns(predicate.get(), bindings, predicate_columns);
+    comparisons = match_comparisons(predicate.get(), bindings);
+    if (predicate_columns.size() == 1 && types_[predicate_columns[0]] == TypeId::STRING && dict_) {
+        string_column = predicate_columns[0];
+        string_matches.assign(dict_->size(), 0);
+    }
 }
 
 void Selection::open() {
@@ -401,35 +455,175 @@ void Selection::open() {
 }
 
 bool Selection::next(ExecBatch& out) {
-    ExecBatch in;
+    ExecBatch& in = input;
     while (child->next(in)) {
         if (!predicate) {
             out = in;
+            if (!encoded_output) flatten(out);
             return true;
         }
-        std::vector<size_t> selected;
-        selected.reserve(in.length);
-        for (size_t row = 0; row < in.length; ++row) {
-            if (evaluate_predicate(predicate.get(), in, row, bindings)) {
-                selected.push_back(row);
+        bool kept = compares_in_place(in)      ? select_compared(in, out)
+                    : strings_by_code(in)     ? select_strings(in, out)
+                    : has_encoded_columns(in) ? select_encoded(in, out)
+                                              : select_rows(in, out);
+        if (kept) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The width kernels read flat and narrow columns, and dictionaries whose
+// codes are deltas
+bool Selection::compares_in_place(const ExecBatch& in) const {
+    return !comparisons.empty() && std::all_of(comparisons.begin(), comparisons.end(), [&](const ColumnComparison& comparison) {
+        const ColumnSlice& slice = in.columns[comparison.column];
+        return slice.kind == VectorKind::Flat || slice.kind == VectorKind::Narrow ||
+               (slice.kind == VectorKind::Dictionary && slice.width == 1);
+    });
+}
+
+bool Selection::select_compared(const ExecBatch& in, ExecBatch& out) {
+    select_comparison(in.columns[comparisons[0].column], comparisons[0], in.length, selected);
+    for (size_t i = 1; i < comparisons.size() && !selected.empty(); ++i) {
+        refine_comparison(in.columns[comparisons[i].column], comparisons[i], selected);
+    }
+    return emit_selected(in, out);
+}
+
+// Runs and constants already evaluate once per run
+bool Selection::strings_by_code(const ExecBatch& in) const {
+    if (string_column == std::string::npos) return false;
+    VectorKind kind = in.columns[string_column].kind;
+    return kind == VectorKind::Flat || kind == VectorKind::Narrow || kind == VectorKind::Dictionary;
+}
+
+// LIKE, IN and comparisons on a string column are evaluated once per
+// dictionary code, the first time a batch holds it; rows then only look
+// their code up
+bool Selection::select_strings(ExecBatch& in, ExecBatch& out) {
+    ColumnSlice& column = in.columns[string_column];
+    const ColumnSlice stored = column;
+    StrId probe = 0;
+    column = {&probe, TypeId::STRING, 1, {}};
+    auto keep = [&](StrId code) {
+        if (code >= string_matches.size()) string_matches.resize(static_cast<size_t>(code) + 1, 0);
+        uint8_t& state = string_matches[code];
+        if (state == 0) {
+            probe = code;
+            state = evaluate_predicate(predicate.get(), in, 0, bindings) ? 2 : 1;
+        }
+        return state == 2;
+    };
+    selected.clear();
+    selected.reserve(in.length);
+    const auto* values = static_cast<const StrId*>(stored.data);
+    switch (stored.kind) {
+        case VectorKind::Narrow:
+            for (size_t row = 0; row < in.length; ++row) {
+                if (keep(static_cast<StrId>(stored.narrow_value(row)))) selected.push_back(row);
+            }
+            break;
+        case VectorKind::Dictionary:
+            // Not every slot of an 8-bit frame is a code the table holds
+            for (size_t row = 0; row < in.length; ++row) {
+                if (keep(values[stored.codes[row]])) selected.push_back(row);
             }
+            break;
+        default:
+            for (size_t row = 0; row < in.length; ++row) {
+                if (keep(values[row])) selected.push_back(row);
+            }
+            break;
+    }
+    column = stored;
+    return emit_selected(in, out);
+}
+
+bool Selection::select_rows(const ExecBatch& in, ExecBatch& out) {
+    selected.clear();
+    selected.reserve(in.length);
+    for (size_t row = 0; row < in.length; ++row) {
+        if (evaluate_predicate(predicate.get(), in, row, bindings)) {
+            selected.push_back(row);
         }
-        if (selected.empty()) {
-            continue;
+    }
+    return emit_selected(in, out);
+}
+
+bool Selection::emit_selected(const ExecBatch& in, ExecBatch& out) {
+    if (selected.empty()) {
+        return false;
+    }
+    out.clear();
+    out.columns.reserve(in.columns.size());
+    for (size_t col = 0; col < in.columns.size(); ++col) {
+        out.columns.push_back(copy_selected(in.columns[col], types_[col], selected));
+    }
+    out.length = selected.size();
+    return true;
+}
+
+bool Selection::select_encoded(ExecBatch& in, ExecBatch& out) {
+    auto reads = [&](VectorKind kind) {
+        return std::any_of(predicate_columns.begin(), predicate_columns.end(),
+                           [&](size_t column) { return in.columns[column].kind == kind; });
+    };
+    if (runs_only(in, predicate_columns)) {
+        // Every row of a segment reads the same values, so the predicate
+        // runs once per segment and whole segments are kept
+        segment_starts(in, predicate_columns, segments);
+        ranges.clear();
+        for (size_t s = 0; s + 1 < segments.size(); ++s) {
+            if (!evaluate_predicate(predicate.get(), in, segments[s], bindings)) continue;
+            if (!ranges.empty() && ranges.back().second == segments[s]) {
+                ranges.back().second = segments[s + 1];
+            } else {
+                ranges.emplace_back(segments[s], segments[s + 1]);
+            }
         }
-        out.clear();
-        out.columns.reserve(in.columns.size());
-        for (size_t col = 0; col < in.columns.size(); ++col) {
-            out.columns.push_back(copy_selected(in.columns[col], types_[col], selected));
+        if (ranges.empty()) {
+            return false;
         }
-        out.length = selected.size();
+        out = in;
+        if (ranges.size() > 1 || ranges[0].second - ranges[0].first < in.length) {
+            select_ranges(out, ranges);
+        }
+        if (!encoded_output) flatten(out);
         return true;
     }
-    return false;
+    if (predicate_columns.size() == 1 && reads(VectorKind::Dictionary)) {
+        // The predicate runs once per distinct value, the first time a batch
+        // holds its code; codes that never occur are never tested, since an
+        // 8-bit frame has slots for values the column does not hold
+        ColumnSlice& column = in.columns[predicate_columns[0]];
+        const ColumnSlice encoded = column;
+        if (encoded.data != code_values || !encoded.owner) {
+            // Outcomes carry over while batches share one set of code values
+            code_matches.assign(encoded.value_count, 0);
+            code_values = encoded.data;
+            code_owner = encoded.owner;
+        }
+        column = {encoded.data, encoded.type, encoded.value_count, {}};
+        selected.clear();
+        selected.reserve(in.length);
+        for (size_t row = 0; row < in.length; ++row) {
+            const uint8_t code = encoded.codes[row];
+            uint8_t& state = code_matches[code];
+            if (state == 0) state = evaluate_predicate(predicate.get(), in, code, bindings) ? 2 : 1;
+            if (state == 2) selected.push_back(row);
+        }
+        column = encoded;
+        return emit_selected(in, out);
+    }
+    // Row at a time, where RLE columns would cost a search per row
+    if (reads(VectorKind::Rle)) flatten(in);
+    return compares_in_place(in) ? select_compared(in, out) : select_rows(in, out);
 }
 
 void Selection::close() {
     child->close();
+    input.clear();
 }
 
 Project::Project(std::unique_ptr<Operator> c,
@@ -450,6 +644,8 @@ Project::Project(std::unique_ptr<Operator> c,
     types_.reserve(expressions.size());
     direct_indices.resize(expressions.size(), -1);
     for (size_t i = 0; i < expressions.size(); ++i) {
+        // Projected literals must decode on output; add them while still single-threaded
+        intern_string_literals(expressions[i].get(), dict_);
         TypeId expr_type = infer_type(expressions[i].get(), bindings);
         types_.push_back(expr_type);
         if (i < aliases.size() && !aliases[i].empty()) {
@@ -496,7 +692,7 @@ void Project::open() {
 }
 
 bool Project::next(ExecBatch& out) {
-    ExecBatch in;
+    ExecBatch& in = input;
     if (!child->next(in)) {
         return false;
     }
@@ -509,46 +705,11 @@ bool Project::next(ExecBatch& out) {
             out.columns.push_back(in.columns[direct]);
             continue;
         }
-        switch (type) {
-            case TypeId::INT64: {
-                auto buffer = std::make_shared<std::vector<int64_t>>(in.length);
-                for (size_t row = 0; row < in.length; ++row) {
-                    auto value = evaluate_expr(expressions[i].get(), in, row, bindings);
-                    (*buffer)[row] = value.type == TypeId::INT64 ? value.value.i64_val
-                                                                  : static_cast<int64_t>(value.value.f64_val);
-                }
-                out.columns.push_back({buffer->data(), type, in.length, std::shared_ptr<void>(buffer, buffer->data())});
-                break;
-            }
-            case TypeId::DOUBLE: {
-                auto buffer = std::make_shared<std::vector<double>>(in.length);
-                for (size_t row = 0; row < in.length; ++row) {
-                    auto value = evaluate_expr(expressions[i].get(), in, row, bindings);
-                    (*buffer)[row] = value.type == TypeId::DOUBLE ? value.value.f64_val
-                                                                  : static_cast<double>(value.value.i64_val);
-                }
-                out.columns.push_back({buffer->data(), type, in.length, std::shared_ptr<void>(buffer, buffer->data())});
-                break;
-            }
-            case TypeId::DATE32: {
-                auto buffer = std::make_shared<std::vector<int32_t>>(in.length);
-                for (size_t row = 0; row < in.length; ++row) {
-                    auto value = evaluate_expr(expressions[i].get(), in, row, bindings);
-                    (*buffer)[row] = value.value.date32_val;
-                }
-                out.columns.push_back({buffer->data(), type, in.length, std::shared_ptr<void>(buffer, buffer->data())});
-                break;
-            }
-            case TypeId::STRING: {
-                auto buffer = std::make_shared<std::vector<uint32_t>>(in.length);
-                for (size_t row = 0; row < in.length; ++row) {
-                    auto value = evaluate_expr(expressions[i].get(), in, row, bindings);
-                    (*buffer)[row] = value.value.str_id;
-                }
-                out.columns.push_back({buffer->data(), type, in.length, std::shared_ptr<void>(buffer, buffer->data())});
-                break;
-            }
-        }
+        ColumnBuilder builder(type, in.length);
+        append_column(builder, in.length, [&](size_t row) {
+            return evaluate_expr(expressions[i].get(), in, row, bindings);
+        });
+        out.columns.push_back(builder.finish());
     }
     out.length = in.length;
     return true;
@@ -556,6 +717,7 @@ bool Project::next(ExecBatch& out) {
 
 void Project::close() {
     child->close();
+    input.clear();
 }
 
 Limit::Limit(std::unique_ptr<Operator> c, int64_t n)
@@ -619,7 +781,7 @@ void Limit::close() {
     cache_offset = 0;
 }
 
-size_t HashJoin::KeyHash::operator()(const Key& key) const {
+size_t JoinBuildSide::KeyHash::operator()(const Key& key) const {
     size_t seed = 0;
     for (const auto& value : key.values) {
         size_t h = 0;
@@ -642,7 +804,7 @@ size_t HashJoin::KeyHash::operator()(const Key& key) const {
     return seed;
 }
 
-bool HashJoin::KeyEqual::operator()(const Key& lhs, const Key& rhs) const {
+bool JoinBuildSide::KeyEqual::operator()(const Key& lhs, const Key& rhs) const {
     if (lhs.values.size() != rhs.values.size()) {
         return false;
     }
@@ -668,130 +830,532 @@ bool HashJoin::KeyEqual::operator()(const Key& lhs, const Key& rhs) const {
     return true;
 }
 
-HashJoin::HashJoin(std::unique_ptr<Operator> left,
-                   std::unique_ptr<Operator> right,
-                   std::vector<std::string> left_keys,
-                   std::vector<std::string> right_keys,
-                   std::unique_ptr<Expr> residual)
-    : left_child(std::move(left)),
-      right_child(std::move(right)),
-      left_key_names(std::move(left_keys)),
-      right_key_names(std::move(right_keys)),
-      residual_filter(std::move(residual)) {
-    if (!left_child || !right_child) {
-        throw std::runtime_error("Join operands cannot be null");
+namespace {
+
+JoinBuildSide::Key make_join_key(const ExecBatch& batch,
+                                 size_t row,
+                                 const std::vector<size_t>& indices,
+                                 const std::vector<TypeId>& key_types) {
+    JoinBuildSide::Key key;
+    key.values.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        key.values.push_back(extract_value(batch.columns[indices[i]], key_types[i], row));
     }
-    left_names = left_child->output_names();
-    left_types = left_child->output_types();
-    right_names = right_child->output_names();
-    right_types = right_child->output_types();
+    return key;
+}
 
-    names_ = left_names;
-    names_.insert(names_.end(), right_names.begin(), right_names.end());
-    types_ = left_types;
-    types_.insert(types_.end(), right_types.begin(), right_types.end());
+std::vector<size_t> resolve_join_keys(const std::vector<std::string>& keys,
+                                      const std::vector<std::string>& columns) {
+    std::vector<size_t> indices;
+    indices.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto it = std::find(columns.begin(), columns.end(), key);
+        if (it == columns.end()) {
+            throw std::runtime_error("Join key not found: " + key);
+        }
+        indices.push_back(static_cast<size_t>(std::distance(columns.begin(), it)));
+    }
+    return indices;
+}
 
-    Dictionary* left_dict = left_child->dictionary();
-    Dictionary* right_dict = right_child->dictionary();
-    bool left_has_string = std::any_of(left_types.begin(), left_types.end(), [](TypeId t) { return t == TypeId::STRING; });
-    bool right_has_string = std::any_of(right_types.begin(), right_types.end(), [](TypeId t) { return t == TypeId::STRING; });
-    if (left_has_string && left_dict) {
-        dict_ = left_dict;
-    } else if (right_has_string && right_dict) {
-        dict_ = right_dict;
-    } else {
-        dict_ = left_dict ? left_dict : right_dict;
+std::vector<std::unique_ptr<Operator>> single_input(std::unique_ptr<Operator> op) {
+    std::vector<std::unique_ptr<Operator>> inputs;
+    inputs.push_back(std::move(op));
+    return inputs;
+}
+
+}
+
+JoinBuildSide::JoinBuildSide(std::vector<std::unique_ptr<Operator>> inputs_in,
+                             std::vector<std::string> key_names_in,
+                             size_t expected_rows_in,
+                             SpillConfig spill_in)
+    : inputs(std::move(inputs_in)),
+      key_names(std::move(key_names_in)),
+      expected_rows(expected_rows_in),
+      spill(std::move(spill_in)) {
+    if (inputs.empty() || std::any_of(inputs.begin(), inputs.end(), [](const auto& op) { return !op; })) {
+        throw std::runtime_error("Join operands cannot be null");
     }
+    names = inputs[0]->output_names();
+    types = inputs[0]->output_types();
+    dict = inputs[0]->dictionary();
+    key_indices = resolve_join_keys(key_names, names);
+    key_types.reserve(key_indices.size());
+    for (size_t index : key_indices) {
+        key_types.push_back(types[index]);
+    }
+}
 
-    left_bindings = make_bindings(left_names, left_types, left_child->dictionary());
-    right_bindings = make_bindings(right_names, right_types, right_child->dictionary());
-
-    auto resolve = [](const std::vector<std::string>& keys,
-                      const std::vector<std::string>& columns) {
-        std::vector<size_t> indices;
-        indices.reserve(keys.size());
-        for (const auto& key : keys) {
-            auto it = std::find(columns.begin(), columns.end(), key);
-            if (it == columns.end()) {
-                throw std::runtime_error("Join key not found: " + key);
+void JoinBuildSide::build() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (built) return;
+    if (!table_memory) {
+        table_memory = std::make_unique<MemoryReservation>();
+    }
+    if (inputs.size() == 1) {
+        // Serial plan: drain and insert on this thread
+        partials.resize(1);
+        drain(0);
+        if (spilled()) {
+            finish_spill();
+            return;
+        }
+        prepare_table();
+        insert_range(0, 0, partials[0].rows.size());
+        finish();
+        return;
+    }
+    Scheduler& scheduler = Scheduler::global();
+    if (!started) {
+        started = true;
+        partials.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            scheduler.submit(drain_tasks, [this, i] { drain(i); });
+        }
+    }
+    lock.unlock();
+    // Probes depend on the build: wait for it by helping to drain the inputs
+    scheduler.wait(drain_tasks);
+    lock.lock();
+    if (built) return;
+    if (spilled()) {
+        finish_spill();
+        return;
+    }
+    if (!inserting) {
+        inserting = true;
+        prepare_table();
+        for (size_t p = 0; p < partials.size(); ++p) {
+            size_t count = partials[p].rows.size();
+            for (size_t begin = 0; begin < count; begin += kDefaultMorselRows) {
+                size_t end = std::min(count, begin + kDefaultMorselRows);
+                scheduler.submit(insert_tasks, [this, p, begin, end] { insert_range(p, begin, end); });
             }
-            indices.push_back(static_cast<size_t>(std::distance(columns.begin(), it)));
         }
-        return indices;
-    };
-
-    left_key_indices = resolve(left_key_names, left_names);
-    right_key_indices = resolve(right_key_names, right_names);
-    if (left_key_indices.size() != right_key_indices.size()) {
-        throw std::runtime_error("Join key cardinality mismatch");
     }
-
-    left_key_types.reserve(left_key_indices.size());
-    right_key_types.reserve(right_key_indices.size());
-    for (size_t index : left_key_indices) {
-        left_key_types.push_back(left_types[index]);
+    lock.unlock();
+    scheduler.wait(insert_tasks);
+    lock.lock();
+    if (!built) {
+        finish();
     }
-    for (size_t index : right_key_indices) {
-        right_key_types.push_back(right_types[index]);
+}
+
+JoinBuildSide::~JoinBuildSide() {
+    for (const auto& files : spilled_files) {
+        remove_spill_files(files);
     }
 }
 
-void HashJoin::open() {
-    hash_table.clear();
-    build_rows.clear();
-    probe_batch.clear();
-    probe_batch_valid = false;
-    probe_row_index = 0;
-    current_matches.clear();
-    match_index = 0;
+size_t JoinBuildSide::row_bytes() const {
+    return sizeof(std::vector<Datum>) + types.size() * sizeof(Datum) + sizeof(Key) +
+           key_indices.size() * sizeof(Datum) + 3 * sizeof(size_t);
+}
 
-    right_child->open();
-    ExecBatch build_batch;
-    size_t row_id = 0;
-    while (right_child->next(build_batch)) {
-        for (size_t row = 0; row < build_batch.length; ++row) {
-            Key key = build_key(build_batch, row, right_key_indices, right_key_types);
-            build_rows.push_back(materialize_row(build_batch, row, right_types));
-            hash_table[key].push_back(row_id);
-            ++row_id;
+Dictionary* JoinBuildSide::map_strings(Dictionary* target) {
+    if (!target || !dict || target == dict || target == mapped_target) return dict ? dict : target;
+    bool other_strings = false;
+    for (size_t i = 0; i < types.size(); ++i) {
+        if (types[i] == TypeId::STRING && std::find(key_indices.begin(), key_indices.end(), i) == key_indices.end()) {
+            other_strings = true;
         }
     }
-    right_child->close();
+    string_codes.resize(dict->size());
+    for (size_t code = 0; code < dict->size(); ++code) {
+        std::string_view value = dict->get(static_cast<StrId>(code));
+        if (auto found = target->find(value)) {
+            string_codes[code] = *found;
+        } else if (other_strings) {
+            if (!overlay) overlay = std::make_unique<Dictionary>(target);
+            string_codes[code] = overlay->get_or_add(value);
+        } else {
+            // Keys without a probe-side code cannot match anything
+            string_codes[code] = kInvalidStrId;
+        }
+    }
+    mapped_target = target;
+    dict = overlay ? overlay.get() : target;
+    return dict;
+}
 
-    left_child->open();
+void JoinBuildSide::translate_strings(std::vector<Datum>& values) const {
+    for (Datum& value : values) {
+        if (value.type != TypeId::STRING) continue;
+        StrId& code = value.value.str_id;
+        code = code < string_codes.size() ? string_codes[code] : kInvalidStrId;
+    }
 }
 
-bool HashJoin::next(ExecBatch& out) {
-    constexpr size_t batch_target = 4096;
+void JoinBuildSide::drain(size_t input) {
+    Partial& partial = partials[input];
+    Operator& op = *inputs[input];
+    const size_t bytes_per_row = row_bytes();
+    op.open();
+    ExecBatch batch;
+    while (op.next(batch)) {
+        size_t buffered = partial.rows.size();
+        for (size_t row = 0; row < batch.length; ++row) {
+            Key key = make_join_key(batch, row, key_indices, key_types);
+            std::vector<Datum> values = materialize_row(batch, row, types);
+            if (!string_codes.empty()) {
+                translate_strings(key.values);
+                translate_strings(values);
+            }
+            if (spilled()) {
+                // Over budget: this and every later row goes to partition files
+                spill_partial(partial);
+                partial.overflow->append(KeyHash{}(key), values);
+                continue;
+            }
+            partial.keys.push_back(std::move(key));
+            partial.rows.push_back(std::move(values));
+            if (spill.memory_limit > 0 &&
+                reserved_bytes.fetch_add(bytes_per_row, std::memory_order_relaxed) + bytes_per_row > spill.memory_limit) {
+                spilling.store(true, std::memory_order_relaxed);
+            }
+        }
+        if (partial.rows.size() > buffered) {
+            table_memory->grow((partial.rows.size() - buffered) * bytes_per_row);
+        }
+    }
+    op.close();
+}
+
+void JoinBuildSide::spill_partial(Partial& partial) {
+    if (!partial.overflow) {
+        partial.overflow = std::make_unique<PartitionedSpill>(spill, types.size());
+    }
+    KeyHash hasher;
+    for (size_t i = 0; i < partial.rows.size(); ++i) {
+        partial.overflow->append(hasher(partial.keys[i]), partial.rows[i]);
+    }
+    table_memory->shrink(partial.rows.size() * row_bytes());
+    partial.keys = {};
+    partial.rows = {};
+}
+
+void JoinBuildSide::finish_spill() {
+    spilled_files.assign(kSpillPartitions, {});
+    for (auto& partial : partials) {
+        spill_partial(partial);
+        std::vector<std::filesystem::path> paths = partial.overflow->finish();
+        spill_stats.runs += partial.overflow->stats().runs;
+        spill_stats.rows += partial.overflow->stats().rows;
+        spill_stats.bytes += partial.overflow->stats().bytes;
+        for (size_t p = 0; p < kSpillPartitions; ++p) {
+            if (!paths[p].empty()) {
+                spilled_files[p].push_back(std::move(paths[p]));
+            }
+        }
+    }
+    partials.clear();
+    spilled_partitions.assign(kSpillPartitions, nullptr);
+    for (size_t p = 0; p < kSpillPartitions; ++p) {
+        if (spilled_files[p].empty()) continue;
+        spilled_partitions[p] = std::make_shared<GracePartition>();
+        spilled_partitions[p]->build_files = spilled_files[p];
+    }
+    built = true;
+}
+
+JoinBuildSide::GracePartition::~GracePartition() {
+    if (owns_files) remove_spill_files(build_files);
+}
+
+bool JoinBuildSide::prepare_grace(GracePartition& partition, bool wait) {
+    if (partition.prepared.load(std::memory_order_acquire)) return true;
+    std::unique_lock<std::mutex> lock(partition.mutex, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return false;
+    }
+    if (partition.prepared.load(std::memory_order_relaxed)) return true;
+    const size_t build_columns = types.size();
+    const size_t budget = spill.memory_limit / std::max<size_t>(probes, 1);
+    const size_t max_rows = std::max<size_t>(budget / row_bytes(), 1);
+    bool too_large = false;
+    std::vector<Datum> row;
+    for (const auto& path : partition.build_files) {
+        // Level-0 files belong to the build side, not to the partition
+        RunReader reader(path, build_columns, false);
+        while (!too_large && reader.next(row)) {
+            if (partition.rows.size() >= max_rows && partition.level + 1 < kMaxSpillLevel) {
+                too_large = true;
+                break;
+            }
+            Key key;
+            key.values.reserve(key_indices.size());
+            for (size_t index : key_indices) {
+                key.values.push_back(row[index]);
+            }
+            partition.table[std::move(key)].push_back(partition.rows.size());
+            partition.rows.push_back(row);
+        }
+    }
+    if (!too_large) {
+        partition.prepared.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Split by the next hash bits; clones that skipped this partition have
+    // no rows for its sub-partitions either
+    partition.table = {};
+    partition.rows = {};
+    KeyHash hasher;
+    PartitionedSpill build_spill(spill, build_columns, partition.level + 1);
+    for (const auto& path : partition.build_files) {
+        RunReader reader(path, build_columns, false);
+        while (reader.next(row)) {
+            Key key;
+            for (size_t index : key_indices) {
+                key.values.push_back(row[index]);
+            }
+            build_spill.append(hasher(key), row);
+        }
+    }
+    if (partition.owns_files) {
+        remove_spill_files(partition.build_files);
+        partition.build_files.clear();
+    }
+    std::vector<std::filesystem::path> paths = build_spill.finish();
+    partition.split.assign(kSpillPartitions, nullptr);
+    for (size_t p = 0; p < kSpillPartitions; ++p) {
+        if (paths[p].empty()) continue;
+        auto sub = std::make_shared<GracePartition>();
+        sub->build_files.push_back(std::move(paths[p]));
+        sub->owns_files = true;
+        sub->level = partition.level + 1;
+        sub->releases = partition.skips;
+        sub->skips = partition.skips;
+        partition.split[p] = std::move(sub);
+    }
+    partition.prepared.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> stats_lock(mutex);
+    spill_stats.runs += build_spill.stats().runs;
+    spill_stats.rows += build_spill.stats().rows;
+    spill_stats.bytes += build_spill.stats().bytes;
+    return true;
+}
+
+void JoinBuildSide::release_grace(GracePartition& partition, bool probed) {
+    std::vector<std::shared_ptr<GracePartition>> skipped;
+    {
+        std::lock_guard<std::mutex> lock(partition.mutex);
+        if (!probed) {
+            // Sub-partitions that exist already are skipped now; later ones
+            // start out counting this release
+            if (partition.prepared) {
+                skipped = partition.split;
+            } else {
+                ++partition.skips;
+            }
+        }
+        if (++partition.releases == std::max<size_t>(probes, 1)) {
+            partition.table = {};
+            partition.rows = {};
+            partition.split.clear();
+            partition.prepared.store(false, std::memory_order_relaxed);
+            partition.releases = 0;
+            partition.skips = 0;
+            if (partition.owns_files) {
+                remove_spill_files(partition.build_files);
+                partition.build_files.clear();
+            }
+        }
+    }
+    for (const auto& sub : skipped) {
+        if (sub) release_grace(*sub, false);
+    }
+}
+
+void JoinBuildSide::prepare_table() {
+    size_t total = 0;
+    for (auto& partial : partials) {
+        partial.offset = total;
+        total += partial.rows.size();
+    }
+    keys.resize(total);
+    rows.resize(total);
+    hashes.resize(total);
+    links.assign(total, 0);
+    // About two buckets per row keeps chains short
+    size_t bucket_count = std::bit_ceil(std::max<size_t>(total, 1) * 2);
+    bucket_shift = static_cast<unsigned>(64 - std::countr_zero(bucket_count));
+    buckets = std::vector<std::atomic<size_t>>(bucket_count);
+}
+
+size_t JoinBuildSide::bucket_of(size_t hash) const {
+    // Fibonacci hashing: the top bits of the product are well mixed even for
+    // the identity hashes std::hash uses for integers
+    return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL) >> bucket_shift);
+}
+
+void JoinBuildSide::insert_range(size_t index, size_t begin, size_t end) {
+    Partial& partial = partials[index];
+    KeyHash hasher;
+    // Walk backwards so a serial build links each chain in insertion order
+    for (size_t i = end; i-- > begin;) {
+        size_t row = partial.offset + i;
+        keys[row] = std::move(partial.keys[i]);
+        rows[row] = std::move(partial.rows[i]);
+        size_t hash = hasher(keys[row]);
+        hashes[row] = hash;
+        std::atomic<size_t>& head = buckets[bucket_of(hash)];
+        size_t link = head.load(std::memory_order_relaxed);
+        do {
+            links[row] = link;
+        } while (!head.compare_exchange_weak(link, row + 1, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+
+void JoinBuildSide::finish() {
+    partials.clear();
+    // Approximate footprint of the build side
+    size_t footprint = rows.size() * row_bytes() + buckets.size() * sizeof(std::atomic<size_t>);
+    count_allocation(footprint);
+    table_memory->resize(footprint);
+    built = true;
+}
+
+size_t JoinBuildSide::scan_chain(size_t link, size_t hash, const Key& key) const {
+    KeyEqual equal;
+    while (link != 0) {
+        size_t row = link - 1;
+        if (hashes[row] == hash && equal(keys[row], key)) {
+            return row;
+        }
+        link = links[row];
+    }
+    return kNoMatch;
+}
+
+size_t JoinBuildSide::find(const Key& key) const {
+    size_t hash = KeyHash{}(key);
+    return scan_chain(buckets[bucket_of(hash)].load(std::memory_order_acquire), hash, key);
+}
+
+size_t JoinBuildSide::next_match(size_t row, const Key& key) const {
+    return scan_chain(links[row], hashes[row], key);
+}
+
+HashJoin::HashJoin(std::unique_ptr<Operator> left,
+                   std::unique_ptr<Operator> right,
+                   std::vector<std::string> left_keys,
+                   std::vector<std::string> right_keys,
+                   std::unique_ptr<Expr> residual,
+                   size_t expected_build_rows)
+    : HashJoin(std::move(left),
+               right ? std::make_shared<JoinBuildSide>(single_input(std::move(right)), std::move(right_keys), expected_build_rows)
+                     : nullptr,
+               std::move(left_keys),
+               std::move(residual)) {}
+
+HashJoin::HashJoin(std::unique_ptr<Operator> left,
+                   std::shared_ptr<JoinBuildSide> build,
+                   std::vector<std::string> left_keys,
+                   std::unique_ptr<Expr> residual)
+    : left_child(std::move(left)),
+      build_side(std::move(build)),
+      left_key_names(std::move(left_keys)),
+      residual_filter(std::move(residual)) {
+    if (!left_child || !build_side) {
+        throw std::runtime_error("Join operands cannot be null");
+    }
+    if (!build_side->owner) {
+        build_side->owner = this;
+    }
+    build_side->probes += 1;
+    left_names = left_child->output_names();
+    left_types = left_child->output_types();
+    const auto& right_names = build_side->names;
+    const auto& right_types = build_side->types;
+
+    names_ = left_names;
+    names_.insert(names_.end(), right_names.begin(), right_names.end());
+    types_ = left_types;
+    types_.insert(types_.end(), right_types.begin(), right_types.end());
+
+    Dictionary* left_dict = left_child->dictionary();
+    Dictionary* right_dict = build_side->dict;
+    bool left_has_string = std::any_of(left_types.begin(), left_types.end(), [](TypeId t) { return t == TypeId::STRING; });
+    bool right_has_string = std::any_of(right_types.begin(), right_types.end(), [](TypeId t) { return t == TypeId::STRING; });
+    if (left_has_string && left_dict) {
+        dict_ = right_has_string ? build_side->map_strings(left_dict) : left_dict;
+    } else if (right_has_string && right_dict) {
+        dict_ = right_dict;
+    } else {
+        dict_ = left_dict ? left_dict : right_dict;
+    }
+
+    left_bindings = make_bindings(left_names, left_types, left_child->dictionary());
+
+    left_key_indices = resolve_join_keys(left_key_names, left_names);
+    if (left_key_indices.size() != build_side->key_indices.size()) {
+        throw std::runtime_error("Join key cardinality mismatch");
+    }
+
+    left_key_types.reserve(left_key_indices.size());
+    for (size_t index : left_key_indices) {
+        left_key_types.push_back(left_types[index]);
+    }
+}
+
+void HashJoin::open() {
+    probe_batch.clear();
+    probe_batch_valid = false;
+    probe_row_index = 0;
+    current_match = JoinBuildSide::kNoMatch;
+
+    build_side->build();
+    grace_pending = build_side->spilled();
+    left_child->open();
+}
+
+bool HashJoin::next(ExecBatch& out) {
+    if (build_side->spilled()) {
+        return next_grace(out);
+    }
+    constexpr size_t batch_target = 4096;
     std::vector<ColumnBuilder> builders;
     builders.reserve(types_.size());
     for (auto type : types_) {
-        builders.push_back(make_builder(type));
+        builders.emplace_back(type, batch_target);
     }
 
+    // Matches are collected as probe and build row numbers; probe columns are
+    // gathered before the probe batch is replaced, build columns at the end
+    probe_rows.clear();
+    build_matches.clear();
+    auto gather_probe_columns = [&]() {
+        for (size_t col = 0; col < left_types.size(); ++col) {
+            builders[col].gather(probe_batch.columns[col], probe_rows);
+        }
+        probe_rows.clear();
+    };
+
     size_t produced = 0;
     while (produced < batch_target) {
-        if (match_index >= current_matches.size()) {
+        if (current_match == JoinBuildSide::kNoMatch) {
             bool found = false;
             while (!found) {
                 if (!probe_batch_valid || probe_row_index >= probe_batch.length) {
+                    if (!probe_rows.empty()) {
+                        gather_probe_columns();
+                    }
                     probe_batch_valid = left_child->next(probe_batch);
                     if (!probe_batch_valid) {
                         break;
                     }
                     probe_row_index = 0;
                 }
-                if (!probe_batch_valid) {
-                    break;
-                }
-                Key key = build_key(probe_batch, probe_row_index, left_key_indices, left_key_types);
-                auto it = hash_table.find(key);
-                if (it == hash_table.end()) {
+                probe_key = make_join_key(probe_batch, probe_row_index, left_key_indices, left_key_types);
+                current_match = build_side->find(probe_key);
+                if (current_match == JoinBuildSide::kNoMatch) {
                     ++probe_row_index;
                     continue;
                 }
-                current_matches = it->second;
-                match_index = 0;
                 found = true;
             }
             if (!found) {
@@ -799,25 +1363,14 @@ bool HashJoin::next(ExecBatch& out) {
             }
         }
 
-        while (match_index < current_matches.size() && produced < batch_target) {
-            size_t right_index = current_matches[match_index];
-            const auto& right_row = build_rows[right_index];
-            size_t builder_idx = 0;
-            for (size_t col = 0; col < left_types.size(); ++col) {
-                append_value(builders[builder_idx], probe_batch.columns[col], probe_row_index);
-                ++builder_idx;
-            }
-            for (size_t col = 0; col < right_row.size(); ++col) {
-                append_value(builders[builder_idx], right_row[col]);
-                ++builder_idx;
-            }
+        while (current_match != JoinBuildSide::kNoMatch && produced < batch_target) {
+            probe_rows.push_back(probe_row_index);
+            build_matches.push_back(current_match);
             ++produced;
-            ++match_index;
+            current_match = build_side->next_match(current_match, probe_key);
         }
 
-        if (match_index >= current_matches.size()) {
-            current_matches.clear();
-            match_index = 0;
+        if (current_match == JoinBuildSide::kNoMatch) {
             ++probe_row_index;
         }
     }
@@ -827,10 +1380,20 @@ bool HashJoin::next(ExecBatch& out) {
         return false;
     }
 
+    if (!probe_rows.empty()) {
+        gather_probe_columns();
+    }
+    const auto& build_rows = build_side->rows;
+    for (size_t col = left_types.size(); col < types_.size(); ++col) {
+        size_t build_col = col - left_types.size();
+        append_column(builders[col], build_matches.size(),
+                      [&](size_t i) -> const Datum& { return build_rows[build_matches[i]][build_col]; });
+    }
+
     out.clear();
     out.columns.reserve(types_.size());
     for (auto& builder : builders) {
-        out.columns.push_back(finalize_builder(builder));
+        out.columns.push_back(builder.finish());
     }
     out.length = produced;
     return true;
@@ -840,26 +1403,186 @@ void HashJoin::close() {
     left_child->close();
     probe_batch.clear();
     probe_batch_valid = false;
-    current_matches.clear();
-    match_index = 0;
+    current_match = JoinBuildSide::kNoMatch;
+    discard_grace_partitions();
 }
 
-HashJoin::Key HashJoin::build_key(const ExecBatch& batch,
-                                  size_t row,
-                                  const std::vector<size_t>& indices,
-                                  const std::vector<TypeId>& key_types) const {
-    Key key;
-    key.values.reserve(indices.size());
-    for (size_t i = 0; i < indices.size(); ++i) {
-        size_t column = indices[i];
-        key.values.push_back(extract_value(batch.columns[column], key_types[i], row));
+SpillStats HashJoin::spill_stats() const {
+    SpillStats stats = build_side->spill_stats;
+    stats.runs += probe_spill_stats.runs;
+    stats.rows += probe_spill_stats.rows;
+    stats.bytes += probe_spill_stats.bytes;
+    return stats;
+}
+
+void HashJoin::partition_probe() {
+    PartitionedSpill probe_spill(build_side->spill, left_types.size());
+    JoinBuildSide::KeyHash hasher;
+    ExecBatch batch;
+    while (left_child->next(batch)) {
+        for (size_t row = 0; row < batch.length; ++row) {
+            Key key = make_join_key(batch, row, left_key_indices, left_key_types);
+            probe_spill.append(hasher(key), materialize_row(batch, row, left_types));
+        }
     }
-    return key;
+    std::vector<std::filesystem::path> paths = probe_spill.finish();
+    probe_spill_stats = probe_spill.stats();
+    queue_grace_work(build_side->grace_partitions(), std::move(paths));
+    grace_pending = false;
+    probe_partitioned = true;
+}
+
+void HashJoin::queue_grace_work(const std::vector<std::shared_ptr<JoinBuildSide::GracePartition>>& builds,
+                                std::vector<std::filesystem::path> probe_paths) {
+    // Processed from the back, so push in reverse to keep partition order
+    for (size_t p = kSpillPartitions; p-- > 0;) {
+        if (!builds[p]) {
+            // Inner join: probe rows without build rows produce nothing
+            remove_spill_files({probe_paths[p]});
+        } else if (probe_paths[p].empty()) {
+            build_side->release_grace(*builds[p], false);
+        } else {
+            grace_work.push_back({builds[p], std::move(probe_paths[p])});
+        }
+    }
+}
+
+void HashJoin::load_grace_partition() {
+    // Rather than wait for a partition another clone is loading, take the
+    // next one; wait only when every partition left is being loaded
+    size_t next = grace_work.size() - 1;
+    bool ready = false;
+    for (size_t i = grace_work.size(); i-- > 0 && !ready;) {
+        ready = build_side->prepare_grace(*grace_work[i].build, false);
+        if (ready) next = i;
+    }
+    if (!ready) build_side->prepare_grace(*grace_work[next].build);
+    GraceWork work = std::move(grace_work[next]);
+    grace_work.erase(grace_work.begin() + static_cast<std::ptrdiff_t>(next));
+    grace_matches = nullptr;
+    if (work.build->split.empty()) {
+        grace_build = std::move(work.build);
+        grace_probe = std::make_unique<RunReader>(work.probe_file, left_types.size());
+        return;
+    }
+
+    // The build rows were split: split the probe rows the same way
+    JoinBuildSide::KeyHash hasher;
+    PartitionedSpill probe_spill(build_side->spill, left_types.size(), work.build->level + 1);
+    {
+        RunReader reader(work.probe_file, left_types.size());
+        std::vector<Datum> row;
+        while (reader.next(row)) {
+            Key key;
+            for (size_t index : left_key_indices) {
+                key.values.push_back(row[index]);
+            }
+            probe_spill.append(hasher(key), row);
+        }
+    }
+    std::vector<std::filesystem::path> probe_paths = probe_spill.finish();
+    probe_spill_stats.runs += probe_spill.stats().runs;
+    probe_spill_stats.rows += probe_spill.stats().rows;
+    probe_spill_stats.bytes += probe_spill.stats().bytes;
+    auto subs = work.build->split;
+    build_side->release_grace(*work.build, true);
+    queue_grace_work(subs, std::move(probe_paths));
 }
 
-size_t HashAggregate::GroupKeyHash::operator()(const std::vector<Datum>& key) const {
+bool HashJoin::next_grace(ExecBatch& out) {
+    if (!probe_partitioned) {
+        partition_probe();
+    }
+    constexpr size_t batch_target = 4096;
+    // Probe rows arrive one at a time from disk: values are staged by column
+    // and converted a column at a time
+    grace_output.resize(types_.size());
+    for (auto& column : grace_output) {
+        column.clear();
+    }
+
+    size_t produced = 0;
+    while (produced < batch_target) {
+        if (grace_matches && grace_match_index < grace_matches->size()) {
+            const auto& right_row = grace_build->rows[(*grace_matches)[grace_match_index++]];
+            size_t col = 0;
+            for (const auto& value : grace_probe_row) {
+                grace_output[col++].push_back(value);
+            }
+            for (const auto& value : right_row) {
+                grace_output[col++].push_back(value);
+            }
+            ++produced;
+            continue;
+        }
+        grace_matches = nullptr;
+        if (grace_probe && grace_probe->next(grace_probe_row)) {
+            Key key;
+            key.values.reserve(left_key_indices.size());
+            for (size_t index : left_key_indices) {
+                key.values.push_back(grace_probe_row[index]);
+            }
+            auto it = grace_build->table.find(key);
+            if (it != grace_build->table.end()) {
+                grace_matches = &it->second;
+                grace_match_index = 0;
+            }
+            continue;
+        }
+        grace_probe.reset();
+        if (grace_build) {
+            build_side->release_grace(*grace_build, true);
+            grace_build.reset();
+        }
+        if (grace_work.empty()) {
+            break;
+        }
+        load_grace_partition();
+    }
+
+    if (produced == 0) {
+        out.clear();
+        return false;
+    }
+    out.clear();
+    out.columns.reserve(types_.size());
+    for (size_t col = 0; col < types_.size(); ++col) {
+        ColumnBuilder builder(types_[col], produced);
+        builder.append(grace_output[col]);
+        out.columns.push_back(builder.finish());
+    }
+    out.length = produced;
+    return true;
+}
+
+void HashJoin::discard_grace_partitions() {
+    grace_probe.reset();
+    grace_matches = nullptr;
+    if (grace_build) {
+        build_side->release_grace(*grace_build, true);
+        grace_build.reset();
+    }
+    for (const auto& work : grace_work) {
+        remove_spill_files({work.probe_file});
+        build_side->release_grace(*work.build, false);
+    }
+    grace_work.clear();
+    if (grace_pending) {
+        // Closed before partitioning its probe rows: no rows for any partition
+        for (const auto& partition : build_side->grace_partitions()) {
+            if (partition) build_side->release_grace(*partition, false);
+        }
+        grace_pending = false;
+    }
+    probe_partitioned = false;
+}
+
+namespace {
+
+size_t hash_group_key(const Datum* key, size_t width) {
     size_t seed = 0;
-    for (const auto& value : key) {
+    for (size_t i = 0; i < width; ++i) {
+        const Datum& value = key[i];
         size_t h = 0;
         switch (value.type) {
             case TypeId::INT64:
@@ -880,9 +1603,8 @@ size_t HashAggregate::GroupKeyHash::operator()(const std::vector<Datum>& key) co
     return seed;
 }
 
-bool HashAggregate::GroupKeyEqual::operator()(const std::vector<Datum>& lhs, const std::vector<Datum>& rhs) const {
-    if (lhs.size() != rhs.size()) return false;
-    for (size_t i = 0; i < lhs.size(); ++i) {
+bool group_keys_equal(const Datum* lhs, const Datum* rhs, size_t width) {
+    for (size_t i = 0; i < width; ++i) {
         const Datum& a = lhs[i];
         const Datum& b = rhs[i];
         if (a.type != b.type) return false;
@@ -904,22 +1626,130 @@ bool HashAggregate::GroupKeyEqual::operator()(const std::vector<Datum>& lhs, con
     return true;
 }
 
+// Mixes the hash before masking, so that the identity hashes of consecutive
+// integers spread and the slot does not follow the aggregate partition
+size_t group_slot(size_t hash, size_t mask) {
+    uint64_t x = static_cast<uint64_t>(hash);
+    x = (x ^ (x >> 31)) * 0xbf58476d1ce4e5b9ULL;
+    return static_cast<size_t>(x ^ (x >> 29)) & mask;
+}
+
+} // namespace
+
+size_t HashAggregate::GroupRows::add(const Datum* key, size_t hash) {
+    keys.insert(keys.end(), key, key + key_width);
+    states.resize(states.size() + aggregates);
+    hashes.push_back(hash);
+    return hashes.size() - 1;
+}
+
+void HashAggregate::GroupRows::clear() {
+    keys.clear();
+    states.clear();
+    hashes.clear();
+}
+
+HashAggregate::GroupTable::GroupTable(size_t key_width, size_t aggregates) {
+    groups.key_width = key_width;
+    groups.aggregates = aggregates;
+}
+
+size_t HashAggregate::GroupTable::find(const Datum* key, size_t hash) const {
+    if (slots.empty()) return kNoGroup;
+    const size_t mask = slots.size() - 1;
+    for (size_t slot = group_slot(hash, mask); slots[slot] != 0; slot = (slot + 1) & mask) {
+        const size_t group = slots[slot] - 1;
+        if (groups.hashes[group] == hash && group_keys_equal(groups.key(group), key, groups.key_width)) return group;
+    }
+    return kNoGroup;
+}
+
+size_t HashAggregate::GroupTable::add(const Datum* key, size_t hash) {
+    reserve(groups.size() + 1);
+    const size_t group = groups.add(key, hash);
+    insert_slot(group);
+    return group;
+}
+
+void HashAggregate::GroupTable::insert_slot(size_t group) {
+    const size_t mask = slots.size() - 1;
+    size_t slot = group_slot(groups.hashes[group], mask);
+    while (slots[slot] != 0) slot = (slot + 1) & mask;
+    slots[slot] = static_cast<uint32_t>(group + 1);
+}
+
+void HashAggregate::GroupTable::reserve(size_t count) {
+    if (count * 2 <= slots.size()) return;
+    size_t capacity = 16;
+    while (capacity < count * 2) capacity *= 2;
+    slots.assign(capacity, 0);
+    for (size_t group = 0; group < groups.size(); ++group) {
+        insert_slot(group);
+    }
+}
+
+void HashAggregate::GroupTable::clear() {
+    groups.clear();
+    std::fill(slots.begin(), slots.end(), 0);
+}
+
+size_t HashAggregate::GroupTable::memory_bytes() const {
+    return groups.keys.capacity() * sizeof(Datum) + groups.states.capacity() * sizeof(AggState) +
+           groups.hashes.capacity() * sizeof(size_t) + slots.capacity() * sizeof(uint32_t);
+}
+
 HashAggregate::HashAggregate(std::unique_ptr<Operator> child_op,
                              std::vector<std::unique_ptr<Expr>> group_exprs_in,
-                             std::vector<AggregateSpec> aggregates_in)
-    : child(std::move(child_op)),
+                             std::vector<AggregateSpec> aggregates_in,
+                             size_t expected_groups_in)
+    : HashAggregate(single_input(std::move(child_op)),
+                    std::move(group_exprs_in),
+                    std::move(aggregates_in),
+                    expected_groups_in) {}
+
+HashAggregate::HashAggregate(std::vector<std::unique_ptr<Operator>> inputs_in,
+                             std::vector<std::unique_ptr<Expr>> group_exprs_in,
+                             std::vector<AggregateSpec> aggregates_in,
+                             size_t expected_groups_in,
+                             SpillConfig spill_in)
+    : inputs(std::move(inputs_in)),
       group_exprs(std::move(group_exprs_in)),
-      aggregates(std::move(aggregates_in)) {
-    if (!child) {
+      aggregates(std::move(aggregates_in)),
+      expected_groups(expected_groups_in),
+      spill(std::move(spill_in)) {
+    if (inputs.empty() || std::any_of(inputs.begin(), inputs.end(), [](const auto& op) { return !op; })) {
         throw std::runtime_error("HashAggregate child is null");
     }
-    const auto& child_names = child->output_names();
-    const auto& child_types = child->output_types();
-    dict_ = child->dictionary();
+    // Clones of one pipeline share a schema, so the first input binds for all
+    const auto& child_names = inputs[0]->output_names();
+    const auto& child_types = inputs[0]->output_types();
+    dict_ = inputs[0]->dictionary();
     child_bindings = make_bindings(child_names, child_types, dict_);
+    for (const auto& expr : group_exprs) {
+        referenced_columns(expr.get(), child_bindings, input_columns);
+    }
+    for (const auto& agg : aggregates) {
+        referenced_columns(agg.arg.get(), child_bindings, input_columns);
+    }
+    auto column_of = [&](const Expr* expr) {
+        std::vector<size_t> columns;
+        if (expr && expr->type == ExprType::COLUMN_REF) referenced_columns(expr, child_bindings, columns);
+        return columns.size() == 1 ? columns[0] : std::string::npos;
+    };
+    decodes_columns = true;
+    for (const auto& expr : group_exprs) {
+        key_columns.push_back(column_of(expr.get()));
+        decodes_columns &= key_columns.back() != std::string::npos;
+    }
+    for (const auto& agg : aggregates) {
+        const bool counts = agg.func_name == "COUNT";
+        arg_columns.push_back(counts ? std::string::npos : column_of(agg.arg.get()));
+        decodes_columns &= counts || arg_columns.back() != std::string::npos;
+    }
 
     group_types.reserve(group_exprs.size());
     for (size_t i = 0; i < group_exprs.size(); ++i) {
+        intern_string_literals(group_exprs[i].get(), dict_);
         TypeId type = infer_type(group_exprs[i].get(), child_bindings);
         group_types.push_back(type);
         std::string name = (group_exprs[i]->type == ExprType::COLUMN_REF)
@@ -933,6 +1763,7 @@ HashAggregate::HashAggregate(std::unique_ptr<Operator> child_op,
     for (size_t i = 0; i < aggregates.size(); ++i) {
         const auto& agg = aggregates[i];
         const std::string& func = agg.func_name;
+        intern_string_literals(agg.arg.get(), dict_);
         TypeId arg_type = TypeId::INT64;
         if (agg.arg && func != "COUNT") {
             arg_type = infer_type(agg.arg.get(), child_bindings);
@@ -960,101 +1791,521 @@ HashAggregate::HashAggregate(std::unique_ptr<Operator> child_op,
 }
 
 void HashAggregate::open() {
-    groups.clear();
-    result_keys.clear();
-    result_aggs.clear();
+    results.clear();
+    spilled_stats = {};
+    state_memory = std::make_unique<MemoryReservation>();
     results_ready = false;
     child_consumed = false;
+    emit_partition = 0;
     emit_index = 0;
-    child->open();
+    for (auto& input : inputs) {
+        input->open();
+    }
+}
+
+namespace {
+
+// Groups a worker keeps locally before flushing them to the partitions
+constexpr size_t kPreAggregateGroups = 16384;
+// Partitions of the merge phase; each is merged by a single task
+constexpr size_t kAggregatePartitionBits = 6;
+constexpr size_t kAggregatePartitions = size_t{1} << kAggregatePartitionBits;
+
+// Takes the top bits of a Fibonacci-scrambled hash so that partitions stay
+// independent of the bucket index the hash maps use
+size_t aggregate_partition(size_t hash) {
+    return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL) >> (64 - kAggregatePartitionBits));
+}
+
+// Calls fn with the slice's values as a typed array
+template <typename Fn>
+void visit_values(const ColumnSlice& slice, Fn&& fn) {
+    switch (slice.type) {
+        case TypeId::INT64: fn(static_cast<const int64_t*>(slice.data)); return;
+        case TypeId::DOUBLE: fn(static_cast<const double*>(slice.data)); return;
+        case TypeId::STRING: fn(static_cast<const uint32_t*>(slice.data)); return;
+        case TypeId::DATE32: fn(static_cast<const int32_t*>(slice.data)); return;
+    }
+}
+
+// Writes convert(value) of rows [0, length) to out[row * stride]. Narrow
+// deltas are widened at their stored width in one loop per width, and a
+// dictionary converts each of its values once, then gathers by code.
+template <typename Out, typename Convert>
+void decode_slice(const ColumnSlice& slice, size_t length, Out* out, size_t stride, Convert&& convert) {
+    auto widen = [&](const auto* deltas) {
+        for (size_t row = 0; row < length; ++row) {
+            out[row * stride] = convert(slice.base + static_cast<int64_t>(deltas[row]));
+        }
+    };
+    switch (slice.kind) {
+        case VectorKind::Narrow:
+            switch (slice.width) {
+                case 1: widen(static_cast<const uint8_t*>(slice.data)); return;
+                case 2: widen(static_cast<const uint16_t*>(slice.data)); return;
+                default: widen(static_cast<const uint32_t*>(slice.data)); return;
+            }
+        case VectorKind::Dictionary:
+            visit_values(slice, [&](const auto* values) {
+                std::array<Out, 256> converted;
+                for (size_t code = 0; code < slice.value_count; ++code) converted[code] = convert(values[code]);
+                for (size_t row = 0; row < length; ++row) out[row * stride] = converted[slice.codes[row]];
+            });
+            return;
+        default:
+            visit_values(slice, [&](const auto* values) {
+                for (size_t row = 0; row < length; ++row) out[row * stride] = convert(values[row]);
+            });
+            return;
+    }
 }
 
-static std::vector<Datum> evaluate_key_row(const std::vector<std::unique_ptr<Expr>>& exprs,
-                                           const ExecBatch& batch,
-                                           size_t row,
-                                           const ExprBindings& bindings) {
-    std::vector<Datum> key;
+// Fills `key` in place, so probing an existing group allocates nothing
+void evaluate_key_row(const std::vector<std::unique_ptr<Expr>>& exprs,
+                      const ExecBatch& batch,
+                      size_t row,
+                      const ExprBindings& bindings,
+                      std::vector<Datum>& key) {
+    key.clear();
     key.reserve(exprs.size());
     for (const auto& expr : exprs) {
         key.push_back(evaluate_expr(expr.get(), batch, row, bindings));
     }
-    return key;
 }
 
-bool HashAggregate::next(ExecBatch& out) {
-    if (!results_ready) {
-        ExecBatch batch;
-        while (child->next(batch)) {
-            for (size_t row = 0; row < batch.length; ++row) {
-                std::vector<Datum> key = evaluate_key_row(group_exprs, batch, row, child_bindings);
-                auto it = groups.find(key);
-                if (it == groups.end()) {
-                    it = groups.emplace(std::move(key), std::vector<AggState>(aggregates.size())).first;
-                }
-                auto& states = it->second;
-                for (size_t a = 0; a < aggregates.size(); ++a) {
-                    const std::string& func = aggregates[a].func_name;
-                    if (func == "COUNT") {
-                        states[a].count += 1;
-                    } else {
-                        Datum value = evaluate_expr(aggregates[a].arg.get(), batch, row, child_bindings);
-                        states[a].sum += datum_as_double(value);
-                        states[a].count += 1;
+}
+
+bool HashAggregate::decode_batch(const ExecBatch& batch, DecodedBatch& decoded) const {
+    decoded.decoded = decodes_columns && std::all_of(input_columns.begin(), input_columns.end(), [&](size_t column) {
+        VectorKind kind = batch.columns[column].kind;
+        return kind == VectorKind::Flat || kind == VectorKind::Narrow || kind == VectorKind::Dictionary;
+    });
+    if (!decoded.decoded) return false;
+    const size_t width = key_columns.size();
+    decoded.keys.resize(batch.length * width);
+    for (size_t k = 0; k < width; ++k) {
+        const TypeId type = group_types[k];
+        decode_slice(batch.columns[key_columns[k]], batch.length, decoded.keys.data() + k, width, [type](auto value) {
+            switch (type) {
+                case TypeId::INT64: return Datum::from_i64(static_cast<int64_t>(value));
+                case TypeId::DOUBLE: return Datum::from_f64(static_cast<double>(value));
+                case TypeId::STRING: return Datum::from_str(static_cast<StrId>(value));
+                case TypeId::DATE32: return Datum::from_date32(static_cast<Date32>(value));
+            }
+            return Datum::from_i64(0);
+        });
+    }
+    decoded.args.resize(aggregates.size());
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        if (arg_columns[a] == std::string::npos) continue;
+        decoded.args[a].resize(batch.length);
+        decode_slice(batch.columns[arg_columns[a]], batch.length, decoded.args[a].data(), 1,
+                     [](auto value) { return static_cast<double>(value); });
+    }
+    return true;
+}
+
+const Datum* HashAggregate::segment_key(const ExecBatch& batch,
+                                        size_t row,
+                                        const DecodedBatch& decoded,
+                                        std::vector<Datum>& scratch) const {
+    if (decoded.decoded) return decoded.keys.data() + row * key_columns.size();
+    evaluate_key_row(group_exprs, batch, row, child_bindings, scratch);
+    return scratch.data();
+}
+
+void HashAggregate::accumulate(AggState* states,
+                               const ExecBatch& batch,
+                               size_t row,
+                               size_t rows,
+                               const DecodedBatch& decoded) const {
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        if (aggregates[a].func_name == "COUNT") {
+            states[a].count += static_cast<int64_t>(rows);
+        } else {
+            double x = decoded.decoded ? decoded.args[a][row]
+                                       : datum_as_double(evaluate_expr(aggregates[a].arg.get(), batch, row, child_bindings));
+            states[a].sum += rows == 1 ? x : x * static_cast<double>(rows);
+            states[a].count += static_cast<int64_t>(rows);
+        }
+    }
+}
+
+// Splits the batch at every row where a column the aggregate reads may
+// change: at run boundaries when those columns are all constant or RLE,
+// otherwise at every row, decoding the keys and arguments up front when
+// their columns allow. `starts` ends with batch.length.
+void HashAggregate::row_segments(ExecBatch& batch, std::vector<size_t>& starts, DecodedBatch& decoded) const {
+    decoded.decoded = false;
+    if (has_encoded_columns(batch)) {
+        if (runs_only(batch, input_columns)) {
+            segment_starts(batch, input_columns, starts);
+            return;
+        }
+        if (std::any_of(input_columns.begin(), input_columns.end(),
+                        [&](size_t column) { return batch.columns[column].kind == VectorKind::Rle; })) {
+            flatten(batch);
+        }
+    }
+    decode_batch(batch, decoded);
+    starts.resize(batch.length + 1);
+    std::iota(starts.begin(), starts.end(), size_t{0});
+}
+
+size_t HashAggregate::group_bytes() const {
+    // Slots are at most half full
+    return group_exprs.size() * sizeof(Datum) + aggregates.size() * sizeof(AggState) + sizeof(size_t) +
+           2 * sizeof(uint32_t);
+}
+
+void HashAggregate::spill_groups(const GroupRows& groups, PartitionedSpill& target) const {
+    // Partial aggregate row: key values, then a SUM and a COUNT per aggregate
+    std::vector<Datum> row;
+    row.reserve(partial_columns());
+    for (size_t group = 0; group < groups.size(); ++group) {
+        row.assign(groups.key(group), groups.key(group) + groups.key_width);
+        const AggState* states = groups.aggs(group);
+        for (size_t a = 0; a < groups.aggregates; ++a) {
+            row.push_back(Datum::from_f64(states[a].sum));
+            row.push_back(Datum::from_i64(states[a].count));
+        }
+        target.append(groups.hashes[group], row);
+    }
+}
+
+void HashAggregate::consume(Operator& input, GroupTable& target, std::unique_ptr<PartitionedSpill>& overflow) const {
+    const size_t max_groups = spill.memory_limit > 0 ? std::max<size_t>(spill.memory_limit / group_bytes(), 1) : 0;
+    MemoryReservation table_memory;
+    const size_t width = group_exprs.size();
+    std::vector<Datum> scratch;
+    std::vector<size_t> starts;
+    DecodedBatch decoded;
+    ExecBatch batch;
+    while (input.next(batch)) {
+        row_segments(batch, starts, decoded);
+        for (size_t s = 0; s + 1 < starts.size(); ++s) {
+            const size_t row = starts[s];
+            const Datum* key = segment_key(batch, row, decoded, scratch);
+            const size_t hash = hash_group_key(key, width);
+            size_t group = target.find(key, hash);
+            if (group == GroupTable::kNoGroup) {
+                if (max_groups > 0 && target.size() >= max_groups) {
+                    // Over budget: move the table's partial aggregates to disk
+                    if (!overflow) {
+                        overflow = std::make_unique<PartitionedSpill>(spill, partial_columns());
                     }
+                    spill_groups(target.groups, *overflow);
+                    target.clear();
                 }
+                group = target.add(key, hash);
             }
+            accumulate(target.groups.aggs(group), batch, row, starts[s + 1] - row, decoded);
         }
-        results_ready = true;
-        child->close();
-        child_consumed = true;
-        for (const auto& entry : groups) {
-            result_keys.push_back(entry.first);
-            result_aggs.push_back(entry.second);
+        table_memory.resize(target.size() * group_bytes());
+    }
+}
+
+void HashAggregate::pre_aggregate(Operator& input,
+                                  PartitionBuffers& buffers,
+                                  std::unique_ptr<PartitionedSpill>& overflow) const {
+    buffers.assign(kAggregatePartitions, empty_groups());
+    GroupTable local(group_exprs.size(), aggregates.size());
+    local.reserve(std::min(kPreAggregateGroups, expected_groups > 0 ? expected_groups : kPreAggregateGroups));
+    size_t rows_since_flush = 0;
+    bool pass_through = false;
+    // Every input may hold an equal share of the memory budget
+    const size_t max_groups = spill.memory_limit > 0
+                                  ? std::max<size_t>(spill.memory_limit / inputs.size() / group_bytes(), 1)
+                                  : 0;
+    size_t buffered = 0;
+    MemoryReservation local_memory;
+
+    auto spill_buffers = [&] {
+        if (!overflow) {
+            overflow = std::make_unique<PartitionedSpill>(spill, partial_columns());
+        }
+        for (auto& partition : buffers) {
+            spill_groups(partition, *overflow);
+            partition.clear();
+        }
+        buffered = 0;
+    };
+    auto flush = [&] {
+        const GroupRows& groups = local.groups;
+        for (size_t group = 0; group < groups.size(); ++group) {
+            GroupRows& partition = buffers[aggregate_partition(groups.hashes[group])];
+            size_t added = partition.add(groups.key(group), groups.hashes[group]);
+            std::copy(groups.aggs(group), groups.aggs(group) + aggregates.size(), partition.aggs(added));
         }
+        buffered += local.size();
+        local.clear();
+        rows_since_flush = 0;
+        if (max_groups > 0 && buffered >= max_groups) {
+            spill_buffers();
+        }
+    };
+    DecodedBatch decoded;
+    auto pass = [&](const Datum* key, size_t hash, const ExecBatch& batch, size_t row, size_t rows) {
+        GroupRows& partition = buffers[aggregate_partition(hash)];
+        accumulate(partition.aggs(partition.add(key, hash)), batch, row, rows, decoded);
+        if (max_groups > 0 && ++buffered >= max_groups) {
+            spill_buffers();
+        }
+    };
+
+    const size_t width = group_exprs.size();
+    std::vector<Datum> scratch;
+    std::vector<size_t> starts;
+    ExecBatch batch;
+    while (input.next(batch)) {
+        row_segments(batch, starts, decoded);
+        for (size_t s = 0; s + 1 < starts.size(); ++s) {
+            const size_t row = starts[s];
+            const size_t rows = starts[s + 1] - row;
+            const Datum* key = segment_key(batch, row, decoded, scratch);
+            const size_t hash = hash_group_key(key, width);
+            if (pass_through) {
+                pass(key, hash, batch, row, rows);
+                continue;
+            }
+            size_t group = local.find(key, hash);
+            if (group == GroupTable::kNoGroup) {
+                if (local.size() >= kPreAggregateGroups || (max_groups > 0 && local.size() + buffered >= max_groups)) {
+                    // Fewer than two rows per group: the local table is not
+                    // reducing the input, so stop probing it
+                    pass_through = local.size() >= kPreAggregateGroups && rows_since_flush < 2 * local.size();
+                    flush();
+                    if (pass_through) {
+                        pass(key, hash, batch, row, rows);
+                        continue;
+                    }
+                }
+                group = local.add(key, hash);
+            }
+            accumulate(local.groups.aggs(group), batch, row, rows, decoded);
+            rows_since_flush += rows;
+        }
+        local_memory.resize((local.size() + buffered) * group_bytes());
     }
+    flush();
+    // The buffers outlive this task: the operator holds them until the merge
+    state_memory->grow(buffered * group_bytes());
+}
 
-    if (emit_index >= result_keys.size()) {
-        return false;
+void HashAggregate::aggregate_serial() {
+    GroupTable groups(group_exprs.size(), aggregates.size());
+    if (expected_groups > 0) {
+        groups.reserve(spill.memory_limit > 0 ? std::min(expected_groups, spill.memory_limit / group_bytes() + 1)
+                                              : expected_groups);
     }
+    std::unique_ptr<PartitionedSpill> overflow;
+    consume(*inputs[0], groups, overflow);
+    if (overflow) {
+        spill_groups(groups.groups, *overflow);
+        std::vector<std::unique_ptr<PartitionedSpill>> spills;
+        spills.push_back(std::move(overflow));
+        queue_spilled(spills);
+        return;
+    }
+    count_allocation(groups.memory_bytes());
+    state_memory->resize(groups.size() * group_bytes());
+    results.clear();
+    results.push_back(std::move(groups.groups));
+}
 
-    size_t batch_size = std::min<size_t>(4096, result_keys.size() - emit_index);
-    std::vector<ColumnBuilder> builders;
-    builders.reserve(types_.size());
-    for (auto type : types_) {
-        builders.push_back(make_builder(type));
+void HashAggregate::aggregate_parallel() {
+    // Phase 1: every input pre-aggregates into its own partition buffers
+    std::vector<PartitionBuffers> buffers(inputs.size());
+    std::vector<std::unique_ptr<PartitionedSpill>> spills(inputs.size());
+    run_parallel(inputs.size(), [&](size_t i) {
+        pre_aggregate(*inputs[i], buffers[i], spills[i]);
+    });
+
+    if (std::any_of(spills.begin(), spills.end(), [](const auto& spill_file) { return spill_file != nullptr; })) {
+        // Some input ran out of budget: spill what the others buffered too and
+        // finish the aggregation partition by partition
+        run_parallel(inputs.size(), [&](size_t i) {
+            if (!spills[i]) {
+                spills[i] = std::make_unique<PartitionedSpill>(spill, partial_columns());
+            }
+            for (auto& partition : buffers[i]) {
+                spill_groups(partition, *spills[i]);
+                partition.clear();
+            }
+        });
+        state_memory->resize(0);
+        queue_spilled(spills);
+        return;
     }
 
-    for (size_t i = 0; i < batch_size; ++i) {
-        const auto& key = result_keys[emit_index + i];
-        const auto& aggs = result_aggs[emit_index + i];
-        size_t col = 0;
-        for (const auto& value : key) {
-            append_value(builders[col], value);
-            ++col;
+    // Phase 2: each partition is merged by one task, so no table is shared
+    results.assign(kAggregatePartitions, empty_groups());
+    std::vector<size_t> partition_bytes(kAggregatePartitions, 0);
+    run_parallel(kAggregatePartitions, [&](size_t p) {
+        size_t incoming = 0;
+        for (const auto& input_buffers : buffers) {
+            incoming += input_buffers[p].size();
         }
-        for (size_t a = 0; a < aggregates.size(); ++a) {
-            const std::string& func = aggregates[a].func_name;
-            const AggState& state = aggs[a];
-            if (func == "COUNT") {
-                append_value(builders[col], Datum::from_i64(state.count));
-            } else if (func == "SUM") {
-                if (agg_types[a] == TypeId::DOUBLE) {
-                    append_value(builders[col], Datum::from_f64(state.sum));
-                } else {
-                    append_value(builders[col], Datum::from_i64(static_cast<int64_t>(state.sum)));
+        GroupTable merged(group_exprs.size(), aggregates.size());
+        merged.reserve(std::min(incoming, expected_groups > 0 ? expected_groups / kAggregatePartitions + 1 : incoming));
+        for (auto& input_buffers : buffers) {
+            GroupRows& partial = input_buffers[p];
+            for (size_t group = 0; group < partial.size(); ++group) {
+                const size_t hash = partial.hashes[group];
+                size_t target = merged.find(partial.key(group), hash);
+                if (target == GroupTable::kNoGroup) target = merged.add(partial.key(group), hash);
+                AggState* states = merged.groups.aggs(target);
+                const AggState* incoming_states = partial.aggs(group);
+                for (size_t a = 0; a < aggregates.size(); ++a) {
+                    states[a].sum += incoming_states[a].sum;
+                    states[a].count += incoming_states[a].count;
+                }
+            }
+            partial = empty_groups();
+        }
+        partition_bytes[p] = merged.memory_bytes();
+        results[p] = std::move(merged.groups);
+    });
+
+    size_t total_groups = 0;
+    size_t total_bytes = 0;
+    for (size_t p = 0; p < kAggregatePartitions; ++p) {
+        total_groups += results[p].size();
+        total_bytes += partition_bytes[p];
+    }
+    count_allocation(total_bytes);
+    state_memory->resize(total_groups * group_bytes());
+}
+
+void HashAggregate::queue_spilled(std::vector<std::unique_ptr<PartitionedSpill>>& spills) {
+    std::vector<SpilledPartition> partitions(kSpillPartitions);
+    for (auto& partitioned : spills) {
+        std::vector<std::filesystem::path> paths = partitioned->finish();
+        spilled_stats.runs += partitioned->stats().runs;
+        spilled_stats.rows += partitioned->stats().rows;
+        spilled_stats.bytes += partitioned->stats().bytes;
+        for (size_t p = 0; p < kSpillPartitions; ++p) {
+            partitions[p].level = partitioned->level();
+            if (!paths[p].empty()) {
+                partitions[p].files.push_back(std::move(paths[p]));
+            }
+        }
+    }
+    // Processed from the back, so push in reverse to keep partition order
+    for (size_t p = kSpillPartitions; p-- > 0;) {
+        if (!partitions[p].files.empty()) {
+            spilled_partitions.push_back(std::move(partitions[p]));
+        }
+    }
+}
+
+void HashAggregate::load_spilled_partition() {
+    SpilledPartition partition = std::move(spilled_partitions.back());
+    spilled_partitions.pop_back();
+    results.clear();
+    emit_partition = 0;
+    emit_index = 0;
+
+    const size_t max_groups = std::max<size_t>(spill.memory_limit / group_bytes(), 1);
+    const size_t key_count = group_exprs.size();
+    GroupTable groups(key_count, aggregates.size());
+    std::unique_ptr<PartitionedSpill> overflow;
+    std::vector<Datum> row;
+    for (const auto& path : partition.files) {
+        RunReader reader(path, partial_columns());
+        while (reader.next(row)) {
+            const size_t hash = hash_group_key(row.data(), key_count);
+            if (overflow) {
+                overflow->append(hash, row);
+                continue;
+            }
+            size_t group = groups.find(row.data(), hash);
+            if (group == GroupTable::kNoGroup) {
+                if (groups.size() >= max_groups && partition.level + 1 < kMaxSpillLevel) {
+                    // Still too large: split this partition one level further
+                    overflow = std::make_unique<PartitionedSpill>(spill, partial_columns(), partition.level + 1);
+                    spill_groups(groups.groups, *overflow);
+                    groups.clear();
+                    overflow->append(hash, row);
+                    continue;
                 }
-            } else if (func == "AVG") {
-                double avg = state.count == 0 ? 0.0 : state.sum / static_cast<double>(state.count);
-                append_value(builders[col], Datum::from_f64(avg));
+                group = groups.add(row.data(), hash);
             }
-            ++col;
+            AggState* states = groups.groups.aggs(group);
+            for (size_t a = 0; a < aggregates.size(); ++a) {
+                states[a].sum += row[key_count + 2 * a].value.f64_val;
+                states[a].count += row[key_count + 2 * a + 1].value.i64_val;
+            }
+        }
+    }
+    if (overflow) {
+        std::vector<std::unique_ptr<PartitionedSpill>> spills;
+        spills.push_back(std::move(overflow));
+        queue_spilled(spills);
+        return;
+    }
+    state_memory->resize(groups.size() * group_bytes());
+    results.push_back(std::move(groups.groups));
+}
+
+bool HashAggregate::next(ExecBatch& out) {
+    if (!results_ready) {
+        if (inputs.size() == 1) {
+            aggregate_serial();
+        } else {
+            aggregate_parallel();
+        }
+        results_ready = true;
+        for (auto& input : inputs) {
+            input->close();
+        }
+        child_consumed = true;
+    }
+
+    // Batches never straddle partitions; spilled partitions are loaded one at
+    // a time once the in-memory ones are emitted
+    while (true) {
+        while (emit_partition < results.size() && emit_index >= results[emit_partition].size()) {
+            ++emit_partition;
+            emit_index = 0;
         }
+        if (emit_partition < results.size()) break;
+        if (spilled_partitions.empty()) return false;
+        load_spilled_partition();
     }
+    const GroupRows& partition = results[emit_partition];
 
+    size_t batch_size = std::min<size_t>(4096, partition.size() - emit_index);
     out.clear();
     out.columns.reserve(types_.size());
-    for (auto& builder : builders) {
-        out.columns.push_back(finalize_builder(builder));
+    for (size_t col = 0; col < group_exprs.size(); ++col) {
+        ColumnBuilder builder(types_[col], batch_size);
+        append_column(builder, batch_size,
+                      [&](size_t i) -> const Datum& { return partition.key(emit_index + i)[col]; });
+        out.columns.push_back(builder.finish());
+    }
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        const std::string& func = aggregates[a].func_name;
+        ColumnBuilder builder(types_[group_exprs.size() + a], batch_size);
+        builder.visit([&](auto& typed) {
+            using T = typename std::decay_t<decltype(typed)>::value_type;
+            T* values = typed.extend(batch_size);
+            if (func == "COUNT") {
+                for (size_t i = 0; i < batch_size; ++i) {
+                    values[i] = static_cast<T>(partition.aggs(emit_index + i)[a].count);
+                }
+            } else if (func == "SUM") {
+                for (size_t i = 0; i < batch_size; ++i) {
+                    values[i] = static_cast<T>(partition.aggs(emit_index + i)[a].sum);
+                }
+            } else {
+                for (size_t i = 0; i < batch_size; ++i) {
+                    const AggState& state = partition.aggs(emit_index + i)[a];
+                    values[i] = static_cast<T>(state.count == 0 ? 0.0 : state.sum / static_cast<double>(state.count));
+                }
+            }
+        });
+        out.columns.push_back(builder.finish());
     }
     out.length = batch_size;
     emit_index += batch_size;
@@ -1063,101 +2314,547 @@ bool HashAggregate::next(ExecBatch& out) {
 
 void HashAggregate::close() {
     if (!child_consumed) {
-        child->close();
+        for (auto& input : inputs) {
+            input->close();
+        }
         child_consumed = true;
     }
-    groups.clear();
-    result_keys.clear();
-    result_aggs.clear();
+    results.clear();
+    for (const auto& partition : spilled_partitions) {
+        remove_spill_files(partition.files);
+    }
+    spilled_partitions.clear();
+    state_memory.reset();
     results_ready = false;
+    emit_partition = 0;
     emit_index = 0;
 }
 
 OrderBy::OrderBy(std::unique_ptr<Operator> child_op,
                  std::vector<SortKey> sort_keys_in)
-    : child(std::move(child_op)),
-      sort_keys(std::move(sort_keys_in)) {
-    if (!child) {
+    : OrderBy(single_input(std::move(child_op)), std::move(sort_keys_in)) {}
+
+OrderBy::OrderBy(std::vector<std::unique_ptr<Operator>> inputs_in,
+                 std::vector<SortKey> sort_keys_in,
+                 std::optional<size_t> top_n_in,
+                 SpillConfig spill_in)
+    : inputs(std::move(inputs_in)),
+      sort_keys(std::move(sort_keys_in)),
+      top_n(top_n_in),
+      spill(std::move(spill_in)) {
+    if (inputs.empty() || std::any_of(inputs.begin(), inputs.end(), [](const auto& op) { return !op; })) {
         throw std::runtime_error("OrderBy child is null");
     }
-    names_ = child->output_names();
-    types_ = child->output_types();
-    dict_ = child->dictionary();
+    names_ = inputs[0]->output_names();
+    types_ = inputs[0]->output_types();
+    dict_ = inputs[0]->dictionary();
     bindings = make_bindings(names_, types_, dict_);
 }
 
 void OrderBy::open() {
     rows.clear();
+    sources.clear();
+    merge_heap.clear();
+    arenas.clear();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        arenas.emplace_back(types_.size() + sort_keys.size());
+    }
+    spilled_stats = {};
+    state_memory = std::make_unique<MemoryReservation>();
     materialized = false;
     emit_index = 0;
     child_consumed = false;
-    child->open();
+    for (auto& input : inputs) {
+        input->open();
+    }
 }
 
-bool OrderBy::next(ExecBatch& out) {
-    if (!materialized) {
-        ExecBatch batch;
-        while (child->next(batch)) {
-            for (size_t row = 0; row < batch.length; ++row) {
-                SortedRow sorted_row;
-                sorted_row.values = materialize_row(batch, row, types_);
-                sorted_row.sort_values.reserve(sort_keys.size());
-                for (const auto& key : sort_keys) {
-                    sorted_row.sort_values.push_back(evaluate_expr(key.expr.get(), batch, row, bindings));
+bool OrderBy::before(const Datum* a, const Datum* b) const {
+    for (size_t i = 0; i < sort_keys.size(); ++i) {
+        int cmp = compare_datum(a[i], b[i]);
+        if (cmp == 0) continue;
+        return sort_keys[i].asc ? cmp < 0 : cmp > 0;
+    }
+    return false;
+}
+
+OrderBy::Run OrderBy::sort_run(Operator& input, RowArena& arena, std::vector<MergeSource>& spilled, SpillStats& stats) const {
+    auto less = [this](const SortedRow& a, const SortedRow& b) { return before(a, b); };
+    // Each input gets an equal share of the budget; Top-N runs are bounded anyway
+    const size_t budget = (spill.memory_limit > 0 && !top_n) ? std::max<size_t>(spill.memory_limit / inputs.size(), 1) : 0;
+    const size_t row_bytes = sizeof(SortedRow) + (types_.size() + sort_keys.size()) * sizeof(Datum);
+    const size_t value_count = types_.size();
+    Run run;
+    MemoryReservation run_memory;
+    std::vector<Datum> candidate(sort_keys.size());
+    ExecBatch batch;
+    while (input.next(batch)) {
+        for (size_t row = 0; row < batch.length; ++row) {
+            if (top_n) {
+                for (size_t k = 0; k < sort_keys.size(); ++k) {
+                    candidate[k] = evaluate_expr(sort_keys[k].expr.get(), batch, row, bindings);
+                }
+                // Max-heap of the best top_n rows: the worst kept row is at the
+                // front, and a row it displaces gives up its arena slot
+                SortedRow slot;
+                if (run.size() == *top_n) {
+                    if (run.empty() || !before(candidate.data(), run.front().cells + value_count)) continue;
+                    std::pop_heap(run.begin(), run.end(), less);
+                    slot = run.back();
+                    run.pop_back();
+                } else {
+                    slot.cells = arena.allocate();
                 }
-                rows.push_back(std::move(sorted_row));
+                materialize_row(batch, row, types_, slot.cells);
+                std::copy(candidate.begin(), candidate.end(), slot.cells + value_count);
+                run.push_back(slot);
+                std::push_heap(run.begin(), run.end(), less);
+                continue;
+            }
+            SortedRow sorted{arena.allocate()};
+            materialize_row(batch, row, types_, sorted.cells);
+            for (size_t k = 0; k < sort_keys.size(); ++k) {
+                sorted.cells[value_count + k] = evaluate_expr(sort_keys[k].expr.get(), batch, row, bindings);
+            }
+            run.push_back(sorted);
+            if (budget > 0 && run.size() * row_bytes >= budget) {
+                spill_run(run, arena, spilled, stats);
             }
         }
-        materialized = true;
-        child->close();
-        child_consumed = true;
+        run_memory.resize(run.size() * row_bytes);
+    }
+    if (top_n) {
+        std::sort_heap(run.begin(), run.end(), less);
+    } else {
+        std::sort(run.begin(), run.end(), less);
+    }
+    return run;
+}
 
-        std::sort(rows.begin(), rows.end(), [&](const SortedRow& a, const SortedRow& b) {
-            for (size_t i = 0; i < sort_keys.size(); ++i) {
-                int cmp = compare_datum(a.sort_values[i], b.sort_values[i]);
-                if (cmp == 0) continue;
-                return sort_keys[i].asc ? cmp < 0 : cmp > 0;
-            }
-            return false;
-        });
+void OrderBy::spill_run(Run& run, RowArena& arena, std::vector<MergeSource>& spilled, SpillStats& stats) const {
+    std::sort(run.begin(), run.end(), [this](const SortedRow& a, const SortedRow& b) { return before(a, b); });
+    // Rows are stored flat, as in the arena: output values, then sort values
+    const size_t width = types_.size() + sort_keys.size();
+    RunWriter writer(spill, width);
+    std::vector<Datum> flat;
+    for (const auto& row : run) {
+        flat.assign(row.cells, row.cells + width);
+        writer.append(flat);
     }
+    std::filesystem::path path = writer.finish();
+    stats.runs += 1;
+    stats.rows += writer.rows_written();
+    stats.bytes += writer.bytes_written();
+    MergeSource source;
+    source.reader = std::make_unique<RunReader>(std::move(path), width);
+    spilled.push_back(std::move(source));
+    run.clear();
+    arena.clear();
+}
 
-    if (emit_index >= rows.size()) {
-        return false;
+bool OrderBy::advance(MergeSource& source) {
+    if (!source.reader) {
+        if (source.position >= source.run.size()) return false;
+        source.head = source.run[source.position++];
+        return true;
     }
+    if (!source.reader->next(source.read_row)) return false;
+    source.head.cells = source.read_row.data();
+    return true;
+}
 
-    size_t batch_size = std::min<size_t>(4096, rows.size() - emit_index);
-    std::vector<ColumnBuilder> builders;
-    builders.reserve(types_.size());
-    for (auto type : types_) {
-        builders.push_back(make_builder(type));
+std::vector<OrderBy::Run> OrderBy::merge_pairs(std::vector<Run>& runs) const {
+    auto less = [this](const SortedRow& a, const SortedRow& b) { return before(a, b); };
+    // Merge path: the first `diagonal` outputs of merging a and b take i rows
+    // from a and diagonal - i from b. Binary search for that i.
+    auto split = [&](const Run& a, const Run& b, size_t diagonal) {
+        size_t lo = diagonal > b.size() ? diagonal - b.size() : 0;
+        size_t hi = std::min(diagonal, a.size());
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (!before(b[diagonal - mid - 1], a[mid])) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    };
+
+    struct Range {
+        size_t pair;
+        size_t a_begin, a_end;
+        size_t b_begin, b_end;
+    };
+    std::vector<Run> merged((runs.size() + 1) / 2);
+    std::vector<Range> ranges;
+    for (size_t p = 0; p < merged.size(); ++p) {
+        if (2 * p + 1 == runs.size()) {
+            merged[p] = std::move(runs[2 * p]);
+            continue;
+        }
+        const Run& a = runs[2 * p];
+        const Run& b = runs[2 * p + 1];
+        size_t total = a.size() + b.size();
+        if (top_n) total = std::min(total, *top_n);
+        merged[p].resize(total);
+        size_t i = 0;
+        size_t j = 0;
+        for (size_t diagonal = 0; diagonal < total;) {
+            diagonal = std::min(total, diagonal + kDefaultMorselRows);
+            size_t next_i = split(a, b, diagonal);
+            ranges.push_back({p, i, next_i, j, diagonal - next_i});
+            i = next_i;
+            j = diagonal - next_i;
+        }
     }
+    run_parallel(ranges.size(), [&](size_t r) {
+        const Range& range = ranges[r];
+        Run& a = runs[2 * range.pair];
+        Run& b = runs[2 * range.pair + 1];
+        std::merge(std::make_move_iterator(a.begin() + range.a_begin), std::make_move_iterator(a.begin() + range.a_end),
+                   std::make_move_iterator(b.begin() + range.b_begin), std::make_move_iterator(b.begin() + range.b_end),
+                   merged[range.pair].begin() + range.a_begin + range.b_begin, less);
+    });
+    return merged;
+}
 
-    for (size_t i = 0; i < batch_size; ++i) {
-        const auto& row = rows[emit_index + i];
-        for (size_t col = 0; col < row.values.size(); ++col) {
-            append_value(builders[col], row.values[col]);
+bool OrderBy::next(ExecBatch& out) {
+    // Min-heap over merge sources by their head row
+    auto heap_order = [this](size_t a, size_t b) { return before(sources[b].head, sources[a].head); };
+    if (!materialized) {
+        std::vector<Run> runs(inputs.size());
+        std::vector<std::vector<MergeSource>> spilled(inputs.size());
+        std::vector<SpillStats> stats(inputs.size());
+        run_parallel(inputs.size(), [&](size_t i) {
+            runs[i] = sort_run(*inputs[i], arenas[i], spilled[i], stats[i]);
+        });
+        materialized = true;
+        for (auto& input : inputs) {
+            input->close();
+        }
+        child_consumed = true;
+        size_t total = 0;
+        for (const auto& run : runs) {
+            total += run.size();
+        }
+        const size_t footprint = total * (sizeof(SortedRow) + (types_.size() + sort_keys.size()) * sizeof(Datum));
+        count_allocation(footprint);
+        state_memory->resize(footprint);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            spilled_stats.runs += stats[i].runs;
+            spilled_stats.rows += stats[i].rows;
+            spilled_stats.bytes += stats[i].bytes;
+            for (auto& source : spilled[i]) {
+                sources.push_back(std::move(source));
+            }
+        }
+        if (sources.empty()) {
+            while (runs.size() > 1) {
+                runs = merge_pairs(runs);
+            }
+            rows = std::move(runs[0]);
+        } else {
+            // Something went to disk: stream a k-way merge of every run
+            for (auto& run : runs) {
+                if (run.empty()) continue;
+                MergeSource source;
+                source.run = std::move(run);
+                sources.push_back(std::move(source));
+            }
+            for (size_t i = 0; i < sources.size(); ++i) {
+                if (advance(sources[i])) {
+                    merge_heap.push_back(i);
+                }
+            }
+            std::make_heap(merge_heap.begin(), merge_heap.end(), heap_order);
         }
     }
 
+    constexpr size_t batch_target = 4096;
     out.clear();
     out.columns.reserve(types_.size());
-    for (auto& builder : builders) {
-        out.columns.push_back(finalize_builder(builder));
+    if (sources.empty()) {
+        size_t produced = std::min(batch_target, rows.size() - emit_index);
+        if (produced == 0) {
+            return false;
+        }
+        for (size_t col = 0; col < types_.size(); ++col) {
+            ColumnBuilder builder(types_[col], produced);
+            append_column(builder, produced,
+                          [&](size_t i) -> const Datum& { return rows[emit_index + i].cells[col]; });
+            out.columns.push_back(builder.finish());
+        }
+        emit_index += produced;
+        out.length = produced;
+        return true;
     }
-    out.length = batch_size;
-    emit_index += batch_size;
+
+    // Merge heads are replaced as they are consumed: stage their values by
+    // column and convert a column at a time
+    merge_output.resize(types_.size());
+    for (auto& column : merge_output) {
+        column.clear();
+    }
+    size_t produced = 0;
+    for (; produced < batch_target && !merge_heap.empty(); ++produced) {
+        std::pop_heap(merge_heap.begin(), merge_heap.end(), heap_order);
+        MergeSource& source = sources[merge_heap.back()];
+        for (size_t col = 0; col < types_.size(); ++col) {
+            merge_output[col].push_back(source.head.cells[col]);
+        }
+        if (advance(source)) {
+            std::push_heap(merge_heap.begin(), merge_heap.end(), heap_order);
+        } else {
+            merge_heap.pop_back();
+        }
+    }
+
+    if (produced == 0) {
+        return false;
+    }
+
+    for (size_t col = 0; col < types_.size(); ++col) {
+        ColumnBuilder builder(types_[col], produced);
+        builder.append(merge_output[col]);
+        out.columns.push_back(builder.finish());
+    }
+    out.length = produced;
     return true;
 }
 
 void OrderBy::close() {
     if (!child_consumed) {
-        child->close();
+        for (auto& input : inputs) {
+            input->close();
+        }
         child_consumed = true;
     }
     rows.clear();
+    sources.clear();
+    merge_heap.clear();
+    arenas.clear();
+    state_memory.reset();
     materialized = false;
     emit_index = 0;
 }
 
+Gather::Gather(std::vector<std::unique_ptr<Operator>> inputs_in, size_t queue_capacity)
+    : inputs(std::move(inputs_in)), capacity(queue_capacity) {
+    if (inputs.empty() || std::any_of(inputs.begin(), inputs.end(), [](const auto& op) { return !op; })) {
+        throw std::runtime_error("Gather input is null");
+    }
+    if (capacity == 0) {
+        capacity = 2 * inputs.size();
+    }
+    names_ = inputs[0]->output_names();
+    types_ = inputs[0]->output_types();
+    dict_ = inputs[0]->dictionary();
+}
+
+Gather::~Gather() {
+    stop();
+}
+
+void Gather::open() {
+    stop();
+    queue.clear();
+    error = nullptr;
+    cancelled = false;
+    active = inputs.size();
+    for (auto& input : inputs) {
+        Scheduler::global().submit(producers, [this, op = input.get()] { produce(*op); });
+    }
+}
+
+void Gather::produce(Operator& input) {
+    try {
+        bool skip = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            skip = cancelled;
+        }
+        if (!skip) {
+            input.open();
+            ExecBatch batch;
+            while (input.next(batch)) {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_full.wait(lock, [&] { return cancelled || queue.size() < capacity; });
+                if (cancelled) break;
+                queue.push_back(std::move(batch));
+                not_empty.notify_one();
+            }
+            input.close();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+        cancelled = true;
+        not_full.notify_all();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    --active;
+    not_empty.notify_all();
+}
+
+bool Gather::next(ExecBatch& out) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [&] { return !queue.empty() || active == 0 || error; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (queue.empty()) {
+        return false;
+    }
+    out = std::move(queue.front());
+    queue.pop_front();
+    not_full.notify_one();
+    return true;
+}
+
+void Gather::close() {
+    stop();
+    queue.clear();
+}
+
+void Gather::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+    }
+    not_full.notify_all();
+    // Producers that have not started yet see the flag and return at once
+    Scheduler::global().wait(producers);
+}
+
+std::string Gather::label() const {
+    return fmt::format("Gather(workers={})", inputs.size());
+}
+
+std::vector<const Operator*> Gather::children() const {
+    std::vector<const Operator*> result;
+    for (const auto& input : inputs) {
+        result.push_back(input.get());
+    }
+    return result;
+}
+
+std::string RawCsvScan::label() const {
+    std::string cols;
+    for (size_t i = 0; i < names_.size(); ++i) {
+        if (i > 0) cols += ", ";
+        cols += names_[i];
+        if (columns[i]) cols += " (cached)";
+    }
+    return fmt::format("RawCsvScan(file={}, columns=[{}])", external->file().path(), cols);
+}
+
+std::string ColumnarScan::label() const {
+    std::string cols;
+    for (size_t i = 0; i < names_.size(); ++i) {
+        if (i > 0) cols += ", ";
+        cols += names_[i];
+    }
+    return fmt::format("ColumnarScan(table={}, columns=[{}])", table->name, cols);
+}
+
+std::string Selection::label() const {
+    return fmt::format("Selection({})", predicate ? predicate->to_string() : "true");
+}
+
+std::vector<const Operator*> Selection::children() const {
+    return {child.get()};
+}
+
+std::string Project::label() const {
+    std::string exprs;
+    for (size_t i = 0; i < expressions.size(); ++i) {
+        if (i > 0) exprs += ", ";
+        exprs += expressions[i]->to_string();
+        if (i < aliases.size() && !aliases[i].empty()) {
+            exprs += " AS " + aliases[i];
+        }
+    }
+    return fmt::format("Project({})", exprs);
+}
+
+std::vector<const Operator*> Project::children() const {
+    return {child.get()};
+}
+
+std::string HashJoin::label() const {
+    std::string keys;
+    const auto& right_key_names = build_side->key_names;
+    for (size_t i = 0; i < left_key_names.size() && i < right_key_names.size(); ++i) {
+        if (i > 0) keys += ", ";
+        keys += left_key_names[i] + " = " + right_key_names[i];
+    }
+    std::string result = fmt::format("HashJoin({}", keys);
+    if (residual_filter) {
+        result += fmt::format(", filter={}", residual_filter->to_string());
+    }
+    return result + ")";
+}
+
+std::vector<const Operator*> HashJoin::children() const {
+    std::vector<const Operator*> result{left_child.get()};
+    // Clones sharing a build side list it once
+    if (build_side->owner == this) {
+        for (const auto& input : build_side->inputs) {
+            result.push_back(input.get());
+        }
+    }
+    return result;
+}
+
+std::string HashAggregate::label() const {
+    std::string keys;
+    for (size_t i = 0; i < group_exprs.size(); ++i) {
+        if (i > 0) keys += ", ";
+        keys += group_exprs[i]->to_string();
+    }
+    std::string aggs;
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        if (i > 0) aggs += ", ";
+        aggs += fmt::format("{}({})", aggregates[i].func_name, aggregates[i].arg ? aggregates[i].arg->to_string() : "*");
+    }
+    return fmt::format("HashAggregate(keys=[{}], aggs=[{}])", keys, aggs);
+}
+
+std::vector<const Operator*> HashAggregate::children() const {
+    std::vector<const Operator*> result;
+    for (const auto& input : inputs) {
+        result.push_back(input.get());
+    }
+    return result;
+}
+
+std::string OrderBy::label() const {
+    std::string keys;
+    for (size_t i = 0; i < sort_keys.size(); ++i) {
+        if (i > 0) keys += ", ";
+        keys += fmt::format("{} {}", sort_keys[i].expr->to_string(), sort_keys[i].asc ? "ASC" : "DESC");
+    }
+    if (top_n) {
+        return fmt::format("OrderBy({}, top={})", keys, *top_n);
+    }
+    return fmt::format("OrderBy({})", keys);
+}
+
+std::vector<const Operator*> OrderBy::children() const {
+    std::vector<const Operator*> result;
+    for (const auto& input : inputs) {
+        result.push_back(input.get());
+    }
+    return result;
+}
+
+std::string Limit::label() const {
+    return fmt::format("Limit({})", limit);
+}
+
+std::vector<const Operator*> Limit::children() const {
+    return {child.get()};
+}
+
 }
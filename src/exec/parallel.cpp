@@ -0,0 +1,46 @@
+#include "exec/parallel.h"
+#include "exec/scheduler.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace bosql {
+
+MorselQueue::MorselQueue(size_t total_rows, size_t morsel_rows)
+    : total(total_rows), morsel(std::max<size_t>(morsel_rows, 1)) {}
+
+bool MorselQueue::next(size_t& begin, size_t& end) {
+    size_t start = cursor.fetch_add(morsel, std::memory_order_relaxed);
+    if (start >= total) return false;
+    begin = start;
+    end = std::min(start + morsel, total);
+    return true;
+}
+
+void run_parallel(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0) return;
+    if (n == 1) {
+        fn(0);
+        return;
+    }
+    Scheduler& scheduler = Scheduler::global();
+    TaskGroup group;
+    for (size_t i = 1; i < n; ++i) {
+        scheduler.submit(group, [&fn, i] { fn(i); });
+    }
+    // The caller takes a share of the work, then helps with whatever is left
+    std::exception_ptr error;
+    try {
+        fn(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    try {
+        scheduler.wait(group);
+    } catch (...) {
+        if (!error) error = std::current_exception();
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace bosql
@@ -1,82 +1,203 @@
 #include "exec/physical_planner.h"
+#include "exec/instrumentation.h"
+#include "storage/csv_file.h"
 #include <algorithm>
 #include <cctype>
 #include <iostream>
+#include <numeric>
 #include <stdexcept>
 
 namespace bosql {
 
-std::unique_ptr<Operator> build_physical_plan(const LogicalOp* logical, const Catalog& catalog) {
+namespace {
+
+// Capacity hint from the planner estimate; capped so a bad estimate cannot
+// reserve an absurd amount of memory up front
+size_t size_hint(const LogicalOp* logical) {
+    constexpr double kMaxHint = 1 << 22;
+    if (logical->estimated_rows <= 0.0) return 0;
+    return static_cast<size_t>(std::min(logical->estimated_rows, kMaxHint));
+}
+
+using Pipelines = std::vector<std::unique_ptr<Operator>>;
+
+// Gives an operator its own memory tracker under the query's, and wraps it in
+// a probe when instrumenting. Clones of one pipeline each report their share
+// of the logical estimate.
+std::unique_ptr<Operator> finish(std::unique_ptr<Operator> op,
+                                 const LogicalOp* logical,
+                                 const PhysicalPlanOptions& options,
+                                 size_t clones = 1) {
+    if (options.memory) {
+        auto tracker = MemoryTracker::create(op->label(), 0, options.memory);
+        op = std::make_unique<TrackedOperator>(std::move(op), std::move(tracker));
+    }
+    if (!options.instrument) return op;
+    double estimate = logical->estimated_rows;
+    if (estimate >= 0.0) estimate /= static_cast<double>(clones);
+    return std::make_unique<InstrumentedOperator>(std::move(op), estimate);
+}
+
+// Merges parallel clones back into a single stream
+std::unique_ptr<Operator> gather(Pipelines pipelines,
+                                 const LogicalOp* logical,
+                                 const PhysicalPlanOptions& options) {
+    if (pipelines.size() == 1) return std::move(pipelines[0]);
+    return finish(std::make_unique<Gather>(std::move(pipelines)), logical, options);
+}
+
+Pipelines single(std::unique_ptr<Operator> op) {
+    Pipelines result;
+    result.push_back(std::move(op));
+    return result;
+}
+
+Pipelines build_pipelines(const LogicalOp* logical,
+                          const Catalog& catalog,
+                          const PhysicalPlanOptions& options,
+                          bool encoded = false);
+
+// Sorts every worker's pipeline into its own run and merges the runs
+std::unique_ptr<Operator> build_order(const LogicalOrder* order,
+                                      const Catalog& catalog,
+                                      const PhysicalPlanOptions& options,
+                                      std::optional<size_t> top_n) {
+    Pipelines inputs = build_pipelines(order->children[0].get(), catalog, options);
+    std::vector<OrderBy::SortKey> sort_keys;
+    sort_keys.reserve(order->order_by.size());
+    for (const auto& item : order->order_by) {
+        OrderBy::SortKey key;
+        key.expr = item.expr->clone();
+        key.asc = item.asc;
+        sort_keys.push_back(std::move(key));
+    }
+    SpillConfig spill{options.memory_limit, options.spill_directory};
+    return finish(std::make_unique<OrderBy>(std::move(inputs), std::move(sort_keys), top_n, std::move(spill)), order, options);
+}
+
+// Builds the operators for `logical` once per worker. Streaming operators
+// (scan, filter, project, join probe) are cloned so every worker runs its own
+// copy of the pipeline; pipeline breakers merge their inputs and return a
+// single operator. With `encoded` the pipelines may emit encoded slices;
+// only filters and aggregates ask for them.
+Pipelines build_pipelines(const LogicalOp* logical,
+                          const Catalog& catalog,
+                          const PhysicalPlanOptions& options,
+                          bool encoded) {
+    const size_t threads = std::max<size_t>(options.threads, 1);
     switch (logical->type) {
         case LogicalOpType::SCAN: {
             const auto* scan = dynamic_cast<const LogicalScan*>(logical);
             if (!scan) throw std::runtime_error("Invalid LogicalScan");
             OptionalRef<const Table> table = catalog.get_table_data(scan->table_name);
             if (!table.has_value()) throw std::runtime_error("Table not found: " + scan->table_name);
+            const Table& tbl = table.value();
             std::vector<size_t> indices;
             if (!scan->columns.empty()) {
-                const Table& tbl = table.value();
                 indices.reserve(scan->columns.size());
                 for (const auto& name : scan->columns) {
-                    bool matched = false;
                     for (size_t i = 0; i < tbl.columns.size(); ++i) {
                         if (tbl.columns[i].name == name) {
                             indices.push_back(i);
-                            matched = true;
                             break;
                         }
                     }
-                    if (!matched) {
-                        continue;
-                    }
                 }
             }
-            return std::make_unique<ColumnarScan>(const_cast<Table*>(&table.value()), std::move(indices));
+            auto* data = const_cast<Table*>(&tbl);
+            if (tbl.external) {
+                // Counted once per query, not per clone, so columns are cached
+                // after the same number of queries at any thread count
+                if (indices.empty()) {
+                    indices.resize(tbl.columns.size());
+                    std::iota(indices.begin(), indices.end(), 0);
+                }
+                tbl.external->note_scan(indices);
+                if (threads == 1) {
+                    return single(finish(std::make_unique<RawCsvScan>(data, std::move(indices)), logical, options));
+                }
+                auto morsels = std::make_shared<MorselQueue>(tbl.external->file().rows());
+                Pipelines clones;
+                for (size_t t = 0; t < threads; ++t) {
+                    clones.push_back(finish(std::make_unique<RawCsvScan>(data, indices, 4096, morsels), logical, options, threads));
+                }
+                return clones;
+            }
+            if (threads == 1) {
+                return single(finish(std::make_unique<ColumnarScan>(data, std::move(indices), 4096, nullptr, encoded),
+                                     logical, options));
+            }
+            size_t rows = tbl.columns.empty() ? 0 : tbl.columns[0].data->size();
+            auto morsels = std::make_shared<MorselQueue>(rows);
+            Pipelines clones;
+            for (size_t t = 0; t < threads; ++t) {
+                clones.push_back(finish(std::make_unique<ColumnarScan>(data, indices, 4096, morsels, encoded), logical, options, threads));
+            }
+            return clones;
         }
         case LogicalOpType::FILTER: {
             const auto* filter = dynamic_cast<const LogicalFilter*>(logical);
             if (!filter) throw std::runtime_error("Invalid LogicalFilter");
-            auto child = build_physical_plan(filter->children[0].get(), catalog);
-            return std::make_unique<Selection>(std::move(child), filter->predicate->clone());
+            Pipelines children = build_pipelines(filter->children[0].get(), catalog, options, true);
+            Pipelines result;
+            for (auto& child : children) {
+                result.push_back(finish(std::make_unique<Selection>(std::move(child), filter->predicate->clone(), encoded),
+                                        logical, options, children.size()));
+            }
+            return result;
         }
         case LogicalOpType::PROJECT: {
             const auto* project = dynamic_cast<const LogicalProject*>(logical);
             if (!project) throw std::runtime_error("Invalid LogicalProject");
             const LogicalOp* child_logical = project->children[0].get();
-            auto child = build_physical_plan(child_logical, catalog);
+            Pipelines children = build_pipelines(child_logical, catalog, options);
             if (project->select_list.empty()) {
-                return child;
+                return children;
             }
             if (child_logical->type == LogicalOpType::AGGREGATE) {
-                return child;
+                return children;
             }
-            std::vector<std::unique_ptr<Expr>> exprs;
-            exprs.reserve(project->select_list.size());
-            for (const auto& expr : project->select_list) {
-                exprs.push_back(expr->clone());
+            Pipelines result;
+            for (auto& child : children) {
+                std::vector<std::unique_ptr<Expr>> exprs;
+                exprs.reserve(project->select_list.size());
+                for (const auto& expr : project->select_list) {
+                    exprs.push_back(expr->clone());
+                }
+                auto aliases = project->aliases;
+                result.push_back(finish(std::make_unique<Project>(std::move(child), std::move(exprs), std::move(aliases)),
+                                        logical, options, children.size()));
             }
-            auto aliases = project->aliases;
-            return std::make_unique<Project>(std::move(child), std::move(exprs), std::move(aliases));
+            return result;
         }
         case LogicalOpType::HASH_JOIN: {
             const auto* join = dynamic_cast<const LogicalHashJoin*>(logical);
             if (!join) throw std::runtime_error("Invalid LogicalHashJoin");
-            auto left = build_physical_plan(join->children[0].get(), catalog);
-            auto right = build_physical_plan(join->children[1].get(), catalog);
-            std::unique_ptr<Expr> residual;
-            if (join->join_filter) {
-                residual = join->join_filter->clone();
+            Pipelines probes = build_pipelines(join->children[0].get(), catalog, options);
+            Pipelines builds = build_pipelines(join->children[1].get(), catalog, options);
+            // Every probe clone shares one hash table, built by all workers
+            auto build_side = std::make_shared<JoinBuildSide>(std::move(builds),
+                                                              join->right_keys,
+                                                              size_hint(join->children[1].get()),
+                                                              SpillConfig{options.memory_limit, options.spill_directory});
+            Pipelines result;
+            for (auto& probe : probes) {
+                std::unique_ptr<Expr> residual;
+                if (join->join_filter) {
+                    residual = join->join_filter->clone();
+                }
+                result.push_back(finish(std::make_unique<HashJoin>(std::move(probe),
+                                                                   build_side,
+                                                                   join->left_keys,
+                                                                   std::move(residual)),
+                                        logical, options, probes.size()));
             }
-            return std::make_unique<HashJoin>(std::move(left),
-                                             std::move(right),
-                                             join->left_keys,
-                                             join->right_keys,
-                                             std::move(residual));
+            return result;
         }
         case LogicalOpType::AGGREGATE: {
             const auto* aggregate = dynamic_cast<const LogicalAggregate*>(logical);
             if (!aggregate) throw std::runtime_error("Invalid LogicalAggregate");
-            auto child = build_physical_plan(aggregate->children[0].get(), catalog);
+            Pipelines inputs = build_pipelines(aggregate->children[0].get(), catalog, options, true);
             std::vector<std::unique_ptr<Expr>> group_exprs;
             group_exprs.reserve(aggregate->group_keys.size());
             for (const auto& key : aggregate->group_keys) {
@@ -96,31 +217,40 @@ std::unique_ptr<Operator> build_physical_plan(const LogicalOp* logical, const Ca
                 }
                 specs.push_back(std::move(spec));
             }
-            return std::make_unique<HashAggregate>(std::move(child), std::move(group_exprs), std::move(specs));
+            SpillConfig spill{options.memory_limit, options.spill_directory};
+            return single(finish(std::make_unique<HashAggregate>(std::move(inputs), std::move(group_exprs), std::move(specs),
+                                                                 size_hint(aggregate), std::move(spill)),
+                                 logical, options));
         }
         case LogicalOpType::ORDER: {
             const auto* order = dynamic_cast<const LogicalOrder*>(logical);
             if (!order) throw std::runtime_error("Invalid LogicalOrder");
-            auto child = build_physical_plan(order->children[0].get(), catalog);
-            std::vector<OrderBy::SortKey> sort_keys;
-            sort_keys.reserve(order->order_by.size());
-            for (const auto& item : order->order_by) {
-                OrderBy::SortKey key;
-                key.expr = item.expr->clone();
-                key.asc = item.asc;
-                sort_keys.push_back(std::move(key));
-            }
-            return std::make_unique<OrderBy>(std::move(child), std::move(sort_keys));
+            return single(build_order(order, catalog, options, std::nullopt));
         }
         case LogicalOpType::LIMIT: {
             const auto* limit = dynamic_cast<const LogicalLimit*>(logical);
             if (!limit) throw std::runtime_error("Invalid LogicalLimit");
-            auto child = build_physical_plan(limit->children[0].get(), catalog);
-            return std::make_unique<Limit>(std::move(child), limit->limit);
+            const LogicalOp* child_logical = limit->children[0].get();
+            std::unique_ptr<Operator> child;
+            if (const auto* order = dynamic_cast<const LogicalOrder*>(child_logical); order && limit->limit >= 0) {
+                // ORDER BY ... LIMIT n only needs the n best rows of every worker
+                child = build_order(order, catalog, options, static_cast<size_t>(limit->limit));
+            } else {
+                child = gather(build_pipelines(child_logical, catalog, options), child_logical, options);
+            }
+            return single(finish(std::make_unique<Limit>(std::move(child), limit->limit), logical, options));
         }
         default:
             throw std::runtime_error("Unsupported logical operator");
     }
 }
 
+} // namespace
+
+std::unique_ptr<Operator> build_physical_plan(const LogicalOp* logical,
+                                              const Catalog& catalog,
+                                              const PhysicalPlanOptions& options) {
+    return gather(build_pipelines(logical, catalog, options), logical, options);
+}
+
 }
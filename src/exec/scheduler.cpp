@@ -0,0 +1,201 @@
+#include "exec/scheduler.h"
+
+#include <algorithm>
+
+namespace bosql {
+
+namespace {
+
+// Worker identity of the current thread, if it belongs to a scheduler
+thread_local const Scheduler* tls_scheduler = nullptr;
+thread_local size_t tls_index = 0;
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+Scheduler::Scheduler(size_t worker_count) {
+    if (worker_count == 0) {
+        worker_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    threads.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        threads.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+Scheduler& Scheduler::global() {
+    static Scheduler instance;
+    return instance;
+}
+
+int Scheduler::worker_index() const {
+    return tls_scheduler == this ? static_cast<int>(tls_index) : -1;
+}
+
+void Scheduler::submit(TaskGroup& group, std::function<void()> fn) {
+    group.pending.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        group.queued.fetch_add(1, std::memory_order_relaxed);
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    MemoryTracker* memory = current_memory_tracker();
+    Task task{&group, std::move(fn), memory ? memory->shared_from_this() : nullptr};
+    int self = worker_index();
+    if (self >= 0) {
+        std::lock_guard<std::mutex> lock(workers[self]->mutex);
+        workers[self]->tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(injection_mutex);
+        injection.push_back(std::move(task));
+    }
+    work_available.notify_one();
+    group_changed.notify_all();
+}
+
+bool Scheduler::find_task(Task& task, TaskGroup* only) {
+    auto take_back = [&](std::deque<Task>& tasks) {
+        for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+            if (!only || it->group == only) {
+                task = std::move(*it);
+                tasks.erase(std::next(it).base());
+                return true;
+            }
+        }
+        return false;
+    };
+    auto take_front = [&](std::deque<Task>& tasks) {
+        for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+            if (!only || it->group == only) {
+                task = std::move(*it);
+                tasks.erase(it);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    int self = worker_index();
+    bool found = false;
+    if (self >= 0) {
+        std::lock_guard<std::mutex> lock(workers[self]->mutex);
+        found = take_back(workers[self]->tasks);
+    }
+    if (!found) {
+        std::lock_guard<std::mutex> lock(injection_mutex);
+        found = take_front(injection);
+    }
+    if (!found) {
+        const size_t count = workers.size();
+        const size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+        for (size_t k = 0; k < count && !found; ++k) {
+            size_t victim = (start + k) % count;
+            if (static_cast<int>(victim) == self) continue;
+            std::lock_guard<std::mutex> lock(workers[victim]->mutex);
+            found = take_front(workers[victim]->tasks);
+        }
+        if (found && self >= 0) {
+            workers[self]->stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (found) {
+        task.group->queued.fetch_sub(1, std::memory_order_relaxed);
+        queued.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return found;
+}
+
+void Scheduler::run(Task& task) {
+    auto start = Clock::now();
+    try {
+        MemoryScope scope(task.memory.get());
+        task.fn();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.group->error_mutex);
+        if (!task.group->error) task.group->error = std::current_exception();
+    }
+    // Release captures before the group can be observed as done
+    task.fn = nullptr;
+    task.memory.reset();
+    int self = worker_index();
+    if (self >= 0) {
+        workers[self]->executed.fetch_add(1, std::memory_order_relaxed);
+        workers[self]->busy_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(),
+                                         std::memory_order_relaxed);
+    }
+    // The group may be destroyed as soon as pending reaches zero
+    if (task.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    group_changed.notify_all();
+}
+
+void Scheduler::worker_loop(size_t index) {
+    tls_scheduler = this;
+    tls_index = index;
+    while (true) {
+        Task task;
+        if (find_task(task, nullptr)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        work_available.wait(lock, [&] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+        if (stopping && queued.load(std::memory_order_relaxed) == 0) return;
+    }
+}
+
+void Scheduler::wait(TaskGroup& group) {
+    while (!group.done()) {
+        Task task;
+        if (find_task(task, &group)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        group_changed.wait(lock, [&] {
+            return group.done() || group.queued.load(std::memory_order_relaxed) > 0;
+        });
+    }
+    std::lock_guard<std::mutex> lock(group.error_mutex);
+    if (group.error) std::rethrow_exception(group.error);
+}
+
+std::vector<Scheduler::WorkerStats> Scheduler::stats() const {
+    std::vector<WorkerStats> result;
+    result.reserve(workers.size());
+    for (const auto& worker : workers) {
+        WorkerStats stats;
+        stats.tasks = worker->executed.load(std::memory_order_relaxed);
+        stats.steals = worker->stolen.load(std::memory_order_relaxed);
+        stats.busy = std::chrono::nanoseconds(worker->busy_ns.load(std::memory_order_relaxed));
+        result.push_back(stats);
+    }
+    return result;
+}
+
+void Scheduler::reset_stats() {
+    for (auto& worker : workers) {
+        worker->executed.store(0, std::memory_order_relaxed);
+        worker->stolen.store(0, std::memory_order_relaxed);
+        worker->busy_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace bosql
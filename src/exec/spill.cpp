@@ -0,0 +1,205 @@
+#include "exec/spill.h"
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <fmt/core.h>
+
+namespace bosql {
+
+namespace {
+
+// Distinguishes the spill files of concurrent processes sharing a directory
+uint64_t process_token() {
+    static const uint64_t token = std::random_device{}();
+    return token;
+}
+
+std::filesystem::path new_spill_path(const SpillConfig& config) {
+    static std::atomic<uint64_t> counter{0};
+    std::filesystem::path directory = config.directory.empty() ? std::filesystem::temp_directory_path() : config.directory;
+    return directory / fmt::format("bosql-spill-{:x}-{}.run", process_token(), counter.fetch_add(1));
+}
+
+}
+
+RunWriter::RunWriter(const SpillConfig& config, size_t columns_in)
+    : path(new_spill_path(config)), columns(columns_in), block(columns_in) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create spill file: " + path.string());
+    }
+    for (auto& column : block) {
+        column.reserve(kSpillBlockRows);
+    }
+}
+
+RunWriter::~RunWriter() {
+    if (finished) return;
+    out.close();
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+}
+
+void RunWriter::append(const std::vector<Datum>& row) {
+    for (size_t col = 0; col < columns; ++col) {
+        block[col].push_back(row[col]);
+    }
+    if (block[0].size() == kSpillBlockRows) {
+        flush_block();
+    }
+}
+
+void RunWriter::flush_block() {
+    uint32_t count = static_cast<uint32_t>(columns == 0 ? 0 : block[0].size());
+    if (count == 0) return;
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    bytes += sizeof(count);
+    for (auto& column : block) {
+        TypeId type = column[0].type;
+        auto tag = static_cast<uint8_t>(type);
+        out.write(reinterpret_cast<const char*>(&tag), sizeof(tag));
+        // Every type stores its value in the first type_width bytes of the union
+        size_t width = type_width(type);
+        bytes += sizeof(tag) + count * width;
+        std::vector<char> values(count * width);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (column[i].type != type) throw std::runtime_error("Spilled column changes type");
+            std::memcpy(values.data() + i * width, &column[i].value, width);
+        }
+        out.write(values.data(), static_cast<std::streamsize>(values.size()));
+        column.clear();
+    }
+    rows += count;
+    if (!out) {
+        throw std::runtime_error("Failed writing spill file: " + path.string());
+    }
+}
+
+std::filesystem::path RunWriter::finish() {
+    flush_block();
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed writing spill file: " + path.string());
+    }
+    finished = true;
+    return path;
+}
+
+RunReader::RunReader(std::filesystem::path path_in, size_t columns_in, bool owns_file_in)
+    : path(std::move(path_in)), columns(columns_in), owns_file(owns_file_in) {
+    in.open(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open spill file: " + path.string());
+    }
+    prefetch();
+}
+
+RunReader::~RunReader() {
+    try {
+        Scheduler::global().wait(read_ahead);
+    } catch (...) {
+        // The error already surfaced through next(), or nobody is reading any more
+    }
+    in.close();
+    if (owns_file) {
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+}
+
+std::optional<RunReader::Block> RunReader::read_block() {
+    uint32_t count = 0;
+    if (!in.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        return std::nullopt;
+    }
+    Block block(columns);
+    for (auto& column : block) {
+        uint8_t tag = 0;
+        in.read(reinterpret_cast<char*>(&tag), sizeof(tag));
+        auto type = static_cast<TypeId>(tag);
+        if (tag > static_cast<uint8_t>(TypeId::DATE32)) {
+            throw std::runtime_error("Corrupt spill file: " + path.string());
+        }
+        size_t width = type_width(type);
+        std::vector<char> values(count * width);
+        in.read(values.data(), static_cast<std::streamsize>(values.size()));
+        column.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            column[i].type = type;
+            column[i].value.i64_val = 0;
+            std::memcpy(&column[i].value, values.data() + i * width, width);
+        }
+    }
+    if (!in) {
+        throw std::runtime_error("Truncated spill file: " + path.string());
+    }
+    return block;
+}
+
+void RunReader::prefetch() {
+    Scheduler::global().submit(read_ahead, [this] { pending = read_block(); });
+}
+
+bool RunReader::next(std::vector<Datum>& row) {
+    if (position >= current_rows) {
+        if (exhausted) return false;
+        Scheduler::global().wait(read_ahead);
+        if (!pending) {
+            exhausted = true;
+            return false;
+        }
+        current = std::move(*pending);
+        pending.reset();
+        current_rows = current.empty() ? 0 : current[0].size();
+        position = 0;
+        prefetch();
+    }
+    row.resize(columns);
+    for (size_t col = 0; col < columns; ++col) {
+        row[col] = current[col][position];
+    }
+    ++position;
+    return true;
+}
+
+size_t spill_partition(size_t hash, unsigned level) {
+    // Scramble first: std::hash is the identity for integers
+    uint64_t mixed = static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>((mixed << (kSpillPartitionBits * level)) >> (64 - kSpillPartitionBits));
+}
+
+PartitionedSpill::PartitionedSpill(SpillConfig config_in, size_t columns_in, unsigned level_in)
+    : config(std::move(config_in)), columns(columns_in), spill_level(level_in), writers(kSpillPartitions) {}
+
+void PartitionedSpill::append(size_t hash, const std::vector<Datum>& row) {
+    auto& writer = writers[spill_partition(hash, spill_level)];
+    if (!writer) {
+        writer = std::make_unique<RunWriter>(config, columns);
+    }
+    writer->append(row);
+}
+
+std::vector<std::filesystem::path> PartitionedSpill::finish() {
+    std::vector<std::filesystem::path> paths(kSpillPartitions);
+    for (size_t p = 0; p < kSpillPartitions; ++p) {
+        if (!writers[p]) continue;
+        paths[p] = writers[p]->finish();
+        totals.runs += 1;
+        totals.rows += writers[p]->rows_written();
+        totals.bytes += writers[p]->bytes_written();
+        writers[p].reset();
+    }
+    return paths;
+}
+
+void remove_spill_files(const std::vector<std::filesystem::path>& paths) {
+    for (const auto& path : paths) {
+        if (path.empty()) continue;
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+}
+
+} // namespace bosql
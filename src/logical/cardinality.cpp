@@ -0,0 +1,318 @@
+#include "logical/cardinality.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace bosql {
+
+namespace {
+
+constexpr double kDefaultEqSelectivity = 0.1;
+constexpr double kDefaultRangeSelectivity = 1.0 / 3.0;
+constexpr double kDefaultSelectivity = 0.5;
+
+// Tables visible to a predicate: every scan below the node being estimated
+struct StatsScope {
+    std::vector<std::pair<const TableMeta*, const Dictionary*>> tables;
+};
+
+struct ColumnRef {
+    const ColumnMeta* meta = nullptr;
+    const Dictionary* dict = nullptr;
+};
+
+ColumnRef find_column(const StatsScope& scope, const std::string& name) {
+    for (const auto& [meta, dict] : scope.tables) {
+        for (const auto& col : meta->columns) {
+            if (col.name == name) return {&col, dict};
+        }
+    }
+    // Qualified references (t.col) against unqualified CSV headers
+    auto dot = name.rfind('.');
+    if (dot != std::string::npos) {
+        std::string bare = name.substr(dot + 1);
+        for (const auto& [meta, dict] : scope.tables) {
+            for (const auto& col : meta->columns) {
+                if (col.name == bare) return {&col, dict};
+            }
+        }
+    }
+    return {};
+}
+
+std::optional<double> literal_value(const Expr* expr, const Dictionary* dict) {
+    switch (expr->type) {
+        case ExprType::LITERAL_INT:
+            return static_cast<double>(expr->i64_val);
+        case ExprType::LITERAL_DOUBLE:
+            return expr->f64_val;
+        case ExprType::LITERAL_STRING:
+            if (dict) {
+                if (auto code = dict->find(expr->str_val)) return static_cast<double>(*code);
+            }
+            return std::nullopt;
+        default:
+            return std::nullopt;
+    }
+}
+
+std::pair<double, double> column_range(const ColumnMeta& col) {
+    switch (col.type) {
+        case TypeId::INT64:
+            return {static_cast<double>(col.stats.min_i64), static_cast<double>(col.stats.max_i64)};
+        case TypeId::DOUBLE:
+            return {col.stats.min_f64, col.stats.max_f64};
+        case TypeId::DATE32:
+            return {static_cast<double>(col.stats.min_date), static_cast<double>(col.stats.max_date)};
+        case TypeId::STRING:
+            break;
+    }
+    return {0.0, 0.0};
+}
+
+double mcv_total(const ColumnStats& stats) {
+    double total = 0.0;
+    for (const auto& mcv : stats.mcvs) total += mcv.frequency;
+    return std::min(total, 1.0);
+}
+
+double eq_selectivity(const ColumnMeta& col, double value) {
+    const ColumnStats& stats = col.stats;
+    // Rows past a sample may hold values outside its range
+    if (col.type != TypeId::STRING && !stats.approximate) {
+        auto [lo, hi] = column_range(col);
+        if (value < lo || value > hi) return 0.0;
+    }
+    if (stats.analyzed) {
+        for (const auto& mcv : stats.mcvs) {
+            if (mcv.value == value) return mcv.frequency;
+        }
+        size_t rest_ndv = stats.ndv > stats.mcvs.size() ? stats.ndv - stats.mcvs.size() : 1;
+        return (1.0 - mcv_total(stats)) / static_cast<double>(rest_ndv);
+    }
+    return stats.ndv > 0 ? 1.0 / static_cast<double>(stats.ndv) : kDefaultEqSelectivity;
+}
+
+// Fraction of a [lo, hi] range below value, assuming a uniform spread
+double interpolate(double lo, double hi, double value) {
+    if (value <= lo) return 0.0;
+    if (value >= hi) return 1.0;
+    return (value - lo) / (hi - lo);
+}
+
+// Fraction of rows with col < value (col <= value when inclusive)
+double below_selectivity(const ColumnMeta& col, double value, bool inclusive) {
+    const ColumnStats& stats = col.stats;
+    auto [lo, hi] = column_range(col);
+    if (!stats.analyzed) {
+        double below = interpolate(lo, hi, value);
+        if (stats.approximate && stats.ndv > 0) {
+            // Values outside the sampled range are taken to be as common as
+            // any one distinct value, rather than absent
+            const double one = 1.0 / static_cast<double>(stats.ndv);
+            below = std::clamp(below, std::min(one, 0.5), std::max(1.0 - one, 0.5));
+        }
+        return below;
+    }
+    double result = 0.0;
+    for (const auto& mcv : stats.mcvs) {
+        if (mcv.value < value || (inclusive && mcv.value == value)) result += mcv.frequency;
+    }
+    double rest = 1.0 - mcv_total(stats);
+    const auto& bounds = stats.histogram.bounds;
+    if (stats.histogram.empty()) {
+        result += rest * interpolate(lo, hi, value);
+    } else if (value >= bounds.back()) {
+        result += rest;
+    } else if (value > bounds.front()) {
+        auto upper = std::upper_bound(bounds.begin(), bounds.end(), value);
+        size_t bucket = static_cast<size_t>(upper - bounds.begin()) - 1;
+        double within = interpolate(bounds[bucket], bounds[bucket + 1], value);
+        result += rest * (static_cast<double>(bucket) + within) / static_cast<double>(stats.histogram.bucket_count());
+    }
+    return result;
+}
+
+BinaryOp flip(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::LT: return BinaryOp::GT;
+        case BinaryOp::LE: return BinaryOp::GE;
+        case BinaryOp::GT: return BinaryOp::LT;
+        case BinaryOp::GE: return BinaryOp::LE;
+        default: return op;
+    }
+}
+
+double comparison_selectivity(const Expr* column, const Expr* literal, BinaryOp op, const StatsScope& scope) {
+    if (column->type != ExprType::COLUMN_REF) {
+        std::swap(column, literal);
+        op = flip(op);
+    }
+    bool is_eq = op == BinaryOp::EQ || op == BinaryOp::NE;
+    double fallback = is_eq ? kDefaultEqSelectivity : kDefaultRangeSelectivity;
+    if (op == BinaryOp::NE) fallback = 1.0 - fallback;
+    if (column->type != ExprType::COLUMN_REF) return fallback;
+
+    ColumnRef ref = find_column(scope, column->str_val);
+    if (!ref.meta) return fallback;
+    std::optional<double> value = literal_value(literal, ref.dict);
+    if (!value) {
+        // A string literal missing from the dictionary can never match
+        if (literal->type == ExprType::LITERAL_STRING && ref.dict && is_eq) {
+            return op == BinaryOp::EQ ? 0.0 : 1.0;
+        }
+        return fallback;
+    }
+    if (ref.meta->type == TypeId::STRING && !is_eq) return fallback;
+
+    switch (op) {
+        case BinaryOp::EQ: return eq_selectivity(*ref.meta, *value);
+        case BinaryOp::NE: return 1.0 - eq_selectivity(*ref.meta, *value);
+        case BinaryOp::LT: return below_selectivity(*ref.meta, *value, false);
+        case BinaryOp::LE: return below_selectivity(*ref.meta, *value, true);
+        case BinaryOp::GT: return 1.0 - below_selectivity(*ref.meta, *value, true);
+        case BinaryOp::GE: return 1.0 - below_selectivity(*ref.meta, *value, false);
+        default: return fallback;
+    }
+}
+
+double comparison_selectivity(const Expr* expr, const StatsScope& scope) {
+    return comparison_selectivity(expr->left.get(), expr->right.get(), expr->op, scope);
+}
+
+// Distinct list values match disjoint rows, so their equalities add up
+double in_list_selectivity(const Expr* expr, const StatsScope& scope) {
+    double matched = 0.0;
+    for (const auto& value : expr->args) {
+        matched += comparison_selectivity(expr->left.get(), value.get(), BinaryOp::EQ, scope);
+    }
+    matched = std::min(matched, 1.0);
+    return expr->op == BinaryOp::NE ? 1.0 - matched : matched;
+}
+
+double selectivity(const Expr* expr, const StatsScope& scope) {
+    if (!expr) return 1.0;
+    if (expr->type == ExprType::IN_LIST) return std::clamp(in_list_selectivity(expr, scope), 0.0, 1.0);
+    if (expr->type != ExprType::BINARY_OP) return kDefaultSelectivity;
+    switch (expr->op) {
+        case BinaryOp::AND:
+            return selectivity(expr->left.get(), scope) * selectivity(expr->right.get(), scope);
+        case BinaryOp::OR: {
+            double l = selectivity(expr->left.get(), scope);
+            double r = selectivity(expr->right.get(), scope);
+            return l + r - l * r;
+        }
+        case BinaryOp::EQ:
+        case BinaryOp::NE:
+        case BinaryOp::LT:
+        case BinaryOp::LE:
+        case BinaryOp::GT:
+        case BinaryOp::GE:
+            return std::clamp(comparison_selectivity(expr, scope), 0.0, 1.0);
+        default:
+            return kDefaultSelectivity;
+    }
+}
+
+void collect_scope(const LogicalOp* op, const Catalog& catalog, StatsScope& scope) {
+    if (op->type == LogicalOpType::SCAN) {
+        const auto* scan = static_cast<const LogicalScan*>(op);
+        auto meta = catalog.get_table_meta(scan->table_name);
+        if (!meta.has_value()) return;
+        auto table = catalog.get_table_data(scan->table_name);
+        const Dictionary* dict = table.has_value() ? table->dict.get() : nullptr;
+        scope.tables.emplace_back(&meta.value(), dict);
+        return;
+    }
+    for (const auto& child : op->children) {
+        collect_scope(child.get(), catalog, scope);
+    }
+}
+
+size_t column_ndv(const std::string& name, const StatsScope& scope) {
+    ColumnRef ref = find_column(scope, name);
+    return ref.meta ? ref.meta->stats.ndv : 0;
+}
+
+double annotate(LogicalOp* op, const Catalog& catalog) {
+    std::vector<double> child_rows;
+    child_rows.reserve(op->children.size());
+    for (auto& child : op->children) {
+        child_rows.push_back(annotate(child.get(), catalog));
+    }
+    double input = child_rows.empty() ? 0.0 : child_rows[0];
+    double rows = input;
+
+    switch (op->type) {
+        case LogicalOpType::SCAN: {
+            const auto* scan = static_cast<const LogicalScan*>(op);
+            auto meta = catalog.get_table_meta(scan->table_name);
+            rows = meta.has_value() ? static_cast<double>(meta->row_count) : 0.0;
+            break;
+        }
+        case LogicalOpType::FILTER: {
+            const auto* filter = static_cast<const LogicalFilter*>(op);
+            StatsScope scope;
+            collect_scope(op, catalog, scope);
+            rows = input * selectivity(filter->predicate.get(), scope);
+            break;
+        }
+        case LogicalOpType::HASH_JOIN: {
+            const auto* join = static_cast<const LogicalHashJoin*>(op);
+            double left = child_rows.size() > 0 ? child_rows[0] : 0.0;
+            double right = child_rows.size() > 1 ? child_rows[1] : 0.0;
+            StatsScope scope;
+            collect_scope(op, catalog, scope);
+            double denominator = 1.0;
+            for (size_t i = 0; i < join->left_keys.size() && i < join->right_keys.size(); ++i) {
+                size_t ndv = std::max(column_ndv(join->left_keys[i], scope),
+                                      column_ndv(join->right_keys[i], scope));
+                denominator *= static_cast<double>(std::max<size_t>(ndv, 1));
+            }
+            rows = join->left_keys.empty() ? left * right : left * right / denominator;
+            break;
+        }
+        case LogicalOpType::AGGREGATE: {
+            const auto* agg = static_cast<const LogicalAggregate*>(op);
+            if (agg->group_keys.empty()) {
+                rows = 1.0;
+                break;
+            }
+            StatsScope scope;
+            collect_scope(op, catalog, scope);
+            double groups = 1.0;
+            for (const auto& key : agg->group_keys) {
+                size_t ndv = key->type == ExprType::COLUMN_REF ? column_ndv(key->str_val, scope) : 0;
+                groups *= ndv > 0 ? static_cast<double>(ndv) : std::max(input / 10.0, 1.0);
+            }
+            rows = std::min(groups, input);
+            break;
+        }
+        case LogicalOpType::LIMIT: {
+            const auto* limit = static_cast<const LogicalLimit*>(op);
+            rows = std::min(input, static_cast<double>(limit->limit));
+            break;
+        }
+        case LogicalOpType::PROJECT:
+        case LogicalOpType::ORDER:
+            break;
+    }
+    op->estimated_rows = rows;
+    return rows;
+}
+
+} // namespace
+
+double estimate_selectivity(const Expr* predicate, const TableMeta& meta, const Dictionary* dict) {
+    StatsScope scope;
+    scope.tables.emplace_back(&meta, dict);
+    return selectivity(predicate, scope);
+}
+
+void annotate_cardinality(LogicalOp* plan, const Catalog& catalog) {
+    if (plan) annotate(plan, catalog);
+}
+
+} // namespace bosql
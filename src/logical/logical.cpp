@@ -4,6 +4,11 @@
 
 namespace bosql {
 
+std::string LogicalOp::estimate_suffix() const {
+    if (estimated_rows < 0.0) return "";
+    return fmt::format(" (est. rows: {:.0f})", estimated_rows);
+}
+
 std::string LogicalScan::to_string(int indent) const {
     std::string prefix(indent, ' ');
     std::string cols_str;
@@ -11,7 +16,7 @@ std::string LogicalScan::to_string(int indent) const {
         if (i > 0) cols_str += ", ";
         cols_str += columns[i];
     }
-    std::string result = fmt::format("{}LogicalScan(table={}, cols={})", prefix, table_name, cols_str);
+    std::string result = fmt::format("{}LogicalScan(table={}, cols={}){}", prefix, table_name, cols_str, estimate_suffix());
     if (!children.empty()) {
         // Scan shouldn't have children, but just in case
         for (const auto& child : children) {
@@ -23,7 +28,7 @@ std::string LogicalScan::to_string(int indent) const {
 
 std::string LogicalFilter::to_string(int indent) const {
     std::string prefix(indent, ' ');
-    std::string result = fmt::format("{}LogicalFilter({})", prefix, predicate->to_string());
+    std::string result = fmt::format("{}LogicalFilter({}){}", prefix, predicate->to_string(), estimate_suffix());
     for (const auto& child : children) {
         result += "\n" + child->to_string(indent + 2);
     }
@@ -40,7 +45,7 @@ std::string LogicalProject::to_string(int indent) const {
             selects_str += fmt::format(" AS {}", aliases[i]);
         }
     }
-    std::string result = fmt::format("{}LogicalProject({})", prefix, selects_str);
+    std::string result = fmt::format("{}LogicalProject({}){}", prefix, selects_str, estimate_suffix());
     for (const auto& child : children) {
         result += "\n" + child->to_string(indent + 2);
     }
@@ -63,7 +68,7 @@ std::string LogicalHashJoin::to_string(int indent) const {
     if (join_filter) {
         result += fmt::format(", filter={}", join_filter->to_string());
     }
-    result += ")";
+    result += ")" + estimate_suffix();
     for (const auto& child : children) {
         result += "\n" + child->to_string(indent + 2);
     }
@@ -85,7 +90,7 @@ std::string LogicalAggregate::to_string(int indent) const {
             aggs_str += fmt::format(" AS {}", aggregates[i].alias);
         }
     }
-    std::string result = fmt::format("{}LogicalAggregate(keys={}, aggs={})", prefix, keys_str, aggs_str);
+    std::string result = fmt::format("{}LogicalAggregate(keys={}, aggs={}){}", prefix, keys_str, aggs_str, estimate_suffix());
     for (const auto& child : children) {
         result += "\n" + child->to_string(indent + 2);
     }
@@ -99,7 +104,7 @@ std::string LogicalOrder::to_string(int indent) const {
         if (i > 0) order_str += ", ";
         order_str += fmt::format("{} {}", order_by[i].expr->to_string(), order_by[i].asc ? "ASC" : "DESC");
     }
-    std::string result = fmt::format("{}LogicalOrder(by: {})", prefix, order_str);
+    std::string result = fmt::format("{}LogicalOrder(by: {}){}", prefix, order_str, estimate_suffix());
     for (const auto& child : children) {
         result += "\n" + child->to_string(indent + 2);
     }
@@ -108,7 +113,7 @@ std::string LogicalOrder::to_string(int indent) const {
 
 std::string LogicalLimit::to_string(int indent) const {
     std::string prefix(indent, ' ');
-    std::string result = fmt::format("{}LogicalLimit({})", prefix, limit);
+    std::string result = fmt::format("{}LogicalLimit({}){}", prefix, limit, estimate_suffix());
     for (const auto& child : children) {
         result += "\n" + child->to_string(indent + 2);
     }
@@ -20,6 +20,12 @@ void collect_columns(const Expr* expr, std::set<std::string>& columns) {
                 collect_columns(arg.get(), columns);
             }
             break;
+        case ExprType::IN_LIST:
+            collect_columns(expr->left.get(), columns);
+            for (const auto& arg : expr->args) {
+                collect_columns(arg.get(), columns);
+            }
+            break;
         default:
             break;
     }
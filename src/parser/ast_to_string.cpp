@@ -30,6 +30,8 @@ std::string Expr::to_string() const {
                 case BinaryOp::DIV: op_str = "/"; break;
                 case BinaryOp::AND: op_str = "AND"; break;
                 case BinaryOp::OR: op_str = "OR"; break;
+                case BinaryOp::LIKE: op_str = "LIKE"; break;
+                case BinaryOp::NOT_LIKE: op_str = "NOT LIKE"; break;
             }
             return fmt::format("({} {} {})", left->to_string(), op_str, right->to_string());
         }
@@ -41,6 +43,14 @@ std::string Expr::to_string() const {
             }
             return fmt::format("{}({})", func_name, args_str);
         }
+        case ExprType::IN_LIST: {
+            std::string args_str;
+            for (size_t i = 0; i < args.size(); ++i) {
+                if (i > 0) args_str += ", ";
+                args_str += args[i]->to_string();
+            }
+            return fmt::format("({} {} ({}))", left->to_string(), op == BinaryOp::NE ? "NOT IN" : "IN", args_str);
+        }
         default:
             return "UNKNOWN_EXPR";
     }
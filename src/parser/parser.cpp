@@ -99,6 +99,9 @@ TokenType Parser::get_keyword(const std::string& s) {
     if (s == "AS") return TokenType::AS;
     if (s == "AND") return TokenType::AND;
     if (s == "OR") return TokenType::OR;
+    if (s == "NOT") return TokenType::NOT;
+    if (s == "LIKE") return TokenType::LIKE;
+    if (s == "IN") return TokenType::IN;
     return TokenType::IDENTIFIER;
 }
 
@@ -229,6 +232,37 @@ std::unique_ptr<Expr> Parser::parse_cmp_expr() {
         expr->right = std::move(right);
         return expr;
     }
+    bool negated = false;
+    if (current().type == TokenType::NOT) {
+        advance();
+        negated = true;
+        if (current().type != TokenType::LIKE && current().type != TokenType::IN) {
+            throw std::runtime_error("Expected LIKE or IN after NOT");
+        }
+    }
+    if (current().type == TokenType::LIKE) {
+        advance();
+        auto expr = std::make_unique<Expr>();
+        expr->type = ExprType::BINARY_OP;
+        expr->op = negated ? BinaryOp::NOT_LIKE : BinaryOp::LIKE;
+        expr->left = std::move(left);
+        expr->right = parse_primary();
+        if (expr->right->type != ExprType::LITERAL_STRING) {
+            throw std::runtime_error("LIKE pattern must be a string literal");
+        }
+        return expr;
+    }
+    if (current().type == TokenType::IN) {
+        advance();
+        expect(TokenType::LPAREN);
+        auto expr = std::make_unique<Expr>();
+        expr->type = ExprType::IN_LIST;
+        expr->op = negated ? BinaryOp::NE : BinaryOp::EQ;
+        expr->left = std::move(left);
+        expr->args = parse_expr_list();
+        expect(TokenType::RPAREN);
+        return expr;
+    }
     return left;
 }
 
@@ -321,6 +355,13 @@ std::unique_ptr<Expr> Parser::parse_primary() {
         expr->type = ExprType::LITERAL_INT;
         expr->i64_val = std::stoll(token.value);
         return expr;
+    } else if (token.type == TokenType::MINUS && current().type == TokenType::NUMBER) {
+        // Negative literal, e.g. in an IN list
+        auto expr = std::make_unique<Expr>();
+        expr->type = ExprType::LITERAL_INT;
+        expr->i64_val = std::stoll("-" + current().value);
+        advance();
+        return expr;
     } else if (token.type == TokenType::STRING_LITERAL) {
         auto expr = std::make_unique<Expr>();
         expr->type = ExprType::LITERAL_STRING;
@@ -0,0 +1,296 @@
+#include "storage/csv_file.h"
+#include "exec/parallel.h"
+#include "storage/compression.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace bosql {
+
+namespace {
+
+// End of the line starting at `at`
+size_t line_end(const char* data, size_t size, size_t at) {
+    const void* newline = std::memchr(data + at, '\n', size - at);
+    return newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : size;
+}
+
+const char* type_label(TypeId type) {
+    switch (type) {
+        case TypeId::INT64: return "INT64";
+        case TypeId::DOUBLE: return "DOUBLE";
+        case TypeId::STRING: return "STRING";
+        case TypeId::DATE32: return "DATE32";
+    }
+    return "UNKNOWN";
+}
+
+// Fast path with from_chars; anything else goes through the same std::sto*
+// calls as load_csv, so both accept the same text
+template <typename T>
+bool parse_number(std::string_view field, T& value) {
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (error == std::errc() && end == field.data() + field.size()) return true;
+    try {
+        if constexpr (std::is_same_v<T, i64>) {
+            f64 parsed = std::stod(std::string(field));
+            if (parsed != std::floor(parsed) || parsed < std::numeric_limits<i64>::min() ||
+                parsed > std::numeric_limits<i64>::max()) {
+                return false;
+            }
+            value = static_cast<i64>(parsed);
+        } else if constexpr (std::is_same_v<T, f64>) {
+            value = std::stod(std::string(field));
+        } else {
+            value = std::stoi(std::string(field));
+        }
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+// Parses a field as load_csv would, including its test for dates
+template <typename T>
+bool parse_value(std::string_view field, T& value) {
+    if (!parse_number(field, value)) return false;
+    if constexpr (std::is_same_v<T, Date32>) {
+        return field.size() == 8 && value >= 19000000 && value <= 21000000;
+    }
+    return true;
+}
+
+std::runtime_error value_mismatch(const CsvFile& file, size_t index, TypeId type, size_t row, std::string_view field,
+                                  const char* mode) {
+    return std::runtime_error("Column '" + file.headers()[index] + "' row " + std::to_string(row + 1) + ": '" +
+                              std::string(field) + "' is not " + type_label(type) +
+                              " as in the sampled rows; load the table without " + mode);
+}
+
+} // namespace
+
+CsvFile::CsvFile(const std::string& filename) : path_(filename), file_(map_file(filename)) {
+    const char* data = file_->data;
+    const size_t size = file_->size;
+    if (size == 0) return;
+    size_t at = line_end(data, size, 0);
+    std::stringstream header(std::string(data, at));
+    std::string name;
+    while (std::getline(header, name, ',')) {
+        headers_.push_back(name);
+    }
+    for (++at; at < size;) {
+        size_t end = line_end(data, size, at);
+        if (end != at) {
+            if (rows_ % kChunkRows == 0) chunk_offsets_.push_back(at);
+            ++rows_;
+        }
+        at = end + 1;
+    }
+}
+
+std::string_view CsvFile::head(size_t rows) const {
+    const char* data = file_->data;
+    const size_t size = file_->size;
+    if (size == 0) return {};
+    size_t at = std::min(line_end(data, size, 0) + 1, size);
+    for (size_t taken = 0; at < size && taken < rows;) {
+        size_t end = line_end(data, size, at);
+        taken += end != at;
+        at = std::min(end + 1, size);
+    }
+    return std::string_view(data, at);
+}
+
+std::string_view csv_field(std::string_view line, size_t index) {
+    size_t begin = 0;
+    for (size_t i = 0; i < index; ++i) {
+        size_t comma = line.find(',', begin);
+        if (comma == std::string_view::npos) {
+            throw std::runtime_error("Row size mismatch");
+        }
+        begin = comma + 1;
+    }
+    size_t end = line.find(',', begin);
+    return line.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin);
+}
+
+LazyCsvColumn::LazyCsvColumn(std::shared_ptr<const CsvFile> file, size_t index, TypeId type, std::shared_ptr<Dictionary> dictionary)
+    : file_(std::move(file)), index_(index), type_(type), dictionary_(std::move(dictionary)) {}
+
+const char* LazyCsvColumn::encoding() const {
+    const Column* column = loaded_.load(std::memory_order_acquire);
+    return column ? column->encoding() : "lazy";
+}
+
+size_t LazyCsvColumn::memory_bytes() const {
+    const Column* column = loaded_.load(std::memory_order_acquire);
+    return column ? column->memory_bytes() : 0;
+}
+
+const Column& LazyCsvColumn::resolve() const {
+    std::call_once(once_, [this] {
+        column_ = parse();
+        loaded_.store(column_.get(), std::memory_order_release);
+    });
+    return *column_;
+}
+
+std::unique_ptr<Column> LazyCsvColumn::parse() const {
+    const size_t rows = file_->rows();
+    auto parse_chunks = [&](auto&& store) {
+        run_parallel(file_->chunks(), [&](size_t chunk) {
+            file_->for_each_line(chunk, [&](size_t row, std::string_view line) { store(row, csv_field(line, index_)); });
+        });
+    };
+    auto numbers = [&]<typename T>(std::vector<T> values) -> std::unique_ptr<Column> {
+        parse_chunks([&](size_t row, std::string_view field) {
+            if (!parse_value(field, values[row])) throw value_mismatch(*file_, index_, type_, row, field, "LAZY");
+        });
+        return std::make_unique<ColumnVector<T>>(std::move(values));
+    };
+    std::unique_ptr<Column> column;
+    switch (type_) {
+        case TypeId::INT64: column = numbers(std::vector<i64>(rows)); break;
+        case TypeId::DOUBLE: column = numbers(std::vector<f64>(rows)); break;
+        case TypeId::DATE32: column = numbers(std::vector<Date32>(rows)); break;
+        case TypeId::STRING: {
+            // Each chunk is interned into a dictionary of its own in
+            // parallel. The chunk dictionaries are then merged in chunk
+            // order, so codes are assigned in row order, as load_csv assigns
+            // them, with one shared lookup per distinct string of a chunk.
+            std::vector<StrId> codes(rows);
+            std::vector<Dictionary> locals(file_->chunks());
+            run_parallel(file_->chunks(), [&](size_t chunk) {
+                file_->for_each_line(chunk, [&](size_t row, std::string_view line) {
+                    codes[row] = locals[chunk].get_or_add(csv_field(line, index_));
+                });
+            });
+            std::vector<StrId> shared;
+            for (size_t chunk = 0; chunk < locals.size(); ++chunk) {
+                shared.resize(locals[chunk].size());
+                for (size_t code = 0; code < shared.size(); ++code) {
+                    shared[code] = dictionary_->get_or_add(locals[chunk].get(static_cast<StrId>(code)));
+                }
+                const size_t first = chunk * CsvFile::kChunkRows;
+                const size_t last = std::min(rows, first + CsvFile::kChunkRows);
+                for (size_t row = first; row < last; ++row) {
+                    codes[row] = shared[codes[row]];
+                }
+            }
+            column = std::make_unique<ColumnVector<StrId>>(std::move(codes));
+            break;
+        }
+    }
+    return compress_column(std::move(column));
+}
+
+ExternalCsv::ExternalCsv(std::shared_ptr<const CsvFile> file)
+    : file_(std::move(file)),
+      field_starts_(file_->headers().size()),
+      fields_sized_(new std::once_flag[file_->headers().size()]),
+      rows_mapped_(new std::atomic<bool>[file_->chunks()]()),
+      fields_mapped_(new std::atomic<bool>[file_->headers().size() * file_->chunks()]()),
+      chunk_locks_(new std::mutex[file_->chunks()]),
+      scans_(new std::atomic<uint32_t>[file_->headers().size()]()) {}
+
+void ExternalCsv::note_scan(const std::vector<size_t>& columns) {
+    for (size_t column : columns) {
+        scans_[column].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ExternalCsv::map(size_t offset, size_t count, const std::vector<size_t>& columns) {
+    if (count == 0) return;
+    const size_t last = (offset + count - 1) / CsvFile::kChunkRows;
+    for (size_t chunk = offset / CsvFile::kChunkRows; chunk <= last; ++chunk) {
+        std::vector<size_t> missing;
+        for (size_t column : columns) {
+            if (!mapped(chunk, column)) missing.push_back(column);
+        }
+        if (!missing.empty()) map_chunk(chunk, std::move(missing));
+    }
+}
+
+void ExternalCsv::map_chunk(size_t chunk, std::vector<size_t> columns) {
+    std::lock_guard<std::mutex> lock(chunk_locks_[chunk]);
+    // Another scan may have mapped some of them while this one waited
+    std::erase_if(columns, [&](size_t column) { return mapped(chunk, column); });
+    if (columns.empty()) return;
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+
+    const std::string_view text = file_->text();
+    std::call_once(rows_sized_, [&] { row_starts_.resize(file_->rows()); });
+    if (!rows_mapped_[chunk].load(std::memory_order_acquire)) {
+        file_->for_each_line(chunk, [&](size_t row, std::string_view line) {
+            row_starts_[row] = static_cast<uint64_t>(line.data() - text.data());
+        });
+        rows_mapped_[chunk].store(true, std::memory_order_release);
+    }
+
+    const size_t first = chunk * CsvFile::kChunkRows;
+    const size_t last = std::min(file_->rows(), first + CsvFile::kChunkRows);
+    const char* end = text.data() + text.size();
+    // Ascending, so each column can start from the one mapped before it
+    for (size_t column : columns) {
+        std::call_once(fields_sized_[column], [&] { field_starts_[column].resize(file_->rows()); });
+        size_t left = column;
+        while (left > 0 && !mapped(chunk, left - 1)) --left;
+        const uint32_t* from = left > 0 ? field_starts_[left - 1].data() : nullptr;
+        const size_t commas = left > 0 ? column - (left - 1) : column;
+        uint32_t* starts = field_starts_[column].data();
+        for (size_t row = first; row < last; ++row) {
+            const char* line = text.data() + row_starts_[row];
+            const char* at = line + (from ? from[row] : 0);
+            for (size_t i = 0; i < commas; ++i) {
+                while (at < end && *at != ',' && *at != '\n') ++at;
+                if (at == end || *at != ',') throw std::runtime_error("Row size mismatch");
+                ++at;
+            }
+            starts[row] = static_cast<uint32_t>(at - line);
+        }
+        fields_mapped_[column * file_->chunks() + chunk].store(true, std::memory_order_release);
+    }
+}
+
+size_t ExternalCsv::read(size_t column, TypeId type, size_t offset, size_t count, void* out) const {
+    const std::string_view text = file_->text();
+    const char* end = text.data() + text.size();
+    const uint64_t* rows = row_starts_.data();
+    const uint32_t* starts = field_starts_[column].data();
+    size_t bytes = 0;
+    auto parse = [&]<typename T>(T* values) {
+        for (size_t i = 0; i < count; ++i) {
+            const size_t row = offset + i;
+            const char* begin = text.data() + rows[row] + starts[row];
+            const char* stop = begin;
+            while (stop < end && *stop != ',' && *stop != '\n') ++stop;
+            std::string_view field(begin, static_cast<size_t>(stop - begin));
+            if (!parse_value(field, values[i])) throw value_mismatch(*file_, column, type, row, field, "AS EXTERNAL");
+            bytes += field.size() + 1;
+        }
+    };
+    switch (type) {
+        case TypeId::INT64: parse(static_cast<i64*>(out)); break;
+        case TypeId::DOUBLE: parse(static_cast<f64*>(out)); break;
+        case TypeId::DATE32: parse(static_cast<Date32*>(out)); break;
+        case TypeId::STRING: throw std::runtime_error("String columns of external tables are read from their cached column");
+    }
+    return bytes;
+}
+
+size_t ExternalCsv::memory_bytes() const {
+    size_t bytes = row_starts_.size() * sizeof(uint64_t);
+    for (const auto& starts : field_starts_) {
+        bytes += starts.size() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+} // namespace bosql
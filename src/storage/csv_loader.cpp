@@ -1,12 +1,15 @@
 #include "storage/csv_loader.h"
+#include "catalog/statistics.h"
+#include "storage/compression.h"
+#include "storage/csv_file.h"
 
 #include <cmath>
 
 namespace bosql {
 
-std::pair<Table, TableMeta> load_csv(std::istream& stream) {
+std::pair<Table, TableMeta> load_csv(std::istream& stream, std::shared_ptr<Dictionary> dictionary) {
     Table table;
-    table.dict = std::make_shared<Dictionary>();
+    table.dict = dictionary ? std::move(dictionary) : std::make_shared<Dictionary>();
     std::vector<ColumnMeta> column_metas;
 
     std::string line;
@@ -70,12 +73,11 @@ std::pair<Table, TableMeta> load_csv(std::istream& stream) {
             for (const auto& row : rows) {
                 data.push_back(std::stoi(row[col]));
             }
-            std::set<Date32> uniques(data.begin(), data.end());
             column.data.reset(new ColumnVector<Date32>(std::move(data)));
             meta.type = TypeId::DATE32;
             meta.stats.min_date = min_date;
             meta.stats.max_date = max_date;
-            meta.stats.ndv = uniques.size();
+            meta.stats.ndv = estimate_ndv(*column.data);
             table.columns.push_back(std::move(column));
             column_metas.push_back(std::move(meta));
             continue;
@@ -106,12 +108,11 @@ std::pair<Table, TableMeta> load_csv(std::istream& stream) {
             for (const auto& row : rows) {
                 data.push_back(static_cast<i64>(std::stod(row[col])));
             }
-            std::set<i64> uniques(data.begin(), data.end());
             column.data.reset(new ColumnVector<i64>(std::move(data)));
             meta.type = TypeId::INT64;
             meta.stats.min_i64 = min_i64;
             meta.stats.max_i64 = max_i64;
-            meta.stats.ndv = uniques.size();
+            meta.stats.ndv = estimate_ndv(*column.data);
             table.columns.push_back(std::move(column));
             column_metas.push_back(std::move(meta));
             continue;
@@ -137,12 +138,11 @@ std::pair<Table, TableMeta> load_csv(std::istream& stream) {
             for (const auto& row : rows) {
                 data.push_back(std::stod(row[col]));
             }
-            std::set<f64> uniques(data.begin(), data.end());
             column.data.reset(new ColumnVector<f64>(std::move(data)));
             meta.type = TypeId::DOUBLE;
             meta.stats.min_f64 = min_f64;
             meta.stats.max_f64 = max_f64;
-            meta.stats.ndv = uniques.size();
+            meta.stats.ndv = estimate_ndv(*column.data);
             table.columns.push_back(std::move(column));
             column_metas.push_back(std::move(meta));
             continue;
@@ -154,23 +154,67 @@ std::pair<Table, TableMeta> load_csv(std::istream& stream) {
         for (const auto& row : rows) {
             data.push_back(table.dict->get_or_add(row[col]));
         }
-        std::set<StrId> uniques(data.begin(), data.end());
         column.data.reset(new ColumnVector<StrId>(std::move(data)));
-        meta.stats.ndv = uniques.size(); // NDV for strings
+        meta.stats.ndv = estimate_ndv(*column.data); // NDV for strings
         table.columns.push_back(std::move(column));
         column_metas.push_back(std::move(meta));
     }
 
+    for (auto& column : table.columns) {
+        column.data = compress_column(std::move(column.data));
+    }
+
     TableMeta table_meta("", std::move(column_metas), num_rows);
     return std::make_pair(std::move(table), std::move(table_meta));
 }
 
-std::pair<Table, TableMeta> load_csv(const std::string& filename) {
+std::pair<Table, TableMeta> load_csv(const std::string& filename, std::shared_ptr<Dictionary> dictionary) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open file: " + filename);
     }
-    return load_csv(file);
+    return load_csv(file, std::move(dictionary));
+}
+
+namespace {
+
+std::pair<Table, TableMeta> index_csv(std::shared_ptr<const CsvFile> file, std::shared_ptr<Dictionary> dictionary) {
+    std::istringstream sample_text{std::string(file->head(kLazySampleRows))};
+    // The sample gets its own dictionary, so strings the full column never
+    // loads do not end up in the shared one
+    auto [sample, meta] = load_csv(sample_text);
+    const size_t sampled = meta.row_count;
+    meta.row_count = file->rows();
+
+    Table table;
+    table.dict = dictionary ? std::move(dictionary) : std::make_shared<Dictionary>();
+    for (size_t i = 0; i < meta.columns.size(); ++i) {
+        ColumnMeta& column = meta.columns[i];
+        column.stats.approximate = sampled < file->rows();
+        // A sample of distinct values is taken to be a key; otherwise the
+        // sample has most likely seen every value
+        if (sampled > 0 && column.stats.ndv * 10 >= sampled * 9) {
+            column.stats.ndv = file->rows();
+        }
+        TableColumn lazy;
+        lazy.name = column.name;
+        lazy.data = std::make_unique<LazyCsvColumn>(file, i, column.type, table.dict);
+        table.columns.push_back(std::move(lazy));
+    }
+    return std::make_pair(std::move(table), std::move(meta));
+}
+
+} // namespace
+
+std::pair<Table, TableMeta> load_csv_lazy(const std::string& filename, std::shared_ptr<Dictionary> dictionary) {
+    return index_csv(std::make_shared<const CsvFile>(filename), std::move(dictionary));
+}
+
+std::pair<Table, TableMeta> load_csv_external(const std::string& filename, std::shared_ptr<Dictionary> dictionary) {
+    auto file = std::make_shared<const CsvFile>(filename);
+    auto result = index_csv(file, std::move(dictionary));
+    result.first.external = std::make_shared<ExternalCsv>(std::move(file));
+    return result;
 }
 
-} // namespace bosql
\ No newline at end of file
+} // namespace bosql
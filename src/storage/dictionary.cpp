@@ -1,14 +1,83 @@
 #include "storage/dictionary.h"
 
+#include <functional>
+#include <utility>
+
 namespace bosql {
 
-StrId Dictionary::get_or_add(const std::string& s) {
-    auto it = std::find(strings.begin(), strings.end(), s);
-    if (it != strings.end()) return static_cast<StrId>(it - strings.begin());
-    strings.push_back(s);
-    return static_cast<StrId>(strings.size() - 1);
+namespace {
+
+size_t hash_string(std::string_view s) { return std::hash<std::string_view>{}(s); }
+
+} // namespace
+
+Dictionary::Dictionary(const Dictionary* base) : base_(base), base_size_(base ? base->size() : 0) {}
+
+Dictionary::Dictionary(std::shared_ptr<const void> owner, const uint64_t* offsets, const char* chars, size_t count)
+    : external_owner_(std::move(owner)), external_offsets_(offsets), external_chars_(chars), external_count_(count) {
+    index_entries();
+}
+
+void Dictionary::insert_slot(StrId own) {
+    const size_t mask = slots_.size() - 1;
+    size_t slot = hash_string(entry(own)) & mask;
+    while (slots_[slot] != kInvalidStrId) slot = (slot + 1) & mask;
+    slots_[slot] = own;
+}
+
+// Brings the index up to date with entries appended directly, growing it
+// to keep it at most half full
+void Dictionary::index_entries() {
+    const size_t count = own_count();
+    if (indexed_ == count && count * 2 < slots_.size()) return;
+    if ((count + 1) * 2 > slots_.size()) {
+        size_t capacity = 16;
+        while (capacity < (count + 1) * 2) capacity *= 2;
+        slots_.assign(capacity, kInvalidStrId);
+        indexed_ = 0;
+    }
+    for (; indexed_ < count; ++indexed_) {
+        insert_slot(static_cast<StrId>(indexed_));
+    }
+}
+
+StrId Dictionary::get_or_add(std::string_view s) {
+    if (auto code = find(s)) return *code;
+    strings.emplace_back(s);
+    index_entries();
+    return static_cast<StrId>(size() - 1);
+}
+
+std::string_view Dictionary::get(StrId id) const {
+    return id < base_size_ ? base_->get(id) : entry(id - base_size_);
+}
+
+std::optional<StrId> Dictionary::find(std::string_view s) const {
+    if (base_) {
+        if (auto code = base_->find(s); code && *code < base_size_) return code;
+    }
+    if (!slots_.empty()) {
+        const size_t mask = slots_.size() - 1;
+        for (size_t slot = hash_string(s) & mask; slots_[slot] != kInvalidStrId; slot = (slot + 1) & mask) {
+            if (entry(slots_[slot]) == s) return static_cast<StrId>(base_size_ + slots_[slot]);
+        }
+    }
+    // Entries appended since the index was last brought up to date
+    for (size_t i = indexed_; i < own_count(); ++i) {
+        if (entry(i) == s) return static_cast<StrId>(base_size_ + i);
+    }
+    return std::nullopt;
 }
 
-const std::string& Dictionary::get(StrId id) const { return strings[id]; }
+size_t Dictionary::memory_bytes() const {
+    // Strings up to the capacity of an empty one live inside the
+    // std::string itself
+    static const size_t inline_capacity = std::string().capacity();
+    size_t bytes = strings.capacity() * sizeof(std::string) + slots_.capacity() * sizeof(StrId);
+    for (const auto& s : strings) {
+        if (s.capacity() > inline_capacity) bytes += s.capacity() + 1;
+    }
+    return bytes;
+}
 
-} // namespace bosql
\ No newline at end of file
+} // namespace bosql
@@ -0,0 +1,39 @@
+#include "storage/mapped_file.h"
+
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bosql {
+
+MappedFile::~MappedFile() {
+    if (data) munmap(const_cast<char*>(data), size);
+}
+
+std::shared_ptr<MappedFile> map_file(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat file: " + path.string());
+    }
+    auto mapped = std::make_shared<MappedFile>();
+    mapped->size = static_cast<size_t>(info.st_size);
+    if (mapped->size > 0) {
+        void* base = mmap(nullptr, mapped->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map file: " + path.string());
+        }
+        mapped->data = static_cast<const char*>(base);
+    }
+    ::close(fd);
+    return mapped;
+}
+
+} // namespace bosql
@@ -0,0 +1,258 @@
+#include <cstring>
+#include <sstream>
+#include <catch2/catch_all.hpp>
+#include "catalog/catalog.h"
+#include "exec/arrow_c_data.h"
+#include "exec/arrow_ipc.h"
+#include "storage/dictionary.h"
+
+using namespace bosql;
+
+namespace {
+
+template <typename T>
+T read(const std::string& bytes, size_t at) {
+    T value;
+    std::memcpy(&value, bytes.data() + at, sizeof(T));
+    return value;
+}
+
+// Position of a table field in a FlatBuffers buffer, or 0 when absent
+size_t field_position(const std::string& fb, size_t table, size_t slot) {
+    size_t vtable = table - read<int32_t>(fb, table);
+    if (4 + 2 * slot >= read<uint16_t>(fb, vtable)) return 0;
+    uint16_t offset = read<uint16_t>(fb, vtable + 4 + 2 * slot);
+    return offset == 0 ? 0 : table + offset;
+}
+
+size_t child_table(const std::string& fb, size_t table, size_t slot) {
+    size_t at = field_position(fb, table, slot);
+    return at + read<uint32_t>(fb, at);
+}
+
+struct Message {
+    uint8_t header_type;
+    std::string metadata;
+    size_t header;  // header table position in `metadata`
+    std::string body;
+};
+
+// Splits an IPC stream into its encapsulated messages
+std::vector<Message> read_messages(const std::string& stream) {
+    std::vector<Message> messages;
+    size_t at = 0;
+    while (true) {
+        REQUIRE(read<uint32_t>(stream, at) == 0xFFFFFFFF);
+        uint32_t length = read<uint32_t>(stream, at + 4);
+        at += 8;
+        if (length == 0) break;
+        REQUIRE(length % 8 == 0);
+        Message message;
+        message.metadata = stream.substr(at, length);
+        at += length;
+        size_t root = read<uint32_t>(message.metadata, 0);
+        REQUIRE(read<int16_t>(message.metadata, field_position(message.metadata, root, 0)) == 4);  // V5
+        message.header_type = read<uint8_t>(message.metadata, field_position(message.metadata, root, 1));
+        message.header = child_table(message.metadata, root, 2);
+        size_t body_length = static_cast<size_t>(read<int64_t>(message.metadata, field_position(message.metadata, root, 3)));
+        message.body = stream.substr(at, body_length);
+        at += body_length;
+        messages.push_back(std::move(message));
+    }
+    REQUIRE(at == stream.size());
+    return messages;
+}
+
+} // namespace
+
+TEST_CASE("Arrow IPC stream carries batches as raw buffers", "[arrow]") {
+    Dictionary dict;
+    StrId north = dict.get_or_add("north");
+    StrId south = dict.get_or_add("south");
+    const int64_t ids[] = {1, 2, 3};
+    const StrId regions[] = {south, north, south};
+    const Date32 days[] = {19700101, 19700102, 20240229};
+    ExecBatch batch;
+    batch.columns.push_back({ids, TypeId::INT64, 3, nullptr});
+    batch.columns.push_back({regions, TypeId::STRING, 3, nullptr});
+    batch.columns.push_back({days, TypeId::DATE32, 3, nullptr});
+    batch.length = 3;
+
+    std::ostringstream out;
+    ArrowIpcFormatter formatter(out);
+    formatter.begin({"id", "region", "day"}, {TypeId::INT64, TypeId::STRING, TypeId::DATE32});
+    formatter.write_batch(batch, &dict);
+    formatter.write_batch(batch, &dict);
+    formatter.end(6);
+
+    auto messages = read_messages(out.str());
+    REQUIRE(messages.size() == 4);
+    REQUIRE(messages[0].header_type == 1);  // Schema
+    REQUIRE(messages[1].header_type == 2);  // DictionaryBatch
+    REQUIRE(messages[2].header_type == 3);  // RecordBatch
+    REQUIRE(messages[3].header_type == 3);
+
+    // Dictionary: offsets then the concatenated strings
+    const Message& dictionary = messages[1];
+    REQUIRE(read<int32_t>(dictionary.body, 4) == 5);
+    REQUIRE(read<int32_t>(dictionary.body, 8) == 10);
+    REQUIRE(dictionary.body.substr(16, 10) == "northsouth");
+
+    // Record batch: the column buffers as they were, each padded to 8 bytes;
+    // dates are counted in days
+    const Message& record = messages[2];
+    REQUIRE(read<int64_t>(record.metadata, field_position(record.metadata, record.header, 0)) == 3);
+    REQUIRE(std::memcmp(record.body.data(), ids, sizeof(ids)) == 0);
+    REQUIRE(std::memcmp(record.body.data() + 24, regions, sizeof(regions)) == 0);
+    REQUIRE(read<int32_t>(record.body, 40) == 0);
+    REQUIRE(read<int32_t>(record.body, 44) == 1);
+    REQUIRE(read<int32_t>(record.body, 48) == 19782);
+}
+
+TEST_CASE("Date conversion round-trips through days since the epoch", "[arrow]") {
+    for (Date32 date : {19700101, 19691231, 20000229, 21000301, 18991231}) {
+        REQUIRE(days_to_date32(date32_to_days(date)) == date);
+    }
+    REQUIRE(date32_to_days(19700101) == 0);
+    REQUIRE(date32_to_days(19691231) == -1);
+}
+
+TEST_CASE("Arrow C Data export shares buffers until release", "[arrow]") {
+    Dictionary dict;
+    StrId north = dict.get_or_add("north");
+    StrId south = dict.get_or_add("south");
+    auto ids = std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{1, 2, 3});
+    const StrId regions[] = {south, north, south};
+    const Date32 days[] = {19700101, 19700102, 20240229};
+    ExecBatch batch;
+    batch.columns.push_back({ids->data(), TypeId::INT64, 3, ids});
+    batch.columns.push_back({regions, TypeId::STRING, 3, nullptr});
+    batch.columns.push_back({days, TypeId::DATE32, 3, nullptr});
+    batch.length = 3;
+
+    ArrowSchema schema;
+    ArrowArray array;
+    export_batch(batch, {"id", "region", "day"}, &dict, &schema, &array);
+    batch.clear();
+    REQUIRE(ids.use_count() == 2);
+
+    REQUIRE(std::string(schema.format) == "+s");
+    REQUIRE(schema.n_children == 3);
+    REQUIRE(std::string(schema.children[0]->format) == "l");
+    REQUIRE(std::string(schema.children[1]->format) == "I");
+    REQUIRE(std::string(schema.children[1]->dictionary->format) == "u");
+    REQUIRE(std::string(schema.children[2]->format) == "tdD");
+    REQUIRE(std::string(schema.children[2]->name) == "day");
+
+    REQUIRE(array.length == 3);
+    REQUIRE(array.children[0]->buffers[1] == ids->data());
+    REQUIRE(array.children[1]->buffers[1] == regions);
+    const ArrowArray* values = array.children[1]->dictionary;
+    REQUIRE(values->length == 2);
+    REQUIRE(static_cast<const int32_t*>(values->buffers[1])[2] == 10);
+    REQUIRE(std::string(static_cast<const char*>(values->buffers[2]), 10) == "northsouth");
+    REQUIRE(static_cast<const int32_t*>(array.children[2]->buffers[1])[2] == 19782);
+
+    array.release(&array);
+    schema.release(&schema);
+    REQUIRE(array.release == nullptr);
+    REQUIRE(ids.use_count() == 1);
+}
+
+TEST_CASE("Arrow C Data export sends only the strings a batch references", "[arrow]") {
+    Dictionary dict;
+    for (int i = 0; i < 100; ++i) dict.get_or_add("city-" + std::to_string(i));
+    const StrId cities[] = {42, 7, 42};
+    ExecBatch batch;
+    batch.columns.push_back({cities, TypeId::STRING, 3, nullptr});
+    batch.length = 3;
+
+    ArrowSchema schema;
+    ArrowArray array;
+    export_batch(batch, {"city"}, &dict, &schema, &array);
+    const ArrowArray* values = array.children[0]->dictionary;
+    REQUIRE(values->length == 2);
+    REQUIRE(std::string(static_cast<const char*>(values->buffers[2]), 13) == "city-42city-7");
+    const auto* indices = static_cast<const uint32_t*>(array.children[0]->buffers[1]);
+    REQUIRE(indices[0] == 0);
+    REQUIRE(indices[1] == 1);
+    REQUIRE(indices[2] == 0);
+
+    array.release(&array);
+    schema.release(&schema);
+}
+
+TEST_CASE("Arrow C Data import round-trips a table into the catalog", "[arrow]") {
+    Table source;
+    source.dict = std::make_shared<Dictionary>();
+    StrId east = source.dict->get_or_add("east");
+    StrId west = source.dict->get_or_add("west");
+    source.columns.push_back({"id", std::make_unique<ColumnVector<i64>>(std::vector<i64>{7, 3, 5})});
+    source.columns.push_back({"price", std::make_unique<ColumnVector<f64>>(std::vector<f64>{1.5, 2.5, 0.5})});
+    source.columns.push_back({"region", std::make_unique<ColumnVector<StrId>>(std::vector<StrId>{west, east, west})});
+    source.columns.push_back({"day", std::make_unique<ColumnVector<Date32>>(std::vector<Date32>{20240101, 19991231, 20240229})});
+
+    ArrowSchema schema;
+    ArrowArray array;
+    export_table(source, &schema, &array);
+
+    // Count releases of the moved array through its callback
+    static int released = 0;
+    static void (*exported_release)(ArrowArray*) = nullptr;
+    released = 0;
+    exported_release = array.release;
+    array.release = [](ArrowArray* moved) {
+        ++released;
+        exported_release(moved);
+    };
+
+    Catalog catalog;
+    {
+        auto [table, meta] = import_table("sales", &schema, &array);
+        schema.release(&schema);
+        REQUIRE(array.release == nullptr);
+        REQUIRE(meta.row_count == 3);
+        REQUIRE(meta.columns[0].type == TypeId::INT64);
+        REQUIRE(meta.columns[0].stats.min_i64 == 3);
+        REQUIRE(meta.columns[0].stats.max_i64 == 7);
+        REQUIRE(meta.columns[1].stats.max_f64 == 2.5);
+        REQUIRE(meta.columns[2].type == TypeId::STRING);
+        REQUIRE(meta.columns[3].stats.min_date == 19991231);
+
+        // Numeric columns are read in place from the exported buffers
+        REQUIRE(table.get_column_data("id").values() == source.columns[0].data->values());
+        auto regions = column_values<StrId>(table.get_column_data("region"));
+        REQUIRE(table.dict->get(regions[0]) == "west");
+        REQUIRE(table.dict->get(regions[1]) == "east");
+        auto days = column_values<Date32>(table.get_column_data("day"));
+        REQUIRE(days[2] == 20240229);
+
+        catalog.register_table(std::move(table), std::move(meta));
+    }
+    REQUIRE(released == 0);
+    REQUIRE(catalog.get_table_meta("sales").has_value());
+    REQUIRE(column_values<f64>(catalog.get_table_data("sales")->get_column_data("price"))[1] == 2.5);
+
+    catalog = Catalog();
+    REQUIRE(released == 1);
+}
+
+TEST_CASE("Arrow C Data import rejects columns with nulls", "[arrow]") {
+    const int64_t values[] = {1, 2};
+    const uint8_t validity[] = {0x1};
+    const void* child_buffers[] = {validity, values};
+    ArrowArray child{2, 1, 0, 2, 0, child_buffers, nullptr, nullptr, [](ArrowArray* a) { a->release = nullptr; }, nullptr};
+    ArrowArray* children[] = {&child};
+    const void* struct_buffers[] = {nullptr};
+    ArrowArray array{2, 0, 0, 1, 1, struct_buffers, children, nullptr, [](ArrowArray* a) {
+        a->children[0]->release(a->children[0]);
+        a->release = nullptr;
+    }, nullptr};
+
+    ArrowSchema field{"l", "id", nullptr, ARROW_FLAG_NULLABLE, 0, nullptr, nullptr, nullptr, nullptr};
+    ArrowSchema* fields[] = {&field};
+    ArrowSchema schema{"+s", "", nullptr, 0, 1, fields, nullptr, nullptr, nullptr};
+
+    REQUIRE_THROWS_AS(import_table("t", &schema, &array), std::runtime_error);
+    REQUIRE(child.release == nullptr);
+}
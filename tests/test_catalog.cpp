@@ -1,6 +1,11 @@
 #include <catch2/catch_all.hpp>
 #include "storage/csv_loader.h"
 #include "catalog/catalog.h"
+#include "catalog/database.h"
+#include "catalog/statistics.h"
+#include "storage/compression.h"
+#include "test_support.h"
+#include <filesystem>
 #include <fstream>
 #include "types.h"
 
@@ -49,4 +54,112 @@ TEST_CASE("Catalog roundtrip test", "[catalog]") {
 
     // Clean up
     std::remove("test_catalog.csv");
-}
\ No newline at end of file
+}
+TEST_CASE("Saved database opens with data, dictionaries and statistics", "[catalog]") {
+    std::ofstream csv_file("test_database.csv");
+    csv_file << "id,city,price,day\n";
+    csv_file << "1,paris,1.5,20240101\n";
+    csv_file << "2,oslo,2.5,20240102\n";
+    csv_file << "3,paris,3.5,20240103\n";
+    csv_file.close();
+
+    bosql::Catalog catalog;
+    auto [table, meta] = bosql::load_csv("test_database.csv");
+    table.name = meta.name = "trips";
+    bosql::analyze_table(table, meta);
+    catalog.register_table(std::move(table), std::move(meta));
+    std::remove("test_database.csv");
+
+    auto directory = std::filesystem::temp_directory_path() / "bosql_test_database";
+    std::filesystem::remove_all(directory);
+    REQUIRE(bosql::save_database(catalog, directory) == 1);
+
+    bosql::Catalog reopened;
+    REQUIRE(bosql::open_database(reopened, directory) == 1);
+    const bosql::TableMeta& original_meta = *catalog.get_table_meta("trips");
+    const bosql::TableMeta& opened_meta = *reopened.get_table_meta("trips");
+    REQUIRE(opened_meta.row_count == 3);
+    REQUIRE(opened_meta.columns.size() == 4);
+    for (size_t c = 0; c < 4; ++c) {
+        REQUIRE(opened_meta.columns[c].name == original_meta.columns[c].name);
+        REQUIRE(opened_meta.columns[c].type == original_meta.columns[c].type);
+        REQUIRE(opened_meta.columns[c].stats.ndv == original_meta.columns[c].stats.ndv);
+        REQUIRE(opened_meta.columns[c].stats.analyzed);
+        REQUIRE(opened_meta.columns[c].stats.mcvs.size() == original_meta.columns[c].stats.mcvs.size());
+    }
+    REQUIRE(opened_meta.columns[0].stats.max_i64 == 3);
+    REQUIRE(opened_meta.columns[3].stats.min_date == 20240101);
+
+    const bosql::Table& opened = *reopened.get_table_data("trips");
+    std::vector<double> price_scratch;
+    auto prices = bosql::column_values<double>(opened.get_column_data("price"), price_scratch);
+    REQUIRE(prices[2] == 3.5);
+    std::vector<bosql::StrId> city_scratch;
+    auto cities = bosql::column_values<bosql::StrId>(opened.get_column_data("city"), city_scratch);
+    REQUIRE(opened.dict->get(cities[0]) == "paris");
+    REQUIRE(opened.dict->get(cities[1]) == "oslo");
+    REQUIRE(cities[2] == cities[0]);
+
+    // Saving again over the open database leaves its mapped columns intact
+    REQUIRE(bosql::save_database(reopened, directory) == 1);
+    std::vector<int64_t> id_scratch;
+    REQUIRE(bosql::column_values<int64_t>(opened.get_column_data("id"), id_scratch)[1] == 2);
+
+    std::filesystem::remove(directory / "MANIFEST");
+    bosql::Catalog missing;
+    REQUIRE_THROWS_AS(bosql::open_database(missing, directory), std::runtime_error);
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Saved database keeps encoded columns encoded", "[catalog]") {
+    bosql::Catalog catalog = bosql::test::build_events_catalog(true);
+    bosql::Table packed;
+    auto codes = std::make_unique<bosql::ColumnVector<int64_t>>();
+    for (int64_t i = 0; i < 1000; ++i) codes->append(i * 37 % 1000);
+    packed.columns.push_back({"packed.code", bosql::compress_column(std::move(codes))});
+    REQUIRE(std::string(packed.columns[0].data->encoding()) == "bitpacked");
+    std::vector<bosql::ColumnMeta> packed_cols{bosql::ColumnMeta("packed.code", bosql::TypeId::INT64)};
+    catalog.register_table(std::move(packed), bosql::TableMeta("packed", std::move(packed_cols), 1000));
+
+    auto directory = std::filesystem::temp_directory_path() / "bosql_test_encoded";
+    std::filesystem::remove_all(directory);
+    REQUIRE(bosql::save_database(catalog, directory) == 2);
+    bosql::Catalog reopened;
+    REQUIRE(bosql::open_database(reopened, directory) == 2);
+
+    for (const auto& name : {"events", "packed"}) {
+        const bosql::Table& original = *catalog.get_table_data(name);
+        const bosql::Table& opened = *reopened.get_table_data(name);
+        for (size_t c = 0; c < original.columns.size(); ++c) {
+            CAPTURE(original.columns[c].name);
+            REQUIRE(std::string(opened.columns[c].data->encoding()) == original.columns[c].data->encoding());
+        }
+    }
+    for (const char* sql : {"SELECT events.region, events.tag, SUM(events.amount), MIN(events.offset) FROM events "
+                            "GROUP BY events.region, events.tag",
+                            "SELECT events.day, events.kind, events.ref FROM events WHERE events.kind < 10",
+                            "SELECT packed.code FROM packed WHERE packed.code > 900"}) {
+        CAPTURE(sql);
+        REQUIRE(bosql::test::run_sorted(reopened, sql, 1) == bosql::test::run_sorted(catalog, sql, 1));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Opening a database rejects counts larger than its manifest", "[catalog]") {
+    auto directory = std::filesystem::temp_directory_path() / "bosql_test_corrupt";
+    std::filesystem::remove_all(directory);
+    bosql::Catalog catalog = bosql::test::build_events_catalog(false, 100);
+    REQUIRE(bosql::save_database(catalog, directory) == 1);
+
+    // The table count follows the 8-byte magic and the 4-byte version
+    std::fstream manifest(directory / "MANIFEST", std::ios::in | std::ios::out | std::ios::binary);
+    manifest.seekp(12);
+    const uint64_t huge = uint64_t{1} << 60;
+    manifest.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    manifest.close();
+
+    bosql::Catalog reopened;
+    REQUIRE_THROWS_AS(bosql::open_database(reopened, directory), std::runtime_error);
+    REQUIRE(reopened.list_tables().empty());
+    std::filesystem::remove_all(directory);
+}
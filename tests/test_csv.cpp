@@ -1,7 +1,11 @@
 #include <catch2/catch_all.hpp>
 #include "storage/csv_loader.h"
 #include "catalog/catalog.h"
+#include "catalog/statistics.h"
+#include "exec/operator.hpp"
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 #include "types.h"
 
 TEST_CASE("CSV load test", "[csv]") {
@@ -51,4 +55,90 @@ TEST_CASE("CSV load test", "[csv]") {
 
     // Clean up
     std::remove("test_load.csv");
-}
\ No newline at end of file
+}
+TEST_CASE("Tables loaded with the catalog dictionary share string codes", "[csv]") {
+    bosql::Catalog catalog;
+    std::istringstream products("sku,name\nb-2,Bolt\na-1,Anchor\n");
+    std::istringstream sales("sku,qty\na-1,5\nc-3,7\n");
+    auto [product_table, product_meta] = bosql::load_csv(products, catalog.shared_dictionary());
+    auto [sales_table, sales_meta] = bosql::load_csv(sales, catalog.shared_dictionary());
+    REQUIRE(product_table.dict == catalog.shared_dictionary());
+    REQUIRE(sales_table.dict == product_table.dict);
+
+    std::vector<uint32_t> product_skus(2), sales_skus(2);
+    product_table.columns[0].data->decode(0, 2, product_skus.data());
+    sales_table.columns[0].data->decode(0, 2, sales_skus.data());
+    REQUIRE(product_skus[1] == sales_skus[0]);
+    REQUIRE(catalog.shared_dictionary()->get(sales_skus[1]) == "c-3");
+
+    // Without one, every table starts its own
+    std::istringstream other("sku\na-1\n");
+    REQUIRE(bosql::load_csv(other).first.dict != catalog.shared_dictionary());
+}
+
+TEST_CASE("Lazy loads parse a column the first time a scan reads it", "[csv]") {
+    {
+        std::ofstream csv_file("test_lazy.csv");
+        csv_file << "id,name,score,day\n";
+        for (int i = 0; i < 40000; ++i) {
+            csv_file << i << ",n" << i % 97 << "," << i * 0.5 << "," << 20240101 + i % 28 << "\n";
+            if (i % 10000 == 0) csv_file << "\n";  // skipped, as by load_csv
+        }
+    }
+    bosql::Catalog catalog;
+    auto [eager, eager_meta] = bosql::load_csv("test_lazy.csv", catalog.shared_dictionary());
+    auto [lazy, lazy_meta] = bosql::load_csv_lazy("test_lazy.csv", catalog.shared_dictionary());
+
+    REQUIRE(lazy_meta.row_count == 40000);
+    REQUIRE(lazy.columns.size() == 4);
+    for (size_t i = 0; i < lazy.columns.size(); ++i) {
+        REQUIRE(lazy.columns[i].name == eager.columns[i].name);
+        REQUIRE(lazy_meta.columns[i].type == eager_meta.columns[i].type);
+        REQUIRE(std::string(lazy.columns[i].data->encoding()) == "lazy");
+        REQUIRE(lazy.columns[i].data->memory_bytes() == 0);
+        REQUIRE(lazy.columns[i].data->size() == 40000);
+    }
+    // The sampled ids are all distinct, so the column is taken to be a key
+    REQUIRE(lazy_meta.columns[0].stats.ndv == 40000);
+    REQUIRE(lazy_meta.columns[3].stats.ndv == eager_meta.columns[3].stats.ndv);
+
+    // Only the scanned columns are parsed, into the same layout and codes
+    bosql::ColumnarScan scan(&lazy, {1, 2});
+    REQUIRE(std::string(lazy.columns[0].data->encoding()) == "lazy");
+    REQUIRE(std::string(lazy.columns[3].data->encoding()) == "lazy");
+    for (size_t i : {1, 2}) {
+        const bosql::Column& loaded = lazy.columns[i].data->resolve();
+        REQUIRE(std::string(loaded.encoding()) == eager.columns[i].data->encoding());
+        REQUIRE(lazy.columns[i].data->memory_bytes() == eager.columns[i].data->memory_bytes());
+    }
+    std::vector<uint32_t> eager_codes(40000), lazy_codes(40000);
+    eager.columns[1].data->decode(0, 40000, eager_codes.data());
+    lazy.columns[1].data->decode(0, 40000, lazy_codes.data());
+    REQUIRE(lazy_codes == eager_codes);
+    std::vector<double> eager_scores(40000), lazy_scores(40000);
+    eager.columns[2].data->decode(0, 40000, eager_scores.data());
+    lazy.columns[2].data->decode(0, 40000, lazy_scores.data());
+    REQUIRE(lazy_scores == eager_scores);
+
+    // Load-time statistics cover the sample only until ANALYZE reads every row
+    REQUIRE(lazy_meta.columns[0].stats.approximate);
+    REQUIRE(lazy_meta.columns[0].stats.max_i64 < 40000 - 1);
+    REQUIRE_FALSE(eager_meta.columns[0].stats.approximate);
+    bosql::analyze_table(lazy, lazy_meta);
+    REQUIRE_FALSE(lazy_meta.columns[0].stats.approximate);
+    REQUIRE(lazy_meta.columns[0].stats.max_i64 == 40000 - 1);
+    REQUIRE(lazy_meta.columns[2].stats.max_f64 == eager_meta.columns[2].stats.max_f64);
+    std::remove("test_lazy.csv");
+
+    // Types come from the sample, so a later value of another type fails the load
+    {
+        std::ofstream csv_file("test_lazy_mismatch.csv");
+        csv_file << "id,value\n";
+        for (int i = 0; i < 3000; ++i) csv_file << i << "," << (i == 2500 ? "oops" : std::to_string(i)) << "\n";
+    }
+    auto [mismatched, mismatched_meta] = bosql::load_csv_lazy("test_lazy_mismatch.csv");
+    REQUIRE(mismatched_meta.columns[1].type == bosql::TypeId::INT64);
+    REQUIRE_NOTHROW(mismatched.columns[0].data->resolve());
+    REQUIRE_THROWS_WITH(mismatched.columns[1].data->resolve(), Catch::Contains("row 2501"));
+    std::remove("test_lazy_mismatch.csv");
+}
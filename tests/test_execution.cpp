@@ -1,12 +1,24 @@
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
 #include <catch2/catch_all.hpp>
 #include "catalog/catalog.h"
+#include "exec/column_builder.h"
+#include "exec/formatter.hpp"
+#include "exec/instrumentation.h"
 #include "exec/operator.hpp"
 #include "exec/physical_planner.h"
 #include "logical/planner.h"
 #include "parser/parser.h"
+#include "storage/compression.h"
+#include "storage/csv_file.h"
+#include "storage/csv_loader.h"
+#include "test_support.h"
 
 using namespace bosql;
+using namespace bosql::test;
 
 namespace {
 
@@ -85,7 +97,7 @@ std::vector<std::vector<std::string>> execute_plan(std::unique_ptr<Operator> roo
                     case TypeId::STRING: {
                         auto values = get_col<uint32_t>(batch, col);
                         if (dict) {
-                            out_row.push_back(dict->get(values[row]));
+                            out_row.emplace_back(dict->get(values[row]));
                         } else {
                             out_row.push_back(std::to_string(values[row]));
                         }
@@ -124,6 +136,72 @@ Catalog build_full_catalog(std::shared_ptr<Dictionary>& detail_dict) {
 
 } // namespace
 
+TEST_CASE("Column builders append in bulk and finish without copying", "[exec]") {
+    TypedColumnBuilder<int64_t> typed(2);
+    const int64_t source[] = {10, 20, 30, 40, 50};
+    typed.append(std::span<const int64_t>(source, 3));
+    const size_t indices[] = {4, 0};
+    typed.gather(source, indices);
+    const int64_t* written = typed.extend(1);
+    ColumnSlice slice = typed.finish();
+    REQUIRE(slice.data == written - 5);
+    REQUIRE(slice.type == TypeId::INT64);
+    REQUIRE(slice.length == 6);
+    auto values = static_cast<const int64_t*>(slice.data);
+    REQUIRE(values[3] == 50);
+    REQUIRE(values[4] == 10);
+    REQUIRE(typed.size() == 0);
+
+    // Run-time typed: datums convert to the column's physical type
+    ColumnBuilder doubles(TypeId::DOUBLE, 4);
+    const Datum datums[] = {Datum::from_i64(3), Datum::from_f64(1.5)};
+    doubles.append(datums);
+    ColumnSlice from_rows = doubles.finish();
+    REQUIRE(from_rows.length == 2);
+    REQUIRE(static_cast<const double*>(from_rows.data)[0] == 3.0);
+    REQUIRE(static_cast<const double*>(from_rows.data)[1] == 1.5);
+    ColumnBuilder dates(TypeId::DATE32, 4);
+    REQUIRE_THROWS_AS(dates.gather(from_rows, std::vector<size_t>{0}), std::runtime_error);
+}
+
+TEST_CASE("Formatters write whole batches", "[exec]") {
+    Dictionary dict;
+    StrId plain = dict.get_or_add("north");
+    StrId quoted = dict.get_or_add("say \"hi\", then");
+    const int64_t ids[] = {7, -12};
+    const double prices[] = {0.1, 2.5e20};
+    const StrId names[] = {plain, quoted};
+    ExecBatch batch;
+    batch.columns.push_back({ids, TypeId::INT64, 2, nullptr});
+    batch.columns.push_back({prices, TypeId::DOUBLE, 2, nullptr});
+    batch.columns.push_back({names, TypeId::STRING, 2, nullptr});
+    batch.length = 2;
+
+    std::ostringstream csv_out;
+    CsvFormatter csv(csv_out);
+    csv.begin({"id", "price", "name"}, {TypeId::INT64, TypeId::DOUBLE, TypeId::STRING});
+    csv.write_batch(batch, &dict);
+    csv.write_batch(batch, &dict);
+    csv.end(4);
+    const std::string row1 = "7,0.1,north\n";
+    const std::string row2 = "-12,2.5e+20,\"say \"\"hi\"\", then\"\n";
+    REQUIRE(csv_out.str() == "id,price,name\n" + row1 + row2 + row1 + row2);
+
+    std::ostringstream md_out;
+    MarkdownFormatter markdown(md_out);
+    markdown.begin({"id", "price"}, {TypeId::INT64, TypeId::DOUBLE});
+    ExecBatch numbers;
+    numbers.columns = {batch.columns[0], batch.columns[1]};
+    numbers.length = 2;
+    markdown.write_batch(numbers, nullptr);
+    markdown.end(2);
+    REQUIRE(md_out.str() ==
+            "| id  | price   |\n"
+            "| --- | ------- |\n"
+            "| 7   | 0.1     |\n"
+            "| -12 | 2.5e+20 |\n");
+}
+
 TEST_CASE("Selection filters rows", "[exec]") {
     Catalog catalog = build_orders_catalog();
     SelectStmt stmt = parse_sql("SELECT orders.id FROM orders WHERE orders.qty > 15");
@@ -268,3 +346,533 @@ TEST_CASE("Top region by quantity", "[exec]") {
     REQUIRE(rows[0][0] == "south");
     REQUIRE(rows[0][1] == "20");
 }
+
+TEST_CASE("EXPLAIN ANALYZE profiles every operator", "[exec]") {
+    std::shared_ptr<Dictionary> detail_dict;
+    Catalog catalog = build_full_catalog(detail_dict);
+    SelectStmt stmt = parse_sql(
+        "SELECT detail.region, SUM(orders.qty) AS total "
+        "FROM orders INNER JOIN detail ON orders.id = detail.id "
+        "GROUP BY detail.region");
+    LogicalPlanner planner;
+    auto logical = planner.build_logical_plan(stmt);
+    PhysicalPlanOptions options;
+    options.instrument = true;
+    auto physical = build_physical_plan(logical.get(), catalog, options);
+
+    auto* root = dynamic_cast<InstrumentedOperator*>(physical.get());
+    REQUIRE(root != nullptr);
+    std::string report = explain_analyze(*physical);
+    REQUIRE(root->profile().rows == 2);
+    REQUIRE(root->profile().bytes_allocated > 0);
+
+    const Operator* join = root->children().at(0);
+    const auto* join_probe = dynamic_cast<const InstrumentedOperator*>(join);
+    REQUIRE(join_probe != nullptr);
+    REQUIRE(join_probe->profile().rows == 2);
+    REQUIRE(join->children().size() == 2);
+
+    REQUIRE(report.find("HashAggregate(keys=[detail.region], aggs=[SUM(orders.qty)])") != std::string::npos);
+    REQUIRE(report.find("HashJoin(orders.id = detail.id)") != std::string::npos);
+    REQUIRE(report.find("ColumnarScan(table=") != std::string::npos);
+    REQUIRE(report.find("Total: 2 rows") != std::string::npos);
+}
+
+TEST_CASE("Encoded slices select whole runs", "[exec]") {
+    // Two columns of 10 rows: RLE 7,7,7,8,8,9,9,9,9,9 and constant 4
+    const int64_t run_values[] = {7, 8, 9};
+    const uint32_t run_ends[] = {3, 5, 10};
+    const int64_t constant = 4;
+    ExecBatch batch;
+    ColumnSlice runs{run_values, TypeId::INT64, 10, {}};
+    runs.kind = VectorKind::Rle;
+    runs.value_count = 3;
+    runs.run_ends = run_ends;
+    ColumnSlice fours{&constant, TypeId::INT64, 10, {}};
+    fours.kind = VectorKind::Constant;
+    fours.value_count = 1;
+    batch.columns = {runs, fours};
+    batch.length = 10;
+    REQUIRE(batch.columns[0].position(4) == 1);
+
+    std::vector<size_t> starts;
+    const size_t both[] = {0, 1};
+    segment_starts(batch, both, starts);
+    REQUIRE(starts == std::vector<size_t>{0, 3, 5, 10});
+
+    // Rows 1..2 and 6..7 share nothing, so the runs stay apart
+    const std::pair<size_t, size_t> ranges[] = {{1, 3}, {6, 8}};
+    select_ranges(batch, ranges);
+    REQUIRE(batch.length == 4);
+    REQUIRE(batch.columns[0].kind == VectorKind::Rle);
+    REQUIRE(batch.columns[0].value_count == 2);
+    REQUIRE(batch.columns[0].run_ends[0] == 2);
+    REQUIRE(batch.columns[1].kind == VectorKind::Constant);
+    REQUIRE(batch.columns[1].length == 4);
+
+    flatten(batch);
+    auto values = get_col<int64_t>(batch, 0);
+    REQUIRE(batch.columns[0].flat());
+    REQUIRE(std::vector<int64_t>(values.begin(), values.end()) == std::vector<int64_t>{7, 7, 9, 9});
+    REQUIRE(get_col<int64_t>(batch, 1)[3] == 4);
+
+    ExecBatch flat_batch;
+    flat_batch.columns = {ColumnSlice{run_values, TypeId::INT64, 3, {}}};
+    flat_batch.length = 3;
+    const size_t flat_column[] = {0};
+    REQUIRE_THROWS_AS(segment_starts(flat_batch, flat_column, starts), std::runtime_error);
+}
+
+TEST_CASE("Filters and aggregates read compressed columns without decoding", "[exec]") {
+    Catalog plain = build_events_catalog(false);
+    Catalog compressed = build_events_catalog(true);
+    const Table& events = *compressed.get_table_data("events");
+    REQUIRE(std::string(events.columns[0].data->encoding()) == "rle");
+    REQUIRE(std::string(events.columns[1].data->encoding()) == "rle");
+    REQUIRE(std::string(events.columns[2].data->encoding()) == "for8");
+    REQUIRE(std::string(events.columns[3].data->encoding()) == "plain");
+
+    // The scan hands runs and codes on as they are stored
+    ColumnarScan scan(const_cast<Table*>(&events), {0, 1, 2}, 4096, nullptr, true);
+    scan.open();
+    ExecBatch batch;
+    REQUIRE(scan.next(batch));
+    REQUIRE(batch.columns[0].kind == VectorKind::Rle);
+    REQUIRE(batch.columns[0].value_count == 5);
+    REQUIRE(batch.columns[2].kind == VectorKind::Dictionary);
+    REQUIRE(scan.next(batch));
+    REQUIRE(scan.next(batch));
+    REQUIRE(batch.length == 808);
+    REQUIRE(batch.columns[0].kind == VectorKind::Constant);
+    scan.close();
+
+    const std::string queries[] = {
+        // Per-run predicate and per-run aggregation
+        "SELECT events.day, SUM(events.amount), COUNT(*) FROM events WHERE events.day > 3 GROUP BY events.day",
+        "SELECT events.region, events.day, COUNT(*) FROM events WHERE events.region = 'south' GROUP BY events.region, events.day",
+        "SELECT COUNT(*) FROM events WHERE events.day < 4",
+        // Per-code predicate
+        "SELECT events.region, COUNT(*), SUM(events.kind) FROM events WHERE events.kind < 30 GROUP BY events.region",
+        // Only undefined at 150, which the 8-bit frame has a slot for but
+        // no row holds
+        "SELECT COUNT(*) FROM events WHERE 100 / (events.kind - 150) < 0",
+        // Mixed layouts fall back to rows
+        "SELECT events.kind, SUM(events.amount) FROM events WHERE events.day = 5 AND events.kind > 50 GROUP BY events.kind",
+        "SELECT events.day, events.kind, events.amount FROM events WHERE events.amount > 500",
+        "SELECT events.region, events.kind FROM events WHERE events.day = 2",
+    };
+    for (const auto& sql : queries) {
+        auto expected = run_sorted(plain, sql, 1);
+        REQUIRE(!expected.empty());
+        REQUIRE(run_sorted(compressed, sql, 1) == expected);
+        REQUIRE(run_sorted(compressed, sql, 2) == expected);
+    }
+}
+
+TEST_CASE("Comparisons run at the width columns are stored in", "[exec]") {
+    // 16-bit deltas from 1000: values 1000, 1005, 1010, ..., 1045
+    uint16_t deltas[10];
+    for (uint16_t i = 0; i < 10; ++i) deltas[i] = static_cast<uint16_t>(i * 5);
+    ColumnSlice narrow{deltas, TypeId::INT64, 10, {}};
+    narrow.kind = VectorKind::Narrow;
+    narrow.width = 2;
+    narrow.base = 1000;
+    REQUIRE(narrow.narrow_value(3) == 1015);
+
+    std::vector<size_t> rows;
+    select_comparison(narrow, {0, BinaryOp::GE, 1012}, 10, rows);
+    REQUIRE(rows == std::vector<size_t>{3, 4, 5, 6, 7, 8, 9});
+    refine_comparison(narrow, {0, BinaryOp::LT, 1030}, rows);
+    REQUIRE(rows == std::vector<size_t>{3, 4, 5});
+    refine_comparison(narrow, {0, BinaryOp::NE, 1020}, rows);
+    REQUIRE(rows == std::vector<size_t>{3, 5});
+    // Literals outside the deltas' reach select everything or nothing
+    select_comparison(narrow, {0, BinaryOp::GT, 999}, 10, rows);
+    REQUIRE(rows.size() == 10);
+    select_comparison(narrow, {0, BinaryOp::LT, 1000}, 10, rows);
+    REQUIRE(rows.empty());
+    select_comparison(narrow, {0, BinaryOp::EQ, 1000 + 70000}, 10, rows);
+    REQUIRE(rows.empty());
+    select_comparison(narrow, {0, BinaryOp::NE, -5}, 10, rows);
+    REQUIRE(rows.size() == 10);
+
+    const int64_t extremes[] = {std::numeric_limits<int64_t>::min(), -1, 0, std::numeric_limits<int64_t>::max()};
+    ColumnSlice flat{extremes, TypeId::INT64, 4, {}};
+    select_comparison(flat, {0, BinaryOp::LT, 0}, 4, rows);
+    REQUIRE(rows == std::vector<size_t>{0, 1});
+    select_comparison(flat, {0, BinaryOp::GT, std::numeric_limits<int64_t>::max()}, 4, rows);
+    REQUIRE(rows.empty());
+    select_comparison(flat, {0, BinaryOp::LE, std::numeric_limits<int64_t>::min()}, 4, rows);
+    REQUIRE(rows == std::vector<size_t>{0});
+
+    // Literal first flips the operator; other shapes are not comparisons
+    std::vector<std::string> names = {"t.a", "t.b"};
+    std::vector<TypeId> types = {TypeId::INT64, TypeId::DOUBLE};
+    ExprBindings bindings = make_bindings(names, types);
+    auto where = [](const std::string& condition) { return parse_sql("SELECT t.a FROM t WHERE " + condition).where_clause->clone(); };
+    auto matched = match_comparisons(where("5 < t.a AND t.a <= 9").get(), bindings);
+    REQUIRE(matched.size() == 2);
+    REQUIRE(matched[0].op == BinaryOp::GT);
+    REQUIRE(matched[0].value == 5);
+    REQUIRE(matched[1].op == BinaryOp::LE);
+    REQUIRE(match_comparisons(where("t.a > 1 OR t.a < 0").get(), bindings).empty());
+    REQUIRE(match_comparisons(where("t.a > 1 AND t.b < 2").get(), bindings).empty());
+    REQUIRE(match_comparisons(where("t.a + 1 > 1").get(), bindings).empty());
+}
+
+TEST_CASE("Filters compare narrow columns without widening them", "[exec]") {
+    Catalog plain = build_events_catalog(false);
+    Catalog compressed = build_events_catalog(true);
+    const Table& events = *compressed.get_table_data("events");
+    REQUIRE(std::string(events.columns[4].data->encoding()) == "for16");
+    REQUIRE(std::string(events.columns[5].data->encoding()) == "for32");
+
+    ColumnarScan scan(const_cast<Table*>(&events), {2, 4, 5}, 4096, nullptr, true);
+    scan.open();
+    ExecBatch batch;
+    REQUIRE(scan.next(batch));
+    REQUIRE(batch.columns[0].kind == VectorKind::Dictionary);
+    REQUIRE(batch.columns[0].width == 1);
+    REQUIRE(batch.columns[1].kind == VectorKind::Narrow);
+    REQUIRE(batch.columns[1].width == 2);
+    REQUIRE(batch.columns[2].kind == VectorKind::Narrow);
+    REQUIRE(batch.columns[2].width == 4);
+    scan.close();
+
+    const std::string queries[] = {
+        "SELECT events.ref, events.kind FROM events WHERE events.ref >= 120000 AND events.ref < 120500",
+        "SELECT events.offset FROM events WHERE events.offset > 0 AND 30 > events.kind",
+        "SELECT events.kind, COUNT(*), SUM(events.offset) FROM events WHERE events.kind != 7 AND events.ref > 140000 GROUP BY events.kind",
+        "SELECT events.region, SUM(events.ref) FROM events WHERE events.day >= 2 AND events.offset <= 100000000 GROUP BY events.region",
+        "SELECT COUNT(*) FROM events WHERE events.ref = 100007",
+    };
+    for (const auto& sql : queries) {
+        auto expected = run_sorted(plain, sql, 1);
+        REQUIRE(!expected.empty());
+        REQUIRE(run_sorted(compressed, sql, 1) == expected);
+        REQUIRE(run_sorted(compressed, sql, 2) == expected);
+    }
+}
+
+TEST_CASE("Aggregates decode narrow and dictionary columns a batch at a time", "[exec]") {
+    Catalog plain = build_events_catalog(false);
+    Catalog compressed = build_events_catalog(true);
+    const std::string queries[] = {
+        // Dictionary key, 16- and 32-bit arguments
+        "SELECT events.kind, COUNT(*), SUM(events.ref), AVG(events.offset) FROM events GROUP BY events.kind",
+        // 16-bit key, dictionary argument
+        "SELECT events.ref, SUM(events.kind), AVG(events.kind) FROM events WHERE events.ref < 100400 GROUP BY events.ref",
+        "SELECT events.region, events.kind, SUM(events.amount) FROM events GROUP BY events.region, events.kind",
+        "SELECT SUM(events.offset), AVG(events.ref), COUNT(*) FROM events",
+        // Expressions are evaluated per row
+        "SELECT events.kind, SUM(events.ref - events.kind) FROM events GROUP BY events.kind",
+    };
+    for (const auto& sql : queries) {
+        auto expected = run_sorted(plain, sql, 1);
+        REQUIRE(!expected.empty());
+        REQUIRE(run_sorted(compressed, sql, 1) == expected);
+        REQUIRE(run_sorted(compressed, sql, 2) == expected);
+    }
+}
+
+TEST_CASE("String joins translate build codes to the probe dictionary", "[exec]") {
+    // Each table encodes its strings with its own dictionary, in a different order
+    Catalog catalog;
+    Table products;
+    products.dict = std::make_shared<Dictionary>();
+    auto product_sku = std::make_unique<ColumnVector<uint32_t>>();
+    auto product_name = std::make_unique<ColumnVector<uint32_t>>();
+    const char* product_rows[][2] = {{"b-2", "Bolt"}, {"a-1", "Anchor"}, {"c-3", "Clamp"}, {"d-4", "Drill"}};
+    for (const auto& row : product_rows) {
+        product_sku->append(products.dict->get_or_add(row[0]));
+        product_name->append(products.dict->get_or_add(row[1]));
+    }
+    products.columns.push_back({"products.sku", std::move(product_sku)});
+    products.columns.push_back({"products.name", std::move(product_name)});
+    std::vector<ColumnMeta> product_cols;
+    product_cols.emplace_back("products.sku", TypeId::STRING);
+    product_cols.emplace_back("products.name", TypeId::STRING);
+    catalog.register_table(std::move(products), TableMeta("products", std::move(product_cols), 4));
+
+    Table sales;
+    sales.dict = std::make_shared<Dictionary>();
+    auto sale_sku = std::make_unique<ColumnVector<uint32_t>>();
+    auto sale_qty = std::make_unique<ColumnVector<int64_t>>();
+    const std::pair<const char*, int64_t> sale_rows[] = {{"a-1", 5}, {"z-9", 1}, {"c-3", 7}, {"a-1", 2}};
+    for (const auto& [sku, qty] : sale_rows) {
+        sale_sku->append(sales.dict->get_or_add(sku));
+        sale_qty->append(qty);
+    }
+    sales.columns.push_back({"sales.sku", std::move(sale_sku)});
+    sales.columns.push_back({"sales.qty", std::move(sale_qty)});
+    std::vector<ColumnMeta> sale_cols;
+    sale_cols.emplace_back("sales.sku", TypeId::STRING);
+    sale_cols.emplace_back("sales.qty", TypeId::INT64);
+    catalog.register_table(std::move(sales), TableMeta("sales", std::move(sale_cols), 4));
+
+    // Keys alone need no new probe-side codes
+    const Dictionary& sales_dict = *catalog.get_table_data("sales")->dict;
+    auto counts = run_sorted(catalog, "SELECT COUNT(*) FROM sales INNER JOIN products ON sales.sku = products.sku", 1);
+    REQUIRE(counts[0][0] == "3");
+    REQUIRE(sales_dict.size() == 3);
+
+    const std::string sql =
+        "SELECT sales.sku, products.name, sales.qty FROM sales INNER JOIN products ON sales.sku = products.sku";
+    for (size_t threads : {1, 2}) {
+        auto rows = run_sorted(catalog, sql, threads);
+        REQUIRE(rows.size() == 3);
+        REQUIRE(rows[0] == std::vector<std::string>{"a-1", "Anchor", "2"});
+        REQUIRE(rows[1] == std::vector<std::string>{"a-1", "Anchor", "5"});
+        REQUIRE(rows[2] == std::vector<std::string>{"c-3", "Clamp", "7"});
+    }
+    // Product names the sales dictionary lacks live in a query-local overlay
+    REQUIRE(sales_dict.size() == 3);
+    REQUIRE_FALSE(sales_dict.find("Anchor").has_value());
+
+    Dictionary base;
+    base.get_or_add("x");
+    Dictionary overlay(&base);
+    REQUIRE(overlay.get_or_add("x") == 0);
+    REQUIRE(overlay.get_or_add("y") == 1);
+    REQUIRE(overlay.get(1) == "y");
+    REQUIRE(base.size() == 1);
+    for (int i = 0; i < 1000; ++i) overlay.get_or_add("s" + std::to_string(i));
+    REQUIRE(overlay.find("s999") == StrId{1001});
+    REQUIRE(overlay.size() == 1002);
+}
+
+TEST_CASE("String predicates are evaluated once per dictionary code", "[exec]") {
+    REQUIRE(like_match("north", "no%"));
+    REQUIRE(like_match("north", "%th"));
+    REQUIRE(like_match("north", "%rt%"));
+    REQUIRE(like_match("north", "n_r_h"));
+    REQUIRE(like_match("", "%"));
+    REQUIRE(like_match("a%b", "a%%b"));
+    REQUIRE(!like_match("north", "no"));
+    REQUIRE(!like_match("north", "%s%"));
+    REQUIRE(!like_match("north", "_____%_"));
+
+    Catalog plain = build_events_catalog(false);
+    Catalog compressed = build_events_catalog(true);
+    const Table& events = *compressed.get_table_data("events");
+    REQUIRE(std::string(events.columns[6].data->encoding()) == "for16");
+
+    // 4500 tags, 2 rows each
+    auto count = [&](const std::string& condition) {
+        auto rows = run_sorted(plain, "SELECT COUNT(*) FROM events WHERE " + condition, 1);
+        return rows.at(0).at(0);
+    };
+    REQUIRE(count("events.tag LIKE 't1%'") == "2222");
+    REQUIRE(count("events.tag LIKE '%5'") == "900");
+    REQUIRE(count("events.tag NOT LIKE 't_'") == "8980");
+    REQUIRE(count("events.tag IN ('t1', 't2', 'nope')") == "4");
+    REQUIRE(count("events.tag NOT IN ('t1')") == "8998");
+    REQUIRE(run_sorted(compressed, "SELECT events.tag FROM events WHERE events.tag LIKE 'x%'", 1).empty());
+
+    const std::string queries[] = {
+        // Flat codes plain, 16-bit deltas compressed
+        "SELECT events.tag, COUNT(*) FROM events WHERE events.tag LIKE '%7%' GROUP BY events.tag",
+        "SELECT events.day, events.tag FROM events WHERE events.tag IN ('t3', 't33', 't299')",
+        "SELECT events.tag, events.kind FROM events WHERE events.tag = 't42' OR events.tag = 't24'",
+        // RLE regions still run once per run
+        "SELECT events.region, COUNT(*) FROM events WHERE events.region LIKE '%th' GROUP BY events.region",
+        "SELECT events.day, COUNT(*) FROM events WHERE events.region NOT IN ('east') GROUP BY events.day",
+        // With another column the predicate runs per row
+        "SELECT events.tag FROM events WHERE events.tag LIKE 't2_' AND events.kind < 50",
+    };
+    for (const auto& sql : queries) {
+        auto expected = run_sorted(plain, sql, 1);
+        REQUIRE(!expected.empty());
+        REQUIRE(run_sorted(compressed, sql, 1) == expected);
+        REQUIRE(run_sorted(compressed, sql, 2) == expected);
+    }
+
+    // An 8-bit frame over 200 codes: the rest of its slots are no string
+    Catalog narrow;
+    Table table;
+    table.dict = std::make_shared<Dictionary>();
+    auto tags = std::make_unique<ColumnVector<uint32_t>>();
+    for (int i = 0; i < 2000; ++i) {
+        tags->append(table.dict->get_or_add("k" + std::to_string(i % 200)));
+    }
+    table.columns.push_back({"k.tag", compress_column(std::move(tags))});
+    REQUIRE(std::string(table.columns[0].data->encoding()) == "for8");
+    narrow.register_table(std::move(table), TableMeta("k", {ColumnMeta("k.tag", TypeId::STRING)}, 2000));
+    auto rows = run_sorted(narrow, "SELECT COUNT(*) FROM k WHERE k.tag LIKE 'k1%'", 1);
+    REQUIRE(rows.at(0).at(0) == "1110");
+}
+
+TEST_CASE("IN lists compile to a bitmap, a sorted array or a hash set", "[exec]") {
+    constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+    constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+    IntSet dense({9, 3, 5});
+    REQUIRE(dense.layout() == IntSet::Layout::Bitmap);
+    REQUIRE(dense.contains(3));
+    REQUIRE(!dense.contains(4));
+    REQUIRE(!dense.contains(10));
+    REQUIRE(!dense.contains(kMin));
+    IntSet top({kMax, kMax - 1});
+    REQUIRE(top.layout() == IntSet::Layout::Bitmap);
+    REQUIRE(top.contains(kMax));
+    REQUIRE(!top.contains(kMin));
+    IntSet sparse({kMin, 0, kMax, 0});
+    REQUIRE(sparse.layout() == IntSet::Layout::Sorted);
+    REQUIRE(sparse.contains(kMin));
+    REQUIRE(sparse.contains(kMax));
+    REQUIRE(!sparse.contains(1));
+    std::vector<int64_t> many;
+    for (int64_t i = 0; i < 1000; ++i) many.push_back(i * 1000003 - 7);
+    IntSet hashed(many);
+    REQUIRE(hashed.layout() == IntSet::Layout::Hash);
+    REQUIRE(std::all_of(many.begin(), many.end(), [&](int64_t value) { return hashed.contains(value); }));
+    REQUIRE(std::none_of(many.begin(), many.end(), [&](int64_t value) { return hashed.contains(value + 1); }));
+
+    // Each query has an IN list where {} stands, and is checked against the
+    // same list spelled out as ORed equalities (ANDed inequalities for NOT IN)
+    struct Case {
+        std::string sql;
+        std::string column;
+        std::vector<int64_t> values;
+        bool negated;
+    };
+    std::vector<int64_t> refs, offsets;
+    for (int64_t j = 0; j < 200; ++j) refs.push_back(100000 + j * 3);
+    for (int64_t j = 0; j < 500; ++j) offsets.push_back(j * 1500000 - 500000000);
+    const Case cases[] = {
+        {"SELECT COUNT(*) FROM events WHERE {}", "events.kind", {1, 5, 50}, false},
+        {"SELECT events.ref FROM events WHERE {}", "events.ref", refs, false},
+        {"SELECT events.offset, events.kind FROM events WHERE {}", "events.offset",
+         {-499700000, -492300000, -100000000, 399900000}, false},
+        {"SELECT events.kind, COUNT(*) FROM events WHERE {} AND events.kind < 40 GROUP BY events.kind", "events.offset", offsets, false},
+        {"SELECT events.kind, SUM(events.ref) FROM events WHERE {} GROUP BY events.kind", "events.kind", {3, 4, 17}, true},
+        {"SELECT events.day, COUNT(*) FROM events WHERE {} GROUP BY events.day", "events.day", {1, 3}, false},
+    };
+    Catalog plain = build_events_catalog(false);
+    Catalog compressed = build_events_catalog(true);
+    for (const auto& c : cases) {
+        std::string list, chain;
+        for (size_t i = 0; i < c.values.size(); ++i) {
+            list += (i ? ", " : "") + std::to_string(c.values[i]);
+            chain += (i ? (c.negated ? " AND " : " OR ") : "") + c.column + (c.negated ? " != " : " = ") + std::to_string(c.values[i]);
+        }
+        std::string in_sql = c.sql, or_sql = c.sql;
+        in_sql.replace(in_sql.find("{}"), 2, c.column + (c.negated ? " NOT IN (" : " IN (") + list + ")");
+        or_sql.replace(or_sql.find("{}"), 2, "(" + chain + ")");
+        auto expected = run_sorted(plain, or_sql, 1);
+        REQUIRE(!expected.empty());
+        REQUIRE(run_sorted(plain, in_sql, 1) == expected);
+        REQUIRE(run_sorted(compressed, in_sql, 1) == expected);
+        REQUIRE(run_sorted(compressed, in_sql, 2) == expected);
+    }
+
+    // A list with a non-literal stays on the row path
+    std::vector<std::string> names = {"t.a"};
+    std::vector<TypeId> types = {TypeId::INT64};
+    ExprBindings bindings = make_bindings(names, types);
+    auto where = [](const std::string& condition) { return parse_sql("SELECT t.a FROM t WHERE " + condition).where_clause->clone(); };
+    auto matched = match_comparisons(where("t.a IN (1, 2) AND t.a > 0").get(), bindings);
+    REQUIRE(matched.size() == 2);
+    REQUIRE(matched[0].set != nullptr);
+    REQUIRE(match_comparisons(where("t.a IN (1, t.a)").get(), bindings).empty());
+}
+
+TEST_CASE("Storage report counts stored and scanned bytes per column", "[exec]") {
+    Catalog compressed = build_events_catalog(true);
+    auto report = storage_report(compressed, "events");
+    REQUIRE(report.size() == 1);
+    REQUIRE(report[0].rows == 9000);
+    REQUIRE(report[0].dictionary_entries == 4503);
+    REQUIRE(report[0].dictionary_bytes >= 4503 * sizeof(std::string));
+    // A 20-character string no longer fits inside its std::string
+    Dictionary dictionary;
+    dictionary.get_or_add(std::string(20, 'x'));
+    REQUIRE(dictionary.memory_bytes() >= sizeof(std::string) + 21);
+    const auto& columns = report[0].columns;
+    REQUIRE(columns.size() == 7);
+    REQUIRE(columns[2].name == "events.kind");
+    REQUIRE(columns[2].encoding == "for8");
+    REQUIRE(columns[2].bytes == 9000);
+    REQUIRE(columns[3].encoding == "plain");
+    REQUIRE(columns[3].bytes == 9000 * sizeof(double));
+    REQUIRE(columns[2].scanned_rows == 0);
+    REQUIRE(storage_report(compressed, "missing").empty());
+
+    // Codes are read a byte per row; the RLE day column a run at a time
+    run_sorted(compressed, "SELECT events.day, COUNT(*) FROM events WHERE events.kind < 10 GROUP BY events.day", 2);
+    report = storage_report(compressed);
+    REQUIRE(report[0].columns[2].scanned_rows == 9000);
+    REQUIRE(report[0].columns[2].scanned_bytes == 9000);
+    REQUIRE(report[0].columns[0].scanned_rows == 9000);
+    REQUIRE(report[0].columns[0].scanned_bytes < 9000);
+    REQUIRE(report[0].columns[3].scanned_rows == 0);
+    run_sorted(compressed, "SELECT events.amount FROM events WHERE events.amount > 500", 1);
+    report = storage_report(compressed);
+    REQUIRE(report[0].columns[3].scanned_rows == 9000);
+    REQUIRE(report[0].columns[3].scanned_bytes == 9000 * sizeof(double));
+}
+
+TEST_CASE("External tables are scanned in place through a positional map", "[exec]") {
+    {
+        std::ofstream csv_file("test_external.csv");
+        csv_file << "id,name,score,day\n";
+        for (int i = 0; i < 40000; ++i) {
+            csv_file << i << ",n" << i % 97 << "," << i * 0.5 << "," << 20240101 + i % 28 << "\n";
+            if (i % 10000 == 0) csv_file << "\n";
+        }
+    }
+    auto load = [](auto loader) {
+        Catalog catalog;
+        auto [table, meta] = loader("test_external.csv", catalog.shared_dictionary());
+        table.name = meta.name = "t";
+        catalog.register_table(std::move(table), std::move(meta));
+        return catalog;
+    };
+    Catalog eager = load([](const std::string& file, auto dict) { return load_csv(file, dict); });
+    Catalog external = load([](const std::string& file, auto dict) { return load_csv_external(file, dict); });
+    const Table& table = *external.get_table_data("t");
+    REQUIRE(table.external);
+    auto encoding = [&](size_t column) { return std::string(table.columns[column].data->encoding()); };
+    auto map_bytes = [&] { return storage_report(external, "t")[0].map_bytes; };
+    REQUIRE(map_bytes() == 0);
+
+    // The first query maps row starts and the fields it reads, and parses nothing
+    const std::string first = "SELECT SUM(score) FROM t WHERE id < 20000";
+    REQUIRE(run_sorted(external, first, 1) == run_sorted(eager, first, 1));
+    REQUIRE(encoding(0) == "lazy");
+    REQUIRE(encoding(2) == "lazy");
+    REQUIRE(map_bytes() == 40000 * (sizeof(uint64_t) + 2 * sizeof(uint32_t)));
+    REQUIRE(storage_report(external, "t")[0].columns[2].scanned_rows == 40000);
+
+    // The day column is found from the score fields to its left
+    const std::string second = "SELECT day, COUNT(*) FROM t WHERE score > 100 GROUP BY day";
+    REQUIRE(run_sorted(external, second, 2) == run_sorted(eager, second, 1));
+    REQUIRE(encoding(3) == "lazy");
+    REQUIRE(map_bytes() == 40000 * (sizeof(uint64_t) + 3 * sizeof(uint32_t)));
+
+    // Strings are cached on their first scan, other columns once they have
+    // been read in place kInSituScans times
+    const std::string third = "SELECT name, MAX(score) FROM t WHERE day > 20240110 GROUP BY name";
+    REQUIRE(run_sorted(external, third, 2) == run_sorted(eager, third, 1));
+    REQUIRE(ExternalCsv::kInSituScans == 2);
+    REQUIRE(encoding(1) == eager.get_table_data("t")->columns[1].data->encoding());
+    REQUIRE(encoding(2) == eager.get_table_data("t")->columns[2].data->encoding());
+    REQUIRE(encoding(3) == "lazy");
+    REQUIRE(encoding(0) == "lazy");
+    REQUIRE(run_sorted(external, first, 2) == run_sorted(eager, first, 1));
+    std::remove("test_external.csv");
+
+    // Values are checked against the sampled type as they are read
+    {
+        std::ofstream csv_file("test_external_mismatch.csv");
+        csv_file << "id,value\n";
+        for (int i = 0; i < 3000; ++i) csv_file << i << "," << (i == 2500 ? "oops" : std::to_string(i)) << "\n";
+    }
+    Catalog mismatched;
+    auto [data, meta] = load_csv_external("test_external_mismatch.csv");
+    data.name = meta.name = "m";
+    mismatched.register_table(std::move(data), std::move(meta));
+    REQUIRE(run_sorted(mismatched, "SELECT COUNT(*) FROM m WHERE id > 10", 1)[0][0] == "2989");
+    REQUIRE_THROWS_WITH(run_sorted(mismatched, "SELECT SUM(value) FROM m", 1),
+                        Catch::Contains("row 2501") && Catch::Contains("AS EXTERNAL"));
+    std::remove("test_external_mismatch.csv");
+}
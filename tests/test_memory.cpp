@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include "catalog/catalog.h"
+#include "exec/buffer_pool.h"
+#include "exec/instrumentation.h"
+#include "exec/memory.h"
+#include "exec/physical_planner.h"
+#include "test_support.h"
+
+using namespace bosql;
+using namespace bosql::test;
+
+namespace {
+
+constexpr int64_t kOrderRows = 40000;
+
+// orders: one row per id, with a customer for every eighth id
+Catalog build_orders_catalog() {
+    Catalog catalog;
+    Table orders;
+    auto id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto customer_col = std::make_unique<ColumnVector<int64_t>>();
+    auto amount_col = std::make_unique<ColumnVector<double>>();
+    for (int64_t i = 0; i < kOrderRows; ++i) {
+        id_col->append(i);
+        customer_col->append(i / 8);
+        amount_col->append(static_cast<double>(i % 100) / 2.0);
+    }
+    orders.columns.push_back({"orders.id", std::move(id_col)});
+    orders.columns.push_back({"orders.customer", std::move(customer_col)});
+    orders.columns.push_back({"orders.amount", std::move(amount_col)});
+    std::vector<ColumnMeta> cols;
+    cols.emplace_back("orders.id", TypeId::INT64);
+    cols.emplace_back("orders.customer", TypeId::INT64);
+    cols.emplace_back("orders.amount", TypeId::DOUBLE);
+    catalog.register_table(std::move(orders), TableMeta("orders", std::move(cols), kOrderRows));
+    return catalog;
+}
+
+bool has_child(const MemoryTracker::Usage& usage, const std::string& prefix) {
+    return std::any_of(usage.children.begin(), usage.children.end(),
+                       [&](const auto& child) { return child.label.rfind(prefix, 0) == 0 && child.peak > 0; });
+}
+
+} // namespace
+
+TEST_CASE("Memory trackers charge every ancestor and enforce limits", "[memory]") {
+    auto query = MemoryTracker::create("query", 1000);
+    auto op = MemoryTracker::create("op", 0, query);
+    size_t process_before = MemoryTracker::process()->current();
+
+    op->consume(600);
+    REQUIRE(op->current() == 600);
+    REQUIRE(query->current() == 600);
+    REQUIRE(MemoryTracker::process()->current() == process_before + 600);
+
+    // Over the query limit: nothing is charged anywhere
+    REQUIRE_THROWS_AS(op->consume(500), std::runtime_error);
+    REQUIRE(op->current() == 600);
+    REQUIRE(query->current() == 600);
+
+    op->release(600);
+    REQUIRE(query->current() == 0);
+    REQUIRE(query->peak() == 600);
+    REQUIRE(MemoryTracker::process()->current() == process_before);
+
+    // A destroyed child keeps its numbers in the query's usage
+    op.reset();
+    auto usage = query->usage();
+    REQUIRE(usage.children.size() == 1);
+    REQUIRE(usage.children[0].label == "op");
+    REQUIRE(usage.children[0].peak == 600);
+}
+
+TEST_CASE("Reservations release their charge on destruction", "[memory]") {
+    auto query = MemoryTracker::create("query");
+    {
+        MemoryScope scope(query.get());
+        MemoryReservation reservation;
+        reservation.grow(100);
+        reservation.resize(40);
+        REQUIRE(query->current() == 40);
+    }
+    REQUIRE(query->current() == 0);
+    REQUIRE(query->peak() == 100);
+}
+
+TEST_CASE("Buffer pool recycles aligned buffers by size class", "[memory]") {
+    BufferPool pool;
+    auto query = MemoryTracker::create("query");
+    void* first = nullptr;
+    {
+        MemoryScope scope(query.get());
+        PooledBuffer buffer = pool.allocate(4096 * sizeof(int64_t));
+        REQUIRE(reinterpret_cast<uintptr_t>(buffer.data) % kBufferAlignment == 0);
+        REQUIRE(buffer.capacity == 32768);
+        REQUIRE(query->current() == 32768);
+        first = buffer.data;
+    }
+    REQUIRE(query->current() == 0);
+    REQUIRE(pool.stats().cached_bytes == 32768);
+
+    // Any request in the same power-of-two class gets the cached buffer back
+    PooledBuffer again = pool.allocate(20000);
+    REQUIRE(again.data == first);
+    REQUIRE(pool.stats().allocations == 1);
+    REQUIRE(pool.stats().reuses == 1);
+    REQUIRE(pool.stats().cached_bytes == 0);
+
+    // Without a cache budget released buffers go straight back to the heap
+    pool.set_max_cached_bytes(0);
+    again.owner.reset();
+    REQUIRE(pool.stats().cached_bytes == 0);
+    PooledBuffer fresh = pool.allocate(20000);
+    REQUIRE(pool.stats().allocations == 2);
+}
+
+TEST_CASE("Queries report per-operator memory and honour a hard limit", "[memory]") {
+    Catalog catalog = build_orders_catalog();
+    const std::string sql = "SELECT orders.customer, SUM(orders.amount) AS total FROM orders GROUP BY orders.customer";
+
+    for (size_t threads : {1, 4}) {
+        INFO("threads: " << threads);
+        PhysicalPlanOptions options;
+        options.threads = threads;
+        options.memory = MemoryTracker::create("query");
+        REQUIRE(run_rows(catalog, sql, options).size() == static_cast<size_t>(kOrderRows / 8));
+        REQUIRE(options.memory->current() == 0);
+        REQUIRE(options.memory->peak() > 0);
+        auto usage = options.memory->usage();
+        // Scans hand out table memory without copying; the aggregate allocates
+        REQUIRE(has_child(usage, "HashAggregate"));
+
+        PhysicalPlanOptions limited = options;
+        limited.memory = MemoryTracker::create("query", 64 * 1024);
+        REQUIRE_THROWS_AS(run_rows(catalog, sql, limited), std::runtime_error);
+    }
+}
+
+TEST_CASE("EXPLAIN ANALYZE shows peak memory", "[memory]") {
+    Catalog catalog = build_orders_catalog();
+    PhysicalPlanOptions options;
+    options.instrument = true;
+    options.memory = MemoryTracker::create("query");
+    auto root = plan_query(catalog, "SELECT orders.id, orders.amount FROM orders ORDER BY orders.amount, orders.id", options);
+    std::string report = explain_analyze(*root, options.memory.get());
+    REQUIRE(report.find("memory: peak") != std::string::npos);
+    REQUIRE(report.find(", peak memory") != std::string::npos);
+}
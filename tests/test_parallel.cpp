@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <catch2/catch_all.hpp>
+#include "catalog/catalog.h"
+#include "exec/operator.hpp"
+#include "exec/parallel.h"
+#include "exec/physical_planner.h"
+#include "exec/scheduler.h"
+#include "test_support.h"
+
+using namespace bosql;
+using namespace bosql::test;
+
+namespace {
+
+constexpr int64_t kSalesRows = 100000;
+
+// sales: 100k rows over 50 stores; stores: one row per store with a region
+Catalog build_sales_catalog() {
+    Catalog catalog;
+    auto dict = std::make_shared<Dictionary>();
+
+    Table sales;
+    sales.dict = dict;
+    auto id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto store_col = std::make_unique<ColumnVector<int64_t>>();
+    auto qty_col = std::make_unique<ColumnVector<double>>();
+    for (int64_t i = 0; i < kSalesRows; ++i) {
+        id_col->append(i);
+        store_col->append((i * 7) % 50);
+        qty_col->append(static_cast<double>(i % 13));
+    }
+    sales.columns.push_back({"sales.id", std::move(id_col)});
+    sales.columns.push_back({"sales.store", std::move(store_col)});
+    sales.columns.push_back({"sales.qty", std::move(qty_col)});
+    std::vector<ColumnMeta> sales_cols;
+    sales_cols.emplace_back("sales.id", TypeId::INT64);
+    sales_cols.emplace_back("sales.store", TypeId::INT64);
+    sales_cols.emplace_back("sales.qty", TypeId::DOUBLE);
+    catalog.register_table(std::move(sales), TableMeta("sales", std::move(sales_cols), kSalesRows));
+
+    Table stores;
+    stores.dict = dict;
+    auto store_id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto region_col = std::make_unique<ColumnVector<uint32_t>>();
+    const char* regions[] = {"north", "south", "east", "west"};
+    for (int64_t s = 0; s < 50; ++s) {
+        store_id_col->append(s);
+        region_col->append(dict->get_or_add(regions[s % 4]));
+    }
+    stores.columns.push_back({"stores.id", std::move(store_id_col)});
+    stores.columns.push_back({"stores.region", std::move(region_col)});
+    std::vector<ColumnMeta> store_cols;
+    store_cols.emplace_back("stores.id", TypeId::INT64);
+    store_cols.emplace_back("stores.region", TypeId::STRING);
+    catalog.register_table(std::move(stores), TableMeta("stores", std::move(store_cols), 50));
+    return catalog;
+}
+
+} // namespace
+
+TEST_CASE("Morsel queue hands out every row exactly once", "[parallel]") {
+    MorselQueue queue(100003, 1000);
+    std::atomic<size_t> claimed{0};
+    std::vector<std::vector<std::pair<size_t, size_t>>> ranges(4);
+    run_parallel(4, [&](size_t worker) {
+        size_t begin = 0;
+        size_t end = 0;
+        while (queue.next(begin, end)) {
+            ranges[worker].emplace_back(begin, end);
+            claimed += end - begin;
+        }
+    });
+    REQUIRE(claimed == 100003);
+    std::vector<std::pair<size_t, size_t>> all;
+    for (const auto& worker : ranges) {
+        all.insert(all.end(), worker.begin(), worker.end());
+    }
+    std::sort(all.begin(), all.end());
+    for (size_t i = 1; i < all.size(); ++i) {
+        REQUIRE(all[i].first == all[i - 1].second);
+    }
+}
+
+TEST_CASE("Scheduler runs nested tasks and propagates errors", "[parallel]") {
+    Scheduler scheduler(4);
+
+    SECTION("tasks that fork and wait on their own groups") {
+        std::atomic<int> leaves{0};
+        TaskGroup outer;
+        for (int i = 0; i < 8; ++i) {
+            scheduler.submit(outer, [&] {
+                TaskGroup inner;
+                for (int j = 0; j < 16; ++j) {
+                    scheduler.submit(inner, [&] { ++leaves; });
+                }
+                scheduler.wait(inner);
+            });
+        }
+        scheduler.wait(outer);
+        REQUIRE(leaves == 8 * 16);
+        uint64_t executed = 0;
+        for (const auto& stats : scheduler.stats()) executed += stats.tasks;
+        REQUIRE(executed <= 8 + 8 * 16);
+    }
+
+    SECTION("probe tasks wait for the build group") {
+        std::atomic<int> built{0};
+        std::atomic<int> probed_early{0};
+        TaskGroup build;
+        for (int i = 0; i < 4; ++i) {
+            scheduler.submit(build, [&] { ++built; });
+        }
+        TaskGroup probe;
+        for (int i = 0; i < 4; ++i) {
+            scheduler.submit(probe, [&] {
+                scheduler.wait(build);
+                if (built != 4) ++probed_early;
+            });
+        }
+        scheduler.wait(probe);
+        REQUIRE(built == 4);
+        REQUIRE(probed_early == 0);
+    }
+
+    SECTION("the first exception reaches the waiter") {
+        std::atomic<int> finished{0};
+        TaskGroup group;
+        for (int i = 0; i < 10; ++i) {
+            scheduler.submit(group, [&, i] {
+                if (i == 3) throw std::runtime_error("task failed");
+                ++finished;
+            });
+        }
+        REQUIRE_THROWS_WITH(scheduler.wait(group), "task failed");
+        REQUIRE(group.done());
+        REQUIRE(finished == 9);
+    }
+}
+
+TEST_CASE("Scheduler balances skewed work by stealing", "[parallel]") {
+    Scheduler scheduler(4);
+    std::atomic<size_t> total{0};
+    // One worker forks all the tasks onto its own deque; idle workers must steal
+    // them. The test thread only polls so that the fork runs on a worker.
+    TaskGroup group;
+    scheduler.submit(group, [&] {
+        TaskGroup work;
+        for (size_t i = 0; i < 64; ++i) {
+            scheduler.submit(work, [&, i] {
+                size_t sum = 0;
+                for (size_t k = 0; k < 20000; ++k) sum += k ^ i;
+                total += sum > 0 ? 1 : 0;
+            });
+        }
+        // Stay busy until another worker has picked up some of the forked work
+        while (total == 0) std::this_thread::yield();
+        scheduler.wait(work);
+    });
+    while (!group.done()) std::this_thread::yield();
+    scheduler.wait(group);
+    REQUIRE(total == 64);
+
+    uint64_t steals = 0;
+    for (const auto& stats : scheduler.stats()) steals += stats.steals;
+    REQUIRE(steals > 0);
+}
+
+TEST_CASE("Parallel plans match serial results", "[parallel]") {
+    Catalog catalog = build_sales_catalog();
+    const std::vector<std::string> queries = {
+        "SELECT sales.id, sales.qty FROM sales WHERE sales.qty > 10",
+        "SELECT sales.store, SUM(sales.qty) AS total, COUNT(*) FROM sales GROUP BY sales.store",
+        "SELECT stores.region, SUM(sales.qty) AS total FROM sales INNER JOIN stores ON sales.store = stores.id "
+        "WHERE sales.id < 60000 GROUP BY stores.region",
+        "SELECT sales.id, stores.region FROM sales INNER JOIN stores ON sales.store = stores.id WHERE stores.region = 'east'",
+        "SELECT sales.id FROM sales ORDER BY sales.id DESC LIMIT 5",
+    };
+    for (const auto& sql : queries) {
+        INFO(sql);
+        auto serial = run_sorted(catalog, sql, 1);
+        REQUIRE(!serial.empty());
+        REQUIRE(run_sorted(catalog, sql, 4) == serial);
+    }
+}
+
+TEST_CASE("Parallel aggregation merges high-cardinality groups by partition", "[parallel]") {
+    Catalog catalog = build_sales_catalog();
+    // Every id is its own group: local pre-aggregation fills up without
+    // reducing anything and the workers switch to passing rows through
+    const std::string sql = "SELECT sales.id, COUNT(*), SUM(sales.qty) AS total, AVG(sales.store) FROM sales GROUP BY sales.id";
+    auto serial = run_sorted(catalog, sql, 1);
+    REQUIRE(serial.size() == static_cast<size_t>(kSalesRows));
+    REQUIRE(run_sorted(catalog, sql, 4) == serial);
+    REQUIRE(run_sorted(catalog, sql, 3) == serial);
+}
+
+TEST_CASE("Parallel join build links every row into the shared table", "[parallel]") {
+    Catalog catalog = build_sales_catalog();
+    // sales is the build side: 100k rows, 2000 per key, inserted by several tasks
+    const std::string sql = "SELECT stores.region, sales.id, sales.qty FROM stores INNER JOIN sales ON stores.id = sales.store";
+    auto serial = run_sorted(catalog, sql, 1);
+    REQUIRE(serial.size() == static_cast<size_t>(kSalesRows));
+    REQUIRE(run_sorted(catalog, sql, 4) == serial);
+}
+
+TEST_CASE("Parallel sort merges worker runs in order", "[parallel]") {
+    Catalog catalog = build_sales_catalog();
+    SECTION("full sort on a unique key") {
+        const std::string sql = "SELECT sales.id, sales.qty FROM sales ORDER BY sales.qty DESC, sales.id";
+        auto serial = run_rows(catalog, sql, 1);
+        REQUIRE(serial.size() == static_cast<size_t>(kSalesRows));
+        REQUIRE(run_rows(catalog, sql, 4) == serial);
+        REQUIRE(run_rows(catalog, sql, 3) == serial);
+    }
+    SECTION("top-n keeps the best rows of every worker") {
+        const std::string sql = "SELECT sales.id, sales.qty FROM sales WHERE sales.store < 10 ORDER BY sales.qty, sales.id DESC LIMIT 25";
+        auto serial = run_rows(catalog, sql, 1);
+        REQUIRE(serial.size() == 25);
+        REQUIRE(run_rows(catalog, sql, 4) == serial);
+    }
+    SECTION("ties stay grouped") {
+        auto rows = run_rows(catalog, "SELECT sales.store, sales.id FROM sales ORDER BY sales.store", 4);
+        REQUIRE(rows.size() == static_cast<size_t>(kSalesRows));
+        auto store = [](const std::vector<std::string>& row) { return std::stoll(row[0]); };
+        REQUIRE(std::is_sorted(rows.begin(), rows.end(), [&](const auto& a, const auto& b) { return store(a) < store(b); }));
+    }
+}
+
+TEST_CASE("Parallel plan clones pipelines under a gather", "[parallel]") {
+    Catalog catalog = build_sales_catalog();
+    PhysicalPlanOptions options;
+    options.threads = 3;
+    auto root = plan_query(catalog, "SELECT sales.id FROM sales WHERE sales.qty > 10", options);
+    REQUIRE(dynamic_cast<Gather*>(root.get()) != nullptr);
+    REQUIRE(root->children().size() == 3);
+
+    // Limit stops early and must shut the workers down cleanly
+    auto limited = run_sorted(catalog, "SELECT sales.id FROM sales LIMIT 10", 4);
+    REQUIRE(limited.size() == 10);
+}
@@ -155,4 +155,19 @@ TEST_CASE("AST to_string test", "[parser]") {
     REQUIRE(result2.find("FROM orders o") != std::string::npos);
     REQUIRE(result2.find("JOIN lineitem l") != std::string::npos);
     REQUIRE(result2.find("WHERE") != std::string::npos);
-}
\ No newline at end of file
+}
+TEST_CASE("AST test - LIKE and IN", "[parser]") {
+    bosql::SelectStmt stmt = bosql::parse_sql("SELECT a FROM t WHERE name LIKE 'ab%' AND code NOT IN (1, 2) AND name NOT LIKE '_x'");
+    REQUIRE(stmt.where_clause->to_string() == "(((name LIKE 'ab%') AND (code NOT IN (1, 2))) AND (name NOT LIKE '_x'))");
+    const auto& like = *stmt.where_clause->left->left;
+    REQUIRE(like.type == bosql::ExprType::BINARY_OP);
+    REQUIRE(like.op == bosql::BinaryOp::LIKE);
+    const auto& in = *stmt.where_clause->left->right;
+    REQUIRE(in.type == bosql::ExprType::IN_LIST);
+    REQUIRE(in.op == bosql::BinaryOp::NE);
+    REQUIRE(in.args.size() == 2);
+    REQUIRE(in.clone()->to_string() == in.to_string());
+
+    REQUIRE_THROWS(bosql::parse_sql("SELECT a FROM t WHERE name LIKE 5"));
+    REQUIRE_THROWS(bosql::parse_sql("SELECT a FROM t WHERE name NOT 5"));
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <filesystem>
+#include <catch2/catch_all.hpp>
+#include "catalog/catalog.h"
+#include "exec/operator.hpp"
+#include "exec/physical_planner.h"
+#include "exec/spill.h"
+#include "test_support.h"
+
+using namespace bosql;
+using namespace bosql::test;
+
+namespace {
+
+constexpr int64_t kEventRows = 50000;
+
+// labels: one row per events.ref, plus a duplicate for every tenth
+void add_labels_table(Catalog& catalog) {
+    Table labels;
+    auto ref_col = std::make_unique<ColumnVector<int64_t>>();
+    auto weight_col = std::make_unique<ColumnVector<int64_t>>();
+    for (int64_t id = 0; id < kEventRows; ++id) {
+        ref_col->append(100000 + id);
+        weight_col->append(id * 3);
+        if (id % 10 == 0) {
+            ref_col->append(100000 + id);
+            weight_col->append(-id);
+        }
+    }
+    size_t label_rows = ref_col->size();
+    labels.columns.push_back({"labels.ref", std::move(ref_col)});
+    labels.columns.push_back({"labels.weight", std::move(weight_col)});
+    std::vector<ColumnMeta> label_cols;
+    label_cols.emplace_back("labels.ref", TypeId::INT64);
+    label_cols.emplace_back("labels.weight", TypeId::INT64);
+    catalog.register_table(std::move(labels), TableMeta("labels", std::move(label_cols), label_rows));
+}
+
+Catalog build_spill_catalog() {
+    Catalog catalog = build_events_catalog(false, kEventRows);
+    add_labels_table(catalog);
+    return catalog;
+}
+
+template <typename T>
+const T* find_operator(const Operator* op) {
+    if (const auto* found = dynamic_cast<const T*>(op)) return found;
+    for (const Operator* child : op->children()) {
+        if (const T* found = find_operator<T>(child)) return found;
+    }
+    return nullptr;
+}
+
+// Rows of `sql` in plan order, with the spill statistics of its T operator
+template <typename T>
+Rows run_spilling(const Catalog& catalog, const std::string& sql, const PhysicalPlanOptions& options, SpillStats& stats) {
+    auto root = plan_query(catalog, sql, options);
+    Rows rows = drain(*root, root->dictionary());
+    stats = find_operator<T>(root.get())->spill_stats();
+    return rows;
+}
+
+Rows sorted(Rows rows) {
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+size_t spill_files(const std::filesystem::path& directory) {
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().filename().string().rfind("bosql-spill-", 0) == 0) ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE("Spilled runs read back every value and type", "[spill]") {
+    SpillConfig config;
+    std::vector<std::vector<Datum>> rows;
+    for (int64_t i = 0; i < 10000; ++i) {
+        rows.push_back({Datum::from_i64(i * -3), Datum::from_f64(static_cast<double>(i) / 8.0),
+                        Datum::from_str(static_cast<StrId>(i % 17)), Datum::from_date32(static_cast<Date32>(20240101 + i))});
+    }
+    RunWriter writer(config, 4);
+    for (const auto& row : rows) {
+        writer.append(row);
+    }
+    std::filesystem::path path = writer.finish();
+    REQUIRE(writer.rows_written() == rows.size());
+    REQUIRE(std::filesystem::file_size(path) == writer.bytes_written());
+    {
+        RunReader reader(path, 4);
+        std::vector<Datum> row;
+        size_t index = 0;
+        bool same = true;
+        while (reader.next(row)) {
+            const auto& expected = rows[index++];
+            same = same && row[0].as_i64() == expected[0].as_i64() && row[1].as_f64() == expected[1].as_f64() &&
+                   row[2].as_str() == expected[2].as_str() && row[3].as_date32() == expected[3].as_date32();
+        }
+        REQUIRE(index == rows.size());
+        REQUIRE(same);
+    }
+    REQUIRE_FALSE(std::filesystem::exists(path));
+}
+
+TEST_CASE("ORDER BY spills sorted runs under a memory limit", "[spill]") {
+    Catalog catalog = build_spill_catalog();
+    auto spill_dir = std::filesystem::temp_directory_path() / "bosql-spill-test";
+    std::filesystem::create_directories(spill_dir);
+    const std::string sql = "SELECT events.ref, events.amount, events.tag FROM events ORDER BY events.amount DESC, events.ref";
+
+    auto expected = run_rows(catalog, sql);
+    REQUIRE(expected.size() == static_cast<size_t>(kEventRows));
+
+    for (size_t threads : {1, 4}) {
+        INFO("threads: " << threads);
+        PhysicalPlanOptions options;
+        options.threads = threads;
+        options.memory_limit = 256 * 1024;
+        options.spill_directory = spill_dir;
+        SpillStats stats;
+        REQUIRE(run_spilling<OrderBy>(catalog, sql, options, stats) == expected);
+        REQUIRE(stats.runs > 1);
+        REQUIRE(stats.rows < static_cast<size_t>(kEventRows));
+        REQUIRE(spill_files(spill_dir) == 0);
+    }
+
+    SECTION("Top-N never spills") {
+        PhysicalPlanOptions options;
+        options.memory_limit = 1024;
+        options.spill_directory = spill_dir;
+        SpillStats stats;
+        auto top = run_spilling<OrderBy>(catalog, sql + " LIMIT 10", options, stats);
+        REQUIRE(top == Rows(expected.begin(), expected.begin() + 10));
+        REQUIRE(stats.runs == 0);
+    }
+    std::filesystem::remove_all(spill_dir);
+}
+
+TEST_CASE("GROUP BY spills hash partitions under a memory limit", "[spill]") {
+    Catalog catalog = build_spill_catalog();
+    auto spill_dir = std::filesystem::temp_directory_path() / "bosql-spill-test";
+    std::filesystem::create_directories(spill_dir);
+    const std::string sql = "SELECT labels.ref, SUM(labels.weight) AS total FROM labels GROUP BY labels.ref";
+
+    auto expected = run_sorted(catalog, sql, 1);
+    REQUIRE(expected.size() == static_cast<size_t>(kEventRows));
+
+    for (size_t threads : {1, 4}) {
+        INFO("threads: " << threads);
+        PhysicalPlanOptions options;
+        options.threads = threads;
+        options.memory_limit = 256 * 1024;
+        options.spill_directory = spill_dir;
+        SpillStats stats;
+        REQUIRE(sorted(run_spilling<HashAggregate>(catalog, sql, options, stats)) == expected);
+        REQUIRE(stats.runs > 1);
+        REQUIRE(spill_files(spill_dir) == 0);
+    }
+    std::filesystem::remove_all(spill_dir);
+}
+
+TEST_CASE("Hash join spills both sides under a memory limit", "[spill]") {
+    Catalog catalog = build_spill_catalog();
+    auto spill_dir = std::filesystem::temp_directory_path() / "bosql-spill-test";
+    std::filesystem::create_directories(spill_dir);
+    const std::string sql = "SELECT events.ref, labels.weight FROM events INNER JOIN labels ON events.ref = labels.ref";
+
+    auto expected = run_sorted(catalog, sql, 1);
+    REQUIRE(expected.size() == static_cast<size_t>(kEventRows + kEventRows / 10));
+
+    // 1MB: partitions fit after one split; 16KB: partitions split recursively
+    for (size_t limit : {1024 * 1024, 16 * 1024}) {
+        for (size_t threads : {1, 4}) {
+            INFO("limit: " << limit << ", threads: " << threads);
+            PhysicalPlanOptions options;
+            options.threads = threads;
+            options.memory_limit = limit;
+            options.spill_directory = spill_dir;
+            SpillStats stats;
+            REQUIRE(sorted(run_spilling<HashJoin>(catalog, sql, options, stats)) == expected);
+            REQUIRE(stats.runs > 1);
+            REQUIRE(spill_files(spill_dir) == 0);
+        }
+    }
+    std::filesystem::remove_all(spill_dir);
+}
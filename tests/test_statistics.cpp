@@ -0,0 +1,146 @@
+#include <catch2/catch_all.hpp>
+#include "catalog/catalog.h"
+#include "catalog/statistics.h"
+#include "logical/cardinality.h"
+#include "logical/planner.h"
+#include "parser/parser.h"
+#include "storage/compression.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace bosql;
+
+namespace {
+
+// 10,000 rows: id is unique, status is 90% 'ok', bucket is uniform over 0..99
+std::pair<Table, TableMeta> make_events() {
+    Table table;
+    table.name = "events";
+    table.dict = std::make_shared<Dictionary>();
+    auto id_col = std::make_unique<ColumnVector<int64_t>>();
+    auto status_col = std::make_unique<ColumnVector<uint32_t>>();
+    auto bucket_col = std::make_unique<ColumnVector<int64_t>>();
+    StrId ok = table.dict->get_or_add("ok");
+    StrId failed = table.dict->get_or_add("failed");
+    for (int64_t i = 0; i < 10000; ++i) {
+        id_col->append(i);
+        status_col->append(i % 10 == 0 ? failed : ok);
+        bucket_col->append(i % 100);
+    }
+    table.columns.push_back({"id", std::move(id_col)});
+    table.columns.push_back({"status", std::move(status_col)});
+    table.columns.push_back({"bucket", std::move(bucket_col)});
+
+    std::vector<ColumnMeta> cols;
+    cols.emplace_back("id", TypeId::INT64);
+    cols.back().stats.min_i64 = 0;
+    cols.back().stats.max_i64 = 9999;
+    cols.emplace_back("status", TypeId::STRING);
+    cols.emplace_back("bucket", TypeId::INT64);
+    cols.back().stats.min_i64 = 0;
+    cols.back().stats.max_i64 = 99;
+    return {std::move(table), TableMeta("events", std::move(cols), 10000)};
+}
+
+} // namespace
+
+TEST_CASE("HyperLogLog estimates distinct counts", "[statistics]") {
+    HyperLogLog small;
+    for (int i = 0; i < 3; ++i) small.add(static_cast<i64>(i));
+    REQUIRE(small.estimate() == 3);
+
+    HyperLogLog large;
+    for (int round = 0; round < 2; ++round) {
+        for (i64 i = 0; i < 200000; ++i) large.add(i);
+    }
+    double estimate = static_cast<double>(large.estimate());
+    REQUIRE(estimate == Catch::Approx(200000.0).epsilon(0.03));
+}
+
+TEST_CASE("ANALYZE builds MCVs and equi-depth histograms", "[statistics]") {
+    auto [table, meta] = make_events();
+    AnalyzeOptions options;
+    options.sample_rows = 2000;
+    analyze_table(table, meta, options);
+
+    const ColumnStats& status = meta.columns[1].stats;
+    REQUIRE(status.analyzed);
+    REQUIRE(status.sample_rows == 2000);
+    REQUIRE(status.ndv == 2);
+    REQUIRE(status.mcvs.size() == 2);
+    REQUIRE(status.mcvs[0].frequency == Catch::Approx(0.9).margin(0.03));
+    REQUIRE(status.histogram.empty());
+
+    const ColumnStats& id = meta.columns[0].stats;
+    REQUIRE(id.mcvs.empty());
+    REQUIRE(id.histogram.bucket_count() == options.histogram_buckets);
+    REQUIRE(id.histogram.bounds.front() >= 0.0);
+    REQUIRE(id.histogram.bounds.back() <= 9999.0);
+    REQUIRE(std::is_sorted(id.histogram.bounds.begin(), id.histogram.bounds.end()));
+}
+
+TEST_CASE("ANALYZE counts NaNs as one value outside the histogram", "[statistics]") {
+    Table table;
+    table.name = "readings";
+    // Runs of 8, so the column is RLE and read back a chunk at a time
+    auto value_col = std::make_unique<ColumnVector<double>>();
+    for (int i = 0; i < 200000; ++i) {
+        value_col->append(i / 8 % 4 == 0 ? std::nan("") : static_cast<double>(i / 8 % 1000));
+    }
+    table.columns.push_back({"value", compress_column(std::move(value_col))});
+    REQUIRE(std::string(table.columns[0].data->encoding()) == "rle");
+    std::vector<ColumnMeta> cols;
+    cols.emplace_back("value", TypeId::DOUBLE);
+    cols.back().stats.approximate = true;
+    TableMeta meta("readings", std::move(cols), 200000);
+
+    AnalyzeOptions options;
+    options.sample_rows = 4000;
+    analyze_table(table, meta, options);
+    const ColumnStats& stats = meta.columns[0].stats;
+    REQUIRE(stats.mcvs.size() == 1);
+    REQUIRE(std::isnan(stats.mcvs[0].value));
+    REQUIRE(stats.mcvs[0].frequency == Catch::Approx(0.25).margin(0.03));
+    REQUIRE(std::none_of(stats.histogram.bounds.begin(), stats.histogram.bounds.end(), [](double b) { return std::isnan(b); }));
+    REQUIRE(std::is_sorted(stats.histogram.bounds.begin(), stats.histogram.bounds.end()));
+    REQUIRE(stats.min_f64 == 1.0);
+    REQUIRE(stats.max_f64 == 999.0);
+    REQUIRE_FALSE(stats.approximate);
+
+    // NaN rows satisfy no comparison
+    auto below = parse_sql("SELECT value FROM readings WHERE value < 2000").where_clause;
+    REQUIRE(estimate_selectivity(below.get(), meta, nullptr) == Catch::Approx(0.75).margin(0.03));
+}
+
+TEST_CASE("Selectivity uses analyzed statistics", "[statistics]") {
+    auto [table, meta] = make_events();
+    analyze_table(table, meta);
+
+    auto where = [](const std::string& predicate) {
+        return parse_sql("SELECT id FROM events WHERE " + predicate).where_clause;
+    };
+    REQUIRE(estimate_selectivity(where("status = 'ok'").get(), meta, table.dict.get()) == Catch::Approx(0.9).margin(0.02));
+    REQUIRE(estimate_selectivity(where("status = 'missing'").get(), meta, table.dict.get()) == 0.0);
+    REQUIRE(estimate_selectivity(where("id < 2500").get(), meta, table.dict.get()) == Catch::Approx(0.25).margin(0.03));
+    REQUIRE(estimate_selectivity(where("id >= 9000").get(), meta, table.dict.get()) == Catch::Approx(0.1).margin(0.03));
+    REQUIRE(estimate_selectivity(where("bucket = 7").get(), meta, table.dict.get()) == Catch::Approx(0.01).margin(0.005));
+    REQUIRE(estimate_selectivity(where("id < 5000 AND status = 'ok'").get(), meta, table.dict.get()) == Catch::Approx(0.45).margin(0.04));
+}
+
+TEST_CASE("Cardinality annotation feeds EXPLAIN", "[statistics]") {
+    auto [table, meta] = make_events();
+    analyze_table(table, meta);
+    Catalog catalog;
+    catalog.register_table(std::move(table), std::move(meta));
+
+    SelectStmt stmt = parse_sql("SELECT bucket, COUNT(*) FROM events WHERE id < 1000 GROUP BY bucket");
+    LogicalPlanner planner;
+    auto plan = planner.build_logical_plan(stmt);
+    annotate_cardinality(plan.get(), catalog);
+
+    const LogicalOp* aggregate = plan->children[0].get();
+    const LogicalOp* filter = aggregate->children[0].get();
+    REQUIRE(filter->estimated_rows == Catch::Approx(1000.0).margin(100.0));
+    REQUIRE(aggregate->estimated_rows == Catch::Approx(100.0).margin(5.0));
+    REQUIRE(plan->to_string().find("est. rows") != std::string::npos);
+}
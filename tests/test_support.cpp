@@ -0,0 +1,106 @@
+#include "test_support.h"
+
+#include <algorithm>
+#include "logical/planner.h"
+#include "parser/parser.h"
+#include "storage/compression.h"
+
+namespace bosql::test {
+
+std::unique_ptr<Operator> plan_query(const Catalog& catalog, const std::string& sql, const PhysicalPlanOptions& options) {
+    SelectStmt stmt = parse_sql(sql);
+    LogicalPlanner planner;
+    auto logical = planner.build_logical_plan(stmt);
+    return build_physical_plan(logical.get(), catalog, options);
+}
+
+Rows drain(Operator& root, const Dictionary* dict) {
+    Rows rows;
+    root.open();
+    ExecBatch batch;
+    while (root.next(batch)) {
+        for (size_t row = 0; row < batch.length; ++row) {
+            std::vector<std::string> out_row;
+            out_row.reserve(batch.columns.size());
+            for (size_t col = 0; col < batch.columns.size(); ++col) {
+                switch (batch.columns[col].type) {
+                    case TypeId::INT64:
+                        out_row.push_back(std::to_string(get_col<int64_t>(batch, col)[row]));
+                        break;
+                    case TypeId::DOUBLE:
+                        out_row.push_back(std::to_string(get_col<double>(batch, col)[row]));
+                        break;
+                    case TypeId::STRING: {
+                        StrId code = get_col<uint32_t>(batch, col)[row];
+                        out_row.push_back(dict ? std::string(dict->get(code)) : std::to_string(code));
+                        break;
+                    }
+                    case TypeId::DATE32:
+                        out_row.push_back(std::to_string(get_col<int32_t>(batch, col)[row]));
+                        break;
+                }
+            }
+            rows.push_back(std::move(out_row));
+        }
+    }
+    // Batches may hold buffers charged to the query; release them first
+    batch.clear();
+    root.close();
+    return rows;
+}
+
+Rows run_rows(const Catalog& catalog, const std::string& sql, const PhysicalPlanOptions& options) {
+    auto root = plan_query(catalog, sql, options);
+    return drain(*root, root->dictionary());
+}
+
+Rows run_rows(const Catalog& catalog, const std::string& sql, size_t threads) {
+    PhysicalPlanOptions options;
+    options.threads = threads;
+    return run_rows(catalog, sql, options);
+}
+
+Rows run_sorted(const Catalog& catalog, const std::string& sql, size_t threads) {
+    Rows rows = run_rows(catalog, sql, threads);
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+Catalog build_events_catalog(bool compress, int64_t rows) {
+    Catalog catalog;
+    Table events;
+    events.dict = std::make_shared<Dictionary>();
+    auto day_col = std::make_unique<ColumnVector<int64_t>>();
+    auto region_col = std::make_unique<ColumnVector<uint32_t>>();
+    auto kind_col = std::make_unique<ColumnVector<int64_t>>();
+    auto amount_col = std::make_unique<ColumnVector<double>>();
+    auto ref_col = std::make_unique<ColumnVector<int64_t>>();
+    auto offset_col = std::make_unique<ColumnVector<int64_t>>();
+    auto tag_col = std::make_unique<ColumnVector<uint32_t>>();
+    const char* regions[] = {"north", "south", "east"};
+    for (int64_t i = 0; i < rows; ++i) {
+        day_col->append(i / 1000);
+        region_col->append(events.dict->get_or_add(regions[i / 500 % 3]));
+        kind_col->append(i * 37 % 100);
+        amount_col->append(static_cast<double>(i * 7919 % 1013) * 0.5);
+        ref_col->append(100000 + i * 7 % 50000);
+        offset_col->append(i * 104729 % 9001 * 100000 - 500000000);
+        tag_col->append(events.dict->get_or_add("t" + std::to_string(i * 7 % 4500)));
+    }
+    events.columns.push_back({"events.day", std::move(day_col)});
+    events.columns.push_back({"events.region", std::move(region_col)});
+    events.columns.push_back({"events.kind", std::move(kind_col)});
+    events.columns.push_back({"events.amount", std::move(amount_col)});
+    events.columns.push_back({"events.ref", std::move(ref_col)});
+    events.columns.push_back({"events.offset", std::move(offset_col)});
+    events.columns.push_back({"events.tag", std::move(tag_col)});
+    std::vector<ColumnMeta> cols;
+    for (auto& column : events.columns) {
+        cols.emplace_back(column.name, column.data->type());
+        if (compress) column.data = compress_column(std::move(column.data));
+    }
+    catalog.register_table(std::move(events), TableMeta("events", std::move(cols), static_cast<size_t>(rows)));
+    return catalog;
+}
+
+} // namespace bosql::test
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "catalog/catalog.h"
+#include "exec/operator.hpp"
+#include "exec/physical_planner.h"
+
+// Helpers the test suites share
+namespace bosql::test {
+
+// Result rows with every value rendered as a string
+using Rows = std::vector<std::vector<std::string>>;
+
+// Parses, plans and builds the physical plan of `sql`
+std::unique_ptr<Operator> plan_query(const Catalog& catalog, const std::string& sql, const PhysicalPlanOptions& options = {});
+
+// Opens `root`, reads every batch and closes it. STRING values are decoded
+// through `dict`, or printed as codes without one.
+Rows drain(Operator& root, const Dictionary* dict);
+
+// Rows of `sql` in the order the plan produces them
+Rows run_rows(const Catalog& catalog, const std::string& sql, const PhysicalPlanOptions& options = {});
+Rows run_rows(const Catalog& catalog, const std::string& sql, size_t threads);
+
+// Rows of `sql` sorted, so runs compare regardless of order
+Rows run_sorted(const Catalog& catalog, const std::string& sql, size_t threads);
+
+// events: sorted by day in runs of 1000 rows, regions in runs of 500, kinds
+// cycling through 0..99, tags through 4500 strings and amounts, refs and
+// offsets with no pattern; refs are distinct up to 50000 rows. At 9000 rows
+// and compressed, day and region are RLE, kind, ref and offset frame of
+// reference at 8, 16 and 32 bits, and tag at 16 bits.
+Catalog build_events_catalog(bool compress, int64_t rows = 9000);
+
+} // namespace bosql::test